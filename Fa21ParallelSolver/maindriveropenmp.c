@@ -2,60 +2,133 @@
 #include "memory.h"
 #include "solver.h"
 #include <omp.h>
+#include <pthread.h>
 #include <unistd.h>
 #include <time.h>
 
 #define shardsize 26
+#define maxidlesleep 1000 //Longest time in microseconds an idle thread sleeps before checking the queue again
+
+//Work queue of shards that are ready to be discovered or solved.
+//Every shard enters the queue exactly twice (once for discovery, once for solving), so the queue is a flat array
+//of 2 * validshards slots that is never reused. Producers claim a slot by atomically incrementing tail and then
+//publish the shard into it; consumers claim the slot at head with a compare-and-swap. No thread ever holds a lock.
+typedef struct shardqueue {
+	shardgraph** slots;
+	uint64_t capacity;
+	uint64_t head;
+	uint64_t tail;
+} shardqueue;
+
+static void pushshard(shardqueue* queue, shardgraph* shard) {
+	uint64_t slot = __atomic_fetch_add(&queue->tail, 1, __ATOMIC_RELAXED);
+	__atomic_store_n(&queue->slots[slot], shard, __ATOMIC_RELEASE);
+}
+
+//Returns the next ready shard, or NULL if no shard is ready right now
+static shardgraph* popshard(shardqueue* queue) {
+	uint64_t slot = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+	while (slot < queue->capacity) {
+		shardgraph* shard = __atomic_load_n(&queue->slots[slot], __ATOMIC_ACQUIRE);
+		if (shard == NULL) return NULL; //Slot is empty, or claimed by a producer that hasn't published yet
+		if (__atomic_compare_exchange_n(&queue->head, &slot, slot + 1, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) return shard;
+		//Another thread took this slot; slot now holds the new head, so try again from there
+	}
+	return NULL;
+}
 
 //Sends a message to all children/parents that the shard is done computing, and adds workable shards to the work queue
 //issolved is 0 if during discovery, and 1 if during solving.
-static void addshardstoqueue(shardgraph** topshard, shardgraph** bottomshard, shardgraph* completedshard, int issolved) {
+//The counters are updated atomically, so exactly one thread sees a shard's last dependency finish and queues it.
+static void addshardstoqueue(shardqueue* queue, shardgraph* completedshard, int issolved) {
+	int count;
 	if (issolved) {
 		for(int i = 0 ; i < completedshard->parentcount;i++) {
 			shardgraph* parentshard = completedshard->parentshards[i];
-			parentshard->childrensolved++;
-			if (parentshard->childrensolved == parentshard->childrencount) {
-				// printf("Added shard %d to queue for solving\n", parentshard->shardid);
-				// fflush(stdout);
-				if (*topshard == NULL) {
-					*topshard = parentshard;
-					*bottomshard = parentshard;
-				} else {
-					(*bottomshard)->nextinqueue = parentshard;
-					*bottomshard = parentshard;
-				}
+			#pragma omp atomic capture
+			count = ++parentshard->childrensolved;
+			if (count == parentshard->childrencount) {
+				pushshard(queue, parentshard);
 			}
 		}
 	} else {
 		for(int i = 0 ; i < completedshard->childrencount;i++) {
 			shardgraph* childshard = completedshard->childrenshards[i];
-			childshard->parentsdiscovered++;
-			if (childshard->parentsdiscovered == childshard->parentcount) {
-				// printf("Added shard %d to queue for discovery\n", childshard->shardid);
-				// fflush(stdout);
-				if (*topshard == NULL) {
-					*topshard = childshard;
-					*bottomshard = childshard;	
-				} else {
-					(*bottomshard)->nextinqueue = childshard;
-					*bottomshard = childshard;
-				}
+			#pragma omp atomic capture
+			count = ++childshard->parentsdiscovered;
+			if (count == childshard->parentcount) {
+				pushshard(queue, childshard);
 			}
 		}
 		if (completedshard->childrencount == 0) {
-			// printf("Added shard %d to queue for solving\n", completedshard->shardid);
-			// fflush(stdout);
-			if (*topshard == NULL) {
-				*topshard = completedshard;
-				*bottomshard = completedshard;	
-			} else {
-				(*bottomshard)->nextinqueue = completedshard;
-				*bottomshard = completedshard;
-			}
+			pushshard(queue, completedshard);
 		}
 	}
 }
 
+//Threads of the outer team that found the queue empty. Near the top and bottom of the shard graph only a few shards
+//are ready at once, so their CPUs are lent to the running shards' OpenMP teams for the per-child loops. As many idle
+//threads as are lent out wait on a condition variable until the shard gives them back, so the CPUs aren't oversubscribed.
+typedef struct idlepool {
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	int spare; //Idle threads not yet lent to a running shard; negative while lent threads are busy again
+	int lent; //Threads lent to running shards; this many idle threads must be parked
+	int parked;
+} idlepool;
+
+//Counts the calling thread as idle, and parks it if a running shard has been lent its CPU.
+//Returns true if it was parked, since by then the queue may have changed.
+static bool waitidle(idlepool* pool, bool* idle, bool* isDone) {
+	bool parked = false;
+	pthread_mutex_lock(&pool->lock);
+	if (!*idle) {
+		pool->spare++;
+		*idle = true;
+	}
+	if (pool->parked < pool->lent) {
+		parked = true;
+		pool->parked++;
+		while (pool->parked <= pool->lent && !__atomic_load_n(isDone, __ATOMIC_ACQUIRE)) {
+			pthread_cond_wait(&pool->wake, &pool->lock);
+		}
+		pool->parked--;
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return parked;
+}
+
+static void markbusy(idlepool* pool, bool* idle) {
+	if (*idle) {
+		pthread_mutex_lock(&pool->lock);
+		pool->spare--;
+		pthread_mutex_unlock(&pool->lock);
+		*idle = false;
+	}
+}
+
+//Lends every currently spare thread to the caller
+static int lendsparethreads(idlepool* pool) {
+	pthread_mutex_lock(&pool->lock);
+	int lent = pool->spare > 0 ? pool->spare : 0;
+	pool->spare -= lent;
+	pool->lent += lent;
+	pthread_mutex_unlock(&pool->lock);
+	return lent;
+}
+
+//Gives lent threads back and wakes as many parked threads
+static void returnsparethreads(idlepool* pool, int lent) {
+	if (lent == 0) return;
+	pthread_mutex_lock(&pool->lock);
+	pool->spare += lent;
+	pool->lent -= lent;
+	if (pool->parked > pool->lent) {
+		pthread_cond_broadcast(&pool->wake);
+	}
+	pthread_mutex_unlock(&pool->lock);
+}
+
 
 int main(int argc, char** argv) {
 	if (argc != 2) {
@@ -63,10 +136,7 @@ int main(int argc, char** argv) {
 		return 1;
 	}
 
-	clock_t start, end;
-	double cpu_time_used;
-
-	start = clock();
+	double start = omp_get_wtime();
 
   	initialize_constants();
 
@@ -75,72 +145,88 @@ int main(int argc, char** argv) {
 	printf("Shard graph computed: %d shards will be computed\n", validshards);
 	fflush(stdout);
 
+	shardqueue queue;
+	queue.capacity = 2 * (uint64_t) validshards;
+	queue.slots = calloc(queue.capacity, sizeof(shardgraph*));
+	queue.head = 0;
+	queue.tail = 0;
+	if (queue.slots == NULL) {
+		printf("Memory allocation error\n");
+		return 1;
+	}
+
 	int shardsdiscovered = 0;
 	int shardssolved = 0;
-	shardgraph* topshard = getstartingshard(shardList, shardsize);
-	shardgraph* bottomshard = topshard; //pointers to front and back of work queue
+	shardgraph* startingshard = getstartingshard(shardList, shardsize);
 	char* workingfolder = argv[1];
-	
-	printf("Discovering shard %d/%d with shard id %d\n", shardsdiscovered, validshards, (topshard)->shardid);	
+
+	printf("Discovering shard %d/%d with shard id %llu\n", shardsdiscovered, validshards, startingshard->shardid);
 	fflush(stdout);
-	discoverfragment(workingfolder, topshard, shardsize, true); //Initialize work queue and compute first shard
-	shardsdiscovered++;	
-	addshardstoqueue(&topshard, &bottomshard, bottomshard, 0);
-	topshard->discovered++;
-	shardgraph* oldtopshard = topshard;
-	topshard = topshard->nextinqueue;
-	oldtopshard->nextinqueue = NULL;
-
-	// Lock information
-	omp_lock_t shardgraphLock;
-	omp_init_lock(&shardgraphLock);
-	omp_lock_t terminalLock;
-	omp_init_lock(&terminalLock);
+	discoverfragment(workingfolder, startingshard, shardsize, true); //Initialize work queue and compute first shard
+	shardsdiscovered++;
+	startingshard->discovered++;
+	addshardstoqueue(&queue, startingshard, 0);
+
 	bool isDone = false;
+	idlepool pool = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0, 0 };
+	omp_set_max_active_levels(2);
 
 	//Compute remaining shards
-	#pragma omp parallel private(oldtopshard)
-	while(!isDone) {
-		if (topshard == NULL) {
-			// printf("Thread %d found no shard, going to sleep\n", omp_get_thread_num());
-			// fflush(stdout);
-			sleep(1);
-			continue;
-		}
-		omp_set_lock(&shardgraphLock);
-		if (topshard == NULL) {
-			omp_unset_lock(&shardgraphLock);
-			continue;
-		}
-		oldtopshard = topshard;
-		topshard = topshard->nextinqueue;
-		oldtopshard->nextinqueue = NULL;
-		omp_unset_lock(&shardgraphLock);
-		if (oldtopshard->discovered) {
-			omp_set_lock(&terminalLock);
-			shardssolved++;
-			printf("Solving shard %d/%d with shard id %llu by thread %d\n", shardssolved, validshards, oldtopshard->shardid, omp_get_thread_num());
-			fflush(stdout);
-			omp_unset_lock(&terminalLock);
-			solvefragment(workingfolder, oldtopshard, shardsize, oldtopshard == getstartingshard(shardList, shardsize));
-			isDone = oldtopshard == getstartingshard(shardList, shardsize);
-		} else {
-			omp_set_lock(&terminalLock);
-			shardsdiscovered++;
-			printf("Discovering shard %d/%d with shard id %llu by thread %d\n", shardsdiscovered, validshards, oldtopshard->shardid, omp_get_thread_num());
-			fflush(stdout);
-			omp_unset_lock(&terminalLock);
-			discoverfragment(workingfolder, oldtopshard, shardsize, false);
+	#pragma omp parallel
+	{
+		int idlesleep = 0;
+		bool idle = false;
+		while (!__atomic_load_n(&isDone, __ATOMIC_ACQUIRE)) {
+			shardgraph* shard = popshard(&queue);
+			if (shard == NULL) {
+				if (waitidle(&pool, &idle, &isDone)) {
+					idlesleep = 0;
+					continue;
+				}
+				idlesleep = idlesleep ? (idlesleep * 2 < maxidlesleep ? idlesleep * 2 : maxidlesleep) : 1;
+				usleep(idlesleep);
+				continue;
+			}
+			markbusy(&pool, &idle);
+			idlesleep = 0;
+
+			int borrowed = lendsparethreads(&pool);
+			shard->helperthreads = 1 + borrowed;
+
+			int wasdiscovered = shard->discovered;
+			int count;
+			if (wasdiscovered) {
+				#pragma omp atomic capture
+				count = ++shardssolved;
+				printf("Solving shard %d/%d with shard id %llu by thread %d with %d threads\n", count, validshards, shard->shardid, omp_get_thread_num(), shard->helperthreads);
+				fflush(stdout);
+				solvefragment(workingfolder, shard, shardsize, shard == startingshard);
+			} else {
+				#pragma omp atomic capture
+				count = ++shardsdiscovered;
+				printf("Discovering shard %d/%d with shard id %llu by thread %d with %d threads\n", count, validshards, shard->shardid, omp_get_thread_num(), shard->helperthreads);
+				fflush(stdout);
+				discoverfragment(workingfolder, shard, shardsize, false);
+			}
+			returnsparethreads(&pool, borrowed);
+
+			//Mark the shard before queueing anything, since a shard with no children is queued again for solving here
+			shard->discovered++;
+			addshardstoqueue(&queue, shard, wasdiscovered);
+			if (wasdiscovered && shard == startingshard) {
+				pthread_mutex_lock(&pool.lock);
+				__atomic_store_n(&isDone, true, __ATOMIC_RELEASE);
+				pthread_cond_broadcast(&pool.wake);
+				pthread_mutex_unlock(&pool.lock);
+			}
 		}
-		omp_set_lock(&shardgraphLock);
-		addshardstoqueue(&topshard, &bottomshard, oldtopshard, oldtopshard->discovered);
-		oldtopshard->discovered++;
-		omp_unset_lock(&shardgraphLock);
 	}
-	end = clock();
-	cpu_time_used = ((double) (end - start)) / CLOCKS_PER_SEC;
+	double end = omp_get_wtime();
 	printf("Done computing\n");
-	printf("Total time taken: %f seconds\n", cpu_time_used);
+	printf("Total time taken: %f seconds\n", end - start);
 	fflush(stdout);
+	pthread_cond_destroy(&pool.wake);
+	pthread_mutex_destroy(&pool.lock);
+	free(queue.slots);
 	freeshardlist(shardList, shardsize); //Clean up
 }
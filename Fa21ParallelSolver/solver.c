@@ -1,4 +1,28 @@
 #include "solver.h"
+#include "transfer.h"
+
+//Opens the transfer files with the given suffix that every parent of targetshard wrote for it, as one merged stream.
+//Returns NULL if a file is missing.
+static transfermerger* openparenttransfers(char* workingfolder, shardgraph* targetshard, const char* suffix) {
+	int filenamemaxlength = strlen(workingfolder) + strlen("/transfer-100000000-100000000-x-primitive") + 1;
+	char** filenames = malloc(sizeof(char*) * targetshard->parentcount);
+	char* filenamestorage = malloc(sizeof(char) * filenamemaxlength * targetshard->parentcount);
+	if((filenames == NULL || filenamestorage == NULL) && targetshard->parentcount > 0) {
+		printf("Memory allocation error\n");
+		fflush(stdout);
+		free(filenames);
+		free(filenamestorage);
+		return NULL;
+	}
+	for (int i = 0; i < targetshard->parentcount; i++) {
+		filenames[i] = filenamestorage + i * filenamemaxlength;
+		snprintf(filenames[i], filenamemaxlength, "%s/transfer-%llu-%llu%s", workingfolder, targetshard->parentshards[i]->shardid, targetshard->shardid, suffix);
+	}
+	transfermerger* merger = opentransfermerger(filenames, targetshard->parentcount);
+	free(filenames);
+	free(filenamestorage);
+	return merger;
+}
 
 
 void discoverfragment(char* workingfolder, shardgraph* targetshard, char fragmentsize, bool isstartingfragment) {
@@ -6,7 +30,7 @@ void discoverfragment(char* workingfolder, shardgraph* targetshard, char fragmen
 
 	// Gives list of children shards that we send discovery children to that we send to
 	int childrenshardcount = targetshard->childrencount;
-	solverdata** childrenshards = malloc(sizeof(solverdata*) * childrenshardcount);
+	childmap** childrenshards = malloc(sizeof(childmap*) * childrenshardcount);
 
 	game g;
 	game newg;
@@ -20,7 +44,7 @@ void discoverfragment(char* workingfolder, shardgraph* targetshard, char fragmen
 	// Next Tier: Use CUDA Malloc when moving to GPU for "moves" and "fringe"
 	solverdata* localpositions = initializesolverdata(fragmentsize);
 	for(int i = 0; i < childrenshardcount; i++) {
-		childrenshards[i] = initializesolverdata(fragmentsize);
+		childrenshards[i] = initializechildmap(fragmentsize);
 		if(childrenshards[i] == NULL) {
 			printf("Memory allocation error\n");
 			fflush(stdout);
@@ -37,16 +61,8 @@ void discoverfragment(char* workingfolder, shardgraph* targetshard, char fragmen
 
 	// Add incoming Discovery states from parent
 	// Multiple top node in shard
-	//Set up the file name
+	//Set up the file name length; each child builds its own name when saving
 	int filenamemaxlength = strlen("/transfer-100000000-100000000-x-primitive")+1;
-	char* filename = malloc(sizeof(char)*(filenamemaxlength + strlen(workingfolder)));
-	if(filename == NULL) {
-		printf("Memory allocation error\n");
-		fflush(stdout);
-		return;
-	}
-	strncpy(filename, workingfolder, strlen(workingfolder));
-	char* filenamewriteaddr = filename+strlen(workingfolder);
 	const int SHARDOFFSETMASK = (1ULL << fragmentsize) - 1;
 	if(isstartingfragment) {
 		fringe[0] = getStartingPositions();
@@ -75,8 +91,8 @@ void discoverfragment(char* workingfolder, shardgraph* targetshard, char fragmen
 					else if(newpositionshard != currentshardid) { // If the child is not in the current shard, insert it into the appropriate child shard
 						for(int l = 0; l < targetshard->childrencount;l++) {
 							if(newpositionshard == targetshard->childrenshards[l]->shardid) {
-								if(!solverread(childrenshards[l], h&SHARDOFFSETMASK))
-									solverinsert(childrenshards[l], h&SHARDOFFSETMASK, isPrimitive(newg, moves[k]));
+								if(!childmapread(childrenshards[l], h&SHARDOFFSETMASK))
+									childmapinsert(childrenshards[l], h&SHARDOFFSETMASK, isPrimitive(newg, moves[k]));
 								break;
 							}
 						}
@@ -87,91 +103,88 @@ void discoverfragment(char* workingfolder, shardgraph* targetshard, char fragmen
 	}
 	else {
 	//Find all children in childrenshards
-		for (int i = 0; i < targetshard->parentcount; i++) {
-			//Open the file and read the first word to determine how many children are to be read
-			snprintf(filenamewriteaddr,filenamemaxlength, "/transfer-%llu-%llu", targetshard->parentshards[i]->shardid, targetshard->shardid);
-			FILE* parentfile = fopen(filename, "rb");
-			if(parentfile == NULL) {
-				printf("File Open Error: %s\n", filename);
-				fflush(stdout);
-				return;
-			}
-			int positioncountfromparent;
-			fread(&positioncountfromparent, sizeof(int), 1, parentfile);
-			//printf("%d positions will be checked from parent %llu\n", positioncountfromparent, targetshard->parentshards[i]->shardid);
-			for(int j = 0; j < positioncountfromparent; j++) {
-				//For each position in the file, add it to the fringe and run graph traversal from there
-				uint32_t newpositionoffset;
-				fread(&newpositionoffset, sizeof(uint32_t), 1, parentfile);
-				if(solverread(localpositions, newpositionoffset)) continue; //If the position already is in the solver, we've already traversed from there, so ignore the position.		
-				gamehash newpositionhash = (((uint64_t) targetshard->shardid) << fragmentsize) + newpositionoffset; //Otherwise, set up the game corresponding to the saved offset.
-				fringe[0] = hashToPosition(newpositionhash);
-				index = 1;
-
-				int movecount, k, oldindex, newpositionshard;
-				while (index) {
-					oldindex = index;
-					g = fringe[index - 1];
-					index--; //For discovery, there's no need to keep the current position on the fringe, since we don't need to go back to it.
-					h = getHash(g);
-					if (solverread(localpositions, h&(SHARDOFFSETMASK)) == 0) { //If we don't find this position in our solver, expand it for discovery
-						solverinsert(localpositions, h&(SHARDOFFSETMASK), 1); //Insert 1 here to that position to signify that it has been expanded. Do this now to minimize the time other threads can access this and try to duplicate work.
-					
-						movecount = generateMoves((char*) &moves, g);
-						for (k = 0; k < movecount; k++) { //Iterate through all children of the current position
-							newg = doMove(g, moves[k]);
-							h = getHash(newg);
-							newpositionshard = h >> fragmentsize;
-							if(newpositionshard == currentshardid && !(solverread(localpositions, h&SHARDOFFSETMASK))) { //If we have a position in our current shard that hasn't been expanded, add it to the fringe
-								if(isPrimitive(newg, moves[k]) == NOT_PRIMITIVE)
-									fringe[index++] = newg;
-								else
-									solverinsert(localpositions, h&(SHARDOFFSETMASK), 2);
-							}
-							else if(newpositionshard != currentshardid) { // If the child is not in the current shard, insert it into the appropriate child shard
-								for(int l = 0; l < targetshard->childrencount;l++) {
-									if(newpositionshard == targetshard->childrenshards[l]->shardid) {
-										if(!solverread(childrenshards[l], h&SHARDOFFSETMASK))
-											solverinsert(childrenshards[l], h&SHARDOFFSETMASK, isPrimitive(newg, moves[k]));
-										break;
-									}
+		//The positions handed down by every parent are read as one sorted stream, so each is looked at once
+		transfermerger* parentpositions = openparenttransfers(workingfolder, targetshard, "");
+		if(parentpositions == NULL) return;
+		uint32_t newpositionoffset;
+		while(transfermergeread(parentpositions, &newpositionoffset)) {
+			//For each position from the parents, add it to the fringe and run graph traversal from there
+			if(solverread(localpositions, newpositionoffset)) continue; //If the position already is in the solver, we've already traversed from there, so ignore the position.		
+			gamehash newpositionhash = (((uint64_t) targetshard->shardid) << fragmentsize) + newpositionoffset; //Otherwise, set up the game corresponding to the saved offset.
+			fringe[0] = hashToPosition(newpositionhash);
+			index = 1;
+
+			int movecount, k, oldindex, newpositionshard;
+			while (index) {
+				oldindex = index;
+				g = fringe[index - 1];
+				index--; //For discovery, there's no need to keep the current position on the fringe, since we don't need to go back to it.
+				h = getHash(g);
+				if (solverread(localpositions, h&(SHARDOFFSETMASK)) == 0) { //If we don't find this position in our solver, expand it for discovery
+					solverinsert(localpositions, h&(SHARDOFFSETMASK), 1); //Insert 1 here to that position to signify that it has been expanded. Do this now to minimize the time other threads can access this and try to duplicate work.
+				
+					movecount = generateMoves((char*) &moves, g);
+					for (k = 0; k < movecount; k++) { //Iterate through all children of the current position
+						newg = doMove(g, moves[k]);
+						h = getHash(newg);
+						newpositionshard = h >> fragmentsize;
+						if(newpositionshard == currentshardid && !(solverread(localpositions, h&SHARDOFFSETMASK))) { //If we have a position in our current shard that hasn't been expanded, add it to the fringe
+							if(isPrimitive(newg, moves[k]) == NOT_PRIMITIVE)
+								fringe[index++] = newg;
+							else
+								solverinsert(localpositions, h&(SHARDOFFSETMASK), 2);
+						}
+						else if(newpositionshard != currentshardid) { // If the child is not in the current shard, insert it into the appropriate child shard
+							for(int l = 0; l < targetshard->childrencount;l++) {
+								if(newpositionshard == targetshard->childrenshards[l]->shardid) {
+									if(!childmapread(childrenshards[l], h&SHARDOFFSETMASK))
+										childmapinsert(childrenshards[l], h&SHARDOFFSETMASK, isPrimitive(newg, moves[k]));
+									break;
 								}
 							}
 						}
 					}
 				}
 			}
-
-			fclose(parentfile); //Clean up
 		}
+		closetransfermerger(parentpositions); //Clean up
 	}
 	//Save all children to appropriate files
+	//Each child shard has its own solver and files, so the children are split among any helper threads lent by the driver
+	int threads = targetshard->helperthreads > 1 ? targetshard->helperthreads : 1;
+	#pragma omp parallel for num_threads(threads) if(threads > 1 && childrenshardcount > 1) schedule(dynamic, 1)
 	for(int i = 0; i < childrenshardcount; i++) {
+		game g;
+		game newg;
+		gamehash h;
+		char moves[getMaxMoves()];
+		char filename[filenamemaxlength + strlen(workingfolder)];
+		strncpy(filename, workingfolder, strlen(workingfolder));
+		char* filenamewriteaddr = filename+strlen(workingfolder);
 		snprintf(filenamewriteaddr,filenamemaxlength, "/transfer-%llu-%llu", currentshardid, targetshard->childrenshards[i]->shardid);
-		FILE* childnonprimitivefile = fopen(filename, "wb"); //Open non-primitive file
+		transferwriter* childnonprimitivefile = opentransferwriter(filename); //Open non-primitive file
 		snprintf(filenamewriteaddr,filenamemaxlength, "/transfer-%llu-%llu-l-primitive", currentshardid, targetshard->childrenshards[i]->shardid);
-		FILE* childlossfile = fopen(filename, "wb"); //Open loss file
+		transferwriter* childlossfile = opentransferwriter(filename); //Open loss file
 		snprintf(filenamewriteaddr,filenamemaxlength, "/transfer-%llu-%llu-t-primitive", currentshardid, targetshard->childrenshards[i]->shardid);
-		FILE* childtiefile = fopen(filename, "wb"); //Open tie file
-		int nppositionsfound = 0, losspositionsfound = 0, tiepositionsfound = 0;
-		fwrite(&nppositionsfound, sizeof(int), 1, childnonprimitivefile); // Store a dummy space of 4 bytes to later save the number of positions found
-		fwrite(&nppositionsfound, sizeof(int), 1, childlossfile); // Store a dummy space of 4 bytes to later save the number of positions found
-		fwrite(&nppositionsfound, sizeof(int), 1, childtiefile); // Store a dummy space of 4 bytes to later save the number of positions found
-		for(uint32_t j = 0; j < 1<<fragmentsize; j++) { //Could probably be made more efficient, but I think this setup is more easily parallelizable
-			switch(solverread(childrenshards[i], j)) { //If the position was found in discovery, save it to the file and increment the number of positions found
+		transferwriter* childtiefile = opentransferwriter(filename); //Open tie file
+		if(childnonprimitivefile == NULL || childlossfile == NULL || childtiefile == NULL) {
+			printf("File Open Error: %s\n", filename);
+			fflush(stdout);
+			exit(1);
+		}
+		uint32_t j;
+		while(childmapnext(childrenshards[i], &j)) { //Visits only the positions found in discovery, in increasing order
+			switch(childmapread(childrenshards[i], j)) { //Save the position to the file for its kind
 				case LOSS: {
-					fwrite(&j, sizeof(uint32_t), 1, childlossfile);
-					losspositionsfound++;
+					transferwrite(childlossfile, j);
 					break;
 				}
 				case TIE: {
-					fwrite(&j, sizeof(uint32_t), 1, childtiefile);
-					tiepositionsfound++;
+					transferwrite(childtiefile, j);
 					break;
 				}
 				case NOT_PRIMITIVE: {
-					fwrite(&j, sizeof(uint32_t), 1, childnonprimitivefile);
-					nppositionsfound++;
+					transferwrite(childnonprimitivefile, j);
 					//No break here; move to the code in unsavednonprimitive
 				}
 				case UNSAVED_NONPRIMITIVE: {
@@ -188,33 +201,25 @@ void discoverfragment(char* workingfolder, shardgraph* targetshard, char fragmen
 						if(newpositionshard == targetshard->childrenshards[i]->shardid) { 
 							if(isPrimitive(newg, moves[k]) == NOT_PRIMITIVE)
 							{
-								solverinsert(childrenshards[i], h&SHARDOFFSETMASK, UNSAVED_NONPRIMITIVE);
+								childmapinsert(childrenshards[i], h&SHARDOFFSETMASK, UNSAVED_NONPRIMITIVE);
 							}
 							else
-								solverinsert(childrenshards[i], h&SHARDOFFSETMASK, UNSAVED_PRIMITIVE);
+								childmapinsert(childrenshards[i], h&SHARDOFFSETMASK, UNSAVED_PRIMITIVE);
 						}
 					}
 					break;
 				}
 			}
 		}
-		//printf("%d positions found\n", positionsfound);
-		fseek(childnonprimitivefile, 0, SEEK_SET);
-		fwrite(&nppositionsfound, sizeof(int), 1, childnonprimitivefile);
-		fseek(childlossfile, 0, SEEK_SET);
-		fwrite(&losspositionsfound, sizeof(int), 1, childlossfile);
-		fseek(childtiefile, 0, SEEK_SET);
-		fwrite(&tiepositionsfound, sizeof(int), 1, childtiefile);
-		fclose(childnonprimitivefile);
-		fclose(childlossfile);
-		fclose(childtiefile);
+		closetransferwriter(childnonprimitivefile);
+		closetransferwriter(childlossfile);
+		closetransferwriter(childtiefile);
+		//The map is done with, so release it now rather than holding every child until the end
+		freechildmap(childrenshards[i]);
+		childrenshards[i] = NULL;
 	}
 	//Clean up
-	free(filename);
 	freesolver(localpositions);
-	for(int i = 0; i < childrenshardcount; i++) {
-		freesolver(childrenshards[i]);
-	}
 	free(childrenshards);
 	free(fringe);
 }
@@ -244,16 +249,26 @@ void solvefragment(char* workingfolder, shardgraph* targetshard, char fragmentsi
 	char* solvedshardfilename = malloc(sizeof(char)*(solvedshardfilenamemaxlength + strlen(workingfolder)));
 	strncpy(solvedshardfilename, workingfolder, strlen(workingfolder));
 	char* solvedshardfilenamewriteaddr = solvedshardfilename+strlen(workingfolder);
+	//Loading the solved children is independent per child, so it is split among any helper threads lent by the driver
+	int threads = targetshard->helperthreads > 1 ? targetshard->helperthreads : 1;
+	bool loaderror = false;
+	#pragma omp parallel for num_threads(threads) if(threads > 1 && childrenshardcount > 1) schedule(dynamic, 1)
 	for(int i = 0; i < childrenshardcount; i++) {
-		snprintf(solvedshardfilenamewriteaddr,solvedshardfilenamemaxlength, "/solved-%d", targetshard->childrenshards[i]->shardid);
-		childrenshards[i] = initializeplayerdata(fragmentsize, solvedshardfilename);
+		char childfilename[solvedshardfilenamemaxlength + strlen(workingfolder)];
+		strncpy(childfilename, workingfolder, strlen(workingfolder));
+		snprintf(childfilename+strlen(workingfolder),solvedshardfilenamemaxlength, "/solved-%d", targetshard->childrenshards[i]->shardid);
+		childrenshards[i] = initializeplayerdata(fragmentsize, childfilename);
 		/*printf("Shard %d player loaded\n", targetshard->childrenshards[i]->shardid);
 		fflush(stdout);*/
 		if(childrenshards[i] == NULL) {
-			printf("Memory allocation error\n");
-			return;
+			#pragma omp atomic write
+			loaderror = true;
 		}
 	}
+	if(loaderror) {
+		printf("Memory allocation error\n");
+		return;
+	}
 	char moves[getMaxMoves()];
 	game* fringe = calloc(sizeof(game), getMaxMoves() * getMaxDepth());
 	if (localpositions == NULL || fringe == NULL) {
@@ -263,11 +278,6 @@ void solvefragment(char* workingfolder, shardgraph* targetshard, char fragmentsi
 
 	// Add incoming Discovery states from parent
 	// Multiple top node in shard
-	//Set up the file name
-	int filenamemaxlength = strlen("/transfer-100000000-100000000-x-primitive")+1;
-	char* filename = malloc(sizeof(char)*(filenamemaxlength + strlen(workingfolder)));
-	strncpy(filename, workingfolder, strlen(workingfolder));
-	char* filenamewriteaddr = filename+strlen(workingfolder);
 	const int SHARDOFFSETMASK = (1ULL << fragmentsize) - 1;
 
 	if(isstartingfragment) {
@@ -357,129 +367,118 @@ void solvefragment(char* workingfolder, shardgraph* targetshard, char fragmentsi
 	}
 	else {
 		//Find all children in childrenshards
-		for (int i = 0; i < targetshard->parentcount; i++) {
-			//Open the file and read the first word to determine how many children are to be read
-			int positioncountfromparent;
-
-			//Insert the loss positions found from the parent shard
-			snprintf(filenamewriteaddr,filenamemaxlength, "/transfer-%llu-%llu-l-primitive", targetshard->parentshards[i]->shardid, targetshard->shardid);
-			FILE* childlossfile = fopen(filename, "rb"); //Open loss file
-			fread(&positioncountfromparent, sizeof(int), 1, childlossfile);
-			for(int j = 0; j < positioncountfromparent; j++) {
-				uint32_t newpositionoffset;
-				fread(&newpositionoffset, sizeof(uint32_t), 1, childlossfile);
-				solverinsert(localpositions, newpositionoffset, LOSS); //Insert is going to be faster than a read and check, so might as well just insert directly.
-			}
-			fclose(childlossfile);
-
-			//Insert the tie positions found from the parent shard
-			snprintf(filenamewriteaddr,filenamemaxlength, "/transfer-%llu-%llu-t-primitive", targetshard->parentshards[i]->shardid, targetshard->shardid);
-			FILE* childtiefile = fopen(filename, "rb"); //Open tie file
-			fread(&positioncountfromparent, sizeof(int), 1, childtiefile);
-			for(int j = 0; j < positioncountfromparent; j++) {
-				uint32_t newpositionoffset;
-				fread(&newpositionoffset, sizeof(uint32_t), 1, childtiefile);
-				solverinsert(localpositions, newpositionoffset, TIE);
-			}
-			fclose(childtiefile);
-			//Begin computing any nonprimitives found from the parent shard
-			snprintf(filenamewriteaddr,filenamemaxlength, "/transfer-%llu-%llu", targetshard->parentshards[i]->shardid, targetshard->shardid);
-			FILE* parentfile = fopen(filename, "rb");
-			fread(&positioncountfromparent, sizeof(int), 1, parentfile);
-			//int itcount = 0, misscount = 0;
-			for(int j = 0; j < positioncountfromparent; j++) {
-				//For each position in the file, add it to the fringe and run graph traversal from there
-				uint32_t newpositionoffset;
-				fread(&newpositionoffset, sizeof(uint32_t), 1, parentfile);
-				if(solverread(localpositions, newpositionoffset)) continue; //If the position already is in the solver, we've already traversed from there, so ignore the position.
-				gamehash newpositionhash = (((uint64_t) targetshard->shardid) << fragmentsize) + newpositionoffset; //Otherwise, set up the game corresponding to the saved offset.
-				fringe[0] = hashToPosition(newpositionhash);
-				index = 1;
-
-
-				int movecount, k, oldindex, newpositionshard;
-				char minprimitive;
-
-				while (index) {
-					/*if(itcount <100) {
-						printf("Done with iteration %d with j=%d and miss=%d on position %llx with index %d\n", itcount, j, misscount, fringe[index-1], index);
-						fflush(stdout);
-					}
-					itcount++;*/
-					minprimitive = 255;
-					oldindex = index;
-					g = fringe[index-1];
-					h = getHash(g);
-					if(solverread(localpositions, h&(SHARDOFFSETMASK)) == 0) //If we don't find this position in our solver, expand it for discovery
-					{
-						//misscount++;
-					movecount = generateMoves((char*)&moves, g);
-					for(k = 0; k < movecount; k++) //Iterate through all children of the current position
-					{
-						newg = doMove(g, moves[k]);
-						h = getHash(newg);
-						newpositionshard = h >> fragmentsize;
-						if(newpositionshard != currentshardid) { //If the position isn't in our current shard, we've already solved it. Read the corresponding data
-							for(int l = 0; l < targetshard->childrencount;l++) {
-								if(newpositionshard == targetshard->childrenshards[l]->shardid) {
-									primitive = playerread(childrenshards[l], h&SHARDOFFSETMASK);
-									/*if(primitive == 0)
-									{
-										printf("Error in primitive value: position %llx\n", h);
-										printf("Current fringe state: ");
-										for(int m = 0; m < index;m++) printf("%llx ", fringe[m]);
-										printf("\n");
-										exit(1);
-									}*/
+		//The positions handed down by every parent are read as one sorted stream per kind, so each is looked at once
+		uint32_t newpositionoffset;
+
+		//Insert the loss positions found from the parent shards
+		transfermerger* parentpositions = openparenttransfers(workingfolder, targetshard, "-l-primitive");
+		if(parentpositions == NULL) return;
+		while(transfermergeread(parentpositions, &newpositionoffset)) {
+			solverinsert(localpositions, newpositionoffset, LOSS); //Insert is going to be faster than a read and check, so might as well just insert directly.
+		}
+		closetransfermerger(parentpositions);
 
-									break;
-								}
-								/*if(l == targetshard->childrencount - 1) {
-									printf("Shard not found in children: %d, %llx, %llx->%llx\n", newpositionshard, h, g, newg);
+		//Insert the tie positions found from the parent shards
+		parentpositions = openparenttransfers(workingfolder, targetshard, "-t-primitive");
+		if(parentpositions == NULL) return;
+		while(transfermergeread(parentpositions, &newpositionoffset)) {
+			solverinsert(localpositions, newpositionoffset, TIE);
+		}
+		closetransfermerger(parentpositions);
+
+		//Begin computing any nonprimitives found from the parent shards
+		parentpositions = openparenttransfers(workingfolder, targetshard, "");
+		if(parentpositions == NULL) return;
+		//int itcount = 0, misscount = 0;
+		while(transfermergeread(parentpositions, &newpositionoffset)) {
+			//For each position from the parents, add it to the fringe and run graph traversal from there
+			if(solverread(localpositions, newpositionoffset)) continue; //If the position already is in the solver, we've already traversed from there, so ignore the position.
+			gamehash newpositionhash = (((uint64_t) targetshard->shardid) << fragmentsize) + newpositionoffset; //Otherwise, set up the game corresponding to the saved offset.
+			fringe[0] = hashToPosition(newpositionhash);
+			index = 1;
+
+
+			int movecount, k, oldindex, newpositionshard;
+			char minprimitive;
+
+			while (index) {
+				/*if(itcount <100) {
+					printf("Done with iteration %d with j=%d and miss=%d on position %llx with index %d\n", itcount, j, misscount, fringe[index-1], index);
+					fflush(stdout);
+				}
+				itcount++;*/
+				minprimitive = 255;
+				oldindex = index;
+				g = fringe[index-1];
+				h = getHash(g);
+				if(solverread(localpositions, h&(SHARDOFFSETMASK)) == 0) //If we don't find this position in our solver, expand it for discovery
+				{
+					//misscount++;
+				movecount = generateMoves((char*)&moves, g);
+				for(k = 0; k < movecount; k++) //Iterate through all children of the current position
+				{
+					newg = doMove(g, moves[k]);
+					h = getHash(newg);
+					newpositionshard = h >> fragmentsize;
+					if(newpositionshard != currentshardid) { //If the position isn't in our current shard, we've already solved it. Read the corresponding data
+						for(int l = 0; l < targetshard->childrencount;l++) {
+							if(newpositionshard == targetshard->childrenshards[l]->shardid) {
+								primitive = playerread(childrenshards[l], h&SHARDOFFSETMASK);
+								/*if(primitive == 0)
+								{
+									printf("Error in primitive value: position %llx\n", h);
 									printf("Current fringe state: ");
 									for(int m = 0; m < index;m++) printf("%llx ", fringe[m]);
 									printf("\n");
 									exit(1);
 								}*/
+
+								break;
 							}
+							/*if(l == targetshard->childrencount - 1) {
+								printf("Shard not found in children: %d, %llx, %llx->%llx\n", newpositionshard, h, g, newg);
+								printf("Current fringe state: ");
+								for(int m = 0; m < index;m++) printf("%llx ", fringe[m]);
+								printf("\n");
+								exit(1);
+							}*/
 						}
-						else primitive = solverread(localpositions, h&SHARDOFFSETMASK); //Otherwise, check its value in the current shard
-						if(!primitive) //Since playerread guarantees nonzero values, only goes through here if it's a local position
-						{
-							primitive = isPrimitive(newg, moves[k]);
-							if(primitive != (char) NOT_PRIMITIVE) {
-								solverinsert(localpositions,h&SHARDOFFSETMASK,primitive);
-								minprimitive = minprimitive <= primitive ? minprimitive : primitive;
-							}
-							else {
-								fringe[index] = newg;
-								index++;
-							}
-						}
-						else
-						{
+					}
+					else primitive = solverread(localpositions, h&SHARDOFFSETMASK); //Otherwise, check its value in the current shard
+					if(!primitive) //Since playerread guarantees nonzero values, only goes through here if it's a local position
+					{
+						primitive = isPrimitive(newg, moves[k]);
+						if(primitive != (char) NOT_PRIMITIVE) {
+							solverinsert(localpositions,h&SHARDOFFSETMASK,primitive);
 							minprimitive = minprimitive <= primitive ? minprimitive : primitive;
 						}
+						else {
+							fringe[index] = newg;
+							index++;
+						}
 					}
-					if(index == oldindex) 
+					else
 					{
-						if(minprimitive & 128)
-						{
-							if(minprimitive & 64) minprimitive = 257-minprimitive;
-							else minprimitive = minprimitive + 1;
-						}
-						else minprimitive = 255-minprimitive;
-						h = getHash(g);
-						solverinsert(localpositions,h&SHARDOFFSETMASK,minprimitive);
-						index--;
+						minprimitive = minprimitive <= primitive ? minprimitive : primitive;
 					}
+				}
+				if(index == oldindex) 
+				{
+					if(minprimitive & 128)
+					{
+						if(minprimitive & 64) minprimitive = 257-minprimitive;
+						else minprimitive = minprimitive + 1;
 					}
-					else { index--;}
+					else minprimitive = 255-minprimitive;
+					h = getHash(g);
+					solverinsert(localpositions,h&SHARDOFFSETMASK,minprimitive);
+					index--;
 				}
+				}
+				else { index--;}
 			}
-
-			fclose(parentfile); //Clean up
 		}
+		closetransfermerger(parentpositions); //Clean up
 	}
 
 
@@ -490,7 +489,6 @@ void solvefragment(char* workingfolder, shardgraph* targetshard, char fragmentsi
 	fclose(childfile);
 
 	//Clean up
-	free(filename);
 	free(solvedshardfilename);
 	freesolver(localpositions);
 	for(int i = 0; i < childrenshardcount; i++) {
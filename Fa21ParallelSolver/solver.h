@@ -18,6 +18,7 @@ typedef struct shardgraph {
 	//For use in shard work queue. Owned by maindriver.c
 	struct shardgraph* nextinqueue;
 	int discovered;
+	int helperthreads; //Threads the solver may use inside this shard; 0 or 1 means run it on the calling thread only
 } shardgraph;
 
 void discoverfragment(char* workingfolder, shardgraph* targetshard, char fragmentsize, bool isstartingfragment);
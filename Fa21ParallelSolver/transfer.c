@@ -0,0 +1,387 @@
+#include "transfer.h"
+#include <string.h>
+
+#define TRANSFERBUFFERSIZE (1 << 16)
+#define CHILDMAPMINBITS 10
+
+struct transferwriter {
+	FILE* file;
+	int count;
+	uint32_t last;
+	size_t used;
+	unsigned char buffer[TRANSFERBUFFERSIZE];
+};
+
+struct transferreader {
+	FILE* file;
+	int remaining;
+	uint32_t last;
+	size_t used;
+	size_t available;
+	unsigned char buffer[TRANSFERBUFFERSIZE];
+};
+
+struct transfermerger {
+	int filecount;
+	transferreader** readers;
+	uint32_t* heads;
+	bool* live;
+};
+
+struct childmap {
+	int keylen;
+
+	//Dense form; NULL while the map is still sparse
+	solverdata* dense;
+
+	//Sparse form: open addressing with linear probing. A value of 0 marks an empty slot.
+	int bits;
+	uint64_t capacity;
+	uint64_t count;
+	uint32_t* keys;
+	unsigned char* vals;
+
+	//State of a walk by childmapnext
+	bool walking;
+	uint32_t cursor;
+	uint32_t* sorted; //Keys present when the walk started, in increasing order
+	uint64_t sortedcount;
+	uint64_t sortedpos;
+	uint32_t* pending; //Min-heap of keys inserted during the walk
+	uint64_t pendingcount;
+	uint64_t pendingcapacity;
+};
+
+
+transferwriter* opentransferwriter(char* filename) {
+	transferwriter* writer = malloc(sizeof(transferwriter));
+	if (!writer) return NULL;
+	writer->file = fopen(filename, "wb");
+	if (!writer->file) {
+		free(writer);
+		return NULL;
+	}
+	writer->count = 0;
+	writer->last = 0;
+	writer->used = 0;
+	fwrite(&writer->count, sizeof(int), 1, writer->file); // Store a dummy space of 4 bytes to later save the number of positions found
+	return writer;
+}
+
+void transferwrite(transferwriter* writer, uint32_t offset) {
+	uint32_t delta = offset - writer->last;
+	if (writer->used + 5 > TRANSFERBUFFERSIZE) {
+		fwrite(writer->buffer, 1, writer->used, writer->file);
+		writer->used = 0;
+	}
+	while (delta >= 0x80) {
+		writer->buffer[writer->used++] = (unsigned char) (delta | 0x80);
+		delta >>= 7;
+	}
+	writer->buffer[writer->used++] = (unsigned char) delta;
+	writer->last = offset;
+	writer->count++;
+}
+
+void closetransferwriter(transferwriter* writer) {
+	fwrite(writer->buffer, 1, writer->used, writer->file);
+	fseek(writer->file, 0, SEEK_SET);
+	fwrite(&writer->count, sizeof(int), 1, writer->file);
+	fclose(writer->file);
+	free(writer);
+}
+
+
+transferreader* opentransferreader(char* filename) {
+	transferreader* reader = malloc(sizeof(transferreader));
+	if (!reader) return NULL;
+	reader->file = fopen(filename, "rb");
+	if (!reader->file) {
+		free(reader);
+		return NULL;
+	}
+	if (fread(&reader->remaining, sizeof(int), 1, reader->file) != 1) reader->remaining = 0;
+	reader->last = 0;
+	reader->used = 0;
+	reader->available = 0;
+	return reader;
+}
+
+static int transferreadbyte(transferreader* reader) {
+	if (reader->used == reader->available) {
+		reader->available = fread(reader->buffer, 1, TRANSFERBUFFERSIZE, reader->file);
+		reader->used = 0;
+		if (reader->available == 0) return EOF;
+	}
+	return reader->buffer[reader->used++];
+}
+
+bool transferread(transferreader* reader, uint32_t* offset) {
+	uint32_t delta = 0;
+	int shift = 0, c;
+	if (reader->remaining <= 0) return false;
+	do {
+		c = transferreadbyte(reader);
+		if (c == EOF) { //Truncated file; treat it as ending here
+			reader->remaining = 0;
+			return false;
+		}
+		delta |= ((uint32_t) (c & 0x7f)) << shift;
+		shift += 7;
+	} while (c & 0x80);
+	reader->remaining--;
+	reader->last += delta;
+	*offset = reader->last;
+	return true;
+}
+
+void closetransferreader(transferreader* reader) {
+	fclose(reader->file);
+	free(reader);
+}
+
+
+transfermerger* opentransfermerger(char** filenames, int filecount) {
+	transfermerger* merger = calloc(1, sizeof(transfermerger));
+	if (!merger) return NULL;
+	merger->filecount = filecount;
+	merger->readers = calloc(filecount, sizeof(transferreader*));
+	merger->heads = calloc(filecount, sizeof(uint32_t));
+	merger->live = calloc(filecount, sizeof(bool));
+	if ((!merger->readers || !merger->heads || !merger->live) && filecount > 0) {
+		closetransfermerger(merger);
+		return NULL;
+	}
+	for (int i = 0; i < filecount; i++) {
+		merger->readers[i] = opentransferreader(filenames[i]);
+		if (!merger->readers[i]) {
+			printf("File Open Error: %s\n", filenames[i]);
+			fflush(stdout);
+			closetransfermerger(merger);
+			return NULL;
+		}
+		merger->live[i] = transferread(merger->readers[i], &merger->heads[i]);
+	}
+	return merger;
+}
+
+bool transfermergeread(transfermerger* merger, uint32_t* offset) {
+	//Parents per shard are few, so a linear scan for the smallest head beats a heap
+	bool found = false;
+	uint32_t smallest = 0;
+	for (int i = 0; i < merger->filecount; i++) {
+		if (merger->live[i] && (!found || merger->heads[i] < smallest)) {
+			smallest = merger->heads[i];
+			found = true;
+		}
+	}
+	if (!found) return false;
+	for (int i = 0; i < merger->filecount; i++) {
+		if (merger->live[i] && merger->heads[i] == smallest) {
+			merger->live[i] = transferread(merger->readers[i], &merger->heads[i]);
+		}
+	}
+	*offset = smallest;
+	return true;
+}
+
+void closetransfermerger(transfermerger* merger) {
+	if (merger->readers) {
+		for (int i = 0; i < merger->filecount; i++) {
+			if (merger->readers[i]) closetransferreader(merger->readers[i]);
+		}
+	}
+	free(merger->readers);
+	free(merger->heads);
+	free(merger->live);
+	free(merger);
+}
+
+
+static uint64_t childmapslot(childmap* map, uint32_t key) {
+	uint64_t mask = map->capacity - 1;
+	uint64_t slot = ((uint32_t) (key * 2654435769u)) >> (32 - map->bits);
+	while (map->vals[slot] && map->keys[slot] != key) slot = (slot + 1) & mask;
+	return slot;
+}
+
+static bool childmapallocate(childmap* map, int bits) {
+	map->bits = bits;
+	map->capacity = 1ULL << bits;
+	map->count = 0;
+	map->keys = malloc(sizeof(uint32_t) * map->capacity);
+	map->vals = calloc(map->capacity, sizeof(unsigned char));
+	return map->keys && map->vals;
+}
+
+static void childmapstopwalk(childmap* map) {
+	free(map->sorted);
+	free(map->pending);
+	map->sorted = NULL;
+	map->pending = NULL;
+	map->sortedcount = map->sortedpos = 0;
+	map->pendingcount = map->pendingcapacity = 0;
+}
+
+//Moves the map to the dense form. A walk in progress carries on from its cursor.
+static bool childmapmakedense(childmap* map) {
+	map->dense = initializesolverdata(map->keylen);
+	if (!map->dense) return false;
+	for (uint64_t i = 0; i < map->capacity; i++) {
+		if (map->vals[i]) solverinsert(map->dense, map->keys[i], map->vals[i]);
+	}
+	free(map->keys);
+	free(map->vals);
+	map->keys = NULL;
+	map->vals = NULL;
+	childmapstopwalk(map);
+	return true;
+}
+
+//Doubles the table, or goes dense if the doubled table would outweigh the dense array
+static bool childmapgrow(childmap* map) {
+	if ((map->capacity * 2) * (sizeof(uint32_t) + 1) >= (1ULL << map->keylen)) return childmapmakedense(map);
+	uint32_t* oldkeys = map->keys;
+	unsigned char* oldvals = map->vals;
+	uint64_t oldcapacity = map->capacity;
+	if (!childmapallocate(map, map->bits + 1)) return false;
+	for (uint64_t i = 0; i < oldcapacity; i++) {
+		if (oldvals[i]) {
+			uint64_t slot = childmapslot(map, oldkeys[i]);
+			map->keys[slot] = oldkeys[i];
+			map->vals[slot] = oldvals[i];
+			map->count++;
+		}
+	}
+	free(oldkeys);
+	free(oldvals);
+	return true;
+}
+
+static void childmappushpending(childmap* map, uint32_t key) {
+	if (map->pendingcount == map->pendingcapacity) {
+		map->pendingcapacity = map->pendingcapacity ? 2 * map->pendingcapacity : 64;
+		map->pending = realloc(map->pending, sizeof(uint32_t) * map->pendingcapacity);
+		if (!map->pending) {
+			printf("Memory allocation error\n");
+			exit(1);
+		}
+	}
+	uint64_t i = map->pendingcount++;
+	while (i > 0 && map->pending[(i - 1) / 2] > key) {
+		map->pending[i] = map->pending[(i - 1) / 2];
+		i = (i - 1) / 2;
+	}
+	map->pending[i] = key;
+}
+
+static uint32_t childmappoppending(childmap* map) {
+	uint32_t top = map->pending[0];
+	uint32_t last = map->pending[--map->pendingcount];
+	uint64_t i = 0, child;
+	while ((child = 2 * i + 1) < map->pendingcount) {
+		if (child + 1 < map->pendingcount && map->pending[child + 1] < map->pending[child]) child++;
+		if (map->pending[child] >= last) break;
+		map->pending[i] = map->pending[child];
+		i = child;
+	}
+	map->pending[i] = last;
+	return top;
+}
+
+childmap* initializechildmap(int keylen) {
+	childmap* map = calloc(1, sizeof(childmap));
+	if (!map) return NULL;
+	map->keylen = keylen;
+	//Tiny shards are cheaper to keep dense from the start
+	if ((1ULL << CHILDMAPMINBITS) * (sizeof(uint32_t) + 1) >= (1ULL << keylen)) {
+		map->dense = initializesolverdata(keylen);
+		if (!map->dense) {
+			free(map);
+			return NULL;
+		}
+		return map;
+	}
+	if (!childmapallocate(map, CHILDMAPMINBITS)) {
+		freechildmap(map);
+		return NULL;
+	}
+	return map;
+}
+
+void childmapinsert(childmap* map, uint32_t key, unsigned char val) {
+	if (!map->dense && 2 * (map->count + 1) > map->capacity && !childmapgrow(map)) {
+		printf("Memory allocation error\n");
+		exit(1);
+	}
+	if (map->dense) {
+		solverinsert(map->dense, key, val);
+		return;
+	}
+	uint64_t slot = childmapslot(map, key);
+	if (!map->vals[slot]) {
+		map->keys[slot] = key;
+		map->count++;
+		if (map->walking && key > map->cursor) childmappushpending(map, key);
+	}
+	map->vals[slot] = val;
+}
+
+unsigned char childmapread(childmap* map, uint32_t key) {
+	if (map->dense) return solverread(map->dense, key);
+	return map->vals[childmapslot(map, key)];
+}
+
+static int compareuint32(const void* a, const void* b) {
+	uint32_t x = *(const uint32_t*) a, y = *(const uint32_t*) b;
+	return (x > y) - (x < y);
+}
+
+bool childmapnext(childmap* map, uint32_t* key) {
+	if (map->dense) {
+		uint64_t end = 1ULL << map->keylen;
+		for (uint64_t k = map->walking ? (uint64_t) map->cursor + 1 : 0; k < end; k++) {
+			if (solverread(map->dense, k)) {
+				map->walking = true;
+				map->cursor = (uint32_t) k;
+				*key = map->cursor;
+				return true;
+			}
+		}
+		map->walking = true;
+		map->cursor = (uint32_t) (end - 1);
+		return false;
+	}
+	if (!map->walking) {
+		map->sorted = malloc(sizeof(uint32_t) * (map->count ? map->count : 1));
+		if (!map->sorted) {
+			printf("Memory allocation error\n");
+			exit(1);
+		}
+		map->sortedcount = 0;
+		for (uint64_t i = 0; i < map->capacity; i++) {
+			if (map->vals[i]) map->sorted[map->sortedcount++] = map->keys[i];
+		}
+		qsort(map->sorted, map->sortedcount, sizeof(uint32_t), compareuint32);
+		map->sortedpos = 0;
+		map->walking = true;
+	}
+	bool fromsorted = map->sortedpos < map->sortedcount;
+	bool frompending = map->pendingcount > 0;
+	if (!fromsorted && !frompending) return false;
+	if (fromsorted && (!frompending || map->sorted[map->sortedpos] < map->pending[0])) {
+		map->cursor = map->sorted[map->sortedpos++];
+	} else {
+		map->cursor = childmappoppending(map);
+	}
+	*key = map->cursor;
+	return true;
+}
+
+void freechildmap(childmap* map) {
+	if (map->dense) freesolver(map->dense);
+	free(map->keys);
+	free(map->vals);
+	childmapstopwalk(map);
+	free(map);
+}
@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "memory.h"
+
+/*
+Transfer files carry the positions a shard hands to one of its child shards.
+Format: a 4-byte count of positions, followed by the position offsets within the child shard
+in strictly increasing order. Each offset is stored as its difference from the previous one
+(the first from 0) as a varint: 7 bits per byte, low bits first, with the high bit set on
+every byte except the last. Crossing positions are clustered, so most deltas take one or two bytes
+instead of four.
+*/
+
+/*Buffered writer for one transfer file*/
+typedef struct transferwriter transferwriter;
+/*Buffered reader for one transfer file*/
+typedef struct transferreader transferreader;
+/*Reads several transfer files for the same shard as one sorted stream without duplicates*/
+typedef struct transfermerger transfermerger;
+
+/*Opens the given file for writing. Returns NULL if error*/
+transferwriter* opentransferwriter(char* filename);
+
+/*Appends an offset. Offsets must be written in strictly increasing order*/
+void transferwrite(transferwriter* writer, uint32_t offset);
+
+/*Flushes the buffer, fills in the position count and closes the file*/
+void closetransferwriter(transferwriter* writer);
+
+/*Opens the given file for reading. Returns NULL if error*/
+transferreader* opentransferreader(char* filename);
+
+/*Reads the next offset into offset. Returns false once every offset has been read*/
+bool transferread(transferreader* reader, uint32_t* offset);
+
+/*Closes the file and frees the reader*/
+void closetransferreader(transferreader* reader);
+
+/*Opens every file in filenames for reading. Returns NULL if any file cannot be opened*/
+transfermerger* opentransfermerger(char** filenames, int filecount);
+
+/*Reads the next offset across all files into offset, in increasing order and with offsets that appear in
+several files returned once. Returns false once every file is exhausted*/
+bool transfermergeread(transfermerger* merger, uint32_t* offset);
+
+/*Closes every file and frees the merger*/
+void closetransfermerger(transfermerger* merger);
+
+
+/*
+Map from offsets in a child shard to the value discovery recorded for them.
+Usually only a small fraction of a child shard is reached from one parent, so the map starts as a sparse
+hash table and turns itself into a dense solverdata only once the table would be larger than
+the 2^keylen byte array.
+*/
+typedef struct childmap childmap;
+
+/*Initializes an empty map for keylen-bit keys. Returns NULL if error*/
+childmap* initializechildmap(int keylen);
+
+/*Sets the value of key, overwriting any previous value. Assumes val != 0*/
+void childmapinsert(childmap* map, uint32_t key, unsigned char val);
+
+/*Reads the value at key, returning 0 if the key has not been inserted*/
+unsigned char childmapread(childmap* map, uint32_t key);
+
+/*Steps through the inserted keys in increasing order, storing the next one in key. Returns false when there are
+no more keys. Keys inserted during the walk that are larger than the last key returned are visited as well*/
+bool childmapnext(childmap* map, uint32_t* key);
+
+/*Frees a map*/
+void freechildmap(childmap* map);
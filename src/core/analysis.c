@@ -38,6 +38,9 @@
 #include <math.h>
 #include <stdint.h>
 #include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <zlib.h>
 
 /*
 ** Globals
@@ -126,25 +129,211 @@ void PrintRawGameValues(BOOLEAN toFile)
 	}
 }
 
+/*
+** Binary export. Positions are exported in rounds of EXPORT_ROUND_CHUNKS
+** chunks. The main thread reads the value, remoteness and mex of a round
+** from the database (databases and the hash window aren't shared between
+** threads), then the gTierSolverThreads workers (just one unless the game
+** sets kSupportsThreads) fill in the children of each chunk while the main
+** thread writes out the previous round. With a filename ending in .gz,
+** each chunk is compressed by its worker into its own gzip member; gzip
+** readers treat the concatenated members as one file.
+*/
+
+#define EXPORT_CHUNK_POSITIONS 1024
+#define EXPORT_ROUND_CHUNKS 32
+
+typedef struct exportround {
+	POSITION start, end;            // positions in this round
+	size_t recordSize;              // bytes per position
+	size_t childOffset;             // offset of the children within a record
+	uint64_t maxMoves;
+	BOOLEAN compress;
+	int numChunks;
+	int nextChunk;                  // next chunk for a worker to claim
+	unsigned char *records;
+	unsigned char *packed[EXPORT_ROUND_CHUNKS];
+	size_t packedSize[EXPORT_ROUND_CHUNKS];
+	size_t packedCapacity[EXPORT_ROUND_CHUNKS];
+	BOOLEAN failed;
+} EXPORTROUND;
+
+typedef struct exportcount {
+	POSITION end;
+	POSITION next;
+	uint64_t maxMoves;
+} EXPORTCOUNT;
+
+static int ExportThreads() {
+	if (gTierSolverThreads > 1 && !kSupportsThreads) {
+		printf("NOTE: This game's moves aren't thread-safe. Exporting with 1 thread.\n");
+		return 1;
+	}
+	if (gTierSolverThreads > 1 && kSupportsTierGamesman && gTierGamesman) {
+		printf("NOTE: The hash window isn't thread-safe. Exporting with 1 thread.\n");
+		return 1;
+	}
+	return gTierSolverThreads;
+}
+
+/* Runs worker(arg) on n threads, the calling thread included, unless
+** background is set, in which case the n threads are started and left
+** running for ExportJoin. */
+static pthread_t *ExportStart(int n, void *(*worker)(void *), void *arg, BOOLEAN background) {
+	pthread_t *threads = (pthread_t *) SafeMalloc(n * sizeof(pthread_t));
+	int i;
+	for (i = background ? 0 : 1; i < n; i++) {
+		if (pthread_create(&threads[i], NULL, worker, arg) != 0) {
+			printf("ERROR: Couldn't create export thread %d!\n", i);
+			ExitStageRight();
+		}
+	}
+	if (!background)
+		worker(arg);
+	return threads;
+}
+
+static void ExportJoin(int n, pthread_t *threads, BOOLEAN background) {
+	int i;
+	for (i = background ? 0 : 1; i < n; i++)
+		pthread_join(threads[i], NULL);
+	SafeFree(threads);
+}
+
+static void *ExportCountWorker(void *ptr) {
+	EXPORTCOUNT *job = (EXPORTCOUNT *) ptr;
+	POSITION from, to, i;
+	uint64_t maxMoves = 0, moves, seen;
+	MOVELIST *all_next_moves;
+
+	generic_hash_thread_start();
+	while ((from = __atomic_fetch_add(&job->next, EXPORT_CHUNK_POSITIONS, __ATOMIC_RELAXED)) < job->end) {
+		to = (job->end - from > EXPORT_CHUNK_POSITIONS) ? from + EXPORT_CHUNK_POSITIONS : job->end;
+		for (i = from; i < to; i++) {
+			all_next_moves = GenerateMoves(i);
+			moves = MoveListLength(all_next_moves);
+			if (moves > maxMoves)
+				maxMoves = moves;
+			FreeMoveList(all_next_moves);
+		}
+	}
+	seen = __atomic_load_n(&job->maxMoves, __ATOMIC_RELAXED);
+	while (maxMoves > seen &&
+	       !__atomic_compare_exchange_n(&job->maxMoves, &seen, maxMoves, FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+	return NULL;
+}
+
+/* Compresses len bytes at data into a gzip member in the chunk's packed buffer. */
+static BOOLEAN ExportPack(EXPORTROUND *round, int chunk, unsigned char *data, size_t len) {
+	z_stream strm;
+	size_t bound;
+	int ret;
+
+	memset(&strm, 0, sizeof(z_stream));
+	if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return FALSE;
+	bound = deflateBound(&strm, len);
+	if (round->packedCapacity[chunk] < bound) {
+		if (round->packed[chunk] != NULL)
+			SafeFree(round->packed[chunk]);
+		round->packed[chunk] = (unsigned char *) SafeMalloc(bound);
+		round->packedCapacity[chunk] = bound;
+	}
+	strm.next_in = data;
+	strm.avail_in = len;
+	strm.next_out = round->packed[chunk];
+	strm.avail_out = bound;
+	ret = deflate(&strm, Z_FINISH);
+	round->packedSize[chunk] = bound - strm.avail_out;
+	deflateEnd(&strm);
+	return ret == Z_STREAM_END;
+}
+
+static void *ExportChildrenWorker(void *ptr) {
+	EXPORTROUND *round = (EXPORTROUND *) ptr;
+	POSITION from, to, i, choice;
+	MOVELIST *all_next_moves, *current_move;
+	unsigned char *record;
+	uint64_t j;
+	int chunk;
+
+	generic_hash_thread_start();
+
+	while ((chunk = __atomic_fetch_add(&round->nextChunk, 1, __ATOMIC_RELAXED)) < round->numChunks) {
+		from = round->start + (POSITION) chunk * EXPORT_CHUNK_POSITIONS;
+		to = (round->end - from > EXPORT_CHUNK_POSITIONS) ? from + EXPORT_CHUNK_POSITIONS : round->end;
+		for (i = from; i < to; i++) {
+			if (kSupportsTierGamesman && gTierGamesman)
+				gInitializeHashWindowToPosition(&i, TRUE);
+			record = round->records + (i - round->start) * round->recordSize + round->childOffset;
+			current_move = all_next_moves = GenerateMoves(i);
+			for (j = 0; j < round->maxMoves; ++j) {
+				if (current_move) {
+					choice = DoMove(i, current_move->move);
+					current_move = current_move->next;
+				} else {
+					/* choice = kBadPosition; */
+					choice = -1;
+				}
+				memcpy(record + j * sizeof(POSITION), &choice, sizeof(POSITION));
+			}
+			FreeMoveList(all_next_moves);
+		}
+		if (round->compress &&
+		    !ExportPack(round, chunk, round->records + (from - round->start) * round->recordSize,
+		                (to - from) * round->recordSize))
+			round->failed = TRUE;
+	}
+	return NULL;
+}
+
+/* Reads the database fields of every position in the round, on this thread. */
+static void ExportFillValues(EXPORTROUND *round) {
+	POSITION i;
+	REMOTENESS remoteness;
+	MEX mex;
+	unsigned char *record = round->records;
+
+	for (i = round->start; i < round->end; i++, record += round->recordSize) {
+		if (kSupportsTierGamesman && gTierGamesman)
+			gInitializeHashWindowToPosition(&i, TRUE);
+		record[0] = gValueLetter[GetValueOfPosition(i)];
+		remoteness = Remoteness(i);
+		memcpy(record + sizeof(char), &remoteness, sizeof(REMOTENESS));
+		if (!kPartizan && !gTwoBits) {
+			mex = MexLoad(i);
+			memcpy(record + sizeof(char) + sizeof(REMOTENESS), &mex, sizeof(MEX));
+		}
+	}
+}
+
+static BOOLEAN ExportWriteRound(EXPORTROUND *round, FILE *fp) {
+	int chunk;
+	if (round->failed)
+		return FALSE;
+	if (!round->compress)
+		return fwrite(round->records, round->recordSize, round->end - round->start, fp) == round->end - round->start;
+	for (chunk = 0; chunk < round->numChunks; chunk++)
+		if (fwrite(round->packed[chunk], 1, round->packedSize[chunk], fp) != round->packedSize[chunk])
+			return FALSE;
+	return TRUE;
+}
+
 void PrintBinaryGameValuesToFile(char * filename)
 {
 	FILE *fp;
 	char filename_array[80];
-	POSITION i = 0;
-	VALUE value = 0;
-	REMOTENESS remoteness = 0;
-	MEX mex = 0;
-	BOOLEAN toFile = 0;
-	uint64_t output = 0;
-	MOVELIST *all_next_moves = NULL;
-	MOVELIST *current_move = NULL;
-	uint64_t max_move_choices = 0;
-	uint64_t possible_move_choices = 0;
-	POSITION choice = 0;
-	POSITION j = 0;
+	uint64_t header[5];
 	POSITION max_position = gNumberOfPositions;
-	size_t count = 1;
-	POSITION last_printed = 0;
+	POSITION roundPositions = (POSITION) EXPORT_CHUNK_POSITIONS * EXPORT_ROUND_CHUNKS;
+	POSITION start;
+	BOOLEAN ok = TRUE;
+	EXPORTCOUNT countJob;
+	EXPORTROUND rounds[2], *round, *previous = NULL;
+	pthread_t *threads;
+	size_t len;
+	int threadCount, r, chunk;
 
 	if (!filename) {
 		printf("File to save to: ");
@@ -159,88 +348,76 @@ void PrintBinaryGameValuesToFile(char * filename)
 
 	printf("Writing to %s\n", filename);
 	fflush(stdout);
+	threadCount = ExportThreads();
+
+	printf("Finding maximum number of move counts...\n");
+	countJob.end = max_position;
+	countJob.next = 0;
+	countJob.maxMoves = 0;
+	ExportJoin(threadCount, ExportStart(threadCount, ExportCountWorker, &countJob, FALSE), FALSE);
+	printf("Maximum move choices: %"PRIu64"\n", countJob.maxMoves);
+
+	memset(rounds, 0, sizeof(rounds));
+	for (r = 0; r < 2; r++) {
+		rounds[r].childOffset = sizeof(char) + sizeof(REMOTENESS) + ((!kPartizan && !gTwoBits) ? sizeof(MEX) : 0);
+		rounds[r].recordSize = rounds[r].childOffset + countJob.maxMoves * sizeof(POSITION);
+		rounds[r].maxMoves = countJob.maxMoves;
+		len = strlen(filename);
+		rounds[r].compress = len > 3 && !strcmp(filename + len - 3, ".gz");
+		rounds[r].records = (unsigned char *) SafeMalloc(roundPositions * rounds[r].recordSize);
+	}
 
 	/* Header */
-	output = sizeof(VALUE);
-	count = (count == 1) && (fwrite(&output, sizeof(uint64_t), 1, fp) == 1); 
-	if(!kPartizan && !gTwoBits) {
-		output = sizeof(MEX);
+	header[0] = sizeof(VALUE);
+	header[1] = (!kPartizan && !gTwoBits) ? sizeof(MEX) : 0;
+	header[2] = sizeof(POSITION);
+	header[3] = countJob.maxMoves;
+	header[4] = gInitialPosition;
+	if (rounds[0].compress) {
+		rounds[0].numChunks = 1;
+		ok = ExportPack(&rounds[0], 0, (unsigned char *) header, sizeof(header))
+		     && fwrite(rounds[0].packed[0], 1, rounds[0].packedSize[0], fp) == rounds[0].packedSize[0];
 	} else {
-		output = 0;
-	}
-	count = (count == 1) && (fwrite(&output, sizeof(uint64_t), 1, fp) == 1);
-	output = sizeof(POSITION);
-	count = (count == 1) && (fwrite(&output, sizeof(uint64_t), 1, fp) == 1);
-
-	printf("Finding maximum number of move counts:\n");
-	printf("    Progress: [%3d%%]", 0);
-
-	/* move_counts */
-	for(i=0; i < max_position; i++) {
-		if (last_printed != ((100 * i) / max_position)) {
-			last_printed = ((100 * i) / max_position);
-			printf("\r    Progress: [%3llu%%]", last_printed);
-			fflush(stdout);
-		}
-		all_next_moves = GenerateMoves(i);
-		possible_move_choices = MoveListLength(all_next_moves);
-		if (possible_move_choices > max_move_choices) {
-			max_move_choices = possible_move_choices;
-		}
-		FreeMoveList(all_next_moves);
+		ok = fwrite(header, sizeof(uint64_t), 5, fp) == 5;
 	}
 
-	printf("\r    Progress: [%3d%%]\n", 100);
-
-	printf("Maximum move choices: %"PRIu64"\n", max_move_choices);
-
-	output = max_move_choices;
-	count = (count == 1) && (fwrite(&output, sizeof(uint64_t), 1, fp) == 1);
-
-	output = gInitialPosition;
-	count = (count == 1) && (fwrite(&output, sizeof(uint64_t), 1, fp) == 1);
-
-	printf("Final export pass:\n");
-
-	printf("    Progress: [%3d%%]", 0);
-	for(i=0; i < gNumberOfPositions; i++) {
-		if (last_printed != ((100 * i) / max_position)) {
-			last_printed = ((100 * i) / max_position);
-			printf("\r    Progress: [%3llu%%]", last_printed);
-			fflush(stdout);
-		}
-		if (kSupportsTierGamesman && gTierGamesman) {
-			gInitializeHashWindowToPosition(&i, TRUE);
-		}
-		value = GetValueOfPosition(i);
-		count = (count == 1) && (fwrite(&gValueLetter[value], sizeof(char), 1, fp) == 1);
-		remoteness = Remoteness(i);
-		count = (count == 1) && (fwrite(&remoteness, sizeof(REMOTENESS), 1, fp) == 1);
-		if(!kPartizan && !gTwoBits) {
-			mex = MexLoad(i);
-			count = (count == 1) && (fwrite(&mex, sizeof(MEX), 1, fp) == 1);
-		}
-		current_move = all_next_moves = GenerateMoves(i);
-		for (j = 0; j < max_move_choices; ++j) {
-			if (current_move) {
-				choice = DoMove(i, current_move->move);
-				current_move = current_move->next;
-			} else {
-				/* choice = kBadPosition; */
-				choice = -1;
-			}
-			count = (count == 1) && (fwrite(&choice, sizeof(POSITION), 1, fp) == 1);
+	printf("Final export pass (%d thread%s):\n", threadCount, threadCount == 1 ? "" : "s");
+	for (start = 0, r = 0; start < max_position; start += roundPositions, r ^= 1) {
+		printf("\r    Progress: [%3llu%%]", (100 * start) / max_position);
+		fflush(stdout);
+		round = &rounds[r];
+		round->start = start;
+		round->end = (max_position - start > roundPositions) ? start + roundPositions : max_position;
+		round->numChunks = (round->end - round->start + EXPORT_CHUNK_POSITIONS - 1) / EXPORT_CHUNK_POSITIONS;
+		round->nextChunk = 0;
+		ExportFillValues(round);
+		if (threadCount > 1) { // write the previous round while this one is worked on
+			threads = ExportStart(threadCount, ExportChildrenWorker, round, TRUE);
+			if (previous != NULL)
+				ok = ExportWriteRound(previous, fp) && ok;
+			ExportJoin(threadCount, threads, TRUE);
+		} else {
+			ExportChildrenWorker(round);
+			if (previous != NULL)
+				ok = ExportWriteRound(previous, fp) && ok;
 		}
-		FreeMoveList(all_next_moves);
+		previous = round;
 	}
+	if (previous != NULL)
+		ok = ExportWriteRound(previous, fp) && ok;
 	printf("\r    Progress: [%3d%%]\n", 100);
 
-	if (count != 1) {
-		printf("EXPORT FAILURE: an error occured in writing the file.\n");
+	for (r = 0; r < 2; r++) {
+		SafeFree(rounds[r].records);
+		for (chunk = 0; chunk < EXPORT_ROUND_CHUNKS; chunk++)
+			if (rounds[r].packed[chunk] != NULL)
+				SafeFree(rounds[r].packed[chunk]);
 	}
 
-	if(toFile) {
-		fclose(fp);
+	ok = (fclose(fp) == 0) && ok;
+	if (!ok) {
+		printf("EXPORT FAILURE: an error occured in writing the file.\n");
+	} else {
 		printf("done\n");
 	}
 }
@@ -556,201 +733,291 @@ void analyze() {
 	}
 }
 
-void DetermineInterestingness(POSITION position) {
-	int debugme = 0;
-	//int count_max = 0;
-	float max_seen = 0.0;
-	POSITION i;
-	POSITION most_interesting = 0;
+/*
+** Interestingness. The graph is walked depth-first from the root as
+** before, but with an explicit stack so deep games can't overflow the C
+** stack. Values, remotenesses and the walk state are kept in one byte per
+** position (interestInfo), read from the database up front on this thread,
+** and interestingness is kept as a 16-bit fraction of
+** INTERESTINGNESS_SCALE rather than a float.
+**
+** A position's interestingness only depends on its children's, so with
+** --threads on a non-loopy game every thread walks from the root, each
+** visiting children in its own rotated order. A thread claims a position
+** by moving it from INTEREST_NEW to INTEREST_BUSY. On reaching a position
+** another thread holds, it helps walk that position's children, then waits
+** for the owner to finish. With no cycles no two threads can wait on each
+** other. Loopy games walk on one thread in move order, which keeps the
+** old results on cycles.
+*/
+
+#define INTEREST_VALUE_MASK 0x07
+#define INTEREST_FAR_WIN    0x08 // remoteness > 1
+#define INTEREST_STATE_MASK 0x30
+#define INTEREST_NEW        0x00
+#define INTEREST_BUSY       0x10
+#define INTEREST_DONE       0x20
+
+static unsigned char *interestInfo = NULL;
+static int interestThreads = 1;
+
+typedef struct interestframe {
+	POSITION position;
+	BOOLEAN owned;          // FALSE if only helping another thread's position
+	POSITION *children;
+	int numChildren, capacity;
+	int next;               // children visited so far
+	int rotation;
+} INTERESTFRAME;
+
+static float InterestingnessOf(POSITION position) {
+	return (float) gAnalysis.Interestingness[position] / INTERESTINGNESS_SCALE;
+}
 
+static void SetInterestingness(POSITION position, float interestingness) {
+	if (interestingness < 0) interestingness = 0;
+	if (interestingness > 1) interestingness = 1;
+	gAnalysis.Interestingness[position] = (unsigned short) (interestingness * INTERESTINGNESS_SCALE + 0.5);
+}
 
-	gAnalysis.Interestingness = (float *) SafeMalloc(gNumberOfPositions * sizeof(float));
+static unsigned char InterestState(POSITION position) {
+	return __atomic_load_n(&interestInfo[position], __ATOMIC_ACQUIRE) & INTEREST_STATE_MASK;
+}
 
-	for (i=0; i < gNumberOfPositions; i++) {
-		gAnalysis.Interestingness[i] = 0.0;
+static BOOLEAN ClaimInterest(POSITION position) {
+	unsigned char info = __atomic_load_n(&interestInfo[position], __ATOMIC_RELAXED);
+	while ((info & INTEREST_STATE_MASK) == INTEREST_NEW) {
+		if (__atomic_compare_exchange_n(&interestInfo[position], &info, info | INTEREST_BUSY, FALSE,
+		                                __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			return TRUE;
 	}
+	return FALSE;
+}
 
-	printf("\nDetermining Interestingness...");
+static void FinishInterest(POSITION position) {
+	__atomic_fetch_xor(&interestInfo[position], INTEREST_BUSY | INTEREST_DONE, __ATOMIC_RELEASE);
+}
 
-	DetermineInterestingnessDFS(position);
+/* Sets the interestingness of a position whose children are all done. */
+static void ComputeInterestingness(INTERESTFRAME *frame) {
+	float interestingness = 0, immediate_interestingness;
+	int wincount = 0, losecount = 0, tiecount = 0, i;
+	VALUE childvalue;
 
-	// set most mostinteresting
-	for (i=0; i < gNumberOfPositions; i++) {
-		if (debugme && gAnalysis.Interestingness[i]) {
-			printf("%d\tNONZERO INTERESTINGNESS IN LOOP at %llu (%f)\n",GetValueOfPosition(i),i,gAnalysis.Interestingness[i]);
+	for (i = 0; i < frame->numChildren; i++) {
+		switch (childvalue = (VALUE) (interestInfo[frame->children[i]] & INTEREST_VALUE_MASK)) {
+		case undecided:
+			break;
+		case win:
+			// only non trivial wins are 'hard to see'
+			if (interestInfo[frame->children[i]] & INTEREST_FAR_WIN) {
+				wincount++;
+			}
+			break;
+		case lose:
+			losecount++;
+			break;
+		case tie:
+			tiecount++;
+			break;
+		default:
+			BadElse("DetermineInterestingness");
 		}
-		if (GetValueOfPosition(i) == win && gAnalysis.Interestingness[i] > max_seen) {
-			//count_max = 0;
-			max_seen = gAnalysis.Interestingness[i];
-			most_interesting = i;
-		} else if (gAnalysis.Interestingness[i] == max_seen) {
-			//count_max++;
+	}
+	switch ((VALUE) (interestInfo[frame->position] & INTEREST_VALUE_MASK)) {
+	case win:
+		// immediate interestingness
+		// higher W+T/W+L+T is better
+		immediate_interestingness = ((float) wincount + tiecount) / ((float) wincount + losecount + tiecount);
+		immediate_interestingness = (immediate_interestingness > PRIMITIVE_INTERESTINGNESS) ? immediate_interestingness : PRIMITIVE_INTERESTINGNESS;
+		// accumulate on loses
+		for (i = 0; i < frame->numChildren; i++) {
+			if ((interestInfo[frame->children[i]] & INTEREST_VALUE_MASK) == lose) {
+				interestingness += InterestingnessOf(frame->children[i]);
+			}
 		}
+		// with gGoAgain a win needn't have a losing child; that term is then 0
+		if (losecount > 0)
+			interestingness /= losecount;
+		SetInterestingness(frame->position, 1.0 - sqrt((1.0 - interestingness)*(1.0 - immediate_interestingness)));
+		break;
+	case lose:
+		// all children should be win values
+		for (i = 0; i < frame->numChildren; i++) {
+			interestingness += InterestingnessOf(frame->children[i]);
+		}
+		SetInterestingness(frame->position, interestingness / frame->numChildren);
+		break;
+	case tie:
+		// this interestingness is zero
+		break;
+	default:
+		// should not get here
+		BadElse("DetermineInterestingness");
 	}
+}
 
-	gAnalysis.MostInteresting = most_interesting;
-	gAnalysis.MaxInterestingness = max_seen = 100 * max_seen;
+/* Pushes a frame for position with its children filled in. */
+static INTERESTFRAME *PushInterestFrame(INTERESTFRAME **frames, int *depth, int *maxDepth,
+                                        POSITION position, BOOLEAN owned, int id) {
+	INTERESTFRAME *frame;
+	MOVELIST *ptr, *head;
 
-	SafeFree(gAnalysis.Interestingness);
-	gAnalysis.Interestingness = NULL;
+	if (*depth == *maxDepth) {
+		*maxDepth *= 2;
+		*frames = (INTERESTFRAME *) SafeRealloc(*frames, *maxDepth * sizeof(INTERESTFRAME));
+		memset(*frames + *depth, 0, (*maxDepth - *depth) * sizeof(INTERESTFRAME));
+	}
+	frame = &(*frames)[(*depth)++];
+	frame->position = position;
+	frame->owned = owned;
+	frame->numChildren = frame->next = 0;
+	head = ptr = GenerateMoves(position);
+	for (; ptr != NULL; ptr = ptr->next) {
+		if (frame->numChildren == frame->capacity) {
+			frame->capacity = frame->capacity ? 2 * frame->capacity : 16;
+			frame->children = (frame->children == NULL)
+			                  ? (POSITION *) SafeMalloc(frame->capacity * sizeof(POSITION))
+			                  : (POSITION *) SafeRealloc(frame->children, frame->capacity * sizeof(POSITION));
+		}
+		frame->children[frame->numChildren++] = DoMove(position, ptr->move);
+	}
+	FreeMoveList(head);
+	frame->rotation = (interestThreads > 1 && frame->numChildren > 0)
+	                  ? (int) ((position * 0x9E3779B97F4A7C15ULL + id * 0x632BE59BD9B4E019ULL) >> 33) % frame->numChildren : 0;
+	return frame;
+}
 
-	printf("%f\n",max_seen);
+/* Walks the graph below position, setting the interestingness of every
+** decided position that this thread claims. */
+static void WalkInterestingness(POSITION position, int id) {
+	int depth = 0, maxDepth = 64, i;
+	INTERESTFRAME *frames = (INTERESTFRAME *) SafeCalloc(maxDepth, sizeof(INTERESTFRAME));
+	INTERESTFRAME *frame;
+	POSITION child;
+	unsigned char info;
+	BOOLEAN owned;
+
+	for (child = position;;) {
+		// visit child: claim it or help with it, then push its frame
+		info = interestInfo[child];
+		if ((info & INTEREST_VALUE_MASK) != undecided) {
+			if ((owned = ClaimInterest(child)) && Primitive(child) != undecided) {
+				// if this is primitive, we assign a default interestingness value
+				SetInterestingness(child, PRIMITIVE_INTERESTINGNESS);
+				FinishInterest(child);
+			} else if (owned || (interestThreads > 1 && InterestState(child) == INTEREST_BUSY)) {
+				PushInterestFrame(&frames, &depth, &maxDepth, child, owned, id);
+			}
+		}
+		// pop every frame whose children have all been visited
+		while (depth > 0 && frames[depth - 1].next == frames[depth - 1].numChildren) {
+			frame = &frames[--depth];
+			if (frame->owned) {
+				// in a non-loopy game, wait for children other threads hold
+				for (i = 0; interestThreads > 1 && i < frame->numChildren; i++) {
+					while ((interestInfo[frame->children[i]] & INTEREST_VALUE_MASK) != undecided
+					       && InterestState(frame->children[i]) == INTEREST_BUSY)
+						sched_yield();
+				}
+				ComputeInterestingness(frame);
+				FinishInterest(frame->position);
+			} else {
+				while (InterestState(frame->position) == INTEREST_BUSY)
+					sched_yield();
+			}
+		}
+		if (depth == 0)
+			break;
+		frame = &frames[depth - 1];
+		child = frame->children[(frame->next++ + frame->rotation) % frame->numChildren];
+	}
+	for (i = 0; i < maxDepth; i++)
+		if (frames[i].children != NULL)
+			SafeFree(frames[i].children);
+	SafeFree(frames);
+}
 
-	printf("Re-saving analysis DB...");
-	SaveAnalysis();
+typedef struct interestworker {
+	POSITION root;
+	int id;
+} INTERESTWORKER;
 
+static void *InterestingnessWorker(void *ptr) {
+	INTERESTWORKER *worker = (INTERESTWORKER *) ptr;
+	generic_hash_thread_start();
+	WalkInterestingness(worker->root, worker->id);
+	return NULL;
 }
 
-void DetermineInterestingnessDFS(POSITION position) {
-	int debugme = 0;
-	// for interestingness calculations
-	float interestingness, immediate_interestingness;
-	int wincount, losecount, tiecount, count;
-	// for generate moves
-	POSITION child;
-	MOVELIST *ptr, *head;
-	MOVE move;
-	// misc
-	VALUE value, childvalue;
+void DetermineInterestingness(POSITION position) {
+	float max_seen = 0.0;
+	unsigned short max_quantized = 0;
+	POSITION i;
+	POSITION most_interesting = 0;
+	VALUE value;
+	INTERESTWORKER *workers;
+	pthread_t *threads;
+	int t;
 
-	if (Visited(position)) {
-		if (debugme) {
-			printf("\tVISITED, returning\n");
-		}
-		// this position's interestingness has been determined
-		// gAnalysis.Interestingness[position] != 0
-		return;
+	if (gAnalysis.Interestingness != NULL)
+		SafeFree(gAnalysis.Interestingness);
+	gAnalysis.Interestingness = (unsigned short *) SafeCalloc(gNumberOfPositions, sizeof(unsigned short));
+	interestInfo = (unsigned char *) SafeMalloc(gNumberOfPositions * sizeof(unsigned char));
+
+	printf("\nDetermining Interestingness...");
+	fflush(stdout);
+
+	for (i = 0; i < gNumberOfPositions; i++) {
+		value = GetValueOfPosition(i);
+		interestInfo[i] = (unsigned char) value;
+		if (value == win && Remoteness(i) > 1)
+			interestInfo[i] |= INTEREST_FAR_WIN;
 	}
-	if ((value = GetValueOfPosition(position)) == undecided) {
-		if(debugme) {
-			printf("\tUNDECIDED or TIE, returning\n");
-		}
 
-		// interestingness defined as zero here
-		// gAnalysis.Interestingness[position] == 0
-		return;
+	interestThreads = gTierSolverThreads;
+	if (kLoopy || !kSupportsThreads || (kSupportsTierGamesman && gTierGamesman))
+		interestThreads = 1;
+	workers = (INTERESTWORKER *) SafeMalloc(interestThreads * sizeof(INTERESTWORKER));
+	threads = (pthread_t *) SafeMalloc(interestThreads * sizeof(pthread_t));
+	for (t = 0; t < interestThreads; t++) {
+		workers[t].root = position;
+		workers[t].id = t;
 	}
-	// first time we've seen this position
-	if (debugme) {
-		printf("UNSEEN POSITION\n");
+	for (t = 1; t < interestThreads; t++) {
+		if (pthread_create(&threads[t], NULL, InterestingnessWorker, &workers[t]) != 0) {
+			printf("ERROR: Couldn't create interestingness thread %d!\n", t);
+			ExitStageRight();
+		}
 	}
-	MarkAsVisited(position);
+	InterestingnessWorker(&workers[0]);
+	for (t = 1; t < interestThreads; t++)
+		pthread_join(threads[t], NULL);
+	SafeFree(threads);
+	SafeFree(workers);
 
-	if (Primitive(position) != undecided) {
-		// if this is primitive, we assign a default interestingness value
-		gAnalysis.Interestingness[position] = PRIMITIVE_INTERESTINGNESS;
-		if(debugme) {
-			printf("\tPRIMITIVE, set to %f\n",gAnalysis.Interestingness[position]);
+	// set most mostinteresting
+	for (i = 0; i < gNumberOfPositions; i++) {
+		if ((interestInfo[i] & INTEREST_VALUE_MASK) == win && gAnalysis.Interestingness[i] > max_quantized) {
+			max_quantized = gAnalysis.Interestingness[i];
+			most_interesting = i;
 		}
+	}
+	max_seen = (float) max_quantized / INTERESTINGNESS_SCALE;
 
-		return;
-	} else {
-		if(debugme) {
-			printf("\tNOT PRIMITIVE, recursing on children\n");
-		}
-		// recurse on children
-		wincount = losecount = tiecount = 0;
-		head = ptr = GenerateMoves(position);
-		while(ptr != NULL) {
-			move = ptr->move;
-
-			child = DoMove(position,move);
-			if ((childvalue = GetValueOfPosition(child)) != undecided) {
-				DetermineInterestingnessDFS(child);
-				switch(childvalue) {
-				case win:
-					// only non trivial wins are 'hard to see'
-					if (Remoteness(child) > 1) {
-						wincount++;
-					}
-					break;
-				case lose:
-					losecount++;
-					break;
-				case tie:
-					tiecount++;
-					break;
-				default:
-					BadElse("DetermineInterestingness");
-				}
+	gAnalysis.MostInteresting = most_interesting;
+	gAnalysis.MaxInterestingness = max_seen = 100 * max_seen;
 
-			}
+	SafeFree(interestInfo);
+	interestInfo = NULL;
+	SafeFree(gAnalysis.Interestingness);
+	gAnalysis.Interestingness = NULL;
 
-			ptr = ptr->next;
-		}
-		// set interestingness of this position by children values, immediate interestingness
-		switch(value) {
-		case win:
-			if (debugme) {
-				printf("\tTHIS IS A WIN\n");
-			}
-			// immediate interestingness
-			// higher W+T/W+L+T is better
-			immediate_interestingness = ((float) wincount + tiecount) / ((float) wincount + losecount + tiecount);
-			immediate_interestingness = (immediate_interestingness > PRIMITIVE_INTERESTINGNESS) ? immediate_interestingness : PRIMITIVE_INTERESTINGNESS;
-			// accumulate on loses
-			// form 1 - \prod_{lose_children} (1 - Interestingness[child])
-			interestingness = 0;
-			count = 0;
-			ptr = head;
-			while(ptr != NULL) {
-				move = ptr->move;
-
-				child = DoMove(position,move);
-				// only include losing children
-				if ((childvalue = GetValueOfPosition(child)) == lose) {
-					interestingness += gAnalysis.Interestingness[child];
-					// interestingness *= 1.0 - gAnalysis.Interestingness[child];
-				}
+	printf("%f\n",max_seen);
 
-				ptr = ptr->next;
-			}
-			// interestingness -= 1.0;
-			// gAnalysis.Interestingness[position] = 1.0 - sqrt((interestingness + (1.0 - immediate_interestingness))/2);
-			interestingness /= losecount;
-			gAnalysis.Interestingness[position] = 1.0 - sqrt((1.0 - interestingness)*(1.0 - immediate_interestingness));
-			if (debugme) {
-				printf("\tIMMEDIATE %f, RECURSIVE %f\n",immediate_interestingness,interestingness);
-			}
-			break;
-		case lose:
-			if (debugme) {
-				printf("\tTHIS IS A LOSE\n");
-			}
-			interestingness = 0;
-			// interestingness = 1;
-			count = 0;
-			ptr = head;
-			while(ptr != NULL) {
-				move = ptr->move;
-
-				child = DoMove(position,move);
-				// all children should be win values
-				interestingness += gAnalysis.Interestingness[child];
-				count++;
-				// interestingness *= 1.0 - gAnalysis.Interestingness[child];
-
-				ptr = ptr->next;
-			}
-			gAnalysis.Interestingness[position] = interestingness /= count;
-			// gAnalysis.Interestingness[position] = 1.0 - interestingness;
+	printf("Re-saving analysis DB...");
+	SaveAnalysis();
 
-			break;
-		case tie:
-			// this interestingness is zero
-			// assert gAnalysis.Interestingness[position] = 0;
-			break;
-		default:
-			// should not get here
-			BadElse("DetermineInterestingness");
-		}
-		// clean up from GenerateMoves
-		FreeMoveList(head);
-	}
-	if(debugme) {
-		printf("Set interestingness of %f for %d\n",gAnalysis.Interestingness[position],value);
-	}
-	// assert gAnalysis.Interestingness[position] != 0
 }
 
 VALUE AnalyzePosition(POSITION thePosition, VALUE theValue)
@@ -13,6 +13,7 @@
 
 #define ANALYSIS_FILE_VER 4
 #define PRIMITIVE_INTERESTINGNESS 0.01
+#define INTERESTINGNESS_SCALE 65535 /* interestingness is stored as n / INTERESTINGNESS_SCALE */
 
 /* Functions to output sets of data */
 
@@ -64,7 +65,6 @@ void    writeXMLVarData                 (void);
 
 /* Interestingness */
 void DetermineInterestingness(POSITION position);
-void DetermineInterestingnessDFS(POSITION position);
 
 /* Analysis Data Structure */
 
@@ -110,7 +110,7 @@ typedef struct analysis_info
 	REMOTENESS LargestFoundFRemoteness;
 	REMOTENESS LargestFoundCorruption;
 
-	float* Interestingness;
+	unsigned short* Interestingness;
 	float MaxInterestingness;
 	POSITION MostInteresting;
 
@@ -64,6 +64,7 @@ BOOLEAN bpdb_readFromDisk = FALSE;
 SCHEME bpdb_readScheme = NULL;
 UINT32 bpdb_readStart = 0;
 UINT8 bpdb_readOffset = 0;
+CHECKPOINTINDEX bpdb_readIndex = NULL;
 
 //
 // stores the format of a slice; in particular the
@@ -276,6 +277,10 @@ bpdb_init(
 	new_db->unmark_visited = bpdb_unmark_visited;
 	new_db->get_mex = bpdb_get_mex;
 	new_db->put_mex = bpdb_set_mex;
+	new_db->get_value_bulk = bpdb_get_value_bulk;
+	new_db->get_remoteness_bulk = bpdb_get_remoteness_bulk;
+	new_db->check_visited_bulk = bpdb_check_visited_bulk;
+	new_db->get_mex_bulk = bpdb_get_mex_bulk;
 	new_db->get_winby = bpdb_get_winby;
 	new_db->put_winby = bpdb_set_winby;
 	new_db->save_database = bpdb_save_database;
@@ -488,6 +493,9 @@ bpdb_free( )
 			BPDB_TRACE("bpdb_load_database()", "call to bitlib to open file failed", status);
 			goto _bailout;
 		}
+
+		bitlib_checkpoint_free( bpdb_readIndex );
+		bpdb_readIndex = NULL;
 	}
 
 	// free write slice format
@@ -606,6 +614,74 @@ bpdb_get_mex(
 	return (MEX) functionsMapping->get_slice_slot( (UINT64)pos, BPDB_MEXSLOT );
 }
 
+/*
+   The bulk getters look up the slot reader and the slice maxima once
+   instead of once per position.
+ */
+
+void
+bpdb_get_value_bulk(
+        POSITION *positions,
+        VALUE *values,
+        int length
+        )
+{
+	UINT64 (*get_slot)(UINT64, UINT8) = functionsMapping->get_slice_slot;
+	int i;
+
+	for(i = 0; i < length; i++) {
+		values[i] = (VALUE) get_slot( (UINT64)positions[i], BPDB_VALUESLOT );
+		if (values[i] == tie && bpdb_get_remoteness(positions[i]) == (int) bpdb_write_slice->maxvalue[BPDB_REMSLOT/2] ) {
+			values[i] = drawdraw;
+		}
+	}
+}
+
+void
+bpdb_get_remoteness_bulk(
+        POSITION *positions,
+        REMOTENESS *remotenesses,
+        int length
+        )
+{
+	UINT64 (*get_slot)(UINT64, UINT8) = functionsMapping->get_slice_slot;
+	int i;
+
+	for(i = 0; i < length; i++) {
+		remotenesses[i] = (REMOTENESS) get_slot( (UINT64)positions[i], BPDB_REMSLOT );
+	}
+}
+
+void
+bpdb_check_visited_bulk(
+        POSITION *positions,
+        BOOLEAN *visited,
+        int length
+        )
+{
+	UINT64 (*get_slot)(UINT64, UINT8) = functionsMapping->get_slice_slot;
+	int i;
+
+	for(i = 0; i < length; i++) {
+		visited[i] = (BOOLEAN) get_slot( (UINT64)positions[i], BPDB_VISITEDSLOT );
+	}
+}
+
+void
+bpdb_get_mex_bulk(
+        POSITION *positions,
+        MEX *mexes,
+        int length
+        )
+{
+	UINT64 (*get_slot)(UINT64, UINT8) = functionsMapping->get_slice_slot;
+	int i;
+
+	for(i = 0; i < length; i++) {
+		mexes[i] = (MEX) get_slot( (UINT64)positions[i], BPDB_MEXSLOT );
+	}
+}
+
 void
 bpdb_set_winby(
         POSITION pos,
@@ -1311,6 +1387,84 @@ bpdb_get_slice_slot(
 }
 
 
+/*++
+
+   Routine Description:
+
+    bpdb_scan_slice_slot decodes a skip-encoded stream,
+    starting at the beginning of the record for slice
+    currentSlice, until it reaches the requested slice
+    and returns the value of the requested slot.
+
+   Arguments:
+
+    inFile - file to refill the buffer from; may be NULL if
+            the buffer already holds every byte to be read
+    inputBuffer - buffer holding the start of the stream
+    bufferLength - length of buffer
+    offset - bit offset of the first record in the first
+            byte of the buffer
+    currentSlice - slice the first record begins at
+    position - slice being looked up
+    index - slot to return
+
+   Return value:
+
+    Value of the requested slot, or 0 if the slice is
+    part of a run of skips
+
+   --*/
+
+static UINT64
+bpdb_scan_slice_slot(
+        dbFILE inFile,
+        BYTE *inputBuffer,
+        UINT32 bufferLength,
+        UINT8 offset,
+        UINT64 currentSlice,
+        UINT64 position,
+        UINT8 index
+        )
+{
+	BYTE *curBuffer = inputBuffer;
+	UINT8 currentSlot = 0;
+	UINT64 value = 0;
+
+	while(currentSlice < position) {
+		if(bitlib_read_from_buffer( inFile, &curBuffer, inputBuffer, bufferLength, &offset, 1 ) == 0) {
+
+			for(currentSlot = 0; currentSlot < (bpdb_write_slice->slots); currentSlot++) {
+				bitlib_read_from_buffer( inFile, &curBuffer, inputBuffer, bufferLength, &offset, bpdb_write_slice->size[currentSlot]);
+			}
+			currentSlice++;
+		} else {
+			currentSlice += bpdb_generic_read_varnum( inFile, bpdb_readScheme, &curBuffer, inputBuffer, bufferLength, &offset, TRUE );
+		}
+	}
+
+	// if skips passed the sought position,
+	// return 0
+	if(currentSlice != position) {
+		return 0;
+	}
+
+	// if slice is part of a range of skips, return 0
+	if(bitlib_read_from_buffer( inFile, &curBuffer, inputBuffer, bufferLength, &offset, 1 ) != 0) {
+		return 0;
+	}
+
+	for(currentSlot = 0; currentSlot < (bpdb_write_slice->slots); currentSlot++) {
+		value = bitlib_read_from_buffer( inFile, &curBuffer, inputBuffer, bufferLength, &offset, bpdb_write_slice->size[currentSlot]);
+
+		if(currentSlot == index) {
+			return value;
+		}
+	}
+
+	return 0;
+}
+
+
 UINT64
 bpdb_get_slice_slot_disk(
         UINT64 position,
@@ -1319,16 +1473,14 @@ bpdb_get_slice_slot_disk(
 {
 	BYTE *inputBuffer = NULL;
 	BYTE *curBuffer = NULL;
+	UINT32 blockLength = 0;
+	UINT64 block = 0;
 
 	index /= 2;
 
 	// assign offset of first bit
 	UINT8 offset = bpdb_readOffset;
 
-	// counters
-	UINT64 currentSlice = 0;
-	UINT8 currentSlot = 0;
-
 	// Eventually REMOVE these NULL checks, once the
 	// code is mature and these NULL errors do not occur.
 	if(NULL == bpdb_readFile) {
@@ -1341,6 +1493,21 @@ bpdb_get_slice_slot_disk(
 		goto _bailout;
 	}
 
+	// with a checkpoint index, inflate and decode only the
+	// block holding the slice; otherwise scan from the start
+	if(NULL != bpdb_readIndex) {
+		if(position >= bpdb_readIndex->slices) {
+			return 0;
+		}
+
+		block = bitlib_checkpoint_find( bpdb_readIndex, position );
+
+		if(GMSUCCESS(bitlib_checkpoint_read_block( bpdb_readIndex, block, &inputBuffer, &blockLength ))) {
+			return bpdb_scan_slice_slot( NULL, inputBuffer, blockLength, bpdb_readIndex->bit[block],
+			                             bpdb_readIndex->slice[block], position, index );
+		}
+	}
+
 	// seek to desired location
 	bitlib_file_seek(bpdb_readFile, bpdb_readStart, SEEK_SET);
 
@@ -1353,42 +1520,7 @@ bpdb_get_slice_slot_disk(
 	bitlib_file_read_bytes( bpdb_readFile, inputBuffer, bpdb_buffer_length );
 
 	if(bpdb_readScheme->indicator) {
-
-		while(currentSlice < position) {
-			if(bitlib_read_from_buffer( bpdb_readFile, &curBuffer, inputBuffer, bpdb_buffer_length, &offset, 1 ) == 0) {
-
-				for(currentSlot = 0; currentSlot < (bpdb_write_slice->slots); currentSlot++) {
-					bitlib_read_from_buffer( bpdb_readFile, &curBuffer, inputBuffer, bpdb_buffer_length, &offset, bpdb_write_slice->size[currentSlot]);
-				}
-				currentSlice++;
-			} else {
-				UINT64 skips = bpdb_generic_read_varnum( bpdb_readFile, bpdb_readScheme, &curBuffer, inputBuffer, bpdb_buffer_length, &offset, TRUE );
-				currentSlice += skips;
-			}
-		}
-
-		if(currentSlice == position)
-		{
-			// if slice is part of a range of skips, return 0
-			if(bitlib_read_from_buffer( bpdb_readFile, &curBuffer, inputBuffer, bpdb_buffer_length, &offset, 1 ) != 0) {
-				return 0;
-			}
-
-			for(currentSlot = 0; currentSlot < (bpdb_write_slice->slots); currentSlot++) {
-				UINT64 value = bitlib_read_from_buffer( bpdb_readFile, &curBuffer, inputBuffer, bpdb_buffer_length, &offset, bpdb_write_slice->size[currentSlot]);
-
-				if(currentSlot == index)
-				{
-					return value;
-				}
-			}
-		}
-		else
-		{
-			// if skips passed the sought position,
-			// return 0
-			return 0;
-		}
+		return bpdb_scan_slice_slot( bpdb_readFile, inputBuffer, bpdb_buffer_length, offset, 0, position, index );
 	} else {
 		// computation for a scheme 0 encoded db
 		UINT64 byteOffset = 0;
@@ -1758,6 +1890,10 @@ bpdb_save_database()
 	// final file name
 	char outfilename[256];
 
+	// checkpoint index file names
+	char indexname[256];
+	char finalindexname[256];
+
 	// track smallest file
 	int smallestscheme = 0;
 	int smallestsize = -1;
@@ -1860,6 +1996,8 @@ bpdb_save_database()
 						printf("Removing %s\n", outfilenames[smallestscheme]);
 					}
 					remove(outfilenames[smallestscheme]);
+					bitlib_checkpoint_filename(outfilenames[smallestscheme], indexname);
+					remove(indexname);
 				}
 				smallestscheme = i;
 				smallestsize = fileinfo.st_size;
@@ -1868,6 +2006,8 @@ bpdb_save_database()
 					printf("Removing %s\n", outfilenames[i]);
 				}
 				remove(outfilenames[i]);
+				bitlib_checkpoint_filename(outfilenames[i], indexname);
+				remove(indexname);
 			}
 		}
 		cur = cur->next;
@@ -1886,6 +2026,13 @@ bpdb_save_database()
 	}
 	rename(outfilenames[smallestscheme], outfilename);
 
+	// carry the checkpoint index along, if the chosen scheme has one
+	bitlib_checkpoint_filename(outfilenames[smallestscheme], indexname);
+	bitlib_checkpoint_filename(outfilename, finalindexname);
+	if(rename(indexname, finalindexname) != 0) {
+		remove(finalindexname);
+	}
+
 _bailout:
 
 	for(i = 0; i<slist_size(bpdb_schemes); i++) {
@@ -2002,12 +2149,19 @@ bpdb_generic_save_database(
 	BYTE *outputBuffer = NULL;
 	BYTE *curBuffer = NULL;
 
+	// restart points for random access to skip-encoded files
+	CHECKPOINTINDEX checkpoints = NULL;
+	char indexname[256];
+
 	outputBuffer = alloca( bpdb_buffer_length * sizeof(BYTE));
 	memset(outputBuffer, 0, bpdb_buffer_length);
 	curBuffer = outputBuffer;
 
 	mkdir("data", 0755);
 
+	bitlib_checkpoint_filename(outfilename, indexname);
+	remove(indexname);
+
 	status = bitlib_file_open(outfilename, "wb", &outFile);
 	if(!GMSUCCESS(status)) {
 		BPDB_TRACE("bpdb_generic_save_database()", "call to bitlib to open file failed", status);
@@ -2033,6 +2187,12 @@ bpdb_generic_save_database(
 	}
 
 	if(scheme->indicator) {
+		checkpoints = bitlib_checkpoint_new( bpdb_slices );
+		if(NULL == checkpoints) {
+			status = STATUS_NOT_ENOUGH_MEMORY;
+			goto _bailout;
+		}
+
 		for(slice = 0; slice<bpdb_slices; slice++) {
 
 			// Check if the slice has a mapping
@@ -2040,11 +2200,24 @@ bpdb_generic_save_database(
 
 				// If so, then check to see if skips must be outputted
 				if(consecutiveSkips != 0) {
+					status = bitlib_checkpoint_mark( outFile, &curBuffer, outputBuffer, offset, checkpoints, slice - consecutiveSkips );
+					if(!GMSUCCESS(status)) {
+						BPDB_TRACE("bpdb_generic_save_database()", "call to bitlib to mark checkpoint failed", status);
+						goto _bailout;
+					}
+
 					// Put skips into output buffer
 					bpdb_generic_write_varnum( outFile, scheme, &curBuffer, outputBuffer, bpdb_buffer_length, &offset, consecutiveSkips);
 					// Reset skip counter
 					consecutiveSkips = 0;
 				}
+
+				status = bitlib_checkpoint_mark( outFile, &curBuffer, outputBuffer, offset, checkpoints, slice );
+				if(!GMSUCCESS(status)) {
+					BPDB_TRACE("bpdb_generic_save_database()", "call to bitlib to mark checkpoint failed", status);
+					goto _bailout;
+				}
+
 				bitlib_value_to_buffer( outFile, &curBuffer, outputBuffer, bpdb_buffer_length, &offset, 0, 1 );
 				for(slot=0; slot < (bpdb_write_slice->slots); slot++) {
 					bitlib_value_to_buffer( outFile, &curBuffer, outputBuffer, bpdb_buffer_length, &offset, bpdb_get_slice_slot(slice, 2*slot), bpdb_write_slice->size[slot] );
@@ -2076,13 +2249,23 @@ bpdb_generic_save_database(
 		bitlib_file_write_bytes(outFile, outputBuffer, curBuffer-outputBuffer+1);
 	}
 
+	if(NULL != checkpoints) {
+		bitlib_checkpoint_finish( outFile, checkpoints );
+	}
+
 	status = bitlib_file_close(outFile);
 	if(!GMSUCCESS(status)) {
 		BPDB_TRACE("bpdb_generic_save_database()", "call to bitlib to close file failed", status);
 		goto _bailout;
 	}
 
+	// an index that cannot be saved only costs lookup speed
+	if(NULL != checkpoints && checkpoints->count > 0) {
+		bitlib_checkpoint_save( checkpoints, outfilename );
+	}
+
 _bailout:
+	bitlib_checkpoint_free( checkpoints );
 	return status;
 }
 
@@ -2179,6 +2362,12 @@ bpdb_load_database( )
 	// otherwise, close the file
 	if(bpdb_readFromDisk) {
 		bpdb_readFile = inFile;
+
+		if(bpdb_readScheme->indicator &&
+		   GMSUCCESS(bitlib_checkpoint_load( outfilename, &bpdb_readIndex )) &&
+		   gBitPerfectDBVerbose) {
+			printf("Using checkpoint index: %llu blocks\n", bpdb_readIndex->count);
+		}
 	} else {
 		status = bitlib_file_close(inFile);
 		if(!GMSUCCESS(status)) {
@@ -120,6 +120,35 @@ bpdb_set_mex(
         POSITION pos,
         MEX mex);
 
+// bulk getters, reading one slot for many positions
+void
+bpdb_get_value_bulk(
+        POSITION *positions,
+        VALUE *values,
+        int length
+        );
+
+void
+bpdb_get_remoteness_bulk(
+        POSITION *positions,
+        REMOTENESS *remotenesses,
+        int length
+        );
+
+void
+bpdb_check_visited_bulk(
+        POSITION *positions,
+        BOOLEAN *visited,
+        int length
+        );
+
+void
+bpdb_get_mex_bulk(
+        POSITION *positions,
+        MEX *mexes,
+        int length
+        );
+
 // get/set winby
 WINBY
 bpdb_get_winby(
@@ -601,3 +601,621 @@ bitlib_read_from_buffer(
 
 	return value;
 }
+
+
+/*++
+
+   Routine Description:
+
+    bitlib_checkpoint_new allocates an empty checkpoint
+    index for a db of the given number of slices.
+
+   Arguments:
+
+    slices - number of slices stored in the db
+
+   Return value:
+
+    The new index, or NULL if memory could not be allocated
+
+   --*/
+
+CHECKPOINTINDEX
+bitlib_checkpoint_new(
+        UINT64 slices
+        )
+{
+	CHECKPOINTINDEX index = NULL;
+
+	index = (CHECKPOINTINDEX) calloc( 1, sizeof(struct checkpointindex) );
+	if(NULL == index) {
+		BPDB_TRACE("bitlib_checkpoint_new()", "Could not allocate checkpoint index in memory", STATUS_NOT_ENOUGH_MEMORY);
+		return NULL;
+	}
+
+	index->slices = slices;
+	index->blockIndex = -1;
+
+	return index;
+}
+
+
+/*++
+
+   Routine Description:
+
+    bitlib_checkpoint_free releases a checkpoint index and
+    closes the raw file handle held by a loaded index.
+
+   Arguments:
+
+    index - index to free; may be NULL
+
+   Return value:
+
+    None
+
+   --*/
+
+void
+bitlib_checkpoint_free(
+        CHECKPOINTINDEX index
+        )
+{
+	if(NULL == index) {
+		return;
+	}
+
+	if(NULL != index->rawFile) {
+		fclose(index->rawFile);
+	}
+
+	SAFE_FREE( index->slice );
+	SAFE_FREE( index->compressed );
+	SAFE_FREE( index->uncompressed );
+	SAFE_FREE( index->bit );
+	SAFE_FREE( index->block );
+	SAFE_FREE( index );
+}
+
+
+/*++
+
+   Routine Description:
+
+    bitlib_checkpoint_filename derives the name of the
+    index file that accompanies a db file.
+
+   Arguments:
+
+    dbname - name of the db file
+    indexname - buffer receiving the index file name; must
+            hold strlen(dbname) + 5 characters
+
+   Return value:
+
+    None
+
+   --*/
+
+void
+bitlib_checkpoint_filename(
+        char *dbname,
+        char *indexname
+        )
+{
+	sprintf(indexname, "%s.idx", dbname);
+}
+
+
+/*++
+
+   Routine Description:
+
+    bitlib_checkpoint_mark records a checkpoint at the
+    current write position if BITLIB_CHECKPOINT_BYTES
+    bytes have been encoded since the last one (the first
+    call always records one). The completed bytes of the
+    output buffer are written out, the partial byte is
+    moved to the front of the buffer, and the gzip stream
+    is cut with a full flush so that inflation may restart
+    at this point with no history.
+
+    Must only be called between records, so that a reader
+    starting here sees the beginning of a slice or of a
+    run of skips.
+
+   Arguments:
+
+    file - db file being written
+    curBuffer - pointer to the current byte of the buffer
+    outputBuffer - start of buffer
+    offset - bit offset within the current byte
+    index - index to append the checkpoint to
+    slice - first slice of the record about to be written
+
+   Return value:
+
+    STATUS_SUCCESS on successful execution, or neccessary
+    error on failure.
+
+   --*/
+
+GMSTATUS
+bitlib_checkpoint_mark(
+        dbFILE file,
+        BYTE **curBuffer,
+        BYTE *outputBuffer,
+        UINT8 offset,
+        CHECKPOINTINDEX index,
+        UINT64 slice
+        )
+{
+	GMSTATUS status = STATUS_SUCCESS;
+	UINT32 whole = *curBuffer - outputBuffer;
+	UINT64 capacity = 0;
+
+	if(index->count > 0 &&
+	   (UINT64) gztell(file) + whole < index->uncompressed[index->count - 1] + BITLIB_CHECKPOINT_BYTES) {
+		goto _bailout;
+	}
+
+	if(whole > 0) {
+		status = bitlib_file_write_bytes(file, outputBuffer, whole);
+		if(!GMSUCCESS(status)) {
+			BPDB_TRACE("bitlib_checkpoint_mark()", "call to bitlib to write buffer failed", status);
+			goto _bailout;
+		}
+		outputBuffer[0] = **curBuffer;
+		memset(outputBuffer + 1, 0, whole);
+		*curBuffer = outputBuffer;
+	}
+
+	if(gzflush(file, Z_FULL_FLUSH) != Z_OK) {
+		status = STATUS_BAD_COMPRESSION;
+		BPDB_TRACE("bitlib_checkpoint_mark()", "call to gzflush failed", status);
+		goto _bailout;
+	}
+
+	if(index->count == index->capacity) {
+		capacity = (index->capacity == 0) ? 64 : 2*index->capacity;
+
+		index->slice = (UINT64 *) realloc( index->slice, capacity*sizeof(UINT64) );
+		index->compressed = (UINT64 *) realloc( index->compressed, capacity*sizeof(UINT64) );
+		index->uncompressed = (UINT64 *) realloc( index->uncompressed, capacity*sizeof(UINT64) );
+		index->bit = (UINT8 *) realloc( index->bit, capacity*sizeof(UINT8) );
+
+		if(NULL == index->slice || NULL == index->compressed ||
+		   NULL == index->uncompressed || NULL == index->bit) {
+			status = STATUS_NOT_ENOUGH_MEMORY;
+			BPDB_TRACE("bitlib_checkpoint_mark()", "Could not grow checkpoint index in memory", status);
+			goto _bailout;
+		}
+		index->capacity = capacity;
+	}
+
+	index->slice[index->count] = slice;
+	index->compressed[index->count] = gzoffset(file);
+	index->uncompressed[index->count] = gztell(file);
+	index->bit[index->count] = offset;
+	index->count++;
+
+_bailout:
+	return status;
+}
+
+
+/*++
+
+   Routine Description:
+
+    bitlib_checkpoint_finish records the final uncompressed
+    length of the db file. Call after the last write and
+    before the file is closed.
+
+   Arguments:
+
+    file - db file being written
+    index - index of the file
+
+   Return value:
+
+    None
+
+   --*/
+
+void
+bitlib_checkpoint_finish(
+        dbFILE file,
+        CHECKPOINTINDEX index
+        )
+{
+	index->length = gztell(file);
+}
+
+
+static void
+bitlib_checkpoint_write_number(
+        FILE *file,
+        UINT64 value
+        )
+{
+	int i;
+
+	for(i = BITSINPOS - BITSINBYTE; i >= 0; i -= BITSINBYTE) {
+		fputc((int) ((value >> i) & 0xff), file);
+	}
+}
+
+
+static UINT64
+bitlib_checkpoint_read_number(
+        FILE *file,
+        BOOLEAN *ok
+        )
+{
+	UINT64 value = 0;
+	int i, c;
+
+	for(i = 0; i < BITSINPOS / BITSINBYTE; i++) {
+		if(EOF == (c = fgetc(file))) {
+			*ok = FALSE;
+		}
+		value = (value << BITSINBYTE) | (UINT64) (c & 0xff);
+	}
+
+	return value;
+}
+
+
+/*++
+
+   Routine Description:
+
+    bitlib_checkpoint_save writes the index next to a
+    closed db file. The size of the compressed db file is
+    stored along with the index so that a stale index is
+    never paired with a rewritten db.
+
+    Format (all numbers 64-bit big-endian):
+    magic, db file size, slices, uncompressed length,
+    checkpoint count, then per checkpoint the first slice,
+    compressed offset, uncompressed offset and bit offset.
+
+   Arguments:
+
+    index - index to save
+    dbname - name of the db file the index describes
+
+   Return value:
+
+    STATUS_SUCCESS on successful execution, or neccessary
+    error on failure.
+
+   --*/
+
+#define BITLIB_CHECKPOINT_MAGIC 0x474d434b50543031ULL
+
+GMSTATUS
+bitlib_checkpoint_save(
+        CHECKPOINTINDEX index,
+        char *dbname
+        )
+{
+	GMSTATUS status = STATUS_SUCCESS;
+	char indexname[256];
+	struct stat fileinfo;
+	FILE *file = NULL;
+	UINT64 i;
+
+	if(stat(dbname, &fileinfo) != 0) {
+		status = STATUS_FILE_COULD_NOT_BE_OPENED;
+		BPDB_TRACE("bitlib_checkpoint_save()", "could not stat db file", status);
+		goto _bailout;
+	}
+
+	bitlib_checkpoint_filename(dbname, indexname);
+
+	if(NULL == (file = fopen(indexname, "wb"))) {
+		status = STATUS_FILE_COULD_NOT_BE_OPENED;
+		BPDB_TRACE("bitlib_checkpoint_save()", "could not open index file", status);
+		goto _bailout;
+	}
+
+	bitlib_checkpoint_write_number(file, BITLIB_CHECKPOINT_MAGIC);
+	bitlib_checkpoint_write_number(file, (UINT64) fileinfo.st_size);
+	bitlib_checkpoint_write_number(file, index->slices);
+	bitlib_checkpoint_write_number(file, index->length);
+	bitlib_checkpoint_write_number(file, index->count);
+
+	for(i = 0; i < index->count; i++) {
+		bitlib_checkpoint_write_number(file, index->slice[i]);
+		bitlib_checkpoint_write_number(file, index->compressed[i]);
+		bitlib_checkpoint_write_number(file, index->uncompressed[i]);
+		bitlib_checkpoint_write_number(file, index->bit[i]);
+	}
+
+	if(fclose(file) != 0) {
+		status = STATUS_FILE_COULD_NOT_BE_CLOSED;
+		BPDB_TRACE("bitlib_checkpoint_save()", "could not close index file", status);
+		remove(indexname);
+	}
+
+_bailout:
+	return status;
+}
+
+
+/*++
+
+   Routine Description:
+
+    bitlib_checkpoint_load reads the index that accompanies
+    a db file and opens a raw handle on the db for block
+    reads. A missing, malformed or stale index is not an
+    error worth reporting; the caller simply falls back to
+    a sequential scan.
+
+   Arguments:
+
+    dbname - name of the db file
+    index - set to the loaded index, or NULL on failure
+
+   Return value:
+
+    STATUS_SUCCESS if an index was loaded, or neccessary
+    error on failure.
+
+   --*/
+
+GMSTATUS
+bitlib_checkpoint_load(
+        char *dbname,
+        CHECKPOINTINDEX *index
+        )
+{
+	GMSTATUS status = STATUS_SUCCESS;
+	CHECKPOINTINDEX loaded = NULL;
+	char indexname[256];
+	struct stat fileinfo;
+	FILE *file = NULL;
+	BOOLEAN ok = TRUE;
+	UINT64 filesize, count, i;
+
+	*index = NULL;
+	bitlib_checkpoint_filename(dbname, indexname);
+
+	if(stat(dbname, &fileinfo) != 0 || NULL == (file = fopen(indexname, "rb"))) {
+		status = STATUS_FILE_COULD_NOT_BE_OPENED;
+		goto _bailout;
+	}
+
+	if(bitlib_checkpoint_read_number(file, &ok) != BITLIB_CHECKPOINT_MAGIC) {
+		status = STATUS_BAD_DECOMPRESSION;
+		goto _bailout;
+	}
+
+	filesize = bitlib_checkpoint_read_number(file, &ok);
+	if(!ok || filesize != (UINT64) fileinfo.st_size) {
+		status = STATUS_BAD_DECOMPRESSION;
+		goto _bailout;
+	}
+
+	if(NULL == (loaded = bitlib_checkpoint_new( bitlib_checkpoint_read_number(file, &ok) ))) {
+		status = STATUS_NOT_ENOUGH_MEMORY;
+		goto _bailout;
+	}
+
+	loaded->length = bitlib_checkpoint_read_number(file, &ok);
+	count = bitlib_checkpoint_read_number(file, &ok);
+
+	if(!ok || 0 == count) {
+		status = STATUS_BAD_DECOMPRESSION;
+		goto _bailout;
+	}
+
+	loaded->slice = (UINT64 *) malloc( count*sizeof(UINT64) );
+	loaded->compressed = (UINT64 *) malloc( count*sizeof(UINT64) );
+	loaded->uncompressed = (UINT64 *) malloc( count*sizeof(UINT64) );
+	loaded->bit = (UINT8 *) malloc( count*sizeof(UINT8) );
+
+	if(NULL == loaded->slice || NULL == loaded->compressed ||
+	   NULL == loaded->uncompressed || NULL == loaded->bit) {
+		status = STATUS_NOT_ENOUGH_MEMORY;
+		BPDB_TRACE("bitlib_checkpoint_load()", "Could not allocate checkpoint index in memory", status);
+		goto _bailout;
+	}
+
+	for(i = 0; i < count && ok; i++) {
+		loaded->slice[i] = bitlib_checkpoint_read_number(file, &ok);
+		loaded->compressed[i] = bitlib_checkpoint_read_number(file, &ok);
+		loaded->uncompressed[i] = bitlib_checkpoint_read_number(file, &ok);
+		loaded->bit[i] = (UINT8) bitlib_checkpoint_read_number(file, &ok);
+	}
+	loaded->count = loaded->capacity = count;
+
+	if(!ok || 0 != loaded->slice[0]) {
+		status = STATUS_BAD_DECOMPRESSION;
+		goto _bailout;
+	}
+
+	if(NULL == (loaded->rawFile = fopen(dbname, "rb"))) {
+		status = STATUS_FILE_COULD_NOT_BE_OPENED;
+		goto _bailout;
+	}
+
+	*index = loaded;
+	loaded = NULL;
+
+_bailout:
+	if(NULL != file) {
+		fclose(file);
+	}
+	bitlib_checkpoint_free(loaded);
+	return status;
+}
+
+
+/*++
+
+   Routine Description:
+
+    bitlib_checkpoint_find binary searches the index for
+    the block that holds a slice, that is the last
+    checkpoint at or before it.
+
+   Arguments:
+
+    index - loaded index
+    slice - slice being looked up
+
+   Return value:
+
+    Number of the block holding the slice
+
+   --*/
+
+UINT64
+bitlib_checkpoint_find(
+        CHECKPOINTINDEX index,
+        UINT64 slice
+        )
+{
+	UINT64 low = 0;
+	UINT64 high = index->count - 1;
+	UINT64 middle;
+
+	while(low < high) {
+		middle = low + (high - low + 1) / 2;
+		if(index->slice[middle] <= slice) {
+			low = middle;
+		} else {
+			high = middle - 1;
+		}
+	}
+
+	return low;
+}
+
+
+/*++
+
+   Routine Description:
+
+    bitlib_checkpoint_read_block inflates one block of the
+    db file into the index's block buffer, starting at the
+    block's restart point. The byte shared with the next
+    block is included so that the last record of the block
+    can be decoded in full. The most recent block is kept,
+    so that repeated lookups in one block inflate it once.
+
+    The returned buffer is padded past the block so that
+    bitlib_read_from_buffer never tries to refill it.
+
+   Arguments:
+
+    index - loaded index
+    block - block number from bitlib_checkpoint_find()
+    buffer - set to the first byte of the block
+    length - set to the buffer length to use for reads
+
+   Return value:
+
+    STATUS_SUCCESS on successful execution, or neccessary
+    error on failure.
+
+   --*/
+
+#define BITLIB_CHECKPOINT_PADDING 8
+#define BITLIB_CHECKPOINT_READ_CHUNK 16384
+
+GMSTATUS
+bitlib_checkpoint_read_block(
+        CHECKPOINTINDEX index,
+        UINT64 block,
+        BYTE **buffer,
+        UINT32 *length
+        )
+{
+	GMSTATUS status = STATUS_SUCCESS;
+	BYTE input[BITLIB_CHECKPOINT_READ_CHUNK];
+	z_stream stream;
+	BOOLEAN streamOpen = FALSE;
+	UINT64 end, need;
+	size_t got;
+	int ret;
+
+	end = (block + 1 < index->count) ? index->uncompressed[block + 1] + 1 : index->length;
+	end = MIN(end, index->length);
+	need = end - index->uncompressed[block];
+
+	if((INT64) block == index->blockIndex) {
+		goto _done;
+	}
+
+	if(need + BITLIB_CHECKPOINT_PADDING > index->blockCapacity) {
+		SAFE_FREE( index->block );
+		index->blockCapacity = need + BITLIB_CHECKPOINT_PADDING;
+		index->block = (BYTE *) malloc( index->blockCapacity );
+		if(NULL == index->block) {
+			index->blockCapacity = 0;
+			status = STATUS_NOT_ENOUGH_MEMORY;
+			BPDB_TRACE("bitlib_checkpoint_read_block()", "Could not allocate block buffer in memory", status);
+			goto _bailout;
+		}
+	}
+	index->blockIndex = -1;
+	memset(index->block, 0, need + BITLIB_CHECKPOINT_PADDING);
+
+	memset(&stream, 0, sizeof(z_stream));
+	if(inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+		status = STATUS_BAD_DECOMPRESSION;
+		BPDB_TRACE("bitlib_checkpoint_read_block()", "call to inflateInit2 failed", status);
+		goto _bailout;
+	}
+	streamOpen = TRUE;
+
+	if(fseeko(index->rawFile, (off_t) index->compressed[block], SEEK_SET) != 0) {
+		status = STATUS_FILE_COULD_NOT_BE_SEEKED;
+		BPDB_TRACE("bitlib_checkpoint_read_block()", "could not seek to checkpoint", status);
+		goto _bailout;
+	}
+
+	stream.next_out = index->block;
+	stream.avail_out = (uInt) need;
+
+	while(stream.avail_out > 0) {
+		if(0 == stream.avail_in) {
+			got = fread(input, 1, BITLIB_CHECKPOINT_READ_CHUNK, index->rawFile);
+			if(0 == got) {
+				break;
+			}
+			stream.next_in = input;
+			stream.avail_in = (uInt) got;
+		}
+
+		// the stream ends at the gzip trailer after the last block
+		ret = inflate(&stream, Z_NO_FLUSH);
+		if(Z_OK != ret) {
+			break;
+		}
+	}
+
+	if(stream.avail_out > 0) {
+		status = STATUS_BAD_DECOMPRESSION;
+		BPDB_TRACE("bitlib_checkpoint_read_block()", "block ended before its checkpoint", status);
+		goto _bailout;
+	}
+
+	index->blockIndex = block;
+
+_done:
+	*buffer = index->block;
+	*length = (UINT32) (need + BITLIB_CHECKPOINT_PADDING);
+
+_bailout:
+	if(streamOpen) {
+		inflateEnd(&stream);
+	}
+	return status;
+}
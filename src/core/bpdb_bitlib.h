@@ -148,4 +148,102 @@ bitlib_read_from_buffer(
         UINT8 length
         );
 
+//
+// sparse checkpoint index into a skip-encoded db file.
+// about every BITLIB_CHECKPOINT_BYTES of encoded slices the
+// writer cuts the gzip stream with a full flush, so that a
+// single block can be inflated on its own without
+// decompressing everything that precedes it. each flush
+// throws away the deflate history, so smaller blocks make
+// lookups faster but the file larger.
+//
+
+#define BITLIB_CHECKPOINT_BYTES 65536
+
+typedef struct checkpointindex {
+
+	// number of checkpoints used and allocated
+	UINT64 count;
+	UINT64 capacity;
+
+	// slices stored in the db and the uncompressed
+	// length of the db file
+	UINT64 slices;
+	UINT64 length;
+
+	// per checkpoint: first slice of the block, byte offset
+	// of the block in the compressed file and in the
+	// uncompressed stream, and the bit offset of the first
+	// record within its byte
+	UINT64          *slice;
+	UINT64          *compressed;
+	UINT64          *uncompressed;
+	UINT8           *bit;
+
+	// reader state: raw handle on the db file and the
+	// most recently inflated block
+	FILE            *rawFile;
+	BYTE            *block;
+	UINT64 blockCapacity;
+	INT64 blockIndex;
+} *CHECKPOINTINDEX;
+
+CHECKPOINTINDEX
+bitlib_checkpoint_new(
+        UINT64 slices
+        );
+
+void
+bitlib_checkpoint_free(
+        CHECKPOINTINDEX index
+        );
+
+void
+bitlib_checkpoint_filename(
+        char *dbname,
+        char *indexname
+        );
+
+GMSTATUS
+bitlib_checkpoint_mark(
+        dbFILE file,
+        BYTE **curBuffer,
+        BYTE *outputBuffer,
+        UINT8 offset,
+        CHECKPOINTINDEX index,
+        UINT64 slice
+        );
+
+void
+bitlib_checkpoint_finish(
+        dbFILE file,
+        CHECKPOINTINDEX index
+        );
+
+GMSTATUS
+bitlib_checkpoint_save(
+        CHECKPOINTINDEX index,
+        char *dbname
+        );
+
+GMSTATUS
+bitlib_checkpoint_load(
+        char *dbname,
+        CHECKPOINTINDEX *index
+        );
+
+UINT64
+bitlib_checkpoint_find(
+        CHECKPOINTINDEX index,
+        UINT64 slice
+        );
+
+GMSTATUS
+bitlib_checkpoint_read_block(
+        CHECKPOINTINDEX index,
+        UINT64 block,
+        BYTE **buffer,
+        UINT32 *length
+        );
+
 #endif /* GMCORE_BITLIB_H */
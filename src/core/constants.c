@@ -188,14 +188,18 @@ STRING kCommandSyntaxHelp =
         "\nSyntax:\n"
         "%s  {--nodb | --newdb | --filedb | --numoptions | --curroption |\n"
         "\t--option <n> | --nobpdb | --2bit | --colldb | --univdb | --gps |\n"
-        "\t--bottomup | --alpha-beta | --lowmem | --slicessolver | --schemes |\n"
+        "\t--bottomup | --csrloopy | --alpha-beta | --lowmem | --slicessolver | --schemes |\n"
         "\t--allschemes | --adjust | --noadjust | --solve [<n> | <all>] |\n"
         "\t--analyze [ <linkname> ] | --open | --visualize |\n"
         "\t--DoMove <args> <move> | --Primitive <args> | --PrintPosition <args> |\n"
         "\t--GenerateMoves <args>} | --lightplayer | --netDb | --hashCounting |\n"
-        "\t--help}\n\n"
-        "--export <filename>\t\t\tSolves the game (if needed) then exports to filename.\n"
+        "\t--hashBench [<n>] | --help}\n\n"
+        "--export <filename>\t\t\tSolves the game (if needed) then exports to filename,\n"
+        "\t\t\tusing --threads threads. A filename ending in .gz is gzip-compressed.\n"
         "--interact\t\t\tSolves the game (if needed) then enters server interaction mode.\n"
+        "--serve <port> [<host>]\tSolves the game (if needed) then answers HTTP start/positions\n"
+        "\t\t\trequests on port with a pool of --threads workers (default 16).\n"
+        "\t\t\tListens on 127.0.0.1 unless given another IPv4 host address.\n"
         "--nodb\t\t\tStarts game without loading or saving to the database.\n"
         "--newdb\t\t\tStarts game and clobbers the old database.\n"
         "--filedb\t\tStarts game with file-based database.\n"
@@ -210,6 +214,7 @@ STRING kCommandSyntaxHelp =
 #endif
         "--gps\t\t\tStarts game with global position solver enabled.\n"
         "--bottomup\n"
+        "--csrloopy\t\tSolves loopy games with the compact (CSR) parent index solver.\n"
         "--alpha-beta\t\tStarts game with weak alpha-beta solver. \n"
         "--lowmem\t\tStarts game with low memory overhead solver enabled.\n"
         "--slicessolver\t\tWith bpdb turned on, the variable slice aware solver will be used (faster).\n"
@@ -220,6 +225,14 @@ STRING kCommandSyntaxHelp =
         "--notiers\t\tStarts game with Tier-Gamesman Mode OFF by default.\n"
         "--notiermenu\t\tThis option disables the Tier-Gamesman solver menu, and auto-solves all tiers.\n"
         "--notierprint\t\tThis option disables the printing from the Tier-Gamesman solver menu.\n"
+        "--threads <n>\t\tSolves each tier with n threads (Tier-Gamesman only). Games\n"
+        "\t\t\twhose moves aren't thread-safe still solve with 1.\n"
+        "--processes <n>\tSolves up to n tiers at once in separate processes, starting\n"
+        "\t\t\teach tier as soon as its child tiers are done (Tier-Gamesman only).\n"
+        "\t\t\tEach process uses --threads threads; with n = 0 (the menu's\n"
+        "\t\t\tdefault) n is the number of CPUs divided by --threads.\n"
+        "--rescantierdbs\t\tRebuilds the list of solved tiers from the tier DBs on disk\n"
+        "\t\t\tinstead of trusting it (Tier-Gamesman only).\n"
         "--solve [<n> | <all>]\tSolves game with the n option configuration.\n"
         "\t\t\tTo solve all option configurations of game, use <all>.\n"
         "\t\t\tIf <n> and <all> are ommited, it will solve the default\n"
@@ -238,6 +251,8 @@ STRING kCommandSyntaxHelp =
         "--lightplayer\t\tHints the database to minimize memory usage.\n"
         "--netDb\t\t\tStarts game with the network database.\n"
         "--hashCounting\t\tStarts the generic-hash counting tool instead of the game.\n"
+        "--hashBench [<n>]\tTimes the generic hash of this game on n random positions, and\n"
+        "\t\t\tchecks it from several threads. Exits with 1 on any mismatch.\n"
         "--hashtable_buckets\t(advanced) Sets the total number of buckets in any hashtables used.\n"
         "--withPen <file>\tStarts game with Anoto Pen support, reading data from <file> (with GUI only)\n"
         "--penDebug\t\tEnables Anoto Pen log messages / data saving to 'bin/pen/' (with GUI only)\n\n";
@@ -80,6 +80,18 @@ DRAWLEVEL       db_get_drawlevel        (POSITION pos);
 BOOLEAN         db_save_database        ();
 BOOLEAN         db_load_database        ();
 void            db_get_bulk             (POSITION* positions, VALUE* ValueArray, REMOTENESS* remotenessArray, int length);
+void            db_get_value_bulk       (POSITION* positions, VALUE* values, int length);
+void            db_put_value_bulk       (POSITION* positions, VALUE* values, int length);
+void            db_get_remoteness_bulk  (POSITION* positions, REMOTENESS* remotenesses, int length);
+void            db_put_remoteness_bulk  (POSITION* positions, REMOTENESS* remotenesses, int length);
+void            db_get_mex_bulk         (POSITION* positions, MEX* mexes, int length);
+void            db_put_mex_bulk         (POSITION* positions, MEX* mexes, int length);
+void            db_check_visited_bulk   (POSITION* positions, BOOLEAN* visited, int length);
+void            db_mark_visited_bulk    (POSITION* positions, int length);
+
+/* the bulk wrappers canonicalize positions this many at a time */
+#define DB_BULK_CHUNK 256
+POSITION*       db_bulk_positions       (POSITION* positions, POSITION* buffer, int length, BOOLEAN canonicalize);
 
 /*internal variables*/
 
@@ -115,6 +127,14 @@ void db_create() {
 	db_functions->load_database = db_load_database;
 	db_functions->free_db = db_free;
 	db_functions->get_bulk = db_get_bulk;
+	db_functions->get_value_bulk = db_get_value_bulk;
+	db_functions->put_value_bulk = db_put_value_bulk;
+	db_functions->get_remoteness_bulk = db_get_remoteness_bulk;
+	db_functions->put_remoteness_bulk = db_put_remoteness_bulk;
+	db_functions->get_mex_bulk = db_get_mex_bulk;
+	db_functions->put_mex_bulk = db_put_mex_bulk;
+	db_functions->check_visited_bulk = db_check_visited_bulk;
+	db_functions->mark_visited_bulk = db_mark_visited_bulk;
 }
 
 void db_destroy() {
@@ -147,7 +167,7 @@ void db_initialize() {
 
 #ifdef HAVE_GMP
 	else if(gUnivDB) {
-		db_functions = univdb_init();
+		univdb_init(db_functions);
 	}
 #endif
 
@@ -262,12 +282,59 @@ BOOLEAN db_load_database(){
 	return FALSE;
 }
 
+/* positions are already canonical here. */
 void db_get_bulk (POSITION* positions, VALUE* ValueArray, REMOTENESS* remotenessArray, int length) {
+	db_functions->get_value_bulk(positions, ValueArray, length);
+	db_functions->get_remoteness_bulk(positions, remotenessArray, length);
+}
+
+/* The fallbacks for DBs without native bulk functions. */
+void db_get_value_bulk (POSITION* positions, VALUE* values, int length) {
 	int i;
-	for (i = 0; i < length; i++) {
-		ValueArray[i] = GetValueOfPosition(positions[i]);
-		remotenessArray[i] = Remoteness(positions[i]);
-	}
+	for (i = 0; i < length; i++)
+		values[i] = db_functions->get_value(positions[i]);
+}
+
+void db_put_value_bulk (POSITION* positions, VALUE* values, int length) {
+	int i;
+	for (i = 0; i < length; i++)
+		db_functions->put_value(positions[i], values[i]);
+}
+
+void db_get_remoteness_bulk (POSITION* positions, REMOTENESS* remotenesses, int length) {
+	int i;
+	for (i = 0; i < length; i++)
+		remotenesses[i] = db_functions->get_remoteness(positions[i]);
+}
+
+void db_put_remoteness_bulk (POSITION* positions, REMOTENESS* remotenesses, int length) {
+	int i;
+	for (i = 0; i < length; i++)
+		db_functions->put_remoteness(positions[i], remotenesses[i]);
+}
+
+void db_get_mex_bulk (POSITION* positions, MEX* mexes, int length) {
+	int i;
+	for (i = 0; i < length; i++)
+		mexes[i] = db_functions->get_mex(positions[i]);
+}
+
+void db_put_mex_bulk (POSITION* positions, MEX* mexes, int length) {
+	int i;
+	for (i = 0; i < length; i++)
+		db_functions->put_mex(positions[i], mexes[i]);
+}
+
+void db_check_visited_bulk (POSITION* positions, BOOLEAN* visited, int length) {
+	int i;
+	for (i = 0; i < length; i++)
+		visited[i] = db_functions->check_visited(positions[i]);
+}
+
+void db_mark_visited_bulk (POSITION* positions, int length) {
+	int i;
+	for (i = 0; i < length; i++)
+		db_functions->mark_visited(positions[i]);
 }
 
 void CreateDatabases()
@@ -396,6 +463,19 @@ void SetRemoteness (POSITION position, REMOTENESS remoteness)
 }
 
 
+VALUE GetValueOfCanonicalPosition(POSITION position)
+{
+	return db_functions->get_value(position);
+}
+
+
+void StoreValueAndRemotenessOfCanonicalPosition(POSITION position, VALUE value, REMOTENESS remoteness)
+{
+	db_functions->put_remoteness(position, remoteness);
+	db_functions->put_value(position, value);
+}
+
+
 BOOLEAN Visited(POSITION position)
 {
 	if(gSymmetries)
@@ -475,6 +555,77 @@ BOOLEAN LoadDatabase() {
 	return db_functions->load_database();
 }
 
+/* Returns positions itself, or buffer filled with their canonical positions */
+POSITION* db_bulk_positions(POSITION* positions, POSITION* buffer, int length, BOOLEAN canonicalize) {
+	int i;
+	if (!canonicalize || !gSymmetries)
+		return positions;
+	for (i = 0; i < length; i++)
+		buffer[i] = gCanonicalPosition(positions[i]);
+	return buffer;
+}
+
+#define DB_BULK_READ_CANONICAL ((gMenuMode != Analysis) || gMenuMode == Evaluated)
+#define DB_BULK_LOOP(call) \
+	POSITION buffer[DB_BULK_CHUNK]; \
+	int done, n; \
+	for (done = 0; done < length; done += n) { \
+		n = (length - done < DB_BULK_CHUNK) ? length - done : DB_BULK_CHUNK; \
+		call; \
+	}
+
+/* Unlike the loops below, get_bulk sees the whole request at once so that
+ * networked DBs can answer it in one round trip. */
 void GetValueAndRemotenessOfPositionBulk(POSITION* positions, VALUE* ValueArray, REMOTENESS* remotenessArray, int length) {
+	POSITION *canonical = positions;
+	if (DB_BULK_READ_CANONICAL && gSymmetries && length > 0) {
+		canonical = (POSITION *) SafeMalloc(length * sizeof(POSITION));
+		db_bulk_positions(positions, canonical, length, TRUE);
+	}
+	db_functions->get_bulk(canonical, ValueArray, remotenessArray, length);
+	if (canonical != positions)
+		SafeFree(canonical);
+}
+
+/* For callers whose positions are canonical already */
+void GetValueAndRemotenessOfCanonicalPositionBulk(POSITION* positions, VALUE* ValueArray, REMOTENESS* remotenessArray, int length) {
 	db_functions->get_bulk(positions, ValueArray, remotenessArray, length);
 }
+
+void GetValueOfPositionBulk(POSITION* positions, VALUE* values, int length) {
+	DB_BULK_LOOP(db_functions->get_value_bulk(db_bulk_positions(positions + done, buffer, n, DB_BULK_READ_CANONICAL), values + done, n))
+}
+
+void StoreValueOfPositionBulk(POSITION* positions, VALUE* values, int length) {
+	int i;
+	showStatus(Update);
+	DB_BULK_LOOP(
+		POSITION* canonical = db_bulk_positions(positions + done, buffer, n, TRUE);
+		for (i = 0; i < n; i++)
+			AnalyzePosition(canonical[i], values[done + i]);
+		db_functions->put_value_bulk(canonical, values + done, n))
+}
+
+void RemotenessBulk(POSITION* positions, REMOTENESS* remotenesses, int length) {
+	DB_BULK_LOOP(db_functions->get_remoteness_bulk(db_bulk_positions(positions + done, buffer, n, DB_BULK_READ_CANONICAL), remotenesses + done, n))
+}
+
+void SetRemotenessBulk(POSITION* positions, REMOTENESS* remotenesses, int length) {
+	DB_BULK_LOOP(db_functions->put_remoteness_bulk(db_bulk_positions(positions + done, buffer, n, TRUE), remotenesses + done, n))
+}
+
+void MexLoadBulk(POSITION* positions, MEX* mexes, int length) {
+	DB_BULK_LOOP(db_functions->get_mex_bulk(db_bulk_positions(positions + done, buffer, n, TRUE), mexes + done, n))
+}
+
+void MexStoreBulk(POSITION* positions, MEX* mexes, int length) {
+	DB_BULK_LOOP(db_functions->put_mex_bulk(db_bulk_positions(positions + done, buffer, n, TRUE), mexes + done, n))
+}
+
+void VisitedBulk(POSITION* positions, BOOLEAN* visited, int length) {
+	DB_BULK_LOOP(db_functions->check_visited_bulk(db_bulk_positions(positions + done, buffer, n, TRUE), visited + done, n))
+}
+
+void MarkAsVisitedBulk(POSITION* positions, int length) {
+	DB_BULK_LOOP(db_functions->mark_visited_bulk(db_bulk_positions(positions + done, buffer, n, TRUE), n))
+}
@@ -86,6 +86,18 @@ typedef struct DB {
 
 	void (*get_bulk)(POSITION* positions, VALUE* ValueArray, REMOTENESS* remotenessArray, int length);
 
+	/* Batch versions of the functions above, for length positions that are
+	   already canonical. db_create() points these at loops over the single
+	   position functions, so a DB only replaces the ones it can do natively. */
+	void (*get_value_bulk)(POSITION* positions, VALUE* values, int length);
+	void (*put_value_bulk)(POSITION* positions, VALUE* values, int length);
+	void (*get_remoteness_bulk)(POSITION* positions, REMOTENESS* remotenesses, int length);
+	void (*put_remoteness_bulk)(POSITION* positions, REMOTENESS* remotenesses, int length);
+	void (*get_mex_bulk)(POSITION* positions, MEX* mexes, int length);
+	void (*put_mex_bulk)(POSITION* positions, MEX* mexes, int length);
+	void (*check_visited_bulk)(POSITION* positions, BOOLEAN* visited, int length);
+	void (*mark_visited_bulk)(POSITION* positions, int length);
+
 } DB_Table;
 
 typedef struct db_list_struct {
@@ -147,6 +159,11 @@ VALUE           StoreValueOfPosition    (POSITION pos, VALUE val);
 REMOTENESS      Remoteness              (POSITION pos);
 void            SetRemoteness           (POSITION pos, REMOTENESS val);
 
+/* For multithreaded solvers: the position must already be canonical, and
+   neither the analysis hook nor the status bar is touched */
+VALUE           GetValueOfCanonicalPosition (POSITION pos);
+void            StoreValueAndRemotenessOfCanonicalPosition (POSITION pos, VALUE val, REMOTENESS remoteness);
+
 /* Visited */
 BOOLEAN         Visited                 (POSITION pos);
 void            MarkAsVisited           (POSITION pos);
@@ -170,6 +187,18 @@ BOOLEAN         SaveDatabase            (void);
 BOOLEAN         LoadDatabase            (void);
 
 //bulk
+/* These take care of symmetries like their single position versions do, and
+   leave the positions array as it was. */
 void GetValueAndRemotenessOfPositionBulk(POSITION* positions, VALUE* ValueArray, REMOTENESS* remotenessArray, int length);
+void            GetValueOfPositionBulk  (POSITION* positions, VALUE* values, int length);
+void            StoreValueOfPositionBulk (POSITION* positions, VALUE* values, int length);
+void            RemotenessBulk          (POSITION* positions, REMOTENESS* remotenesses, int length);
+void            SetRemotenessBulk       (POSITION* positions, REMOTENESS* remotenesses, int length);
+void            MexLoadBulk             (POSITION* positions, MEX* mexes, int length);
+void            MexStoreBulk            (POSITION* positions, MEX* mexes, int length);
+void            VisitedBulk             (POSITION* positions, BOOLEAN* visited, int length);
+void            MarkAsVisitedBulk       (POSITION* positions, int length);
+/* Same as GetValueAndRemotenessOfPositionBulk, for positions that are canonical already */
+void GetValueAndRemotenessOfCanonicalPositionBulk(POSITION* positions, VALUE* ValueArray, REMOTENESS* remotenessArray, int length);
 
 #endif /* GMCORE_DB_H */
@@ -40,6 +40,7 @@
 
 #include "db_bman.h"
 #include "db_globals.h"
+#include "db_io.h"
 #include "db_types.h"
 
 static gamesdb_frameid gamesdb_translate(gamesdb* db,
@@ -65,22 +66,17 @@ static gamesdb_frameid gamesdb_translate(gamesdb* db,
 #endif
             }
             assert(ppn->tag != vpn);
-            if (ppn->tag != vpn) {
-                // buffer page is valid but not the one we want
-                // if (bufp->dirty[bufpage]) //if the page is dirty
-                // flush it
-                gamesdb_buf_write(db, ppn);
-                // load in the new page
-                gamesdb_buf_read(db, ppn, vpn);
-            }
-        } else {
-            // load in the new page
-            gamesdb_buf_read(db, ppn, vpn);
-            // set the tag where it is
-            // if (ppn->tag != vpn)
-            // the buffer is uninitialized, this means no record
-            // exists in the page
+            // buffer page is valid but not the one we want
+            // if the page is dirty, hand it to the I/O thread
+            gamesdb_buf_write(db, ppn);
+            ppn->valid = GAMESDB_FALSE;
+            ppn->tag = 0;
         }
+        // load in the new page
+        // if it was never written, the page comes back zeroed,
+        // meaning no record exists in the page
+        gamesdb_buf_read(db, ppn, vpn);
+        gamesdb_bman_readahead(db, vpn);
     }
 
     if (GAMESDB_DEBUG) {
@@ -127,10 +123,10 @@ gamesdb* gamesdb_create(int rec_size, gamesdb_pageid max_recs,
         exit(1);
     }
     data->store = storep;
+    data->io = gamesdb_io_init(data);
 
     // create initial page
     gamesdb_buf_addpage(data);
-    bman->clock_hand = bufp->pages;
 
     return data;
 }
@@ -138,6 +134,7 @@ gamesdb* gamesdb_create(int rec_size, gamesdb_pageid max_recs,
 void gamesdb_destroy(gamesdb* data) {
     gamesdb_bman_destroy(data->buf_man);
     gamesdb_buf_destroy(data);
+    gamesdb_io_destroy(data->io);
     gamesdb_close(data->store);
     gamesdb_SafeFree(data);
 }
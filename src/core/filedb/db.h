@@ -36,6 +36,7 @@
 #include "db_store.h"
 #include "db_buf.h"
 #include "db_bman.h"
+#include "db_io.h"
 #include "db_malloc.h"
 #include "db_basichash.h"
 
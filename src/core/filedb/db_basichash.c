@@ -35,149 +35,125 @@
 #include <assert.h>
 //#include <string.h>
 
-static gamesdb_bhashin* gamesdb_basichash_getrow(gamesdb_bhash* hash, gamesdb_pageid id) {
-	int row = id & (hash->index_size - 1);
-	return ((hash->rows) + row);
+/* open addressing with linear probing. the table is kept at most half full,
+ * so a lookup touches a slot or two instead of walking a chain of chunks.
+ */
+
+static int gamesdb_basichash_slot(gamesdb_bhash* hash, gamesdb_pageid id) {
+	return (int) ((id * 0x9E3779B97F4A7C15ULL) >> (64 - hash->index_bits));
 }
 
-//returns the pointer to the chunk for easy modification.
-//when id is found, returns the pointer to the chunk that contains the loc
-//when id is not found, returns the pointer to the chunk with the first free spot, growing the row as necessary
-static gamesdb_bhashin* gamesdb_basichash_lookupchunk(gamesdb_bhash* hash, gamesdb_pageid id){
-	gamesdb_bhashin* place = gamesdb_basichash_getrow(hash, id);
+//returns the slot holding id, or the empty slot where it would go
+static int gamesdb_basichash_probe(gamesdb_bhash* hash, gamesdb_pageid id) {
+	int mask = hash->index_size - 1;
+	int i = gamesdb_basichash_slot(hash, id);
 
-	int myid = id >> hash->index_bits;
+	while (hash->id[i] != id && hash->id[i] != GAMESDB_NOPAGE)
+		i = (i + 1) & mask;
+	return i;
+}
 
+static void gamesdb_basichash_alloc(gamesdb_bhash* hash, int ind_bits) {
 	int i;
-	gamesdb_bhashin *prev = NULL, *firstempty = NULL;
-
-	while(place != NULL) {
-		for(i=0; i<hash->chunk_size; i++) {
-			if(place->id[i] == (gamesdb_pageid) myid)
-				return place;
-			if(place->id[i] == -1ULL && firstempty == NULL)
-				firstempty = place;
-		}
-		prev = place;
-		place = place->next;
-	}
-	if(firstempty != NULL)
-		return firstempty; // this fixes the fragmentation problem.
-	//new elements are added to the first empty slot instead of at the last place.
-
-	//every row has one initial chunk, so we don't have to worry about modifying the root pointer here.
-	gamesdb_bhashin *new_chunk = (gamesdb_bhashin *) gamesdb_SafeMalloc(sizeof(gamesdb_bhashin));
-	new_chunk->loc = (gamesdb_frameid*) gamesdb_SafeMalloc(sizeof(gamesdb_frameid) * hash->chunk_size);
-	new_chunk->id = (gamesdb_pageid*) gamesdb_SafeMalloc(sizeof(gamesdb_pageid) * hash->chunk_size);
-	new_chunk->next = NULL;
-	for(i=0; i<hash->chunk_size; i++) {
-		new_chunk->id[i] = -1;
+
+	hash->index_bits = ind_bits;
+	hash->index_size = 1 << ind_bits;
+	hash->count = 0;
+	hash->id = (gamesdb_pageid*) gamesdb_SafeMalloc(sizeof(gamesdb_pageid) * hash->index_size);
+	hash->loc = (gamesdb_frameid*) gamesdb_SafeMalloc(sizeof(gamesdb_frameid) * hash->index_size);
+	for(i=0; i<hash->index_size; i++) {
+		hash->id[i] = GAMESDB_NOPAGE;
 	}
-	prev->next = new_chunk;
+}
 
-	return new_chunk;
+//doubles the table and reinserts every entry
+static void gamesdb_basichash_grow(gamesdb_bhash* hash) {
+	gamesdb_pageid* old_id = hash->id;
+	gamesdb_frameid* old_loc = hash->loc;
+	int old_size = hash->index_size;
+	int i, slot;
+
+	gamesdb_basichash_alloc(hash, hash->index_bits + 1);
+	for(i=0; i<old_size; i++) {
+		if (old_id[i] != GAMESDB_NOPAGE) {
+			slot = gamesdb_basichash_probe(hash, old_id[i]);
+			hash->id[slot] = old_id[i];
+			hash->loc[slot] = old_loc[i];
+			hash->count++;
+		}
+	}
+	gamesdb_SafeFree(old_id);
+	gamesdb_SafeFree(old_loc);
 }
 
 /*generates and returns a db_bhash pointer to newly malloced memory.
  * the destructor frees all of the memory. Whatever calls this
  * must also call the destructor eventually.
  */
-gamesdb_bhash* gamesdb_basichash_create(int ind_bits, int chk_size){
-	int i,j;
-
+gamesdb_bhash* gamesdb_basichash_create(int ind_bits){
 	gamesdb_bhash* new = (gamesdb_bhash*) gamesdb_SafeMalloc(sizeof(gamesdb_bhash));
 
-	new->index_bits = ind_bits;
-	new->index_size = 1 << ind_bits;
-	new->chunk_size = chk_size;
-	new->rows = (gamesdb_bhashin*) gamesdb_SafeMalloc(sizeof(gamesdb_bhashin) * new->index_size);
-
-	for(i=0; i<new->index_size; i++) {
-		(new->rows)[i].loc = (gamesdb_frameid*) gamesdb_SafeMalloc(sizeof(gamesdb_frameid) * chk_size);
-		(new->rows)[i].id = (gamesdb_pageid*) gamesdb_SafeMalloc(sizeof(gamesdb_pageid) * chk_size);
-		(new->rows)[i].next = NULL;
-		for(j=0; j<chk_size; j++) {
-			(new->rows)[i].id[j] = -1;
-		}
-	}
+	gamesdb_basichash_alloc(new, ind_bits);
 
 	return new;
 }
 
-//returns the frame_id assosiated with page_id. -1 if it does not exist
+//returns the frame_id assosiated with page_id. NULL if it does not exist
 gamesdb_frameid gamesdb_basichash_get(gamesdb_bhash* hash, gamesdb_pageid id){
-	gamesdb_bhashin* mychunk = gamesdb_basichash_lookupchunk(hash, id);
-	int i;
-	int myid = id >> hash->index_bits;
-	for(i=0; i<hash->chunk_size; i++) {
-		if(mychunk->id[i] == (gamesdb_pageid) myid)
-			return mychunk->loc[i];
-	}
+	int slot = gamesdb_basichash_probe(hash, id);
 
-	return NULL;
+	if (hash->id[slot] == GAMESDB_NOPAGE)
+		return NULL;
+	return hash->loc[slot];
 }
 
 //Assosciates an id with a loc. Only one id per table. returns 0 on success.
 int gamesdb_basichash_put(gamesdb_bhash* hash, gamesdb_pageid id, gamesdb_frameid loc){
-	gamesdb_bhashin* place;
-	int i;
-
-	place = gamesdb_basichash_lookupchunk(hash,id);
+	int slot;
 
-	int firstempty = -1;
+	assert(id != GAMESDB_NOPAGE);
+	if (2 * (hash->count + 1) > hash->index_size)
+		gamesdb_basichash_grow(hash);
 
-	int myid = id >> hash->index_bits;
-	for(i=0; i < hash->chunk_size && place->id[i] != (gamesdb_pageid) myid; i++) {
-		if (place->id[i] == -1ULL && firstempty == -1) {
-			firstempty = i;
-		}
-	};
-
-	if(i == hash->chunk_size) { //firstempty must have something
-		assert(firstempty != -1);
-		place->id[firstempty] = myid;
-		place->loc[firstempty] = loc;
-		return 0;
-	}else{
-		//updating existing entry
-		place->loc[i] = loc;
-		return 0;
+	slot = gamesdb_basichash_probe(hash, id);
+	if (hash->id[slot] == GAMESDB_NOPAGE) {
+		hash->id[slot] = id;
+		hash->count++;
 	}
+	//updating existing entry otherwise
+	hash->loc[slot] = loc;
+	return 0;
 }
 
 /* removes id from the hash table. returns frame_id or NULL if id does not exist
+ * entries after it in the probe run are shifted back, so no tombstones build up.
  */
 gamesdb_frameid gamesdb_basichash_remove(gamesdb_bhash* hash, gamesdb_pageid id){
-	int i;
-	gamesdb_bhashin* place;
-
-	place = gamesdb_basichash_lookupchunk(hash,id);
-	int myid = id >> hash->index_bits;
-	for(i=0; i < hash->chunk_size && place->id[i] != (gamesdb_pageid) myid; i++) ;
-	if(i < hash->chunk_size) {
-		place->id[i] = -1;
-		return place->loc[i];
+	int mask = hash->index_size - 1;
+	int hole = gamesdb_basichash_probe(hash, id);
+	int i, home;
+	gamesdb_frameid ret;
+
+	if (hash->id[hole] == GAMESDB_NOPAGE)
+		return NULL;
+	ret = hash->loc[hole];
+
+	for (i = (hole + 1) & mask; hash->id[i] != GAMESDB_NOPAGE; i = (i + 1) & mask) {
+		home = gamesdb_basichash_slot(hash, hash->id[i]);
+		//move i into the hole unless its home lies cyclically in (hole, i]
+		if (((i - home) & mask) >= ((i - hole) & mask)) {
+			hash->id[hole] = hash->id[i];
+			hash->loc[hole] = hash->loc[i];
+			hole = i;
+		}
 	}
-	return NULL;
+	hash->id[hole] = GAMESDB_NOPAGE;
+	hash->count--;
+	return ret;
 }
 
 void gamesdb_basichash_destroy(gamesdb_bhash* hash){
-	int i;
-	gamesdb_bhashin *place,*next,*start;
-
-	for(i=0; i < hash->index_size; i++) {
-		//once per row.
-		place = hash->rows + i;
-		start = place;
-		while(place != NULL) {
-			gamesdb_SafeFree(place->loc);
-			gamesdb_SafeFree(place->id);
-			next = place->next;
-			if(place != start)
-				gamesdb_SafeFree(place);
-			place = next;
-		}
-	}
-	gamesdb_SafeFree(hash->rows);
+	gamesdb_SafeFree(hash->id);
+	gamesdb_SafeFree(hash->loc);
 	gamesdb_SafeFree(hash);
 }
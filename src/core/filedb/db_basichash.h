@@ -36,7 +36,7 @@
 #include  "db_buf.h"
 #include  "db_types.h"
 
-gamesdb_bhash*      gamesdb_basichash_create    (int ind_bits, int chk_size);
+gamesdb_bhash*      gamesdb_basichash_create    (int ind_bits);
 gamesdb_frameid     gamesdb_basichash_get       (gamesdb_bhash* hash, gamesdb_pageid id);
 gamesdb_frameid     gamesdb_basichash_remove    (gamesdb_bhash* hash, gamesdb_pageid id);
 int gamesdb_basichash_put       (gamesdb_bhash* hash, gamesdb_pageid, gamesdb_frameid );
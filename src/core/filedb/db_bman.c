@@ -35,12 +35,12 @@
 #include "db_bman.h"
 #include "db_basichash.h"
 #include "db_buf.h"
+#include "db_io.h"
 #include "db_malloc.h"
 #include <stdint.h>
 #include <inttypes.h>
 
 #define INDEX_BITLENGTH 10
-#define INDEX_CHUNKSIZE 10
 
 /* buffer replacement stratagy and replacement tools.
  * ask the buffer manager for a specific buffer to be brought into memory.
@@ -51,13 +51,14 @@
 gamesdb_bman* gamesdb_bman_init(gamesdb_buffer* bufp){
 	(void) bufp;
 	gamesdb_bman *new = (gamesdb_bman*) gamesdb_SafeMalloc(sizeof(gamesdb_bman));
-	new->hash = gamesdb_basichash_create(INDEX_BITLENGTH, INDEX_CHUNKSIZE);
-	new->clock_hand = NULL;
+	new->hash = gamesdb_basichash_create(INDEX_BITLENGTH);
+	new->clock_hand = 0;
+	new->last_miss = GAMESDB_NOPAGE;
 	return new;
 }
 
 
-/*Find's page_id and returns the location. -1 if not found.
+/*Find's page_id and returns the location. NULL if not found.
  */
 gamesdb_frameid gamesdb_bman_find(gamesdb* db, gamesdb_pageid id){
 	return gamesdb_basichash_get(db->buf_man->hash,id);
@@ -69,31 +70,18 @@ gamesdb_frameid gamesdb_bman_find(gamesdb* db, gamesdb_pageid id){
 gamesdb_frameid gamesdb_bman_replace(gamesdb* db, gamesdb_pageid vpn) {
 	gamesdb_buffer* bufp = db->buffer;
 
-	//find free space, if found make hash changes, return
-	gamesdb_bufferpage* page = bufp->pages;
-
 	gamesdb_bhash *bhash = db->buf_man->hash;
 
-	for (; page!= NULL; page = page->next) {
-		if (page->valid == GAMESDB_FALSE) {
-			gamesdb_basichash_put(bhash, vpn, page);
-			return page;
-		}
-	}
-
 	gamesdb_bufferpage *newpage;
 
 	//see if we have space for more physical pages, if so grow the memory pool
-	if (bufp->num_pages < bufp->max_pages || bufp->max_pages == 0) {
+	if (bufp->num_free == 0 && (bufp->num_pages < bufp->max_pages || bufp->max_pages == 0)) {
 
 		if (GAMESDB_DEBUG) {
 			printf("db_bufman: Growing the page pool.\n");
 		}
 
-		if ((newpage = gamesdb_buf_addpage(db)) != NULL) {
-			gamesdb_basichash_put(bhash, vpn, newpage);
-			return newpage;
-		} else { //shrink
+		if (gamesdb_buf_addpage(db) == NULL) { //shrink
 			gamesdb_pageid initial = bufp->num_pages >> 1;
 			if (initial == 0) {
 				initial = 1;
@@ -104,6 +92,13 @@ gamesdb_frameid gamesdb_bman_replace(gamesdb* db, gamesdb_pageid vpn) {
 		}
 	}
 
+	//take a free frame if there is one, if found make hash changes, return
+	if (bufp->num_free > 0) {
+		newpage = bufp->free_frames[--bufp->num_free];
+		gamesdb_basichash_put(bhash, vpn, newpage);
+		return newpage;
+	}
+
 	//otherwise, pick one from n-chance, make page table changes, and return
 	if (GAMESDB_DEBUG) {
 		printf("db_bufman: No more free pages in page table. Evicting one page using n-chance.\n");
@@ -113,29 +108,34 @@ gamesdb_frameid gamesdb_bman_replace(gamesdb* db, gamesdb_pageid vpn) {
 		printf("db_bufman: max page limit reached zero.");
 	}
 
-	page = bufp->pages;
-	gamesdb_bufferpage *ret = db->buf_man->clock_hand;
+	/* clean pages go first, since they can be dropped without a write.
+	 * the first dirty page that runs out of chances is remembered, and
+	 * taken if one more sweep turns up no clean page that has run out.
+	 */
+	int hand = db->buf_man->clock_hand;
+	int steps = 0;
+	gamesdb_bufferpage *ret, *dirty = NULL;
 
 	while(GAMESDB_TRUE) {
+		ret = bufp->frames[hand];
+		hand = (hand + 1) % bufp->num_pages;
 		if (ret->valid == GAMESDB_TRUE && ret->chances < GAMESDB_MAX_CHANCES) {
 			ret->chances++;
-		} else {
+		} else if (ret->dirty == GAMESDB_FALSE) {
 			break;
+		} else if (dirty == NULL) {
+			dirty = ret;
 		}
-		ret = ret->next;
-		if (ret == NULL) {
-			ret = page;
+		if (dirty != NULL && ++steps >= bufp->num_pages) {
+			ret = dirty;
+			break;
 		}
 	}
 	//kick off the record for the old page from page table
 	gamesdb_basichash_remove(bhash, ret->tag);
 	gamesdb_basichash_put(bhash, vpn, ret);
 
-	db->buf_man->clock_hand = ret->next;
-
-	if (db->buf_man->clock_hand == NULL) {
-		db->buf_man->clock_hand = page;
-	}
+	db->buf_man->clock_hand = (ret->index + 1) % bufp->num_pages;
 
 	if (GAMESDB_DEBUG) {
 #if defined(__LP64__) || defined(_WIN64)
@@ -148,6 +148,22 @@ gamesdb_frameid gamesdb_bman_replace(gamesdb* db, gamesdb_pageid vpn) {
 	return ret;
 }
 
+/* called after a miss on vpn. when misses run through sequential pages,
+ * the next few that are not in the buffer are read ahead.
+ */
+void gamesdb_bman_readahead(gamesdb* db, gamesdb_pageid vpn) {
+	gamesdb_pageid id;
+
+	if (db->buf_man->last_miss != GAMESDB_NOPAGE && vpn == db->buf_man->last_miss + 1) {
+		for (id = vpn + 1; id <= vpn + GAMESDB_READAHEAD_PAGES; id++) {
+			if (gamesdb_bman_find(db, id) == NULL) {
+				gamesdb_io_readahead(db, id);
+			}
+		}
+	}
+	db->buf_man->last_miss = vpn;
+}
+
 void gamesdb_bman_destroy(gamesdb_bman* bman){
 	gamesdb_basichash_destroy(bman->hash);
 	gamesdb_SafeFree(bman);
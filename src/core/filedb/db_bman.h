@@ -39,6 +39,7 @@
 gamesdb_bman*   gamesdb_bman_init(gamesdb_buffer* bufp); //,frame_id (*r_fn) (db_bman*));
 gamesdb_frameid gamesdb_bman_find(gamesdb*, gamesdb_pageid);
 gamesdb_frameid gamesdb_bman_replace(gamesdb*, gamesdb_pageid);
+void                    gamesdb_bman_readahead(gamesdb*, gamesdb_pageid);
 void                    gamesdb_bman_destroy(gamesdb_bman*);
 
 #endif /* GMCORE_DB_BMAN_H */
@@ -38,6 +38,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "db_basichash.h"
+#include "db_io.h"
 #include "db_malloc.h"
 #include "db_store.h"
 #include "db_types.h"
@@ -55,19 +57,40 @@ gamesdb_buffer *gamesdb_buf_init(gamesdb_pageid rec_size,
     bufp->max_pages = num_buf;
     bufp->rec_size = rec_size;
     bufp->buf_size = max_recs;
-    bufp->pages = NULL;
+    bufp->frames = NULL;
+    bufp->free_frames = NULL;
+    bufp->num_free = 0;
+    bufp->frame_cap = 0;
 
     return bufp;
 }
 
+// adds a frame to the pool. it goes on the free stack until
+// gamesdb_bman_replace hands it out.
 gamesdb_bufferpage *gamesdb_buf_addpage(gamesdb *db) {
+    gamesdb_buffer *bufp = db->buffer;
+    if (bufp->num_pages == bufp->frame_cap) {
+        int cap = bufp->frame_cap ? 2 * bufp->frame_cap : 16;
+        gamesdb_bufferpage **frames = (gamesdb_bufferpage **)gamesdb_SafeRealloc(
+            bufp->frames, sizeof(gamesdb_bufferpage *) * cap);
+        if (frames == NULL) {
+            return NULL;
+        }
+        bufp->frames = frames;
+        gamesdb_bufferpage **free_frames = (gamesdb_bufferpage **)gamesdb_SafeRealloc(
+            bufp->free_frames, sizeof(gamesdb_bufferpage *) * cap);
+        if (free_frames == NULL) {
+            return NULL;
+        }
+        bufp->free_frames = free_frames;
+        bufp->frame_cap = cap;
+    }
     gamesdb_bufferpage *buf =
         (gamesdb_bufferpage *)gamesdb_SafeMalloc(
             sizeof(gamesdb_bufferpage));
     if (buf == NULL) {
         return buf;
     }
-    gamesdb_buffer *bufp = db->buffer;
     buf->mem = (char *)gamesdb_SafeMalloc(
         sizeof(char) * bufp->buf_size * bufp->rec_size);
     if (buf->mem == NULL) {
@@ -78,30 +101,44 @@ gamesdb_bufferpage *gamesdb_buf_addpage(gamesdb *db) {
     buf->valid = GAMESDB_FALSE;
     buf->chances = 0;
     buf->dirty = GAMESDB_FALSE;
-    buf->next = bufp->pages;
-    bufp->pages = buf;
-    bufp->num_pages++;
+    buf->index = bufp->num_pages;
+    bufp->frames[bufp->num_pages++] = buf;
+    bufp->free_frames[bufp->num_free++] = buf;
     return buf;
 }
 
+// drops the last frame in the pool, writing its page out first.
 void gamesdb_buf_removepage(gamesdb *db) {
-    gamesdb_bufferpage *oldhead = db->buffer->pages;
-    if (oldhead == NULL) {
+    gamesdb_buffer *bufp = db->buffer;
+    if (bufp->num_pages == 0) {
         printf("db_buf: There are no pages in the pool. WTF?");
         return;
     }
-    gamesdb_bufferpage *newhead = oldhead->next;
-    if (newhead == NULL) {
+    if (bufp->num_pages == 1) {
         printf(
             "db_buf: There is only one page in the pool. Cannot "
             "shrink anymore.");
         return;
     }
-    gamesdb_buf_write(db, oldhead);
-    gamesdb_SafeFree(oldhead->mem);
-    gamesdb_SafeFree(oldhead);
-    db->buffer->pages = newhead;
-    db->buffer->num_pages--;
+    gamesdb_bufferpage *oldpage = bufp->frames[bufp->num_pages - 1];
+    if (oldpage->valid == GAMESDB_TRUE) {
+        gamesdb_buf_write(db, oldpage);
+        gamesdb_basichash_remove(db->buf_man->hash, oldpage->tag);
+    } else {
+        int i;
+        for (i = 0; i < bufp->num_free; i++) {
+            if (bufp->free_frames[i] == oldpage) {
+                bufp->free_frames[i] = bufp->free_frames[--bufp->num_free];
+                break;
+            }
+        }
+    }
+    gamesdb_SafeFree(oldpage->mem);
+    gamesdb_SafeFree(oldpage);
+    bufp->num_pages--;
+    if (db->buf_man->clock_hand >= bufp->num_pages) {
+        db->buf_man->clock_hand = 0;
+    }
 }
 
 int gamesdb_buf_flush_all(gamesdb *db) {
@@ -109,21 +146,26 @@ int gamesdb_buf_flush_all(gamesdb *db) {
     // a straight squential scan will cause ordered forward access to
     // the db_store this will be as fast as it gets int i;
     gamesdb_buffer *bufp = db->buffer;
-    gamesdb_bufferpage *buf;
+    int i;
 
-    for (buf = bufp->pages; buf != NULL; buf = buf->next) {
-        if (buf->dirty == GAMESDB_TRUE) {
-            gamesdb_buf_write(db, buf);
+    for (i = 0; i < bufp->num_pages; i++) {
+        if (bufp->frames[i]->dirty == GAMESDB_TRUE) {
+            gamesdb_buf_write(db, bufp->frames[i]);
         }
     }
+    // wait for the I/O thread, so the pages are on disk when this returns
+    gamesdb_io_sync(db);
     return 0;
 }
 
 // reads a page from disk
 int gamesdb_buf_read(gamesdb *db, gamesdb_frameid spot,
                      gamesdb_pageid vpn) {
-    // load in the new page
-    gamesdb_read(db, vpn, spot);
+    // load in the new page, unless it was read ahead or is still
+    // waiting to be written
+    if (!gamesdb_io_claim(db, spot, vpn)) {
+        gamesdb_read(db, vpn, spot);
+    }
 
     assert(spot->tag == 0 || spot->tag == vpn);
     assert(spot->dirty == GAMESDB_FALSE);
@@ -150,14 +192,14 @@ int gamesdb_buf_read(gamesdb *db, gamesdb_frameid spot,
     return 0;
 }
 
-// writes a page to disk
+// queues a page to be written to disk by the I/O thread
 int gamesdb_buf_write(gamesdb *db, gamesdb_frameid spot) {
     // gamesdb_buffer* bufp = db->buffer;
 
     // we don't have to write the page if it's clean
     if (spot->dirty == GAMESDB_TRUE) {
         spot->chances = 0;
-        gamesdb_write(db, spot->tag, spot);
+        gamesdb_io_write(db, spot);
         spot->dirty = GAMESDB_FALSE;
         if (GAMESDB_DEBUG) {
 #if defined(__LP64__) || defined(_WIN64)
@@ -177,17 +219,16 @@ int gamesdb_buf_destroy(gamesdb *db) {
     gamesdb_buf_flush_all(db);
 
     gamesdb_buffer *bufp = db->buffer;
+    int i;
 
-    gamesdb_bufferpage *current = bufp->pages;
-    gamesdb_bufferpage *nextp;
-
-    assert(current != NULL);
-    for (; current != NULL; current = nextp) {
-        nextp = current->next;
-        gamesdb_SafeFree(current->mem);
-        gamesdb_SafeFree(current);
+    assert(bufp->num_pages > 0);
+    for (i = 0; i < bufp->num_pages; i++) {
+        gamesdb_SafeFree(bufp->frames[i]->mem);
+        gamesdb_SafeFree(bufp->frames[i]);
     }
 
+    gamesdb_SafeFree(bufp->frames);
+    gamesdb_SafeFree(bufp->free_frames);
     gamesdb_SafeFree(bufp);
     return 0;  // no error checking;
 }
@@ -45,4 +45,15 @@
 
 #define GAMESDB_GEOMETRY_FILENAME "geometry.dat"
 
+#define GAMESDB_NOPAGE (-1ULL) //empty slot in the page table
+
+#define GAMESDB_WRITEBACK_DEPTH 64 //page jobs the I/O thread may have queued
+
+#define GAMESDB_READAHEAD_PAGES 4 //pages fetched ahead of a sequential miss
+#define GAMESDB_READAHEAD_SLOTS 8 //read-ahead pages held until claimed
+
+#define GAMESDB_IO_EMPTY 0
+#define GAMESDB_IO_LOADING 1
+#define GAMESDB_IO_READY 2
+
 #endif /* GMCORE_DB_GLOBALS_H */
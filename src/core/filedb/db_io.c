@@ -0,0 +1,278 @@
+/************************************************************************
+**
+** NAME:	db_io.c
+**
+** DESCRIPTION:	Background page I/O.
+**
+** AUTHOR:	GamesCrafters Research Group, UC Berkeley
+**		Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+**
+** DATE:	2005-01-11
+**
+** LICENSE:	This file is part of GAMESMAN,
+**		The Finite, Two-person Perfect-Information Game Generator
+**		Released under the GPL:
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program, in COPYING; if not, write to the Free Software
+** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+**************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "db_types.h"
+#include "db_io.h"
+#include "db_store.h"
+#include "db_malloc.h"
+
+/* one thread per database does all page file I/O off the solver's path.
+ * evicted dirty pages are copied and queued for it to gzip out, and on a
+ * run of sequential misses it reads the next few pages into read-ahead
+ * slots. jobs are done in queue order, so a read-ahead queued after a
+ * write of the same page sees that write. a miss checks the read-ahead
+ * slots, then pending writes, before going to disk itself.
+ */
+
+static void *gamesdb_io_thread(void *arg) {
+	gamesdb_io *io = (gamesdb_io *) arg;
+	gamesdb_iojob job;
+	gamesdb_ioslot *slot;
+	gamesdb_pageid tag;
+	gamesdb_boolean found = GAMESDB_FALSE;
+
+	pthread_mutex_lock(&io->lock);
+	while (GAMESDB_TRUE) {
+		while (io->count == 0 && !io->stop) {
+			pthread_cond_wait(&io->work, &io->lock);
+		}
+		if (io->count == 0) {
+			break;
+		}
+		//the job stays at the head of the ring until it is done
+		job = io->jobs[io->head];
+		slot = (job.slot < 0) ? NULL : io->readahead + job.slot;
+		pthread_mutex_unlock(&io->lock);
+
+		if (slot == NULL) {
+			gamesdb_store_put(io->db, job.tag, job.mem, job.chances);
+		} else {
+			found = gamesdb_store_get(io->db, job.tag, slot->mem, &slot->chances, &tag);
+		}
+
+		pthread_mutex_lock(&io->lock);
+		if (slot == NULL) {
+			io->spare[io->num_spare++] = job.mem;
+		} else {
+			slot->found = found;
+			slot->state = GAMESDB_IO_READY;
+		}
+		io->head = (io->head + 1) % GAMESDB_WRITEBACK_DEPTH;
+		io->count--;
+		pthread_cond_broadcast(&io->done);
+	}
+	pthread_mutex_unlock(&io->lock);
+	return NULL;
+}
+
+gamesdb_io* gamesdb_io_init(gamesdb* db) {
+	gamesdb_io *io = (gamesdb_io *) gamesdb_SafeMalloc(sizeof(gamesdb_io));
+	int i;
+
+	memset(io, 0, sizeof(gamesdb_io));
+	io->db = db;
+	for (i = 0; i < GAMESDB_READAHEAD_SLOTS; i++) {
+		io->readahead[i].state = GAMESDB_IO_EMPTY;
+	}
+	pthread_mutex_init(&io->lock, NULL);
+	pthread_cond_init(&io->work, NULL);
+	pthread_cond_init(&io->done, NULL);
+	if (pthread_create(&io->thread, NULL, gamesdb_io_thread, io) != 0) {
+		printf("db_io: could not start the I/O thread.\n");
+		exit(1);
+	}
+	return io;
+}
+
+/* queues a copy of spot's page to be written out, waiting if the queue is
+ * full. spot may be reused as soon as this returns.
+ */
+void gamesdb_io_write(gamesdb* db, gamesdb_frameid spot) {
+	gamesdb_io *io = db->io;
+	gamesdb_buffer *bufp = db->buffer;
+	gamesdb_iojob *job;
+	char *mem;
+
+	pthread_mutex_lock(&io->lock);
+	while (io->count == GAMESDB_WRITEBACK_DEPTH) {
+		pthread_cond_wait(&io->done, &io->lock);
+	}
+	if (io->num_spare > 0) {
+		mem = io->spare[--io->num_spare];
+	} else if ((mem = (char *) gamesdb_SafeMalloc(sizeof(char) * bufp->buf_size * bufp->rec_size)) == NULL) {
+		//no memory for a snapshot, write it here
+		pthread_mutex_unlock(&io->lock);
+		gamesdb_write(db, spot->tag, spot);
+		return;
+	}
+	memcpy(mem, spot->mem, sizeof(char) * bufp->buf_size * bufp->rec_size);
+
+	job = io->jobs + (io->head + io->count) % GAMESDB_WRITEBACK_DEPTH;
+	job->mem = mem;
+	job->tag = spot->tag;
+	job->chances = spot->chances;
+	job->slot = -1;
+	io->count++;
+	pthread_cond_signal(&io->work);
+	pthread_mutex_unlock(&io->lock);
+}
+
+/* fills spot with page vpn if it was read ahead or is still waiting to be
+ * written, the same way gamesdb_read would. returns FALSE if neither.
+ */
+gamesdb_boolean gamesdb_io_claim(gamesdb* db, gamesdb_frameid spot, gamesdb_pageid vpn) {
+	gamesdb_io *io = db->io;
+	gamesdb_buffer *bufp = db->buffer;
+	gamesdb_ioslot *slot;
+	gamesdb_iojob *job;
+	char *mem;
+	int i;
+
+	pthread_mutex_lock(&io->lock);
+	for (i = 0; i < GAMESDB_READAHEAD_SLOTS; i++) {
+		slot = io->readahead + i;
+		if (slot->state == GAMESDB_IO_EMPTY || slot->tag != vpn) {
+			continue;
+		}
+		while (slot->state == GAMESDB_IO_LOADING) {
+			pthread_cond_wait(&io->done, &io->lock);
+		}
+		//hand the slot's buffer to the frame and keep the frame's old one
+		mem = spot->mem;
+		spot->mem = slot->mem;
+		slot->mem = mem;
+		spot->chances = slot->chances;
+		spot->tag = slot->found ? vpn : 0;
+		spot->valid = slot->found;
+		slot->state = GAMESDB_IO_EMPTY;
+		pthread_mutex_unlock(&io->lock);
+		return GAMESDB_TRUE;
+	}
+	//newest pending write first
+	for (i = io->count - 1; i >= 0; i--) {
+		job = io->jobs + (io->head + i) % GAMESDB_WRITEBACK_DEPTH;
+		if (job->slot < 0 && job->tag == vpn) {
+			memcpy(spot->mem, job->mem, sizeof(char) * bufp->buf_size * bufp->rec_size);
+			spot->chances = job->chances;
+			spot->tag = vpn;
+			spot->valid = GAMESDB_TRUE;
+			pthread_mutex_unlock(&io->lock);
+			return GAMESDB_TRUE;
+		}
+	}
+	pthread_mutex_unlock(&io->lock);
+	return GAMESDB_FALSE;
+}
+
+/* asks the I/O thread to read page vpn into a read-ahead slot. does nothing
+ * if the queue is full or every slot is still loading. the caller makes
+ * sure vpn is not in the buffer.
+ */
+void gamesdb_io_readahead(gamesdb* db, gamesdb_pageid vpn) {
+	gamesdb_io *io = db->io;
+	gamesdb_buffer *bufp = db->buffer;
+	gamesdb_ioslot *slot = NULL;
+	gamesdb_iojob *job;
+	int i;
+
+	pthread_mutex_lock(&io->lock);
+	if (io->count == GAMESDB_WRITEBACK_DEPTH) {
+		pthread_mutex_unlock(&io->lock);
+		return;
+	}
+	for (i = 0; i < GAMESDB_READAHEAD_SLOTS; i++) {
+		if (io->readahead[i].state != GAMESDB_IO_EMPTY && io->readahead[i].tag == vpn) {
+			pthread_mutex_unlock(&io->lock);
+			return;
+		}
+		//take an empty slot, or else drop the oldest unclaimed page
+		if (io->readahead[i].state == GAMESDB_IO_EMPTY) {
+			if (slot == NULL || slot->state != GAMESDB_IO_EMPTY) {
+				slot = io->readahead + i;
+			}
+		} else if (io->readahead[i].state == GAMESDB_IO_READY) {
+			if (slot == NULL || (slot->state == GAMESDB_IO_READY && io->readahead[i].stamp < slot->stamp)) {
+				slot = io->readahead + i;
+			}
+		}
+	}
+	if (slot == NULL) {
+		pthread_mutex_unlock(&io->lock);
+		return;
+	}
+	if (slot->mem == NULL &&
+	    (slot->mem = (char *) gamesdb_SafeMalloc(sizeof(char) * bufp->buf_size * bufp->rec_size)) == NULL) {
+		pthread_mutex_unlock(&io->lock);
+		return;
+	}
+	slot->tag = vpn;
+	slot->state = GAMESDB_IO_LOADING;
+	slot->stamp = ++io->stamp;
+
+	job = io->jobs + (io->head + io->count) % GAMESDB_WRITEBACK_DEPTH;
+	job->mem = NULL;
+	job->tag = vpn;
+	job->chances = 0;
+	job->slot = (int) (slot - io->readahead);
+	io->count++;
+	pthread_cond_signal(&io->work);
+	pthread_mutex_unlock(&io->lock);
+}
+
+//waits until every queued job is done
+void gamesdb_io_sync(gamesdb* db) {
+	gamesdb_io *io = db->io;
+
+	pthread_mutex_lock(&io->lock);
+	while (io->count > 0) {
+		pthread_cond_wait(&io->done, &io->lock);
+	}
+	pthread_mutex_unlock(&io->lock);
+}
+
+void gamesdb_io_destroy(gamesdb_io* io) {
+	int i;
+
+	pthread_mutex_lock(&io->lock);
+	io->stop = GAMESDB_TRUE;
+	pthread_cond_signal(&io->work);
+	pthread_mutex_unlock(&io->lock);
+	//the thread drains the queue before it exits
+	pthread_join(io->thread, NULL);
+
+	for (i = 0; i < io->num_spare; i++) {
+		gamesdb_SafeFree(io->spare[i]);
+	}
+	for (i = 0; i < GAMESDB_READAHEAD_SLOTS; i++) {
+		if (io->readahead[i].mem != NULL) {
+			gamesdb_SafeFree(io->readahead[i].mem);
+		}
+	}
+	pthread_mutex_destroy(&io->lock);
+	pthread_cond_destroy(&io->work);
+	pthread_cond_destroy(&io->done);
+	gamesdb_SafeFree(io);
+}
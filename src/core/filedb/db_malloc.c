@@ -45,6 +45,17 @@ void* gamesdb_SafeMalloc(gamesdb_offset num_bytes){
 	return ret;
 }
 
+void* gamesdb_SafeRealloc(void* mem, gamesdb_offset num_bytes){
+	void* ret;
+
+	ret = (void*) realloc(mem, num_bytes);
+
+	if(ret == NULL)
+		fprintf(stderr,"Error in database SafeRealloc, unable to allocate space\n");
+
+	return ret;
+}
+
 void gamesdb_SafeFree(void* mem){
 	free(mem);
 }
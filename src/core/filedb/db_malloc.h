@@ -35,6 +35,7 @@
 #include "db_types.h"
 
 void* gamesdb_SafeMalloc (gamesdb_offset num_bytes);
+void* gamesdb_SafeRealloc (void* mem, gamesdb_offset num_bytes);
 void gamesdb_SafeFree(void* ptr);
 
 
@@ -95,7 +95,7 @@ gamesdb_store* gamesdb_open(gamesdb* db, char* filename, int cluster_size){
 
 	gamesdb_store* db_store = (gamesdb_store*) gamesdb_SafeMalloc(sizeof(gamesdb_store));
 
-	db_store->filename = (char*) gamesdb_SafeMalloc (sizeof(char)*strlen(filename));
+	db_store->filename = (char*) gamesdb_SafeMalloc (sizeof(char)*(strlen(filename) + 1));
 	strcpy(db_store->filename, filename);
 
 	db_store->dir_size = cluster_size;
@@ -151,11 +151,8 @@ static gamesdb_pageid gamesdb_checkpath(char *base_path, gamesdb_pageid page_no,
 	return page_no;
 }
 
-//writes a page into the database
-int gamesdb_write(gamesdb* db, gamesdb_pageid page, gamesdb_bufferpage* buf){
-
-	assert(buf->valid == GAMESDB_TRUE);
-	assert(buf->tag == page);
+//writes a page image into the database. safe to call from the I/O thread.
+int gamesdb_store_put(gamesdb* db, gamesdb_pageid page, char* mem, gamesdb_counter chances){
 
 	char filename[GAMESDB_MAX_FILENAME_LEN] = "";
 
@@ -165,23 +162,25 @@ int gamesdb_write(gamesdb* db, gamesdb_pageid page, gamesdb_bufferpage* buf){
 	sprintf(filename, "./data/%s", dbfile->filename);
 	gamesdb_checkpath(filename, page, dbfile->dir_size);
 
-	gzFile pagefile = gzopen(filename, "w+");
+	gzFile pagefile = gzopen(filename, "wb");
 
 	if (GAMESDB_DEBUG)
 		printf ("db_write: path = %s, page = %llu\n", filename, page);
 
 	//write data
 	//Remember to write data in the same order and sizes as when you read it
-	gzwrite(pagefile, (void*)(buf->mem), sizeof(char) * bufp->buf_size * bufp->rec_size);
-	gzwrite(pagefile, (void*)&(buf->chances), sizeof(gamesdb_counter));
-	gzwrite(pagefile, (void*)&(buf->tag), sizeof(gamesdb_pageid));
+	gzwrite(pagefile, (void*)mem, sizeof(char) * bufp->buf_size * bufp->rec_size);
+	gzwrite(pagefile, (void*)&chances, sizeof(gamesdb_counter));
+	gzwrite(pagefile, (void*)&page, sizeof(gamesdb_pageid));
 	//gzwrite(pagefile, (void*)&(buf->valid), sizeof(gamesdb_boolean));
 
 	gzclose(pagefile);
 	return 0;
 }
 
-int gamesdb_read(gamesdb* db, gamesdb_pageid page, gamesdb_bufferpage* buf){
+//reads a page image from the database. returns FALSE and a zeroed page if
+//it is not on disk. safe to call from the I/O thread.
+gamesdb_boolean gamesdb_store_get(gamesdb* db, gamesdb_pageid page, char* mem, gamesdb_counter* chances, gamesdb_pageid* tag){
 
 	char filename[GAMESDB_MAX_FILENAME_LEN] = "";
 
@@ -191,36 +190,49 @@ int gamesdb_read(gamesdb* db, gamesdb_pageid page, gamesdb_bufferpage* buf){
 	sprintf(filename, "./data/%s", dbfile->filename);
 	gamesdb_checkpath(filename, page, dbfile->dir_size);
 
-	gzFile pagefile = gzopen(filename, "r+");
+	gzFile pagefile = gzopen(filename, "rb");
 
 	if (GAMESDB_DEBUG) {
 		printf ("db_read: path = %s, page = %llu\n", filename, page);
 	}
 
-	if(pagefile != NULL) {
-		//read data
-		//Remember to read data in the same order and sizes as when you wrote it
-		gzread(pagefile, (void*)(buf->mem), sizeof(char) * bufp->buf_size * bufp->rec_size);
-		gzread(pagefile, (void*)&(buf->chances), sizeof(gamesdb_counter));
-		gzread(pagefile, (void*)&(buf->tag), sizeof(gamesdb_pageid));
-		//gzread(pagefile, (void*)&(buf->valid), sizeof(gamesdb_boolean));
-		buf->valid = GAMESDB_TRUE;
-		//assert(buf->valid == TRUE);
-
-	} else { //page does not exist in disk
+	if(pagefile == NULL) { //page does not exist in disk
 		if (GAMESDB_DEBUG) {
 			printf ("db_read: starting a fresh page.\n");
 		}
-		memset(buf->mem, 0, sizeof(char) * bufp->buf_size * bufp->rec_size);
-		buf->chances = 0;
-		buf->tag = 0;
-		buf->valid = GAMESDB_FALSE;
+		memset(mem, 0, sizeof(char) * bufp->buf_size * bufp->rec_size);
+		*chances = 0;
+		*tag = 0;
+		return GAMESDB_FALSE;
 	}
 
-	//the caller will take care of the dirty bit
+	//read data
+	//Remember to read data in the same order and sizes as when you wrote it
+	gzread(pagefile, (void*)mem, sizeof(char) * bufp->buf_size * bufp->rec_size);
+	gzread(pagefile, (void*)chances, sizeof(gamesdb_counter));
+	gzread(pagefile, (void*)tag, sizeof(gamesdb_pageid));
+	//gzread(pagefile, (void*)&(buf->valid), sizeof(gamesdb_boolean));
 
 	gzclose(pagefile);
 
+	return GAMESDB_TRUE;
+}
+
+//writes a page into the database
+int gamesdb_write(gamesdb* db, gamesdb_pageid page, gamesdb_bufferpage* buf){
+
+	assert(buf->valid == GAMESDB_TRUE);
+	assert(buf->tag == page);
+
+	return gamesdb_store_put(db, page, buf->mem, buf->chances);
+}
+
+int gamesdb_read(gamesdb* db, gamesdb_pageid page, gamesdb_bufferpage* buf){
+
+	buf->valid = gamesdb_store_get(db, page, buf->mem, &buf->chances, &buf->tag);
+
+	//the caller will take care of the dirty bit
+
 	return 0;
 
 }
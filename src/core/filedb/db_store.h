@@ -43,6 +43,8 @@ int             gamesdb_close           (gamesdb_store* db);
 void            gamesdb_seek            (gamesdb_store* db, gamesdb_pageid page);
 int             gamesdb_read            (gamesdb* db, gamesdb_pageid page, gamesdb_bufferpage* buf);
 int             gamesdb_write           (gamesdb* db, gamesdb_pageid page, gamesdb_bufferpage* buf);
+int             gamesdb_store_put       (gamesdb* db, gamesdb_pageid page, char* mem, gamesdb_counter chances);
+gamesdb_boolean gamesdb_store_get       (gamesdb* db, gamesdb_pageid page, char* mem, gamesdb_counter* chances, gamesdb_pageid* tag);
 //page_id       db_newPage  (db_store* db);
 
 #endif /* GMCORE_DB_FILE_H */
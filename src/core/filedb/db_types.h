@@ -2,6 +2,7 @@
 #define DB_TYPES_H_
 
 #include <zlib.h>
+#include <pthread.h>
 #include "db_globals.h"
 
 //basic types
@@ -22,7 +23,7 @@ typedef struct gamesdb_bufferpage_struct {
 	gamesdb_boolean valid;
 	gamesdb_boolean dirty;
 	gamesdb_counter chances;
-	struct gamesdb_bufferpage_struct *next;
+	int index; //position in buffer->frames
 } gamesdb_bufferpage;
 
 //physical
@@ -41,23 +42,20 @@ typedef struct dbfile_struct {
 }gamesdb_store;
 
 //hash
-typedef struct db_bhashin_struct {
-	gamesdb_frameid* loc;
-	gamesdb_pageid* id;
-	struct db_bhashin_struct* next;
-} gamesdb_bhashin;
-
-
+//open addressing page table from page id to frame. empty slots hold GAMESDB_NOPAGE.
 typedef struct {
-	int index_size;
+	gamesdb_pageid* id;
+	gamesdb_frameid* loc;
 	int index_bits;
-	int chunk_size;
-	gamesdb_bhashin* rows;
-
+	int index_size;
+	int count;
 } gamesdb_bhash;
 
 typedef struct {
-	gamesdb_bufferpage* pages;
+	gamesdb_bufferpage** frames; //every frame, indexed by bufferpage->index
+	gamesdb_bufferpage** free_frames; //stack of frames holding no page
+	int num_free;
+	int frame_cap; //allocated length of frames and free_frames
 	int rec_size; //number of bytes in a record
 	int buf_size; //number of records in a buffer
 	int num_pages; //number of pages in memory
@@ -69,14 +67,51 @@ typedef struct {
 	//gamesdb_buffer* bufp;
 	//frame_id (*replace_fun) (db_bman*);
 	gamesdb_bhash *hash;
-	gamesdb_bufferpage *clock_hand;
+	int clock_hand; //index into buffer->frames
+	gamesdb_pageid last_miss; //for spotting sequential misses
 } gamesdb_bman;
 
-//the db object, so to speak
+//background I/O
+//a page queued for the I/O thread: a snapshot to write out, or a read-ahead
 typedef struct {
+	char *mem; //write: private copy of the page. read: NULL
+	gamesdb_pageid tag;
+	gamesdb_counter chances;
+	int slot; //read: index into io->readahead. write: -1
+} gamesdb_iojob;
+
+//a page read ahead of time, waiting to be claimed by a miss
+typedef struct {
+	char *mem;
+	gamesdb_pageid tag;
+	gamesdb_counter chances;
+	gamesdb_boolean state; //GAMESDB_IO_EMPTY, _LOADING or _READY
+	gamesdb_boolean found; //FALSE if the page was not on disk
+	unsigned long long stamp; //issue order, oldest ready slot is dropped first
+} gamesdb_ioslot;
+
+typedef struct {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t work; //signalled when a job is queued or on stop
+	pthread_cond_t done; //signalled when a job finishes
+	gamesdb_iojob jobs[GAMESDB_WRITEBACK_DEPTH]; //FIFO ring, head is in progress
+	int head;
+	int count;
+	gamesdb_ioslot readahead[GAMESDB_READAHEAD_SLOTS];
+	unsigned long long stamp;
+	char *spare[GAMESDB_WRITEBACK_DEPTH]; //page buffers for write snapshots, reused
+	int num_spare;
+	gamesdb_boolean stop;
+	struct gamesdb_struct *db;
+} gamesdb_io;
+
+//the db object, so to speak
+typedef struct gamesdb_struct {
 	gamesdb_bman* buf_man;
 	gamesdb_buffer* buffer;
 	gamesdb_store* store;
+	gamesdb_io* io;
 	//gamesdb_pageid num_page;
 } gamesdb;
 
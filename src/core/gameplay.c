@@ -34,6 +34,7 @@
 
 #include "gamesman.h"
 #include "httpclient.h"
+#include "netdb.h"
 #include "openPositions.h"
 #include "globals.h"
 #include "seval.h"
@@ -1684,7 +1685,44 @@ VALUE_MOVES* SortMoves (POSITION thePosition, MOVE move, VALUE_MOVES* valueMoves
 }
 
 
+static int ComparePositions(const void *a, const void *b)
+{
+	POSITION x = *(const POSITION *) a, y = *(const POSITION *) b;
+	return (x < y) ? -1 : (x > y);
+}
+
 /* GamesCrafters Network Team 4/20/06 */
+/* Whichever move is made next, GetValueMoves will need the values of that
+ * child's children. Ask the network DB for all of them now so the answers
+ * arrive while the player is thinking. The lookups will ask for canonical
+ * positions, so those are what get prefetched, each one once. */
+static void NetworkPrefetchGrandchildren(POSITION *children, int numChildren)
+{
+	POSITIONLIST *grandchildren = NULL, *walker;
+	POSITION *positions;
+	MOVELIST *moves, *ptr;
+	int i, j, count = 0;
+
+	for (i = 0; i < numChildren; i++) {
+		if (Primitive(children[i]) != undecided)
+			continue;
+		moves = GenerateMoves(children[i]);
+		for (ptr = moves; ptr != NULL; ptr = ptr->next, count++)
+			grandchildren = StorePositionInList(DoMove(children[i], ptr->move), grandchildren);
+		FreeMoveList(moves);
+	}
+	positions = (POSITION *) SafeMalloc((count + 1) * sizeof(POSITION));
+	for (i = 0, walker = grandchildren; walker != NULL; walker = walker->next)
+		positions[i++] = gSymmetries ? gCanonicalPosition(walker->position) : walker->position;
+	qsort(positions, count, sizeof(POSITION), ComparePositions);
+	for (i = j = 0; i < count; i++)
+		if (j == 0 || positions[i] != positions[j - 1])
+			positions[j++] = positions[i];
+	netdb_prefetch(positions, j);
+	SafeFree(positions);
+	FreePositionList(grandchildren);
+}
+
 VALUE_MOVES* NetworkSortMoves (POSITION thePosition, MOVELIST* head, VALUE_MOVES* valueMoves)
 {
 	POSITION *childArray;
@@ -1737,6 +1775,8 @@ VALUE_MOVES* NetworkSortMoves (POSITION thePosition, MOVELIST* head, VALUE_MOVES
 		}
 	}
 
+	NetworkPrefetchGrandchildren(childArray, lengthOfMoveList);
+
 	SafeFree(childArray);
 	SafeFree(childValueArray);
 	SafeFree(remotenessArray);
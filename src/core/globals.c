@@ -90,6 +90,7 @@ BOOLEAN gAlphaBeta = FALSE;
 BOOLEAN gGlobalPositionSolver = FALSE;
 BOOLEAN gUseGPS = FALSE;
 BOOLEAN gBottomUp = FALSE;        /* Default is no bottom up solving, should enable for only win4 */
+BOOLEAN gCSRLoopySolver = FALSE;  /* Loopy solver with array parent index and frontiers, default: FALSE */
 BOOLEAN gZeroMemSolver = FALSE;   /* Zero Memory Overhead Solver, default: FALSE */
 BOOLEAN gAnalyzing = FALSE;       /* Write analysis for each variant
                                    * solved, default: FALSE */
@@ -150,6 +151,9 @@ BOOLEAN gDontLoadTierDB = FALSE;
 unsigned int HASHTABLE_BUCKETS = 1024;
 BOOLEAN gTierSolvePrint = TRUE;
 BOOLEAN gTotalTiers = 0;
+int gTierSolverThreads = 1;
+int gTierSolverProcesses = 0; /* 0 = CPUs / gTierSolverThreads */
+BOOLEAN gTierDBRescan = FALSE; /* rebuild the solve manifest from the tier DBs */
 // For the hash window
 BOOLEAN gHashWindowInitialized = FALSE;
 BOOLEAN gCurrentTierIsLoopy = FALSE;
@@ -165,6 +169,7 @@ BOOLEAN kSupportsTierGamesman = FALSE;
 BOOLEAN kSupportsShardGamesman = FALSE;
 BOOLEAN kUsesQuartoGamesman = FALSE;
 BOOLEAN kExclusivelyTierGamesman = FALSE;
+BOOLEAN kSupportsThreads = FALSE; /* module callbacks may run on several threads at once */
 BOOLEAN kDebugTierMenu = FALSE;
 TIERPOSITION gInitialTierPosition = -1;
 TIER gInitialTier = -1;
@@ -183,9 +188,8 @@ void (*gPositionToStringFunPtr)(POSITION,char*) = NULL;
 POSITION (*gRandomInitialPositionFunPtr)(void) = NULL;
 
 BOOLEAN kUsePureDraw = FALSE;
-// For the experimental GenerateMoves
-int (*gGenerateMovesEfficientFunPtr)(POSITION) = NULL;
-MOVE*           gGenerateMovesArray = NULL;
+// Array move generation, NULL for games that only build a MOVELIST
+int (*gGenerateMovesArrayFunPtr)(POSITION,MOVE*,int) = NULL;
 int MAXFANOUT = 100;
 
 /* Variables for the parallelized solver */
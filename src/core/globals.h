@@ -14,7 +14,7 @@ extern BOOLEAN gStandardGame, gSaveDatabase, gLoadDatabase,
                gBitPerfectDB, gBitPerfectDBSolver, gBitPerfectDBSchemes, gBitPerfectDBAllSchemes, gBitPerfectDBAdjust, gBitPerfectDBVerbose, gBitPerfectDBZeroMemoryPlayer,
                gTwoBits, gCollDB, gUnivDB, gFileDB,
                gGlobalPositionSolver, gZeroMemSolver,
-               gAnalyzing, gSymmetries, gUseGPS, gBottomUp, gAlphaBeta, gUseOpen, gWinBy, gInterestingness, gWinByClose,
+               gAnalyzing, gSymmetries, gUseGPS, gBottomUp, gCSRLoopySolver, gAlphaBeta, gUseOpen, gWinBy, gInterestingness, gWinByClose,
                gIncludeInterestingnessWithAnalysis,
                gVisTiers, gVisTiersPlain, gSolveOnlyTier, gIsInteract, gLoadTierdbArray;
 
@@ -146,6 +146,9 @@ extern BOOLEAN gDontLoadTierDB;
 extern unsigned int HASHTABLE_BUCKETS;
 extern BOOLEAN gTierSolvePrint;
 extern BOOLEAN gTotalTiers;
+extern int gTierSolverThreads;
+extern int gTierSolverProcesses;
+extern BOOLEAN gTierDBRescan;
 // For the hash window
 extern BOOLEAN gHashWindowInitialized;
 extern BOOLEAN gCurrentTierIsLoopy;
@@ -160,6 +163,7 @@ extern BOOLEAN kSupportsTierGamesman;
 extern BOOLEAN kSupportsShardGamesman;
 extern BOOLEAN kUsesQuartoGamesman;
 extern BOOLEAN kExclusivelyTierGamesman;
+extern BOOLEAN kSupportsThreads;
 extern BOOLEAN kDebugTierMenu;
 extern TIERPOSITION gInitialTierPosition;
 extern TIER gInitialTier;
@@ -175,10 +179,11 @@ extern void (*gPositionStringToAutoGUIPositionStringFunPtr)(char*,char*);
 extern void (*gPositionStringDoMoveFunPtr)(char*,MOVE,char*);
 extern void (*gPositionToStringFunPtr)(POSITION,char*);
 extern POSITION (*gRandomInitialPositionFunPtr)(void);
-// For the experimental GenerateMoves
-extern int (*gGenerateMovesEfficientFunPtr)(POSITION);
-extern MOVE*            gGenerateMovesArray;
-extern int MAXFANOUT;
+// Array move generation: writes at most capacity moves of the position to
+// moves and returns how many moves it has. NULL for games that only build a
+// MOVELIST; GenerateMovesToBuffer() handles both.
+extern int (*gGenerateMovesArrayFunPtr)(POSITION,MOVE*,int);
+extern int MAXFANOUT;           // first capacity of a MOVEBUFFER
 
 /* Variables for the parallelized solver */
 extern BOOLEAN gParallelizing;
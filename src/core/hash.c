@@ -31,6 +31,8 @@
 **************************************************************************/
 
 #include "gamesman.h"
+#include <pthread.h>
+#include <time.h>
 
 /*********************************************************************************
 *** A *PERFECT* hash function -
@@ -40,7 +42,8 @@
 ***   and implemented by Attila Gyulassy
 *********************************************************************************/
 
-#define cCon contextList[currentContext]
+#define hash_current_index() (hashThreadContext >= 0 ? hashThreadContext : currentContext)
+#define cCon contextList[hash_current_index()]
 #define combiHash(x,y,z) ((x*y)+z)
 #define combiUnM(x,y)  (x%y)
 #define combiUnD(x,y) (x/y)
@@ -51,10 +54,29 @@
 #define UNKNOWN -1
 #define RECT 0
 #define HEX 1
+#define HASH_RANK_TABLE_MAX (1 << 20)   /* most rank table entries a context may build */
+#define HASH_RANK_TABLE_BUDGET (1 << 24)        /* most rank table entries of all contexts together */
+#define HASH_FAST_MAX_PIECES 32
+#define HASH_BATCH_PARALLEL_MIN 65536   /* smallest batch split across threads */
+#define HASH_CHECK_THREADS 2            /* threads the benchmark hashes from at once */
+#define HASH_CHECK_ROUNDS 4             /* passes each of them makes over the samples */
+#define SYM_MAX_CELLS 256       /* largest board the symmetry tables handle */
+#define SYM_MAX_IMAGES 64       /* most symmetries the symmetry tables handle */
 /* Global Variables */
 struct hashContext **contextList = NULL;
 int hash_tot_context = 0, currentContext = 0;
+/* The thread that made the contexts owns currentContext. Any other thread
+   that switches gets its own current context in hashThreadContext, and
+   follows currentContext until it does. */
+static __thread int hashThreadContext = -1;
+static pthread_t hashOwnerThread;
+/* Scratch arrays of each thread, freed when the thread exits */
+static __thread HASH_SCRATCH *hashThreadScratch = NULL;
+static pthread_key_t hashScratchKey;
+static pthread_once_t hashScratchOnce = PTHREAD_ONCE_INIT;
+static int hash_max_pieces = 0;         // most pieces of any context so far
 BOOLEAN custom_contexts_mode = FALSE;
+long long hash_rank_table_entries = 0;
 /* Hashtable Stuff */
 // Using a MOVELIST just to get ints
 MOVELIST** generic_hash_hashtable = NULL;
@@ -66,6 +88,13 @@ int numSymmetries = 1;  // we'll always have the identity.
 int symBoardRows = 0;
 int symBoardCols = 0;
 struct symEntry* symmetriesList = NULL;
+/* symmetriesList after the identity, packed for generic_hash_canonicalPosition():
+   symPerms[s*symTableCells + i] is sym[i] of the s-th symmetry */
+int *symPerms = NULL;
+char *symFlips = NULL;
+int symTableImages = 0, symTableCells = 0;
+void buildSymmetryTables();
+POSITION legacyCanonicalPosition(struct hashContext* ctx, HASH_SCRATCH* scratch, POSITION pos);
 struct symEntry* new_sym_entry(int symType, int symAngle, int flip);
 void composeSymmetries();
 BOOLEAN sym_exists(int symType, int symAngle);
@@ -97,15 +126,28 @@ int convert(int row, int col, int boardType);
 void            hash_combiCalc();
 void            freeHashContext(int contextNum);
 int             validConfig(int *t);
-int             searchIndices(int s);
-int             searchOffset(POSITION h);
-POSITION        combiCount(int* tc);
+int             searchIndices(struct hashContext* ctx, int s);
+int             searchOffset(struct hashContext* ctx, POSITION h);
+POSITION        combiCount(struct hashContext* ctx, int* tc);
 int             hash_countPieces(int *pA);
-POSITION        hash_cruncher (char* board);
-POSITION        hash_cruncher_sym (char* board, struct symEntry* symIndex);
-void            hash_uncruncher (POSITION hashed, char *dest);
+POSITION        hash_cruncher (struct hashContext* ctx, HASH_SCRATCH* scratch, char* board);
+POSITION        hash_cruncher_sym (struct hashContext* ctx, HASH_SCRATCH* scratch, char* board, struct symEntry* symIndex);
+void            hash_uncruncher (struct hashContext* ctx, HASH_SCRATCH* scratch, POSITION hashed, char *dest);
+static int      hash_context_index(int context);
+static void     hash_select_context(int index);
+static HASH_SCRATCH* hash_scratch_fit(HASH_SCRATCH* scratch, int numPieces);
+static POSITION hash_legacy_hash(struct hashContext* ctx, HASH_SCRATCH* scratch, char* board, BOOLEAN scan);
+static POSITION hash_hash_sym(struct hashContext* ctx, HASH_SCRATCH* scratch, char* board, int player, POSITION offset, struct symEntry* symIndex);
+static void     hash_legacy_unhash(struct hashContext* ctx, HASH_SCRATCH* scratch, POSITION hashed, char* dest, BOOLEAN scan);
+static int      hash_scan_indices(struct hashContext* ctx, int s);
+static int      hash_scan_offset(struct hashContext* ctx, POSITION h);
+static void     hash_build_offset_tables(void);
+static void     hash_build_rank_tables(void);
+static long long hash_rank_table_size(struct hashContext* ctx);
+static BOOLEAN  hash_fast_hash(struct hashContext* ctx, char* board, POSITION* result);
+static void     hash_fast_unhash(struct hashContext* ctx, POSITION hashed, char* dest);
 int             getPieceParams(int *pa,char *pi,int *mi,int *ma);
-POSITION        nCr(int n, int r);
+POSITION        nCr(struct hashContext* ctx, int n, int r);
 void            nCr_init(int a);
 int*            gpd (int n);
 int             gpi (int n);
@@ -184,7 +226,7 @@ POSITION generic_hash_init(int boardsize, int *pieces_array, int (*fn)(int *), i
 
 	newcntxt = generic_hash_context_init();
 
-	currentContext = newcntxt; //context switch
+	hash_select_context(newcntxt); //context switch
 
 	cCon->numPieces = hash_countPieces(pieces_array);
 	cCon->gfn = fn;
@@ -193,11 +235,9 @@ POSITION generic_hash_init(int boardsize, int *pieces_array, int (*fn)(int *), i
 	cCon->mins = (int*) SafeMalloc (sizeof(int) * cCon->numPieces);
 	cCon->maxs = (int*) SafeMalloc (sizeof(int) * cCon->numPieces);
 	cCon->nums = (int*) SafeMalloc (sizeof(int) * cCon->numPieces);
-	cCon->thisCount = (int*) SafeMalloc (sizeof(int) * cCon->numPieces);
-	cCon->localMins = (int*) SafeMalloc (sizeof(int) * cCon->numPieces);
 	cCon->gpdStore = (int*) SafeMalloc (sizeof(int) * cCon->numPieces);
-	cCon->miniOffset = (POSITION*) SafeMalloc (sizeof(POSITION) * (cCon->numPieces+2));
-	cCon->miniIndices = (int*) SafeMalloc (sizeof(int) * (cCon->numPieces+2));
+	if (cCon->numPieces > hash_max_pieces)
+		hash_max_pieces = cCon->numPieces;
 
 	getPieceParams(pieces_array, cCon->pieces, cCon->mins,cCon->maxs);
 	for (i = 0; i < cCon->numPieces; i++) {
@@ -226,7 +266,7 @@ POSITION generic_hash_init(int boardsize, int *pieces_array, int (*fn)(int *), i
 	cCon->hashOffset[0] = 0;
 	cCon->offsetIndices[0] = 0;
 	for (k = 1; k <= cCon->usefulSpace; k++) {
-		cCon->hashOffset[k] = combiCount(gPieceDist(k-1));
+		cCon->hashOffset[k] = combiCount(cCon, gPieceDist(k-1));
 		cCon->offsetIndices[k] = gpi(k-1);
 	}
 	cCon->hashOffset[k] = -1;
@@ -249,6 +289,9 @@ POSITION generic_hash_init(int boardsize, int *pieces_array, int (*fn)(int *), i
 
 	cCon->player = player % 3;         // ensures player is either 0, 1, or 2
 
+	hash_build_offset_tables();
+	hash_build_rank_tables();
+
 	if (cCon->player != 0)
 		return sofar;
 	else return sofar*2;
@@ -323,7 +366,7 @@ void hash_combiCalc()
 		for(i=0; i<cCon->numPieces; i++) {
 			sums = combiHash(sums,cCon->nums[i],thPieces[i]);
 		}
-		cCon->combiArray[sums] = combiCount(thPieces);
+		cCon->combiArray[sums] = combiCount(cCon, thPieces);
 		thPieces[0]++;
 		i=0;
 		while(i<(cCon->numPieces-1) && thPieces[i] > cCon->maxs[i]) {
@@ -343,128 +386,148 @@ void hash_combiCalc()
 
 /* hashes *board to a POSITION */
 POSITION generic_hash_hash(char* board, int player) {
+	return generic_hash_hash_ctx(cCon, NULL, board, player);
+}
+
+POSITION generic_hash_hash_ctx(struct hashContext* ctx, HASH_SCRATCH* scratch, char* board, int player) {
+	POSITION temp;
+
+	if (ctx->rankTable == NULL || !hash_fast_hash(ctx, board, &temp))
+		temp = hash_legacy_hash(ctx, hash_scratch_fit(scratch, ctx->numPieces), board, FALSE);
+	if (temp > ctx->maxPos) {
+		ExitStageRightErrorString("generic_hash encountered position larger than maxPos.");
+	}
+	if (ctx->player != 0) // using single-player boards, ignore "player"
+		return temp;
+	else return temp + (player-1)*(ctx->maxPos); //accomodates generic_hash_turn
+}
+
+/* hashes *board without the rank tables, ignoring the player. scan finds
+   the configuration with the linear scan the offset tables replaced, for
+   the benchmark. */
+static POSITION hash_legacy_hash(struct hashContext* ctx, HASH_SCRATCH* scratch, char* board, BOOLEAN scan) {
 	int i, j;
 	POSITION temp, sum;
-	int boardSize = cCon->boardSize; /*hash_boardSize;*/
+	int boardSize = ctx->boardSize; /*hash_boardSize;*/
 
-	for (i = 0; i < cCon->numPieces; i++)
+	for (i = 0; i < ctx->numPieces; i++)
 	{
-		cCon->thisCount[i] = 0;
-		cCon->localMins[i] = cCon->mins[i];
+		scratch->thisCount[i] = 0;
+		scratch->localMins[i] = ctx->mins[i];
 	}
 
 	for (i = 0; i < boardSize; i++)
 	{
-		for (j = 0; j < cCon->numPieces; j++) {
-			if (board[i] == cCon->pieces[j]) {
-				cCon->thisCount[j]++;
+		for (j = 0; j < ctx->numPieces; j++) {
+			if (board[i] == ctx->pieces[j]) {
+				scratch->thisCount[j]++;
 			}
 		}
 	}
 	sum = 0;
-	for (i = cCon->numPieces-1; i >= 0; i--)
+	for (i = ctx->numPieces-1; i >= 0; i--)
 	{
-		sum += (cCon->thisCount[i] - cCon->mins[i]);
+		sum += (scratch->thisCount[i] - ctx->mins[i]);
 		if (i > 0) {
-			sum *= cCon->nums[i-1];
+			sum *= ctx->nums[i-1];
 		}
 	}
-	temp = cCon->hashOffset[searchIndices(sum)];
-	temp += hash_cruncher(board);
-	if (temp > cCon->maxPos) {
-		ExitStageRightErrorString("generic_hash encountered position larger than maxPos.");
-	}
-	if (cCon->player != 0) // using single-player boards, ignore "player"
-		return temp;
-	else return temp + (player-1)*(cCon->maxPos); //accomodates generic_hash_turn
+	temp = ctx->hashOffset[scan ? hash_scan_indices(ctx, sum) : searchIndices(ctx, sum)];
+	temp += hash_cruncher(ctx, scratch, board);
+	return temp;
 }
 
 //accomodates generic_hash_turn and symmetries
 POSITION generic_hash_hash_sym(char* board, int player, POSITION offset, struct symEntry* symIndex)
+{
+	return hash_hash_sym(cCon, hash_scratch_fit(NULL, cCon->numPieces), board, player, offset, symIndex);
+}
+
+static POSITION hash_hash_sym(struct hashContext* ctx, HASH_SCRATCH* scratch, char* board, int player, POSITION offset, struct symEntry* symIndex)
 {
 	int i, j;
 	POSITION temp;
-	int boardSize = cCon->boardSize; /*hash_boardSize;*/
+	int boardSize = ctx->boardSize; /*hash_boardSize;*/
 
 	if (symIndex == NULL)
 		ExitStageRightErrorString("Invalid symmetry");
 
-	for (i = 0; i < cCon->numPieces; i++)
+	for (i = 0; i < ctx->numPieces; i++)
 	{
-		cCon->thisCount[i] = 0;
-		cCon->localMins[i] = cCon->mins[i];
+		scratch->thisCount[i] = 0;
+		scratch->localMins[i] = ctx->mins[i];
 	}
 
 	for (i = 0; i < boardSize; i++)
 	{
-		for (j = 0; j < cCon->numPieces; j++) {
-			if (board[symIndex->sym[i]] == cCon->pieces[j]) {
-				cCon->thisCount[j]++;
+		for (j = 0; j < ctx->numPieces; j++) {
+			if (board[symIndex->sym[i]] == ctx->pieces[j]) {
+				scratch->thisCount[j]++;
 			}
 		}
 	}
-	temp = offset + hash_cruncher_sym(board, symIndex);
-	if (cCon->player != 0) // using single-player boards, ignore "player"
+	temp = offset + hash_cruncher_sym(ctx, scratch, board, symIndex);
+	if (ctx->player != 0) // using single-player boards, ignore "player"
 		return temp;
-	else return temp + (player-1)*(cCon->maxPos); //accomodates generic_hash_turn
+	else return temp + (player-1)*(ctx->maxPos); //accomodates generic_hash_turn
 }
 
 /* helper func from generic_hash_unhash() computes lexicographic rank of *board
    among boards with the same configuration argument *thiscount */
-POSITION hash_cruncher (char* board)
+POSITION hash_cruncher (struct hashContext* ctx, HASH_SCRATCH* scratch, char* board)
 {
 	POSITION sum = 0;
 	int i = 0, k = 0, max1 = 0;
-	int boardSize = cCon->boardSize;
+	int boardSize = ctx->boardSize;
 
 	for(; boardSize>1; boardSize--) {
 		i = 0;
 
-		while (board[boardSize - 1] != cCon->pieces[i])
+		while (board[boardSize - 1] != ctx->pieces[i])
 			i++;
 		for (k = 0; k < i; k++) {
 			max1 = 1;
-			if (cCon->localMins[k] > 1)
-				max1 = cCon->localMins[k];
+			if (scratch->localMins[k] > 1)
+				max1 = scratch->localMins[k];
 
-			if (cCon->thisCount[k] >= max1) {
-				cCon->thisCount[k]--;
-				sum += combiCount(cCon->thisCount);
-				cCon->thisCount[k]++;
+			if (scratch->thisCount[k] >= max1) {
+				scratch->thisCount[k]--;
+				sum += combiCount(ctx, scratch->thisCount);
+				scratch->thisCount[k]++;
 			}
 		}
-		cCon->thisCount[i]--;
-		cCon->localMins[i]--;
+		scratch->thisCount[i]--;
+		scratch->localMins[i]--;
 	}
 
 	return sum;
 }
 
 // symmetry version
-POSITION hash_cruncher_sym (char* board, struct symEntry* symIndex)
+POSITION hash_cruncher_sym (struct hashContext* ctx, HASH_SCRATCH* scratch, char* board, struct symEntry* symIndex)
 {
 	POSITION sum = 0;
 	int i = 0, k = 0, max1 = 0;
-	int boardSize = cCon->boardSize;
+	int boardSize = ctx->boardSize;
 
 	for(; boardSize>1; boardSize--) {
 		i = 0;
 
-		while (board[symIndex->sym[boardSize - 1]] != cCon->pieces[i])
+		while (board[symIndex->sym[boardSize - 1]] != ctx->pieces[i])
 			i++;
 		for (k = 0; k < i; k++) {
 			max1 = 1;
-			if (cCon->localMins[k] > 1)
-				max1 = cCon->localMins[k];
+			if (scratch->localMins[k] > 1)
+				max1 = scratch->localMins[k];
 
-			if (cCon->thisCount[k] >= max1) {
-				cCon->thisCount[k]--;
-				sum += combiCount(cCon->thisCount);
-				cCon->thisCount[k]++;
+			if (scratch->thisCount[k] >= max1) {
+				scratch->thisCount[k]--;
+				sum += combiCount(ctx, scratch->thisCount);
+				scratch->thisCount[k]++;
 			}
 		}
-		cCon->thisCount[i]--;
-		cCon->localMins[i]--;
+		scratch->thisCount[i]--;
+		scratch->localMins[i]--;
 	}
 
 	return sum;
@@ -473,9 +536,14 @@ POSITION hash_cruncher_sym (char* board, struct symEntry* symIndex)
 /* tells whose move it is, given a board's hash number */
 int generic_hash_turn (POSITION hashed)
 {
-	if (cCon->player != 0)         // using single-player boards
-		return cCon->player;
-	else return hashed >= cCon->maxPos ? 2 : 1;
+	return generic_hash_turn_ctx(cCon, hashed);
+}
+
+int generic_hash_turn_ctx (struct hashContext* ctx, POSITION hashed)
+{
+	if (ctx->player != 0)         // using single-player boards
+		return ctx->player;
+	else return hashed >= ctx->maxPos ? 2 : 1;
 }
 
 
@@ -497,60 +565,833 @@ char* generic_hash_unhash_tcl(POSITION pos)
 /* unhashes hashed to a board */
 char* generic_hash_unhash(POSITION hashed, char* dest)
 {
-	POSITION offst;
-	int i, j;
-	hashed %= cCon->maxPos; //accomodates generic_hash_turn
+	return generic_hash_unhash_ctx(cCon, NULL, hashed, dest);
+}
 
-	j = searchOffset(hashed);
-	offst = cCon->hashOffset[j];
-	hashed -= offst;
-	for (i = 0; i < cCon->numPieces; i++) {
-		cCon->localMins[i] = cCon->mins[i];
-		cCon->thisCount[i] = gpd(cCon->offsetIndices[j + 1] - 1)[i];
-	}
-	hash_uncruncher(hashed, dest);
+char* generic_hash_unhash_ctx(struct hashContext* ctx, HASH_SCRATCH* scratch, POSITION hashed, char* dest)
+{
+	hashed %= ctx->maxPos; //accomodates generic_hash_turn
+
+	if (ctx->rankTable != NULL)
+		hash_fast_unhash(ctx, hashed, dest);
+	else hash_legacy_unhash(ctx, hash_scratch_fit(scratch, ctx->numPieces), hashed, dest, FALSE);
 	return dest;
 }
 
+/* unhashes hashed (already reduced mod maxPos) without the rank tables;
+   scan as for hash_legacy_hash() */
+static void hash_legacy_unhash(struct hashContext* ctx, HASH_SCRATCH* scratch, POSITION hashed, char* dest, BOOLEAN scan)
+{
+	int i, j, k;
+
+	j = scan ? hash_scan_offset(ctx, hashed) : searchOffset(ctx, hashed);
+	hashed -= ctx->hashOffset[j];
+	k = ctx->offsetIndices[j + 1] - 1;
+	for (i = 0; i < ctx->numPieces; i++) {
+		scratch->localMins[i] = ctx->mins[i];
+		scratch->thisCount[i] = ctx->mins[i] + (k % (ctx->nums[i]));
+		k = k/(ctx->nums[i]);
+	}
+	hash_uncruncher(ctx, scratch, hashed, dest);
+}
+
 /* helper func from generic_hash_hash() computes a board, given its lexicographic rank hashed
    among boards with the same configuration argument *thiscount*/
-void hash_uncruncher (POSITION hashed, char *dest)
+void hash_uncruncher (struct hashContext* ctx, HASH_SCRATCH* scratch, POSITION hashed, char *dest)
 {
 	int i = 0, j = 0;
 	int max1 = 0;
-	int boardSize = cCon->boardSize;
+	int boardSize = ctx->boardSize;
+	int *thisCount = scratch->thisCount, *localMins = scratch->localMins, *miniIndices = scratch->miniIndices;
+	POSITION *miniOffset = scratch->miniOffset;
 
 	for(; boardSize>0; boardSize--) {
 		if (boardSize == 1) {
 			i = 0;
-			while (cCon->thisCount[i] == 0)
+			while (thisCount[i] == 0)
 				i++;
-			dest[0] = cCon->pieces[i];
+			dest[0] = ctx->pieces[i];
 		} else {
-			cCon->miniOffset[0] = 0;
-			cCon->miniIndices[0] = 0;
+			miniOffset[0] = 0;
+			miniIndices[0] = 0;
 			j = 1;
-			for (i = 0; (i < cCon->numPieces) && (cCon->miniOffset[j-1] <= hashed); i++) {
+			for (i = 0; (i < ctx->numPieces) && (miniOffset[j-1] <= hashed); i++) {
 				max1 = 1;
-				if (cCon->localMins[i] > 1)
-					max1 = cCon->localMins[i];
-				if (cCon->thisCount[i] >= max1) {
-					cCon->thisCount[i]--;
-					cCon->miniOffset[j] = cCon->miniOffset[j-1] + combiCount(cCon->thisCount);
-					cCon->thisCount[i]++;
-					cCon->miniIndices[j] = i;
+				if (localMins[i] > 1)
+					max1 = localMins[i];
+				if (thisCount[i] >= max1) {
+					thisCount[i]--;
+					miniOffset[j] = miniOffset[j-1] + combiCount(ctx, thisCount);
+					thisCount[i]++;
+					miniIndices[j] = i;
 					j++;
 				}
 			}
 			i = j-1;
-			cCon->thisCount[cCon->miniIndices[i]]--;
-			cCon->localMins[cCon->miniIndices[i]]--;
-			dest[boardSize-1] = cCon->pieces[cCon->miniIndices[i]];
-			hashed = hashed - cCon->miniOffset[i-1];
+			thisCount[miniIndices[i]]--;
+			localMins[miniIndices[i]]--;
+			dest[boardSize-1] = ctx->pieces[miniIndices[i]];
+			hashed = hashed - miniOffset[i-1];
+		}
+
+	}
+
+}
+
+/*************************************
+**
+**      Scratch
+**
+**  The legacy paths count pieces in arrays sized by the context. Each
+**  thread keeps one set, grown to the most pieces of any context, so
+**  threads can hash in the same context at once.
+**
+*************************************/
+
+static void hash_scratch_free(void *arg)
+{
+	HASH_SCRATCH *scratch = (HASH_SCRATCH *) arg;
+
+	SafeFree(scratch->thisCount);
+	SafeFree(scratch->localMins);
+	SafeFree(scratch->miniOffset);
+	SafeFree(scratch->miniIndices);
+	SafeFree(scratch);
+}
+
+static void hash_scratch_key_init(void)
+{
+	pthread_key_create(&hashScratchKey, hash_scratch_free);
+}
+
+/* makes scratch big enough for numPieces pieces */
+static void hash_scratch_grow(HASH_SCRATCH* scratch, int numPieces)
+{
+	/* a new scratch has nothing to give back yet */
+	if (scratch->thisCount != NULL) SafeFree(scratch->thisCount);
+	if (scratch->localMins != NULL) SafeFree(scratch->localMins);
+	if (scratch->miniOffset != NULL) SafeFree(scratch->miniOffset);
+	if (scratch->miniIndices != NULL) SafeFree(scratch->miniIndices);
+	scratch->thisCount = (int*) SafeMalloc(sizeof(int) * numPieces);
+	scratch->localMins = (int*) SafeMalloc(sizeof(int) * numPieces);
+	scratch->miniOffset = (POSITION*) SafeMalloc(sizeof(POSITION) * (numPieces+2));
+	scratch->miniIndices = (int*) SafeMalloc(sizeof(int) * (numPieces+2));
+	scratch->size = numPieces;
+}
+
+/* the calling thread's scratch, made on first use */
+HASH_SCRATCH* generic_hash_scratch(void)
+{
+	HASH_SCRATCH *scratch = hashThreadScratch;
+
+	if (scratch == NULL) {
+		pthread_once(&hashScratchOnce, hash_scratch_key_init);
+		scratch = (HASH_SCRATCH *) SafeMalloc(sizeof(HASH_SCRATCH));
+		scratch->thisCount = scratch->localMins = scratch->miniIndices = NULL;
+		scratch->miniOffset = NULL;
+		hash_scratch_grow(scratch, hash_max_pieces > 0 ? hash_max_pieces : 1);
+		pthread_setspecific(hashScratchKey, scratch);
+		hashThreadScratch = scratch;
+	} else if (scratch->size < hash_max_pieces) {
+		hash_scratch_grow(scratch, hash_max_pieces);
+	}
+	return scratch;
+}
+
+/* scratch, or the calling thread's if NULL, with room for numPieces pieces */
+static HASH_SCRATCH* hash_scratch_fit(HASH_SCRATCH* scratch, int numPieces)
+{
+	if (scratch == NULL)
+		scratch = hashThreadScratch != NULL ? hashThreadScratch : generic_hash_scratch();
+	if (scratch->size < numPieces)
+		hash_scratch_grow(scratch, numPieces);
+	return scratch;
+}
+
+
+
+/*************************************
+**
+**      Offset Tables
+**
+**  Hashing needs the hashOffset slot of a board's piece configuration,
+**  and unhashing the slot a position falls in. Rather than scanning
+**  hashOffset from the top, each context keeps the slot of every
+**  configuration index, and a copy of hashOffset in Eytzinger (BFS)
+**  order that a branchless binary search walks from the root.
+**
+*************************************/
+
+/* fills slotTree from node k down with the slots from slot on, in order;
+   returns the next slot */
+static int hash_fill_slot_tree(struct hashContext* ctx, int slot, int k)
+{
+	if (k <= ctx->usefulSpace + 1) {
+		slot = hash_fill_slot_tree(ctx, slot, 2*k);
+		ctx->slotTree[k] = ctx->hashOffset[slot];
+		ctx->slotTreeIndex[k] = slot++;
+		slot = hash_fill_slot_tree(ctx, slot, 2*k + 1);
+	}
+	return slot;
+}
+
+/* builds the offset tables of the current context */
+static void hash_build_offset_tables(void)
+{
+	struct hashContext *ctx = cCon;
+	int i, m;
+
+	ctx->cfgSlots = (int*) SafeMalloc(sizeof(int) * ctx->numCfgs);
+	for (i = 0, m = 0; i < ctx->numCfgs; i++) {
+		while (m < ctx->usefulSpace && ctx->offsetIndices[m+1] <= i)
+			m++;
+		ctx->cfgSlots[i] = m;
+	}
+	ctx->slotTree = (POSITION*) SafeMalloc(sizeof(POSITION) * (ctx->usefulSpace + 2));
+	ctx->slotTreeIndex = (int*) SafeMalloc(sizeof(int) * (ctx->usefulSpace + 2));
+	hash_fill_slot_tree(ctx, 0, 1);
+}
+
+/*************************************
+**
+**      Rank Tables
+**
+**  hash_cruncher() and hash_uncruncher() call combiCount() for every
+**  piece of every cell. For most contexts, the sums they build can be
+**  tabulated once at init time, over every vector of piece counts up to
+**  the maxima. After that, a hash is one table lookup per cell and an
+**  unhash is at most numPieces lookups per cell. These paths only read
+**  the context, so several threads may use them at once.
+**
+*************************************/
+
+/* builds the rank tables of the current context, unless they'd be too big */
+static void hash_build_rank_tables(void)
+{
+	struct hashContext *ctx = cCon;
+	int numPieces = ctx->numPieces;
+	int i, j, k, count, total;
+	long long size = 1;
+	POSITION *multinomials, prod, hold, sum;
+
+	if (numPieces <= 0 || numPieces > HASH_FAST_MAX_PIECES || ctx->boardSize <= 0)
+		return;
+	for (j = 0; j < numPieces; j++) {
+		size *= ctx->maxs[j] + 1;
+		if (size * numPieces > HASH_RANK_TABLE_MAX)
+			return;
+	}
+	if (hash_rank_table_entries + size * numPieces > HASH_RANK_TABLE_BUDGET)
+		return;
+	memset(ctx->pieceIndex, -1, sizeof(ctx->pieceIndex));
+	for (j = 0; j < numPieces; j++) {
+		if (ctx->pieceIndex[(unsigned char) ctx->pieces[j]] != -1)
+			return;
+		ctx->pieceIndex[(unsigned char) ctx->pieces[j]] = j;
+	}
+
+	ctx->rankStrides = (int*) SafeMalloc(sizeof(int) * numPieces);
+	ctx->cfgStrides = (int*) SafeMalloc(sizeof(int) * numPieces);
+	ctx->rankStrides[0] = ctx->cfgStrides[0] = 1;
+	for (j = 1; j < numPieces; j++) {
+		ctx->rankStrides[j] = ctx->rankStrides[j-1] * (ctx->maxs[j-1] + 1);
+		ctx->cfgStrides[j] = ctx->cfgStrides[j-1] * ctx->nums[j-1];
+	}
+
+	/* multinomials of every counts vector; ones that can't occur on a board
+	   (too many pieces, or too many boards to count) are left at 0 */
+	multinomials = (POSITION*) SafeMalloc(sizeof(POSITION) * size);
+	for (i = 0; i < size; i++) {
+		k = i;
+		total = 0;
+		prod = 1;
+		for (j = 0; j < numPieces && prod != 0; j++) {
+			count = k % (ctx->maxs[j] + 1);
+			k /= ctx->maxs[j] + 1;
+			total += count;
+			if (total > ctx->boardSize) {
+				prod = 0;
+			} else {
+				hold = nCr(ctx, total, count);
+				prod = (prod > ((POSITION) -1) / hold) ? 0 : prod * hold;
+			}
 		}
+		multinomials[i] = prod;
+	}
+
+	ctx->rankTable = (POSITION*) SafeMalloc(sizeof(POSITION) * size * numPieces);
+	for (i = 0; i < size; i++) {
+		k = i;
+		sum = 0;
+		for (j = 0; j < numPieces; j++) {
+			ctx->rankTable[i*numPieces + j] = sum;
+			if (k % (ctx->maxs[j] + 1) > 0)
+				sum += multinomials[i - ctx->rankStrides[j]];
+			k /= ctx->maxs[j] + 1;
+		}
+	}
+	SafeFree(multinomials);
+	hash_rank_table_entries += size * numPieces;
+}
+
+/* number of entries in the rank table of ctx */
+static long long hash_rank_table_size(struct hashContext* ctx)
+{
+	return (long long) ctx->rankStrides[ctx->numPieces-1] *
+	       (ctx->maxs[ctx->numPieces-1] + 1) * ctx->numPieces;
+}
+
+/* hashes *board like hash_legacy_hash(); FALSE if it holds a character that
+   isn't a piece or a piece count outside its bounds */
+static BOOLEAN hash_fast_hash(struct hashContext* ctx, char* board, POSITION* result)
+{
+	int counts[HASH_FAST_MAX_PIECES];
+	int numPieces = ctx->numPieces;
+	int i, p, index = 0, cfg = 0;
+	POSITION rank = 0;
+
+	for (p = 0; p < numPieces; p++)
+		counts[p] = 0;
+	for (i = 0; i < ctx->boardSize; i++) {
+		p = ctx->pieceIndex[(unsigned char) board[i]];
+		if (p < 0)
+			return FALSE;
+		counts[p]++;
+	}
+	for (p = 0; p < numPieces; p++) {
+		if (counts[p] < ctx->mins[p] || counts[p] > ctx->maxs[p])
+			return FALSE;
+		index += counts[p] * ctx->rankStrides[p];
+		cfg += (counts[p] - ctx->mins[p]) * ctx->cfgStrides[p];
+	}
+	for (i = ctx->boardSize - 1; i > 0; i--) {
+		p = ctx->pieceIndex[(unsigned char) board[i]];
+		rank += ctx->rankTable[index*numPieces + p];
+		index -= ctx->rankStrides[p];
+	}
+	*result = ctx->hashOffset[ctx->cfgSlots[cfg]] + rank;
+	return TRUE;
+}
+
+/* fills counts with the piece counts of the configuration in slot, and
+   returns their counts index */
+static int hash_fast_counts(struct hashContext* ctx, int slot, int* counts)
+{
+	int p, k = ctx->pieceIndices[slot], index = 0;
 
+	for (p = 0; p < ctx->numPieces; p++) {
+		counts[p] = ctx->mins[p] + k % ctx->nums[p];
+		k /= ctx->nums[p];
+		index += counts[p] * ctx->rankStrides[p];
 	}
+	return index;
+}
 
+/* unhashes hashed (already reduced mod maxPos) like hash_uncruncher() */
+static void hash_fast_unhash(struct hashContext* ctx, POSITION hashed, char* dest)
+{
+	int counts[HASH_FAST_MAX_PIECES];
+	int numPieces = ctx->numPieces;
+	int i, p, slot, index;
+	POSITION *row;
+
+	slot = searchOffset(ctx, hashed);
+	hashed -= ctx->hashOffset[slot];
+	index = hash_fast_counts(ctx, slot, counts);
+	for (i = ctx->boardSize - 1; i > 0; i--) {
+		row = ctx->rankTable + index*numPieces;
+		for (p = numPieces - 1; counts[p] == 0 || row[p] > hashed; p--)
+			;
+		hashed -= row[p];
+		counts[p]--;
+		index -= ctx->rankStrides[p];
+		dest[i] = ctx->pieces[p];
+	}
+	for (p = 0; counts[p] == 0; p++)
+		;
+	dest[0] = ctx->pieces[p];
+}
+
+/* slot of the configuration reached by turning one oldPiece of the
+   configuration in slot into a newPiece, or -1 if that isn't a
+   configuration of this context */
+static int hash_fast_change_slot(struct hashContext* ctx, int slot, int* counts, int oldPiece, int newPiece)
+{
+	int cfg;
+
+	if (counts[oldPiece] <= ctx->mins[oldPiece] || counts[newPiece] >= ctx->maxs[newPiece])
+		return -1;
+	cfg = ctx->pieceIndices[slot] - ctx->cfgStrides[oldPiece] + ctx->cfgStrides[newPiece];
+	slot = ctx->cfgSlots[cfg];
+	if (slot >= ctx->usefulSpace || ctx->pieceIndices[slot] != cfg)
+		return -1;
+	return slot;
+}
+
+/* returns the hash of *board with board[cell] set to piece, and sets it.
+   hashed must be the hash of *board before the change. Only the cells
+   from cell upward are ranked again, so changes near the end of the board
+   are cheapest. */
+POSITION generic_hash_rehash(POSITION hashed, char* board, int cell, char piece, int player)
+{
+	return generic_hash_rehash_ctx(cCon, NULL, hashed, board, cell, piece, player);
+}
+
+POSITION generic_hash_rehash_ctx(struct hashContext* ctx, HASH_SCRATCH* scratch, POSITION hashed, char* board, int cell, char piece, int player)
+{
+	int counts[HASH_FAST_MAX_PIECES];
+	int numPieces = ctx->numPieces;
+	int i, p, oldPiece, newPiece, slot, newSlot, oldIndex, newIndex;
+	POSITION oldRank = 0, newRank = 0;
+
+	if (cell < 0 || cell >= ctx->boardSize)
+		ExitStageRightErrorString("generic_hash_rehash: cell is off the board");
+	if (ctx->rankTable == NULL) {
+		board[cell] = piece;
+		return generic_hash_hash_ctx(ctx, scratch, board, player);
+	}
+	oldPiece = ctx->pieceIndex[(unsigned char) board[cell]];
+	newPiece = ctx->pieceIndex[(unsigned char) piece];
+	if (oldPiece < 0 || newPiece < 0) {
+		board[cell] = piece;
+		return generic_hash_hash_ctx(ctx, scratch, board, player);
+	}
+	hashed %= ctx->maxPos;
+	if (oldPiece != newPiece) {
+		slot = searchOffset(ctx, hashed);
+		oldIndex = hash_fast_counts(ctx, slot, counts);
+		newSlot = hash_fast_change_slot(ctx, slot, counts, oldPiece, newPiece);
+		if (newSlot < 0) {
+			board[cell] = piece;
+			return generic_hash_hash_ctx(ctx, scratch, board, player);
+		}
+		newIndex = oldIndex - ctx->rankStrides[oldPiece] + ctx->rankStrides[newPiece];
+		for (i = ctx->boardSize - 1; i >= cell && i > 0; i--) {
+			p = ctx->pieceIndex[(unsigned char) board[i]];
+			oldRank += ctx->rankTable[oldIndex*numPieces + p];
+			oldIndex -= ctx->rankStrides[p];
+			if (i == cell)
+				p = newPiece;
+			newRank += ctx->rankTable[newIndex*numPieces + p];
+			newIndex -= ctx->rankStrides[p];
+		}
+		board[cell] = piece;
+		hashed = ctx->hashOffset[newSlot] + (hashed - ctx->hashOffset[slot]) - oldRank + newRank;
+	}
+	if (ctx->player != 0) // using single-player boards, ignore "player"
+		return hashed;
+	else return hashed + (player-1)*(ctx->maxPos);
+}
+
+/*************************************
+**
+**      Batched Hashing
+**
+**  The batch calls work on count boards of boardSize characters packed
+**  one after another. Big batches are split across gTierSolverThreads
+**  threads, each hashing with its own scratch.
+**
+*************************************/
+
+typedef struct hash_batch_job {
+	struct hashContext *ctx;
+	char *boards;
+	int *players;
+	POSITION *positions;
+	int begin, end;
+} HASH_BATCH_JOB;
+
+static void *hash_batch_hash_worker(void *arg)
+{
+	HASH_BATCH_JOB *job = (HASH_BATCH_JOB *) arg;
+	struct hashContext *ctx = job->ctx;
+	char *board;
+	int i;
+
+	for (i = job->begin; i < job->end; i++) {
+		board = job->boards + (size_t) i * ctx->boardSize;
+		if (ctx->rankTable == NULL || !hash_fast_hash(ctx, board, &job->positions[i]) ||
+		    job->positions[i] > ctx->maxPos) {
+			job->positions[i] = generic_hash_hash_ctx(ctx, NULL, board, job->players == NULL ? 1 : job->players[i]);
+			continue;
+		}
+		if (ctx->player == 0 && job->players != NULL)
+			job->positions[i] += (job->players[i] - 1) * ctx->maxPos;
+	}
+	return NULL;
+}
+
+static void *hash_batch_unhash_worker(void *arg)
+{
+	HASH_BATCH_JOB *job = (HASH_BATCH_JOB *) arg;
+	struct hashContext *ctx = job->ctx;
+	int i;
+
+	for (i = job->begin; i < job->end; i++)
+		generic_hash_unhash_ctx(ctx, NULL, job->positions[i], job->boards + (size_t) i * ctx->boardSize);
+	return NULL;
+}
+
+/* runs worker over [0, count) in gTierSolverThreads pieces, or in one if
+   the batch is small; returns the number of jobs left in jobs */
+static int hash_batch_run(HASH_BATCH_JOB *jobs, void *(*worker)(void *), int count)
+{
+	pthread_t *threads;
+	int numJobs = 1, i, started;
+
+	if (gTierSolverThreads > 1 && count >= HASH_BATCH_PARALLEL_MIN)
+		numJobs = gTierSolverThreads;
+	for (i = 0; i < numJobs; i++) {
+		jobs[i] = jobs[0];
+		jobs[i].begin = (int) ((long long) count * i / numJobs);
+		jobs[i].end = (int) ((long long) count * (i + 1) / numJobs);
+	}
+	if (numJobs == 1) {
+		worker(&jobs[0]);
+		return 1;
+	}
+	threads = (pthread_t *) SafeMalloc(sizeof(pthread_t) * numJobs);
+	for (started = 1; started < numJobs; started++)
+		if (pthread_create(&threads[started], NULL, worker, &jobs[started]) != 0)
+			break;
+	worker(&jobs[0]);
+	for (i = started; i < numJobs; i++)
+		worker(&jobs[i]);
+	for (i = 1; i < started; i++)
+		pthread_join(threads[i], NULL);
+	SafeFree(threads);
+	return numJobs;
+}
+
+/* hashes count boards into dest. players[i] is whose turn it is on board i;
+   players may be NULL for contexts that ignore the player. */
+void generic_hash_hash_batch(char* boards, int* players, POSITION* dest, int count)
+{
+	HASH_BATCH_JOB *jobs;
+
+	if (count <= 0)
+		return;
+	jobs = (HASH_BATCH_JOB *) SafeMalloc(sizeof(HASH_BATCH_JOB) * (gTierSolverThreads > 1 ? gTierSolverThreads : 1));
+	jobs[0].ctx = cCon;
+	jobs[0].boards = boards;
+	jobs[0].players = players;
+	jobs[0].positions = dest;
+	hash_batch_run(jobs, hash_batch_hash_worker, count);
+	SafeFree(jobs);
+}
+
+/* unhashes count positions into dest, boardSize characters apiece */
+void generic_hash_unhash_batch(POSITION* hashed, char* dest, int count)
+{
+	HASH_BATCH_JOB *jobs;
+
+	if (count <= 0)
+		return;
+	jobs = (HASH_BATCH_JOB *) SafeMalloc(sizeof(HASH_BATCH_JOB) * (gTierSolverThreads > 1 ? gTierSolverThreads : 1));
+	jobs[0].ctx = cCon;
+	jobs[0].boards = dest;
+	jobs[0].players = NULL;
+	jobs[0].positions = hashed;
+	hash_batch_run(jobs, hash_batch_unhash_worker, count);
+	SafeFree(jobs);
+}
+
+/*************************************
+**
+**      Benchmark
+**
+*************************************/
+
+static double hash_bench_seconds(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void hash_bench_report(STRING name, double legacy, double fast, int count)
+{
+	if (legacy > 0)
+		printf("  %-16s %9.1f ns  %9.1f ns  %6.1fx\n", name,
+		       legacy * 1e9 / count, fast * 1e9 / count, legacy / fast);
+	else
+		printf("  %-16s %12s  %9.1f ns\n", name, "", fast * 1e9 / count);
+}
+
+/* what one thread of hash_bench_threads() checks, and what it found */
+typedef struct hashThreadCheck
+{
+	struct hashContext *ctx;
+	POSITION *positions;
+	char *boards;           // positions unhashed by the calling thread
+	int count;
+	int mismatches;
+} HASH_THREAD_CHECK;
+
+static void *hash_bench_thread(void *arg)
+{
+	HASH_THREAD_CHECK *check = (HASH_THREAD_CHECK *) arg;
+	struct hashContext *ctx = check->ctx;
+	char *board = (char *) SafeMalloc(ctx->boardSize);
+	HASH_SCRATCH *scratch = hash_scratch_fit(NULL, ctx->numPieces); // this thread's own
+	int i, round;
+
+	for (round = 0; round < HASH_CHECK_ROUNDS; round++) {
+		for (i = 0; i < check->count; i++) {
+			hash_legacy_unhash(ctx, scratch, check->positions[i], board, FALSE);
+			if (memcmp(board, check->boards + (size_t) i * ctx->boardSize, ctx->boardSize) != 0
+			    || hash_legacy_hash(ctx, scratch, board, FALSE) != check->positions[i])
+				check->mismatches++;
+			/* and through the entry points, which find the context and scratch themselves */
+			generic_hash_unhash(check->positions[i], board);
+			if (generic_hash_hash(board, 1) != check->positions[i])
+				check->mismatches++;
+		}
+	}
+	SafeFree(board);
+	return NULL;
+}
+
+/* hashes and unhashes count positions on the legacy path from
+   HASH_CHECK_THREADS threads at once, against what the calling thread got;
+   returns how many results differ */
+static int hash_bench_threads(struct hashContext* ctx, HASH_SCRATCH* scratch, POSITION* positions, int count)
+{
+	HASH_THREAD_CHECK checks[HASH_CHECK_THREADS];
+	pthread_t threads[HASH_CHECK_THREADS];
+	char *boards = (char *) SafeMalloc((size_t) count * ctx->boardSize);
+	int i, started = 0, mismatches = 0;
+	double start;
+
+	for (i = 0; i < count; i++)
+		hash_legacy_unhash(ctx, scratch, positions[i], boards + (size_t) i * ctx->boardSize, FALSE);
+	start = hash_bench_seconds();
+	for (i = 0; i < HASH_CHECK_THREADS; i++) {
+		checks[i].ctx = ctx;
+		checks[i].positions = positions;
+		checks[i].boards = boards;
+		checks[i].count = count;
+		checks[i].mismatches = 0;
+		if (pthread_create(&threads[i], NULL, hash_bench_thread, &checks[i]) != 0)
+			break;
+		started++;
+	}
+	for (i = 0; i < started; i++) {
+		pthread_join(threads[i], NULL);
+		mismatches += checks[i].mismatches;
+	}
+	if (started < HASH_CHECK_THREADS)
+		mismatches++; // couldn't check at all
+	printf("  %d threads, %d legacy round trips each: %.2f s. Mismatches: %d\n",
+	       started, 2 * HASH_CHECK_ROUNDS * count, hash_bench_seconds() - start, mismatches);
+	SafeFree(boards);
+	return mismatches;
+}
+
+/* times the legacy paths with the linear scans and with the offset tables
+   on count positions; returns how many results differ */
+static int hash_bench_offset_tables(struct hashContext* ctx, HASH_SCRATCH* scratch, POSITION* positions, int count)
+{
+	char *boards, *tableBoards;
+	POSITION *rehashed;
+	int i, boardSize = ctx->boardSize, mismatches = 0;
+	double start, scan, tables;
+
+	boards = (char *) SafeMalloc((size_t) count * boardSize);
+	tableBoards = (char *) SafeMalloc((size_t) count * boardSize);
+	rehashed = (POSITION *) SafeMalloc(sizeof(POSITION) * count);
+	printf("  %-16s %12s  %12s   (%d configurations)\n", "", "scans", "offset tables", ctx->usefulSpace);
+
+	start = hash_bench_seconds();
+	for (i = 0; i < count; i++)
+		hash_legacy_unhash(ctx, scratch, positions[i], boards + (size_t) i * boardSize, TRUE);
+	scan = hash_bench_seconds() - start;
+	start = hash_bench_seconds();
+	for (i = 0; i < count; i++)
+		hash_legacy_unhash(ctx, scratch, positions[i], tableBoards + (size_t) i * boardSize, FALSE);
+	tables = hash_bench_seconds() - start;
+	hash_bench_report("legacy unhash", scan, tables, count);
+	if (memcmp(boards, tableBoards, (size_t) count * boardSize) != 0)
+		mismatches++;
+
+	start = hash_bench_seconds();
+	for (i = 0; i < count; i++)
+		rehashed[i] = hash_legacy_hash(ctx, scratch, boards + (size_t) i * boardSize, TRUE);
+	scan = hash_bench_seconds() - start;
+	for (i = 0; i < count; i++)
+		if (rehashed[i] != positions[i])
+			mismatches++;
+	start = hash_bench_seconds();
+	for (i = 0; i < count; i++)
+		rehashed[i] = hash_legacy_hash(ctx, scratch, boards + (size_t) i * boardSize, FALSE);
+	tables = hash_bench_seconds() - start;
+	hash_bench_report("legacy hash", scan, tables, count);
+	for (i = 0; i < count; i++)
+		if (rehashed[i] != positions[i])
+			mismatches++;
+
+	start = hash_bench_seconds();
+	for (i = 0; i < count; i++)
+		rehashed[i] = hash_scan_offset(ctx, positions[i]);
+	scan = hash_bench_seconds() - start;
+	start = hash_bench_seconds();
+	for (i = 0; i < count; i++)
+		if (searchOffset(ctx, positions[i]) != (int) rehashed[i])
+			mismatches++;
+	tables = hash_bench_seconds() - start;
+	hash_bench_report("offset lookup", scan, tables, count);
+
+	SafeFree(boards);
+	SafeFree(tableBoards);
+	SafeFree(rehashed);
+	return mismatches;
+}
+
+/* times the legacy and rank table paths on samples random positions of the
+   current context, and checks that they agree, also when threads hash at
+   once; returns how many results differ */
+int generic_hash_benchmark(int samples)
+{
+	struct hashContext *ctx = cCon;
+	HASH_SCRATCH *scratch = hash_scratch_fit(NULL, ctx->numPieces);
+	POSITION *positions, *rehashed;
+	POSITION state = 0x9E3779B97F4A7C15ULL;
+	char *boards, *fastBoards, *pieces;
+	int *cells, *counts, i, j, slot, boardSize = ctx->boardSize, mismatches = 0, changes = 0;
+	int oldPiece, newPiece;
+	double start, legacy, fast;
+
+	if (samples <= 0)
+		samples = 200000;
+	printf("\nGeneric hash context %d: board size %d, %d pieces, " POSITION_FORMAT " positions, %d samples\n",
+	       generic_hash_cur_context(), boardSize, ctx->numPieces, ctx->maxPos, samples);
+	positions = (POSITION *) SafeMalloc(sizeof(POSITION) * samples);
+	for (i = 0; i < samples; i++) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		positions[i] = (state >> 1) % ctx->maxPos;
+	}
+	mismatches = hash_bench_offset_tables(ctx, scratch, positions, samples);
+	mismatches += hash_bench_threads(ctx, scratch, positions, samples);
+	if (ctx->rankTable == NULL) {
+		printf("  This context is too big for rank tables. Mismatches: %d\n\n", mismatches);
+		SafeFree(positions);
+		return mismatches;
+	}
+
+	rehashed = (POSITION *) SafeMalloc(sizeof(POSITION) * samples);
+	boards = (char *) SafeMalloc((size_t) samples * boardSize);
+	fastBoards = (char *) SafeMalloc((size_t) samples * boardSize);
+	cells = (int *) SafeMalloc(sizeof(int) * samples);
+	pieces = (char *) SafeMalloc(sizeof(char) * samples);
+	counts = (int *) SafeMalloc(sizeof(int) * HASH_FAST_MAX_PIECES);
+	printf("  %-16s %12s  %12s\n", "", "legacy", "rank tables");
+
+	start = hash_bench_seconds();
+	for (i = 0; i < samples; i++)
+		hash_legacy_unhash(ctx, scratch, positions[i], boards + (size_t) i * boardSize, FALSE);
+	legacy = hash_bench_seconds() - start;
+	start = hash_bench_seconds();
+	for (i = 0; i < samples; i++)
+		generic_hash_unhash(positions[i], fastBoards + (size_t) i * boardSize);
+	fast = hash_bench_seconds() - start;
+	hash_bench_report("unhash", legacy, fast, samples);
+	if (memcmp(boards, fastBoards, (size_t) samples * boardSize) != 0)
+		mismatches++;
+
+	start = hash_bench_seconds();
+	for (i = 0; i < samples; i++)
+		rehashed[i] = hash_legacy_hash(ctx, scratch, boards + (size_t) i * boardSize, FALSE);
+	legacy = hash_bench_seconds() - start;
+	for (i = 0; i < samples; i++)
+		if (rehashed[i] != positions[i])
+			mismatches++;
+	start = hash_bench_seconds();
+	for (i = 0; i < samples; i++)
+		rehashed[i] = generic_hash_hash(boards + (size_t) i * boardSize, 1);
+	fast = hash_bench_seconds() - start;
+	hash_bench_report("hash", legacy, fast, samples);
+	for (i = 0; i < samples; i++)
+		if (rehashed[i] != positions[i])
+			mismatches++;
+
+	memset(fastBoards, 0, (size_t) samples * boardSize);
+	start = hash_bench_seconds();
+	generic_hash_unhash_batch(positions, fastBoards, samples);
+	fast = hash_bench_seconds() - start;
+	hash_bench_report("unhash batch", 0, fast, samples);
+	if (memcmp(boards, fastBoards, (size_t) samples * boardSize) != 0)
+		mismatches++;
+	start = hash_bench_seconds();
+	generic_hash_hash_batch(fastBoards, NULL, rehashed, samples);
+	fast = hash_bench_seconds() - start;
+	hash_bench_report("hash batch", 0, fast, samples);
+	for (i = 0; i < samples; i++)
+		if (rehashed[i] != positions[i])
+			mismatches++;
+
+	/* single cell changes that stay within the context's configurations */
+	for (i = 0; i < samples; i++) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		cells[i] = -1;
+		j = (int) ((state >> 33) % boardSize);
+		oldPiece = ctx->pieceIndex[(unsigned char) boards[(size_t) i * boardSize + j]];
+		newPiece = (int) ((state >> 17) % ctx->numPieces);
+		slot = searchOffset(ctx, positions[i]);
+		hash_fast_counts(ctx, slot, counts);
+		if (oldPiece != newPiece && hash_fast_change_slot(ctx, slot, counts, oldPiece, newPiece) >= 0) {
+			cells[i] = j;
+			pieces[i] = ctx->pieces[newPiece];
+			changes++;
+		}
+	}
+	if (changes > 0) {
+		memcpy(fastBoards, boards, (size_t) samples * boardSize);
+		start = hash_bench_seconds();
+		for (i = 0; i < samples; i++)
+			if (cells[i] >= 0) {
+				fastBoards[(size_t) i * boardSize + cells[i]] = pieces[i];
+				rehashed[i] = generic_hash_hash(fastBoards + (size_t) i * boardSize, 1);
+			}
+		legacy = hash_bench_seconds() - start;
+		start = hash_bench_seconds();
+		for (i = 0; i < samples; i++)
+			if (cells[i] >= 0)
+				positions[i] = generic_hash_rehash(positions[i], boards + (size_t) i * boardSize, cells[i], pieces[i], 1);
+		fast = hash_bench_seconds() - start;
+		printf("  %-16s %12s  %12s\n", "", "hash", "rehash");
+		hash_bench_report("one cell change", legacy, fast, changes);
+		for (i = 0; i < samples; i++)
+			if (cells[i] >= 0 && positions[i] != rehashed[i])
+				mismatches++;
+	}
+	if (symPerms != NULL && symTableCells == boardSize) {
+		for (i = 0; i < samples; i++)
+			if (ctx->player == 0 && (i & 1))
+				positions[i] += ctx->maxPos;
+		start = hash_bench_seconds();
+		for (i = 0; i < samples; i++)
+			rehashed[i] = legacyCanonicalPosition(ctx, scratch, positions[i]);
+		legacy = hash_bench_seconds() - start;
+		start = hash_bench_seconds();
+		for (i = 0; i < samples; i++)
+			if (generic_hash_canonicalPosition(positions[i]) != rehashed[i])
+				mismatches++;
+		fast = hash_bench_seconds() - start;
+		printf("  %-16s %12s  %12s\n", "", "legacy", "sym tables");
+		hash_bench_report("canonical", legacy, fast, samples);
+	}
+	printf("  Rank tables: %lld bytes (%lld in all contexts). Mismatches: %d\n\n",
+	       hash_rank_table_size(ctx) * (long long) sizeof(POSITION),
+	       hash_rank_table_entries * (long long) sizeof(POSITION), mismatches);
+
+	SafeFree(positions);
+	SafeFree(rehashed);
+	SafeFree(boards);
+	SafeFree(fastBoards);
+	SafeFree(cells);
+	SafeFree(pieces);
+	SafeFree(counts);
+	return mismatches;
 }
 
 
@@ -583,6 +1424,10 @@ int generic_hash_context_init()
 	struct hashContext *newHashC;
 
 	int myContext = hash_tot_context;
+	if (hash_tot_context == 0) {
+		hashOwnerThread = pthread_self();
+		hashThreadContext = -1;
+	}
 	hash_tot_context++;
 
 	temp = (struct hashContext **) SafeMalloc (sizeof(struct hashContext*)*(hash_tot_context));
@@ -611,12 +1456,16 @@ int generic_hash_context_init()
 	newHashC->nums = NULL;
 	newHashC->mins = NULL;
 	newHashC->maxs = NULL;
-	newHashC->thisCount = NULL;
-	newHashC->localMins = NULL;
 	newHashC->gfn = NULL;
 	newHashC->player = 0;
 	//newHashC->init = FALSE;
 	newHashC->contextNumber = -1;
+	newHashC->rankTable = NULL;
+	newHashC->rankStrides = NULL;
+	newHashC->cfgStrides = NULL;
+	newHashC->cfgSlots = NULL;
+	newHashC->slotTree = NULL;
+	newHashC->slotTreeIndex = NULL;
 	contextList[hash_tot_context-1] = newHashC;
 
 	return myContext;
@@ -627,36 +1476,78 @@ int generic_hash_context_init()
 ** generic_hash_context_switch(int context)
 **
 **  Switches the current hash context
-**  to the indicated hash context. Set's global
-**  variables for speed improvements during solving
+**  of the calling thread to the indicated
+**  hash context. Contexts are shared, so
+**  threads may switch independently.
 **
 ******************************/
 
 void generic_hash_context_switch(int context)
 {
+	hash_select_context(hash_context_index(context));
+}
+
+/******************************
+**
+** generic_hash_thread_start()
+**
+**  For a worker thread about to call
+**  into the module: takes the current
+**  context of the thread that made the
+**  contexts as its own, so switches
+**  made there later don't move it.
+**
+******************************/
+
+void generic_hash_thread_start()
+{
+	if (hash_tot_context > 0 && !pthread_equal(pthread_self(), hashOwnerThread))
+		hashThreadContext = __atomic_load_n(&currentContext, __ATOMIC_RELAXED);
+}
+
+/* index in contextList of context, which is a custom context number in
+   custom contexts mode */
+static int hash_context_index(int context)
+{
+	int index = context;
+
 	if (custom_contexts_mode) {
-		currentContext = hashtableGet(context);
-		if (currentContext == -1)
+		index = hashtableGet(context);
+		if (index == -1)
 			ExitStageRightErrorString("ERROR: Attempting to switch to non-existant hash context");
-	} else {
-		if(context > hash_tot_context || context < 0)
-			ExitStageRightErrorString("Attempting to switch to non-existant hash context");
-
-		currentContext = context;
+	} else if (context >= hash_tot_context || context < 0) {
+		ExitStageRightErrorString("Attempting to switch to non-existant hash context");
 	}
+	return index;
+}
+
+/* makes contextList[index] the current context of the calling thread */
+static void hash_select_context(int index)
+{
+	if (pthread_equal(pthread_self(), hashOwnerThread))
+		__atomic_store_n(&currentContext, index, __ATOMIC_RELAXED); // read by generic_hash_thread_start()
+	else hashThreadContext = index;
+}
+
+/******************************
+**
+** generic_hash_context(int context)
+** generic_hash_current()
+**
+** Return the indicated context, or the
+** calling thread's current one, for
+** the reentrant *_ctx calls
+**
+******************************/
 
-	//hash_hashOffset = cCon->hashOffset;
-	//hash_NCR = cCon->NCR;
-	//hash_miniOffset = cCon->miniOffset;
-	//hash_pieces = cCon->pieces;
-	//hash_thisCount = cCon->thisCount;
-	//hash_localMins = cCon->localMins;
-	//hash_miniOffset = cCon->miniOffset;
-	//hash_miniIndices = cCon->miniIndices;
-	//hash_numPieces = cCon->numPieces;
-	//hash_boardSize = cCon->boardSize;
-	//hash_usefulSpace = cCon->usefulSpace;
-	//hash_maxPos = cCon->maxPos;
+struct hashContext* generic_hash_context(int context)
+{
+	return contextList[hash_context_index(context)];
+}
+
+struct hashContext* generic_hash_current()
+{
+	return cCon;
 }
 
 /******************************
@@ -672,7 +1563,20 @@ int generic_hash_cur_context()
 {
 	if (custom_contexts_mode)
 		return cCon->contextNumber;
-	else return currentContext;
+	else return hash_current_index();
+}
+
+/******************************
+**
+** generic_hash_num_contexts()
+**
+** Returns how many contexts have been made so far
+**
+******************************/
+
+int generic_hash_num_contexts()
+{
+	return hash_tot_context;
 }
 
 /******************************
@@ -685,9 +1589,14 @@ int generic_hash_cur_context()
 
 POSITION generic_hash_max_pos()
 {
-	if (cCon->player != 0)         // using single-player boards
-		return cCon->maxPos;
-	else return (cCon->maxPos)*2;
+	return generic_hash_max_pos_ctx(cCon);
+}
+
+POSITION generic_hash_max_pos_ctx(struct hashContext* ctx)
+{
+	if (ctx->player != 0)         // using single-player boards
+		return ctx->maxPos;
+	else return (ctx->maxPos)*2;
 }
 
 /******************************
@@ -715,7 +1624,7 @@ void generic_hash_set_context(int context)
 {
 	if (context < 0)
 		ExitStageRightErrorString("ERROR: Attempting to set a negative custom context");
-	hashtablePut(context, currentContext, cCon->contextNumber); // add/change its entry in the hashtable
+	hashtablePut(context, hash_current_index(), cCon->contextNumber); // add/change its entry in the hashtable
 	cCon->contextNumber = context;
 }
 
@@ -733,6 +1642,15 @@ void freeHashContext(int contextNum)
 	if(contextList[contextNum] == NULL)
 		ExitStageRightErrorString("Attempting to free an invalid hash context");
 
+	if (contextList[contextNum]->rankTable != NULL) {
+		hash_rank_table_entries -= hash_rank_table_size(contextList[contextNum]);
+		SafeFree(contextList[contextNum]->rankTable);
+		SafeFree(contextList[contextNum]->rankStrides);
+		SafeFree(contextList[contextNum]->cfgStrides);
+	}
+	SafeFree(contextList[contextNum]->cfgSlots);
+	SafeFree(contextList[contextNum]->slotTree);
+	SafeFree(contextList[contextNum]->slotTreeIndex);
 	SafeFree(contextList[contextNum]->hashOffset);
 	SafeFree(contextList[contextNum]->NCR);
 	SafeFree(contextList[contextNum]->gpdStore);
@@ -742,8 +1660,6 @@ void freeHashContext(int contextNum)
 	SafeFree(contextList[contextNum]->nums);
 	SafeFree(contextList[contextNum]->mins);
 	SafeFree(contextList[contextNum]->maxs);
-	SafeFree(contextList[contextNum]->thisCount);
-	SafeFree(contextList[contextNum]->localMins);
 
 	SafeFree(contextList[contextNum]);
 
@@ -760,31 +1676,50 @@ int validConfig(int *t)
 
 
 /* function used to map a member of gHashOffset into gOffsetIndices */
-int searchIndices(int s)
+int searchIndices(struct hashContext* ctx, int s)
+{
+	if (s < 0 || s >= ctx->numCfgs)
+		return hash_scan_indices(ctx, s);
+	return ctx->cfgSlots[s];
+}
+
+/* function used to map a member of gOffsetIndices into gHashOffset:
+   the last slot whose offset is at most h */
+int searchOffset(struct hashContext* ctx, POSITION h)
+{
+	int k = 1, n = ctx->usefulSpace + 1;
+
+	while (k <= n)
+		k = 2*k + (ctx->slotTree[k] <= h);
+	k >>= __builtin_ffs(~k);
+	return (k == 0 ? n : ctx->slotTreeIndex[k]) - 1;
+}
+
+/* searchIndices() and searchOffset() without the offset tables */
+static int hash_scan_indices(struct hashContext* ctx, int s)
 {
-	int i = cCon->usefulSpace;
-	while(cCon->offsetIndices[i] > s)
+	int i = ctx->usefulSpace;
+	while(ctx->offsetIndices[i] > s)
 		i--;
 	return i;
 }
 
-/* function used to map a member of gOffsetIndices into gHashOffset */
-int searchOffset(POSITION h)
+static int hash_scan_offset(struct hashContext* ctx, POSITION h)
 {
-	int i = cCon->usefulSpace;
-	while(cCon->hashOffset[i] > h)
+	int i = ctx->usefulSpace;
+	while(ctx->hashOffset[i] > h)
 		i--;
 	return i;
 }
 
 /* helper function used to find n choose (t1,t2,t3,...,tn) where the ti's are
    the members of *tc */
-POSITION combiCount(int* tc)
+POSITION combiCount(struct hashContext* ctx, int* tc)
 {
 	POSITION sum = 0, prod = 1, ind = 0,old=1,hold=0;
-	for (ind = 0; ind < (POSITION)(cCon->numPieces - 1); ind++) {
+	for (ind = 0; ind < (POSITION)(ctx->numPieces - 1); ind++) {
 		sum += tc[ind];
-		hold = nCr(sum+tc[ind+1], sum);
+		hold = nCr(ctx, sum+tc[ind+1], sum);
 		prod *= hold;
 		if(prod/hold !=  old)
 			ExitStageRightErrorString("Combination Calculation Wraps");
@@ -843,9 +1778,9 @@ int gpi (int n)
 }
 
 /* shorthand for n choose r */
-POSITION nCr(int n, int r)
+POSITION nCr(struct hashContext* ctx, int n, int r)
 {
-	return cCon->NCR[n*(cCon->boardSize+1) + r];
+	return ctx->NCR[n*(ctx->boardSize+1) + r];
 }
 
 void generic_hash_destroy()
@@ -861,7 +1796,8 @@ void generic_hash_destroy()
 	if (generic_hash_hashtable != NULL) {
 		freeHashtable();
 	}
-	hash_tot_context = currentContext = 0;
+	hash_tot_context = currentContext = hash_max_pieces = 0;
+	hashThreadContext = -1;
 	custom_contexts_mode = FALSE;
 }
 
@@ -1241,6 +2177,7 @@ void generic_hash_init_sym(int boardType, int numRows, int numCols, int* reflect
 		SafeFree(hex0Ref);
 		SafeFree(tempSym);
 	}
+	buildSymmetryTables();
 	// set the function pointer.
 	gCanonicalPosition = generic_hash_canonicalPosition;
 }
@@ -1300,13 +2237,165 @@ void printXSpaces(int x) {
 	}
 }
 
+/* copies the symmetries into symPerms and symFlips, if they fit */
+void buildSymmetryTables() {
+	struct symEntry *symIndex;
+	int s, numImages = 0;
+
+	if (symPerms != NULL) {
+		SafeFree(symPerms);
+		SafeFree(symFlips);
+		symPerms = NULL;
+		symFlips = NULL;
+	}
+	symTableImages = symTableCells = 0;
+	for (symIndex = symmetriesList->next; symIndex != NULL; symIndex = symIndex->next)
+		numImages++;
+	if (numImages == 0 || numImages > SYM_MAX_IMAGES || cCon->boardSize > SYM_MAX_CELLS)
+		return;
+
+	symPerms = (int*) SafeMalloc(sizeof(int) * numImages * cCon->boardSize);
+	symFlips = (char*) SafeMalloc(sizeof(char) * numImages);
+	for (s = 0, symIndex = symmetriesList->next; symIndex != NULL; s++, symIndex = symIndex->next) {
+		memcpy(symPerms + s * cCon->boardSize, symIndex->sym, sizeof(int) * cCon->boardSize);
+		symFlips[s] = (symIndex->flip == 1);
+	}
+	symTableImages = numImages;
+	symTableCells = cCon->boardSize;
+}
+
+/* configuration offset plus player offset, as generic_hash_hash() adds
+   them, of boards with the given piece counts */
+static POSITION canonicalGroupKey(struct hashContext* ctx, int* counts, int player) {
+	POSITION sum = 0;
+	int i;
+
+	for (i = ctx->numPieces-1; i >= 0; i--) {
+		sum += (counts[i] - ctx->mins[i]);
+		if (i > 0)
+			sum *= ctx->nums[i-1];
+	}
+	sum = ctx->hashOffset[searchIndices(ctx, sum)];
+	if (ctx->player != 0)
+		return sum;
+	else return sum + (player-1)*(ctx->maxPos);
+}
+
+/* Returns the least hash among the images of pos.
+   Images with the same piece counts and player hash in the order of their
+   cells, read from the last cell down with pieces in the order they were
+   declared. So the images are compared cell by cell, dropping every image
+   that's bigger than another at some cell, until one is left. Only that
+   one gets hashed. Flipped images (pieces 0 and 1 swapped) may have other
+   counts and the other player; those only compete when their
+   configuration and player offset ties with the unflipped ones. */
 POSITION generic_hash_canonicalPosition(POSITION pos) {
-	char* board = (char*) SafeMalloc(sizeof(char) * cCon->boardSize);
-	char* flippedboard = (char*) SafeMalloc(sizeof(char) * cCon->boardSize);
+	return generic_hash_canonicalPosition_ctx(cCon, NULL, pos);
+}
+
+POSITION generic_hash_canonicalPosition_ctx(struct hashContext* ctx, HASH_SCRATCH* scratch, POSITION pos) {
+	char board[SYM_MAX_CELLS], image[SYM_MAX_CELLS];
+	signed char cells[SYM_MAX_CELLS];
+	int images[SYM_MAX_IMAGES + 1], flipMap[HASH_FAST_MAX_PIECES];
+	int counts[HASH_FAST_MAX_PIECES], flippedCounts[HASH_FAST_MAX_PIECES];
+	int i, j, c, s, v, least, numAlive, boardSize = ctx->boardSize;
+	int player, flippedplayer, *perm;
+	BOOLEAN anyFlips = FALSE, plainAlive = TRUE, flippedAlive = FALSE;
+	POSITION key, flippedKey;
+
+	if (symPerms == NULL || symTableCells != boardSize || ctx->numPieces > HASH_FAST_MAX_PIECES)
+		return legacyCanonicalPosition(ctx, scratch, pos);
+
+	generic_hash_unhash_ctx(ctx, scratch, pos, board);
+	player = generic_hash_turn_ctx(ctx, pos);
+	flippedplayer = (player == 1) ? 2 : 1;
+	for (j = 0; j < ctx->numPieces; j++) {
+		counts[j] = 0;
+		flipMap[j] = j;
+	}
+	for (i = 0; i < boardSize; i++) {
+		if (ctx->rankTable != NULL) {
+			j = ctx->pieceIndex[(unsigned char) board[i]];
+		} else {
+			for (j = 0; j < ctx->numPieces && board[i] != ctx->pieces[j]; j++)
+				;
+		}
+		if (j < 0 || j >= ctx->numPieces)
+			return legacyCanonicalPosition(ctx, scratch, pos);
+		cells[i] = j;
+		counts[j]++;
+	}
+
+	for (s = 0; s < symTableImages; s++)
+		anyFlips |= symFlips[s];
+	if (anyFlips && ctx->numPieces >= 2) {
+		flipMap[0] = 1;
+		flipMap[1] = 0;
+		memcpy(flippedCounts, counts, sizeof(int) * ctx->numPieces);
+		flippedCounts[0] = counts[1];
+		flippedCounts[1] = counts[0];
+		key = canonicalGroupKey(ctx, counts, player);
+		flippedKey = canonicalGroupKey(ctx, flippedCounts, flippedplayer);
+		plainAlive = (key <= flippedKey);
+		flippedAlive = (flippedKey <= key);
+	}
+
+	/* images[] holds symmetry numbers, -1 for the identity */
+	numAlive = 0;
+	if (plainAlive)
+		images[numAlive++] = -1;
+	for (s = 0; s < symTableImages; s++)
+		if (symFlips[s] ? flippedAlive : plainAlive)
+			images[numAlive++] = s;
+
+	for (c = boardSize - 1; c >= 0 && numAlive > 1; c--) {
+		least = ctx->numPieces;
+		for (i = 0; i < numAlive; i++) {
+			s = images[i];
+			if (s < 0)
+				v = cells[c];
+			else {
+				v = cells[symPerms[s * boardSize + c]];
+				if (symFlips[s])
+					v = flipMap[v];
+			}
+			if (v < least)
+				least = v;
+		}
+		for (i = 0, j = 0; i < numAlive; i++) {
+			s = images[i];
+			if (s < 0)
+				v = cells[c];
+			else {
+				v = cells[symPerms[s * boardSize + c]];
+				if (symFlips[s])
+					v = flipMap[v];
+			}
+			if (v == least)
+				images[j++] = s;
+		}
+		numAlive = j;
+	}
+
+	s = images[0];
+	if (s < 0)
+		return pos;
+	perm = symPerms + s * boardSize;
+	for (i = 0; i < boardSize; i++)
+		image[i] = ctx->pieces[symFlips[s] ? flipMap[(int) cells[perm[i]]] : cells[perm[i]]];
+	return generic_hash_hash_ctx(ctx, scratch, image, symFlips[s] ? flippedplayer : player);
+}
+
+/* the canonicalisation generic_hash_canonicalPosition() replaces, kept for
+   symmetry sets too big for the tables and for the benchmark */
+POSITION legacyCanonicalPosition(struct hashContext* ctx, HASH_SCRATCH* scratch, POSITION pos) {
+	scratch = hash_scratch_fit(scratch, ctx->numPieces);
+	char* board = (char*) SafeMalloc(sizeof(char) * ctx->boardSize);
+	char* flippedboard = (char*) SafeMalloc(sizeof(char) * ctx->boardSize);
 	struct symEntry* symIndex = symmetriesList->next;
-	generic_hash_unhash(pos, board);
-	generic_hash_unhash(pos, flippedboard);
-	int player = generic_hash_turn(pos);
+	generic_hash_unhash_ctx(ctx, scratch, pos, board);
+	generic_hash_unhash_ctx(ctx, scratch, pos, flippedboard);
+	int player = generic_hash_turn_ctx(ctx, pos);
 	int flippedplayer;
 	if (player == 1)
 		flippedplayer = 2;
@@ -1314,73 +2403,73 @@ POSITION generic_hash_canonicalPosition(POSITION pos) {
 		flippedplayer = 1;
 	POSITION tempPos, sum, offset, minPos;
 	POSITION flippedsum, flippedoffset;
-	int i, j, boardSize = cCon->boardSize;
+	int i, j, boardSize = ctx->boardSize;
 
-	for (i = 0; i < cCon->numPieces; i++)
+	for (i = 0; i < ctx->numPieces; i++)
 	{
-		cCon->thisCount[i] = 0;
-		cCon->localMins[i] = cCon->mins[i];
+		scratch->thisCount[i] = 0;
+		scratch->localMins[i] = ctx->mins[i];
 	}
 
 	for (i = 0; i < boardSize; i++)
 	{
-		for (j = 0; j < cCon->numPieces; j++) {
-			if (board[symIndex->sym[i]] == cCon->pieces[j]) {
-				cCon->thisCount[j]++;
+		for (j = 0; j < ctx->numPieces; j++) {
+			if (board[symIndex->sym[i]] == ctx->pieces[j]) {
+				scratch->thisCount[j]++;
 			}
 		}
 	}
 	sum = 0;
-	for (i = cCon->numPieces-1; i >= 0; i--)
+	for (i = ctx->numPieces-1; i >= 0; i--)
 	{
-		sum += (cCon->thisCount[i] - cCon->mins[i]);
+		sum += (scratch->thisCount[i] - ctx->mins[i]);
 		if (i > 0) {
-			sum *= cCon->nums[i-1];
+			sum *= ctx->nums[i-1];
 		}
 	}
-	offset = cCon->hashOffset[searchIndices(sum)];
+	offset = ctx->hashOffset[searchIndices(ctx, sum)];
 
 	if (symmetriesList->flip == 1) {
 		//for flipped:
-		for (i = 0; i < cCon->boardSize; i++) {
-			if (flippedboard[i] == cCon->pieces[0])
-				flippedboard[i] = cCon->pieces[1];
-			else if (flippedboard[i] == cCon->pieces[1])
-				flippedboard[i] = cCon->pieces[0];
+		for (i = 0; i < ctx->boardSize; i++) {
+			if (flippedboard[i] == ctx->pieces[0])
+				flippedboard[i] = ctx->pieces[1];
+			else if (flippedboard[i] == ctx->pieces[1])
+				flippedboard[i] = ctx->pieces[0];
 		}
 
-		for (i = 0; i < cCon->numPieces; i++) {
-			cCon->thisCount[i] = 0;
-			cCon->localMins[i] = cCon->mins[i];
+		for (i = 0; i < ctx->numPieces; i++) {
+			scratch->thisCount[i] = 0;
+			scratch->localMins[i] = ctx->mins[i];
 		}
 
 		for (i = 0; i < boardSize; i++)
 		{
-			for (j = 0; j < cCon->numPieces; j++) {
-				if (flippedboard[symIndex->sym[i]] == cCon->pieces[j]) {
-					cCon->thisCount[j]++;
+			for (j = 0; j < ctx->numPieces; j++) {
+				if (flippedboard[symIndex->sym[i]] == ctx->pieces[j]) {
+					scratch->thisCount[j]++;
 				}
 			}
 		}
 		flippedsum = 0;
-		for (i = cCon->numPieces-1; i >= 0; i--)
+		for (i = ctx->numPieces-1; i >= 0; i--)
 		{
-			flippedsum += (cCon->thisCount[i] - cCon->mins[i]);
+			flippedsum += (scratch->thisCount[i] - ctx->mins[i]);
 			if (i > 0) {
-				flippedsum *= cCon->nums[i-1];
+				flippedsum *= ctx->nums[i-1];
 			}
 		}
-		flippedoffset = cCon->hashOffset[searchIndices(flippedsum)];
+		flippedoffset = ctx->hashOffset[searchIndices(ctx, flippedsum)];
 	}
 
-	minPos = generic_hash_hash_sym(board, player, offset, symmetriesList);
+	minPos = hash_hash_sym(ctx, scratch, board, player, offset, symmetriesList);
 	// try each symmetry, keeping the lowest position hash
 	// returns as the canonical position.
 	while (symIndex != NULL) {
 		if (symIndex->flip == 1)
-			tempPos = generic_hash_hash_sym(flippedboard, flippedplayer, flippedoffset, symIndex);
+			tempPos = hash_hash_sym(ctx, scratch, flippedboard, flippedplayer, flippedoffset, symIndex);
 		else
-			tempPos = generic_hash_hash_sym(board, player, offset, symIndex);
+			tempPos = hash_hash_sym(ctx, scratch, board, player, offset, symIndex);
 		minPos = (tempPos < minPos) ? tempPos : minPos;
 		symIndex = symIndex->next;
 
@@ -1412,6 +2501,14 @@ void freeSymmetries() {
 		SafeFree(symIndex);
 		symIndex = tempNext;
 	}
+	symmetriesList = NULL;
+	if (symPerms != NULL) {
+		SafeFree(symPerms);
+		SafeFree(symFlips);
+		symPerms = NULL;
+		symFlips = NULL;
+	}
+	symTableImages = symTableCells = 0;
 }
 
 void generic_hash_add_sym(int* symToAdd) {
@@ -1426,6 +2523,7 @@ void generic_hash_add_sym(int* symToAdd) {
 	}
 	symIndex->next = newEntry;
 	numSymmetries++;
+	buildSymmetryTables();
 }
 
 // composes symmetries together, adding new compositions if they are not equal
@@ -50,23 +50,46 @@ struct hashContext
 	int *mins;
 	int *maxs;
 
-	int *thisCount;
-	int *localMins;
-
-	POSITION *miniOffset;
-	int *miniIndices;
-
 	int (*gfn)(int *);
 
 	int player;             // 0=Both Player boards (default), 1=1st Player only, 2=2nd only
 
 	int contextNumber;
+
+	/* Rank tables for the fast path, NULL when the context is too large for them.
+	   A counts index is sum(count[p] * rankStrides[p]) over the pieces, and
+	   rankTable[index*numPieces + p] is how many boards with those counts
+	   rank below the ones that have piece p in the highest cell. */
+	POSITION *rankTable;
+	int *rankStrides;
+	int *cfgStrides;        // configuration index stride of each piece
+	signed char pieceIndex[256];    // piece number of each board character, -1 if not a piece
+
+	/* Offset tables, which searchIndices() and searchOffset() look slots up in */
+	int *cfgSlots;          // hashOffset slot of each configuration index
+	POSITION *slotTree;     // hashOffset[0..usefulSpace] in Eytzinger order, from slotTree[1]
+	int *slotTreeIndex;     // hashOffset slot of each slotTree entry
 };
 
+/* Working arrays of the legacy hash and unhash paths. A context is only
+   read once generic_hash_init() has built it, so all the state a hash
+   call writes lives here. Every thread has its own, from
+   generic_hash_scratch(). */
+typedef struct hashScratch
+{
+	int size;               // pieces the arrays have room for
+	int *thisCount;
+	int *localMins;
+	POSITION *miniOffset;
+	int *miniIndices;
+} HASH_SCRATCH;
+
 int generic_hash_context_init(void);
 void generic_hash_context_switch(int context);
+void generic_hash_thread_start(void);
 void generic_hash_destroy(void);
 int generic_hash_cur_context(void);
+int generic_hash_num_contexts(void);
 POSITION generic_hash_max_pos(void);
 void generic_hash_custom_context_mode(BOOLEAN on);
 void generic_hash_set_context(int context);
@@ -76,9 +99,28 @@ POSITION generic_hash_hash(char* board, int player);
 POSITION generic_hash_hash_sym(char* board, int player, POSITION offset, struct symEntry* symIndex);
 char* generic_hash_unhash_tcl(POSITION pos);
 char* generic_hash_unhash(POSITION hashed, char* dest);
+POSITION generic_hash_rehash(POSITION hashed, char* board, int cell, char piece, int player);
+void generic_hash_hash_batch(char* boards, int* players, POSITION* dest, int count);
+void generic_hash_unhash_batch(POSITION* hashed, char* dest, int count);
+int generic_hash_benchmark(int samples);
 int generic_hash_turn (POSITION hashed);
 void hashCounting(void);
 
+/* Reentrant calls: these take the context and scratch to use instead of
+   the calling thread's current context. scratch may be NULL, in which
+   case the calling thread's own is used. generic_hash_context_switch()
+   only changes the current context of the calling thread; threads that
+   never switch follow the thread that made the contexts. */
+struct hashContext* generic_hash_context(int context);
+struct hashContext* generic_hash_current(void);
+HASH_SCRATCH* generic_hash_scratch(void);
+POSITION generic_hash_hash_ctx(struct hashContext* ctx, HASH_SCRATCH* scratch, char* board, int player);
+char* generic_hash_unhash_ctx(struct hashContext* ctx, HASH_SCRATCH* scratch, POSITION hashed, char* dest);
+POSITION generic_hash_rehash_ctx(struct hashContext* ctx, HASH_SCRATCH* scratch, POSITION hashed, char* board, int cell, char piece, int player);
+int generic_hash_turn_ctx(struct hashContext* ctx, POSITION hashed);
+POSITION generic_hash_max_pos_ctx(struct hashContext* ctx);
+POSITION generic_hash_canonicalPosition_ctx(struct hashContext* ctx, HASH_SCRATCH* scratch, POSITION pos);
+
 void generic_hash_init_sym(int boardType, int numRows, int numCols, int* reflections, int numReflects, int* rotations, int numRots, int flippable);
 POSITION generic_hash_canonicalPosition(POSITION pos);
 void flipboard(char* board);
@@ -2,6 +2,9 @@
 #include <errno.h>
 #include "globals.h"
 #include <string.h>
+#include <sys/time.h>
+
+#define CONN_TIMEOUT_SECONDS 30
 
 /* FUNCTIONS */
 
@@ -203,6 +206,87 @@ void freeresponse(httpres *res)
 	free(res);
 }
 
+/**
+ * Writes all length bytes of data to the socket, retrying short writes.
+ * Returns 0 if successful, -1 otherwise.
+ */
+static int writeall(int sockFd, const char *data, int length)
+{
+	int n;
+	while (length > 0)
+	{
+		n = write(sockFd, data, length);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return -1;
+		data += n;
+		length -= n;
+	}
+	return 0;
+}
+
+/**
+ * Writes the POST request line, the headers of req and the body (if any)
+ * to the socket. Returns 0 if successful, -1 otherwise.
+ *
+ * sockFd - connected socket
+ * req - httpreq holding the path and headers to send
+ * body - content for the body of the HTTP POST, can be NULL
+ * bodyLength - length of the body content, can be 0 if body is NULL
+ */
+static int writerequest(int sockFd, httpreq *req, char body[], int bodyLength)
+{
+	header *currHdr;
+	int r = 0;
+
+	r |= writeall(sockFd, "POST ", 5);
+	r |= writeall(sockFd, req->path, strlen(req->path));
+	r |= writeall(sockFd, " HTTP/1.1\r\n", 11);
+	// Add the headers
+	for (currHdr = req->headers; currHdr != NULL; currHdr = currHdr->next)
+	{
+		r |= writeall(sockFd, currHdr->name, strlen(currHdr->name));
+		r |= writeall(sockFd, ": ", 2);
+		r |= writeall(sockFd, currHdr->value, strlen(currHdr->value));
+		r |= writeall(sockFd, "\r\n", 2);
+	}
+
+	// Add the extra line to separate headers from body
+	r |= writeall(sockFd, "\r\n", 2);
+	// Add the body (if any)
+	if (bodyLength > 0)
+		r |= writeall(sockFd, body, bodyLength);
+	return r;
+}
+
+/**
+ * Frees the httpreq and all its request headers.
+ *
+ * req - httpreq struct to free
+ */
+static void freerequest(httpreq *req)
+{
+	header *currHdr = req->headers;
+	header *tmpHdr;
+
+	while (currHdr != NULL)
+	{
+		tmpHdr = currHdr;
+		currHdr = currHdr->next;
+		if (tmpHdr->name != NULL)
+			free(tmpHdr->name);
+		if (tmpHdr->value != NULL)
+			free(tmpHdr->value);
+		free(tmpHdr);
+	}
+	if (req->hostName != NULL)
+		free(req->hostName);
+	if (req->path != NULL)
+		free(req->path);
+	free(req);
+}
+
 /**
  * POST's the specified httpreq to it's preconfigured url with
  * all preconfigured headers and the body content (if any). Frees
@@ -220,8 +304,6 @@ void freeresponse(httpres *res)
  */
 int post(httpreq *req, char body[], int bodyLength, httpres** res, char** errMsg)
 {
-	header *currHdr = NULL;
-	header *tmpHdr = NULL;
 	char buffer[64];
 	int sockFd;
 	*res = NULL;
@@ -255,25 +337,7 @@ int post(httpreq *req, char body[], int bodyLength, httpres** res, char** errMsg
 	}
 
 	// Submit the http request
-	(void)write(sockFd, "POST ", 5);
-	(void)write(sockFd, req->path, strlen(req->path));
-	(void)write(sockFd, " HTTP/1.1\r\n", 11);
-	// Add the headers
-	currHdr = req->headers;
-	while (currHdr != NULL)
-	{
-		(void)write(sockFd, currHdr->name, strlen(currHdr->name));
-		(void)write(sockFd, ": ", 2);
-		(void)write(sockFd, currHdr->value, strlen(currHdr->value));
-		(void)write(sockFd, "\r\n", 2);
-		currHdr = currHdr->next;
-	}
-
-	// Add the extra line to separate headers from body
-	(void)write(sockFd, "\r\n", 2);
-	// Add the body (if any)
-	if (bodyLength > 0)
-		(void)write(sockFd, body, bodyLength);
+	(void)writerequest(sockFd, req, body, bodyLength);
 
 	// Create the response
 	if ((*res = malloc(sizeof(httpres))) == NULL)
@@ -294,26 +358,7 @@ int post(httpreq *req, char body[], int bodyLength, httpres** res, char** errMsg
 	close(sockFd);
 	shutdown(sockFd,2);
 
-	// Free the malloc'd memory
-	currHdr = req->headers;
-	while (currHdr != NULL)
-	{
-		if (currHdr->name != NULL)
-			free(currHdr->name);
-		if (currHdr->value != NULL)
-			free(currHdr->value);
-		if (tmpHdr != NULL)
-			free(tmpHdr);
-		tmpHdr = currHdr;
-		currHdr = currHdr->next;
-	}
-	if (tmpHdr != NULL)
-		free(tmpHdr);
-	if (req->hostName != NULL)
-		free(req->hostName);
-	if (req->path != NULL)
-		free(req->path);
-	free(req);
+	freerequest(req);
 	return 0;
 }
 
@@ -341,13 +386,13 @@ void readresponse(int sockFd, httpres *res)
 	while (1)
 	{
 		p = 0;
-		while ((n = read(sockFd, c, 1)) != EOF)
+		while ((n = read(sockFd, c, 1)) > 0 || (n < 0 && errno == EINTR))
 		{
-			if (c[0] == '\r')
+			if (n < 0 || c[0] == '\r')
 				continue;
 			else if (c[0] == '\n')
 				break;
-			else
+			else if (p < (int) sizeof(buffer) - 1)
 				buffer[p++] = c[0];
 		}
 		buffer[p] = '\0';
@@ -449,7 +494,17 @@ void readresponse(int sockFd, httpres *res)
 				fprintf(stderr,"ERROR, could not allocate memory for response body\n");
 				return;
 			}
-			res->bodyLength = read(sockFd, res->body, p);
+			// A single read may return only part of a large body
+			res->bodyLength = 0;
+			while (res->bodyLength < p)
+			{
+				n = read(sockFd, res->body + res->bodyLength, p - res->bodyLength);
+				if (n < 0 && errno == EINTR)
+					continue;
+				if (n <= 0)
+					break;
+				res->bodyLength += n;
+			}
 			res->body[p] = '\0';
 			//printf("expected: %d read: %d body: '%s'\n", p, res->bodyLength, res->body);
 		}
@@ -951,3 +1006,227 @@ int mallocstrcpyext(char** errMsg, char msg1[], char msg2[])
 	strcat(*errMsg, msg2);
 	return 0;
 }
+
+/**
+ * Creates a persistent connection to the server named by the url. The host
+ * is resolved once here; the socket itself is opened by the first
+ * sendrequest and reopened by later ones after closeconnection. Returns 0
+ * if successful. Otherwise, returns a non-zero value and populates the
+ * errMsg string.
+ *
+ * WARNING: clobbers url
+ *
+ * url - url the requests will use (minus the http:// prefix)
+ * conn - handle to the httpconn struct
+ * errMsg - handle to the error message string
+ */
+int newconnection(char url[], httpconn** conn, char** errMsg)
+{
+	httpreq *req;
+
+	*conn = NULL;
+	if (newrequest(url, &req, errMsg) != 0)
+	{
+		if (req != NULL)
+			freerequest(req);
+		return 1;
+	}
+	if ((*conn = malloc(sizeof(httpconn))) == NULL)
+	{
+		freerequest(req);
+		mallocstrcpy(errMsg, "ERROR, could not allocate memory for http connection");
+		return 1;
+	}
+
+	// Keep the resolved address and the url parts; the headers are per request
+	(*conn)->sock = req->sock;
+	(*conn)->hostName = req->hostName;
+	(*conn)->path = req->path;
+	(*conn)->portNum = req->portNum;
+	(*conn)->sockFd = -1;
+	req->hostName = NULL;
+	req->path = NULL;
+	freerequest(req);
+	return 0;
+}
+
+/**
+ * Creates a new httpreq for the specified connection, like newrequest
+ * but without parsing or resolving the url again, and asking the server
+ * to keep the connection open. Returns 0 if successful, 1 otherwise.
+ *
+ * conn - connection the request will be sent on
+ * req - handle to the httpreq struct
+ */
+int newconnrequest(httpconn *conn, httpreq** req)
+{
+	if ((*req = malloc(sizeof(httpreq))) == NULL)
+	{
+		fprintf(stderr,"ERROR, could not allocate memory for http request\n");
+		return 1;
+	}
+	(*req)->headers = NULL;
+	(*req)->serverAddr = NULL;
+	(*req)->sock = conn->sock;
+	(*req)->portNum = conn->portNum;
+	(*req)->hostName = NULL;
+	(*req)->path = NULL;
+	mallocstrcpy(&((*req)->hostName), conn->hostName);
+	mallocstrcpy(&((*req)->path), conn->path);
+
+	addheader(*req, "Host", conn->hostName); // Required by HTTP 1.1
+	addheader(*req, "Connection", "keep-alive");
+	addheader(*req, "User-Agent", "Gamesman/1.0");
+	addheader(*req, "Content-Type", "application/octet-stream");
+	return 0;
+}
+
+/**
+ * POST's the specified httpreq on the connection without waiting for the
+ * response, connecting first if needed, and frees the httpreq. Several
+ * requests may be outstanding; read their responses in order with
+ * receiveresponse. Returns 0 if successful. Otherwise, closes the
+ * connection, returns a non-zero value and populates the errMsg string.
+ *
+ * conn - connection to send on
+ * req - httpreq struct to POST
+ * body - content for the body of the HTTP POST, can be NULL
+ * bodyLength - length of the body content, can be 0 if body is NULL
+ * errMsg - handle to the error message string
+ */
+int sendrequest(httpconn *conn, httpreq *req, char body[], int bodyLength, char** errMsg)
+{
+	struct timeval timeout = { CONN_TIMEOUT_SECONDS, 0 };
+	char buffer[64];
+	int r;
+
+	*errMsg = NULL;
+	net_itoa(bodyLength, buffer);
+	addheader(req, "Content-Length", buffer);
+
+	if (conn->sockFd < 0)
+	{
+		if ((conn->sockFd = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+		{
+			r = errno;
+			connecterror(buffer);
+			mallocstrcpyext(errMsg, "ERROR, creating socket: ", buffer);
+			freerequest(req);
+			return r ? r : 1;
+		}
+		// Don't let a stalled server hang the game forever
+		setsockopt(conn->sockFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		setsockopt(conn->sockFd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+		if (connect(conn->sockFd, &(conn->sock.res), sizeof(struct sockaddr_in)) < 0)
+		{
+			r = errno;
+			connecterror(buffer);
+			mallocstrcpyext(errMsg, "ERROR, opening socket: ", buffer);
+			closeconnection(conn);
+			freerequest(req);
+			return r ? r : 1;
+		}
+	}
+
+	r = writerequest(conn->sockFd, req, body, bodyLength);
+	freerequest(req);
+	if (r != 0)
+	{
+		mallocstrcpy(errMsg, "ERROR, writing to socket: connection lost");
+		closeconnection(conn);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * Reads the response to the oldest request still outstanding on the
+ * connection. Closes the connection afterwards if the server asked for
+ * that. Returns 0 if successful. Otherwise, closes the connection,
+ * returns a non-zero value and populates the errMsg string.
+ *
+ * conn - connection to read from
+ * res - handle to the httpres struct (free with freeresponse)
+ * errMsg - handle to the error message string
+ */
+int receiveresponse(httpconn *conn, httpres** res, char** errMsg)
+{
+	char *value;
+	int expected;
+
+	*errMsg = NULL;
+	*res = NULL;
+	if (conn->sockFd < 0)
+	{
+		mallocstrcpy(errMsg, "No outstanding request on a closed connection.");
+		return 1;
+	}
+	if ((*res = malloc(sizeof(httpres))) == NULL)
+	{
+		mallocstrcpy(errMsg, "ERROR, could not allocate memory for http response");
+		return 1;
+	}
+	(*res)->headers = NULL;
+	(*res)->status = NULL;
+	(*res)->body = NULL;
+	(*res)->statusCode = 0;
+	(*res)->bodyLength = 0;
+	readresponse(conn->sockFd, *res);
+
+	if ((*res)->status == NULL)
+	{
+		mallocstrcpy(errMsg, "No response received from server.");
+		closeconnection(conn);
+		return 1;
+	}
+	getheader(*res, "Content-Length", &value);
+	expected = (value != NULL) ? atoi(value) : 0;
+	if (value != NULL)
+		free(value);
+	if ((*res)->bodyLength < expected)
+	{
+		mallocstrcpy(errMsg, "Connection closed in the middle of a response.");
+		closeconnection(conn);
+		return 1;
+	}
+
+	getheader(*res, "Connection", &value);
+	if (value != NULL)
+	{
+		if (!strcasecmp(value, "close"))
+			closeconnection(conn);
+		free(value);
+	}
+	return 0;
+}
+
+/**
+ * Closes the connection's socket. Outstanding responses are lost; the
+ * next sendrequest reconnects.
+ *
+ * conn - connection to close
+ */
+void closeconnection(httpconn *conn)
+{
+	if (conn->sockFd >= 0)
+	{
+		shutdown(conn->sockFd, 2);
+		close(conn->sockFd);
+		conn->sockFd = -1;
+	}
+}
+
+/**
+ * Closes and frees the connection.
+ *
+ * conn - connection to free
+ */
+void freeconnection(httpconn *conn)
+{
+	if (conn == NULL)
+		return;
+	closeconnection(conn);
+	free(conn->hostName);
+	free(conn->path);
+	free(conn);
+}
@@ -41,6 +41,19 @@ struct httpres_struct
 };
 typedef struct httpres_struct httpres;
 
+/* A persistent (keep-alive) connection to one server. Requests made with
+ * newconnrequest may be sent back to back and their responses read in
+ * the same order. */
+struct httpconn_struct
+{
+	union sock sock;
+	char *hostName;
+	char *path;
+	int portNum;
+	int sockFd;
+};
+typedef struct httpconn_struct httpconn;
+
 
 /* FUNCTION DECLARATIONS */
 #ifndef htonll
@@ -61,6 +74,12 @@ int responseerrorcheck(httpres *res, char** errMsg); // checks for bad server re
 void connecterror(char errMsg[]); // copies the error message corresponding to the errno into the specified buffer
 int mallocstrcpy(char** errMsg, const char msg[]); // copies a string into a malloc'd area of memory
 int mallocstrcpyext(char** errMsg, char msg1[], char msg2[]); // copies and concatenates 2 strings into a malloc' area of memory
+int newconnection(char url[], httpconn** conn, char** errMsg); // resolve a url once for a persistent connection
+int newconnrequest(httpconn *conn, httpreq** req); // instantiate a keep-alive request on a connection
+int sendrequest(httpconn *conn, httpreq *req, char body[], int bodyLength, char** errMsg); // POST without waiting for the response
+int receiveresponse(httpconn *conn, httpres** res, char** errMsg); // read the oldest outstanding response
+void closeconnection(httpconn *conn); // drop the socket, keep the address
+void freeconnection(httpconn *conn); // close and free a connection
 
 /* HEADERS AND VALUES */
 #define HD_GET_VALUE_OF_POSITIONS "GetValueOfPositions"
@@ -0,0 +1,564 @@
+/************************************************************************
+**
+** NAME:	httpserver.c
+**
+** DESCRIPTION:	Embedded HTTP server for the --serve option. Answers the
+**		same GET /<game>/<variant>/<command>?p=<board> requests as
+**		src/py/server.py, but directly from this process's
+**		loaded database instead of through an --interact pipe.
+**
+**		The main thread accepts connections and hands them to a
+**		fixed pool of worker threads through a bounded queue; a
+**		connection that finds the queue full is answered 503.
+**		Each worker owns its string buffers and keeps its
+**		connection open between requests (HTTP/1.1 keep-alive)
+**		until the client closes it, it sits idle for
+**		SERVE_IDLE_SECONDS, or it is idle while another
+**		connection is waiting for a worker.
+**
+**		Request parsing, socket I/O and idle connections are
+**		handled concurrently. Calls into the game module and the
+**		database are made under serveGameLock: shared when the
+**		module sets kSupportsThreads and the DB is read from
+**		memory (ServeCanShare), exclusive otherwise.
+**
+** LICENSE:	This file is part of GAMESMAN,
+**		The Finite, Two-person Perfect-Information Game Generator
+**		Released under the GPL:
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program, in COPYING; if not, write to the Free Software
+** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+**************************************************************************/
+
+#include <pthread.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "gamesman.h"
+#include "interact.h"
+#include "autoguistrings.h"
+#include "sharddb.h"
+#include "httpserver.h"
+
+#define SERVE_DEFAULT_HOST "127.0.0.1"
+#define SERVE_DEFAULT_WORKERS 16
+#define SERVE_QUEUE_SIZE 256
+#define SERVE_REQUEST_MAX 8192
+#define SERVE_IDLE_SECONDS 30
+#define SERVE_IDLE_POLL_MS 100
+#define SERVE_HEADER_MAX 256
+
+/* Error bodies, identical to the ones sent by server.py. */
+static STRING couldNotParseMsg =
+	"{\n \"status\":\"error\",\n \"reason\":\"Could not parse request.\"\n}";
+static STRING couldNotStartMsg =
+	"{\n \"status\":\"error\",\n \"reason\":\"Could not start game.\"\n}";
+static STRING invalidBoardMsg = "{\"error\":\"Invalid board string.\"}";
+
+typedef struct serve_worker {
+	char request[SERVE_REQUEST_MAX];
+	int length;						// Bytes buffered in request.
+	char board[MAX_POSITION_STRING_LENGTH];
+	char positionStringBuffer[MAX_POSITION_STRING_LENGTH];
+	char positionStringBuffer2[MAX_POSITION_STRING_LENGTH];
+	char moveStringBuffer[MAX_MOVE_STRING_LENGTH];
+} serve_worker_t;
+
+static char serveGameName[MAX_POSITION_STRING_LENGTH];
+static volatile sig_atomic_t serveStopping = 0;
+
+/* Held shared by requests that may run concurrently (serveShared),
+ * exclusively by the rest and by shutdown, which sets serveClosed. */
+static pthread_rwlock_t serveGameLock = PTHREAD_RWLOCK_INITIALIZER;
+static BOOLEAN serveShared = FALSE;
+static BOOLEAN serveClosed = FALSE;
+
+/* Accepted connections waiting for a worker. */
+static pthread_mutex_t serveQueueLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t serveQueueNotEmpty = PTHREAD_COND_INITIALIZER;
+static int serveQueue[SERVE_QUEUE_SIZE];
+static int serveQueueHead = 0;
+static int serveQueueCount = 0;
+
+/* Returns FALSE, leaving fd to the caller, if the queue is full. */
+static BOOLEAN ServeQueuePush(int fd) {
+	BOOLEAN pushed = FALSE;
+	pthread_mutex_lock(&serveQueueLock);
+	if (serveQueueCount < SERVE_QUEUE_SIZE) {
+		serveQueue[(serveQueueHead + serveQueueCount++) % SERVE_QUEUE_SIZE] = fd;
+		pthread_cond_signal(&serveQueueNotEmpty);
+		pushed = TRUE;
+	}
+	pthread_mutex_unlock(&serveQueueLock);
+	return pushed;
+}
+
+static int ServeQueuePop(void) {
+	int fd;
+	pthread_mutex_lock(&serveQueueLock);
+	while (serveQueueCount == 0)
+		pthread_cond_wait(&serveQueueNotEmpty, &serveQueueLock);
+	fd = serveQueue[serveQueueHead];
+	serveQueueHead = (serveQueueHead + 1) % SERVE_QUEUE_SIZE;
+	serveQueueCount--;
+	pthread_mutex_unlock(&serveQueueLock);
+	return fd;
+}
+
+static BOOLEAN ServeQueueWaiting(void) {
+	BOOLEAN waiting;
+	pthread_mutex_lock(&serveQueueLock);
+	waiting = serveQueueCount > 0;
+	pthread_mutex_unlock(&serveQueueLock);
+	return waiting;
+}
+
+/* Takes serveGameLock for one request. Returns FALSE, holding nothing,
+ * once the server has shut down and the DB is gone. */
+static BOOLEAN ServeGameLock(void) {
+	if (serveShared)
+		pthread_rwlock_rdlock(&serveGameLock);
+	else
+		pthread_rwlock_wrlock(&serveGameLock);
+	if (serveClosed) {
+		pthread_rwlock_unlock(&serveGameLock);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static int ServeHexDigit(char c) {
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	return -1;
+}
+
+/* Decodes %XX escapes in place. */
+static void ServeURLDecode(char *s) {
+	char *out = s;
+	while (*s) {
+		if (s[0] == '%' && ServeHexDigit(s[1]) >= 0 && ServeHexDigit(s[2]) >= 0) {
+			*out++ = (char) (ServeHexDigit(s[1]) * 16 + ServeHexDigit(s[2]));
+			s += 3;
+		} else {
+			*out++ = *s++;
+		}
+	}
+	*out = '\0';
+}
+
+/* Copies the value of the p parameter into board the way
+ * InteractReadBoardString would read it from a position_response line:
+ * surrounding quotes are optional, '+' stands for a space and control
+ * characters are rejected.
+ */
+static BOOLEAN ServeReadBoard(char *value, char *board) {
+	char *end;
+	int i;
+	if (*value == '"') {
+		value++;
+		if ((end = strchr(value, '"')) != NULL) *end = '\0';
+	}
+	for (i = 0; value[i]; i++) {
+		if (i == MAX_POSITION_STRING_LENGTH - 1 || iscntrl((unsigned char) value[i]))
+			return FALSE;
+		board[i] = (value[i] == '+') ? ' ' : value[i];
+	}
+	board[i] = '\0';
+	return TRUE;
+}
+
+/* Writes the response body for target (path and query) to out and returns
+ * the HTTP status code.
+ */
+static int ServeRoute(serve_worker_t *w, char *target, FILE *out) {
+	char *query = strchr(target, '?');
+	char *parts[3];
+	char *param, *value, *end;
+	BOOLEAN haveBoard = FALSE;
+	long variant;
+	int i;
+
+	if (query) *query++ = '\0';
+	if (strstr(target, "favicon.ico")) return 404;
+
+	/* /<game>/<variant>/<command> */
+	if (*target == '/') target++;
+	for (i = 0; i < 3; i++) {
+		parts[i] = target;
+		target += strcspn(target, "/");
+		if (*target) *target++ = '\0';
+		ServeURLDecode(parts[i]);
+		if (*parts[i] == '\0') {
+			fputs(couldNotParseMsg, out);
+			return 200;
+		}
+	}
+
+	/* Only the variant loaded by this process can be answered. */
+	variant = strtol(parts[1], &end, 10);
+	if ((strcmp(parts[0], serveGameName) && strcmp(parts[0], kDBName)) ||
+	    *end != '\0' || variant != getOption()) {
+		fputs(couldNotStartMsg, out);
+		return 200;
+	}
+
+	/* Board strings may contain '=', so only split on the first one. */
+	for (param = query; param && *param; param = end) {
+		end = param + strcspn(param, "&");
+		if (*end) *end++ = '\0';
+		value = param + strcspn(param, "=");
+		if (*value) *value++ = '\0';
+		if (!strcmp(param, "p")) {
+			ServeURLDecode(value);
+			haveBoard = ServeReadBoard(value, w->board);
+			if (!haveBoard) {
+				fputs(invalidBoardMsg, out);
+				return 200;
+			}
+		}
+	}
+
+	if (!strcmp(parts[2], "start")) {
+		if (!ServeGameLock()) return 503;
+		InteractStartResponse(out, w->positionStringBuffer);
+		pthread_rwlock_unlock(&serveGameLock);
+	} else if (!strcmp(parts[2], "positions")) {
+		BOOLEAN valid = FALSE;
+		if (haveBoard) {
+			if (!ServeGameLock()) return 503;
+			valid = InteractPositionResponse(out, "", w->board,
+			        w->positionStringBuffer, w->positionStringBuffer2, w->moveStringBuffer);
+			pthread_rwlock_unlock(&serveGameLock);
+		}
+		if (!valid) fputs(invalidBoardMsg, out);
+	} else {
+		fputs(couldNotParseMsg, out);
+	}
+	return 200;
+}
+
+static BOOLEAN ServeWriteAll(int fd, const char *data, size_t length) {
+	ssize_t sent;
+	while (length > 0) {
+		sent = send(fd, data, length, 0);
+		if (sent < 0 && errno == EINTR) continue;
+		if (sent <= 0) return FALSE;
+		data += sent;
+		length -= sent;
+	}
+	return TRUE;
+}
+
+static STRING ServeStatusText(int status) {
+	switch (status) {
+	case 200: return "OK";
+	case 400: return "Bad Request";
+	case 404: return "Not Found";
+	case 405: return "Method Not Allowed";
+	case 431: return "Request Header Fields Too Large";
+	case 503: return "Service Unavailable";
+	default: return "Internal Server Error";
+	}
+}
+
+static BOOLEAN ServeRespond(int fd, int status, const char *body, size_t bodyLength, BOOLEAN keepAlive) {
+	char header[SERVE_HEADER_MAX];
+	int headerLength = snprintf(header, sizeof(header),
+	        "HTTP/1.1 %d %s\r\n"
+	        "Content-Type: text/plain\r\n"
+	        "Content-Length: %lu\r\n"
+	        "Access-Control-Allow-Origin: *\r\n"
+	        "Connection: %s\r\n\r\n",
+	        status, ServeStatusText(status), (unsigned long) bodyLength,
+	        keepAlive ? "keep-alive" : "close");
+	return ServeWriteAll(fd, header, headerLength) && ServeWriteAll(fd, body, bodyLength);
+}
+
+/* Returns the length of the request head (through the blank line) buffered
+ * in w, or 0 if it is not complete yet.
+ */
+static int ServeHeadLength(serve_worker_t *w) {
+	int i;
+	for (i = 3; i < w->length; i++) {
+		if (w->request[i] == '\n' && w->request[i - 1] == '\r' &&
+		    w->request[i - 2] == '\n' && w->request[i - 3] == '\r')
+			return i + 1;
+	}
+	return 0;
+}
+
+/* Finds the value of header name in the request head, or NULL. */
+static char *ServeHeader(char *head, STRING name) {
+	size_t nameLength = strlen(name);
+	char *line;
+	for (line = strchr(head, '\n'); line; line = strchr(line, '\n')) {
+		line++;
+		if (!strncasecmp(line, name, nameLength) && line[nameLength] == ':') {
+			line += nameLength + 1;
+			while (*line == ' ' || *line == '\t') line++;
+			return line;
+		}
+	}
+	return NULL;
+}
+
+/* Waits for the next request on an idle keep-alive connection. Returns
+ * FALSE if it stays idle for SERVE_IDLE_SECONDS, or for SERVE_IDLE_POLL_MS
+ * while another connection is waiting for a worker, so idle clients can't
+ * starve new ones.
+ */
+static BOOLEAN ServeAwaitRequest(int fd) {
+	struct pollfd ready = { fd, POLLIN, 0 };
+	int waited;
+	for (waited = 0; waited < SERVE_IDLE_SECONDS * 1000; waited += SERVE_IDLE_POLL_MS) {
+		switch (poll(&ready, 1, SERVE_IDLE_POLL_MS)) {
+		case 0: break;
+		case -1: if (errno == EINTR) break; return FALSE;
+		default: return TRUE;
+		}
+		if (ServeQueueWaiting()) return FALSE;
+	}
+	return FALSE;
+}
+
+/* Answers requests on fd until the client closes the connection, asks for
+ * it to be closed, sends something unparseable, or idles (ServeAwaitRequest).
+ */
+static void ServeConnection(serve_worker_t *w, int fd) {
+	char *method, *target, *version, *connection, *contentLength, *body;
+	size_t bodyLength;
+	long skip;
+	int headLength, status;
+	ssize_t got;
+	BOOLEAN keepAlive, served = FALSE;
+	FILE *out;
+
+	w->length = 0;
+	while (TRUE) {
+		while ((headLength = ServeHeadLength(w)) == 0) {
+			if (w->length == 0 && served && !ServeAwaitRequest(fd))
+				return;
+			if (w->length == SERVE_REQUEST_MAX) {
+				ServeRespond(fd, 431, "", 0, FALSE);
+				return;
+			}
+			got = recv(fd, w->request + w->length, SERVE_REQUEST_MAX - w->length, 0);
+			if (got < 0 && errno == EINTR) continue;
+			if (got <= 0) return;
+			w->length += got;
+		}
+		w->request[headLength - 1] = '\0';
+
+		/* Request line: <method> <target> <version> */
+		method = w->request;
+		target = strchr(method, ' ');
+		version = target ? strchr(target + 1, ' ') : NULL;
+		if (!version) {
+			ServeRespond(fd, 400, "", 0, FALSE);
+			return;
+		}
+		*target++ = '\0';
+		*version++ = '\0';
+
+		connection = ServeHeader(version, "Connection");
+		if (!strncmp(version, "HTTP/1.1", 8))
+			keepAlive = !(connection && !strncasecmp(connection, "close", 5));
+		else
+			keepAlive = connection && !strncasecmp(connection, "keep-alive", 10);
+
+		/* Skip any request body; GET requests should not carry one. */
+		contentLength = ServeHeader(version, "Content-Length");
+		skip = contentLength ? atol(contentLength) : 0;
+		if (skip < 0) {
+			ServeRespond(fd, 400, "", 0, FALSE);
+			return;
+		}
+
+		if (strcmp(method, "GET")) {
+			ServeRespond(fd, 405, "", 0, FALSE);
+			return;
+		}
+		body = NULL;
+		bodyLength = 0;
+		out = open_memstream(&body, &bodyLength);
+		if (!out) return;
+		status = ServeRoute(w, target, out);
+		fclose(out);
+		if (status == 503) keepAlive = FALSE;
+		if (!ServeRespond(fd, status, body, bodyLength, keepAlive))
+			keepAlive = FALSE;
+		free(body);
+		if (!keepAlive) return;
+		served = TRUE;
+
+		/* Keep whatever the client has already pipelined after this request. */
+		if (skip <= w->length - headLength) {
+			w->length -= headLength + skip;
+			memmove(w->request, w->request + headLength + skip, w->length);
+		} else {
+			skip -= w->length - headLength;
+			w->length = 0;
+			while (skip > 0) {
+				got = recv(fd, w->request, (skip < SERVE_REQUEST_MAX) ? skip : SERVE_REQUEST_MAX, 0);
+				if (got < 0 && errno == EINTR) continue;
+				if (got <= 0) return;
+				skip -= got;
+			}
+		}
+	}
+}
+
+static void *ServeWorker(void *unused) {
+	serve_worker_t *w = (serve_worker_t *) SafeMalloc(sizeof(serve_worker_t));
+	struct timeval idle = { SERVE_IDLE_SECONDS, 0 };
+	int one = 1;
+	int fd;
+	(void) unused;
+
+	generic_hash_thread_start();
+	AutoGUIWriteEmptyString(w->positionStringBuffer);
+	AutoGUIWriteEmptyString(w->moveStringBuffer);
+	while (TRUE) {
+		fd = ServeQueuePop();
+		setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &idle, sizeof(idle));
+		setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &idle, sizeof(idle));
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+		ServeConnection(w, fd);
+		close(fd);
+	}
+	return NULL;
+}
+
+/* Requests can share serveGameLock only if the module is reentrant and
+ * lookups just read an in-memory DB: tier hash windows, the shard cache,
+ * the Quarto solver and the file, network and disk-backed DBs all keep
+ * per-lookup state in globals.
+ */
+static BOOLEAN ServeCanShare(void) {
+	return kSupportsThreads && !(kSupportsTierGamesman && gTierGamesman) &&
+	       !kSupportsShardGamesman && !kUsesQuartoGamesman &&
+	       !gNetworkDB && !gFileDB && !gCollDB && !gUnivDB &&
+	       !gBitPerfectDBZeroMemoryPlayer;
+}
+
+static void ServeStop(int sig) {
+	(void) sig;
+	serveStopping = 1;
+}
+
+/* Serves the loaded database over HTTP on host:port until SIGINT or
+ * SIGTERM. host is an IPv4 address, or NULL for SERVE_DEFAULT_HOST.
+ */
+void ServeHTTP(STRING executableName, STRING host, int port) {
+	STRING base = strrchr(executableName, '/');
+	struct sockaddr_in address;
+	struct sigaction stop;
+	sigset_t blocked, previous;
+	pthread_t thread;
+	int workers = (gTierSolverThreads > 1) ? gTierSolverThreads : SERVE_DEFAULT_WORKERS;
+	int listenFd, fd, i;
+	int one = 1;
+
+	/* server.py names games by their binary, e.g. "ttt" for mttt. */
+	base = base ? base + 1 : executableName;
+	if (base[0] == 'm') base++;
+	strncpy(serveGameName, base, sizeof(serveGameName) - 1);
+
+	if (kSupportsShardGamesman) {
+		sharddb_cache_init();
+	}
+	serveShared = ServeCanShare();
+
+	if (!host) host = SERVE_DEFAULT_HOST;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons((unsigned short) port);
+	if (inet_pton(AF_INET, host, &address.sin_addr) != 1) {
+		fprintf(stderr, "ServeHTTP: %s is not an IPv4 address\n", host);
+		return;
+	}
+
+	listenFd = socket(AF_INET, SOCK_STREAM, 0);
+	if (listenFd < 0) {
+		perror("ServeHTTP: socket");
+		return;
+	}
+	setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	if (bind(listenFd, (struct sockaddr *) &address, sizeof(address)) < 0 ||
+	    listen(listenFd, SERVE_QUEUE_SIZE) < 0) {
+		perror("ServeHTTP: bind");
+		close(listenFd);
+		return;
+	}
+
+	/* A peer that hangs up mid-response must not kill the server, and
+	 * SIGINT/SIGTERM should interrupt accept() rather than restart it. */
+	signal(SIGPIPE, SIG_IGN);
+	memset(&stop, 0, sizeof(stop));
+	stop.sa_handler = ServeStop;
+	sigemptyset(&stop.sa_mask);
+	sigaction(SIGINT, &stop, NULL);
+	sigaction(SIGTERM, &stop, NULL);
+
+	/* Workers inherit a mask with the stop signals blocked, so they are
+	 * always delivered to the accepting thread. */
+	sigemptyset(&blocked);
+	sigaddset(&blocked, SIGINT);
+	sigaddset(&blocked, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+	for (i = 0; i < workers; i++) {
+		if (pthread_create(&thread, NULL, ServeWorker, NULL) != 0) {
+			fprintf(stderr, "ServeHTTP: could not start worker thread\n");
+			ExitStageRight();
+		}
+		pthread_detach(thread);
+	}
+	pthread_sigmask(SIG_SETMASK, &previous, NULL);
+	printf("\nServing %s variant %d on %s:%d with %d %s workers.\n",
+	       serveGameName, getOption(), host, port, workers,
+	       serveShared ? "concurrent" : "serialized");
+	fflush(stdout);
+
+	while (!serveStopping) {
+		fd = accept(listenFd, NULL, NULL);
+		if (fd < 0) {
+			if (errno != EINTR) perror("ServeHTTP: accept");
+			continue;
+		}
+		if (!ServeQueuePush(fd)) {
+			ServeRespond(fd, 503, "", 0, FALSE);
+			close(fd);
+		}
+	}
+	close(listenFd);
+
+	/* Let any request in flight finish before the DB goes away; requests
+	 * that get the lock afterwards see serveClosed and are answered 503. */
+	pthread_rwlock_wrlock(&serveGameLock);
+	serveClosed = TRUE;
+	if (kSupportsShardGamesman) {
+		sharddb_cache_deallocate();
+	}
+	pthread_rwlock_unlock(&serveGameLock);
+	printf("\n");
+}
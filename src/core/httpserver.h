@@ -0,0 +1,8 @@
+#ifndef GMCORE_HTTPSERVER_H
+#define GMCORE_HTTPSERVER_H
+
+#include "gamesman.h"
+
+void ServeHTTP(STRING executableName, STRING host, int port);
+
+#endif /* GMCORE_HTTPSERVER_H */
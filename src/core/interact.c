@@ -94,22 +94,237 @@ STRING InteractValueCharToValueString(char value_char) {
 	}
 }
 
-void InteractPrintJSONMEXValue(POSITION position) {
+void InteractPrintJSONMEXValue(FILE *out, POSITION position) {
 	if (gSupportsMex && !gTwoBits) {
-		printf(",\"mex\":");
+		fprintf(out, ",\"mex\":");
 		int theMex = MexLoad(position);
 		if(theMex == (MEX) 0)
-			printf("\"0\"");
+			fprintf(out, "\"0\"");
 		else if(theMex == (MEX)1)
-			printf("\"*\"");
+			fprintf(out, "\"*\"");
 		else
-			printf("\"*%d\"", (int)theMex);
+			fprintf(out, "\"*%d\"", (int)theMex);
 	}
 }
 
-void InteractPrintJSONPositionValue(VALUE val) {
+void InteractPrintJSONPositionValue(FILE *out, VALUE val) {
 	char value_char = gValueLetter[val];
-	printf(",\"positionValue\":\"%s\"", InteractValueCharToValueString(value_char));
+	fprintf(out, ",\"positionValue\":\"%s\"", InteractValueCharToValueString(value_char));
+}
+
+/* Writes the JSON position_response for the board string to out, preceded
+ * by prefix. Returns FALSE without writing anything if the board string does
+ * not describe a valid position.
+ */
+BOOLEAN InteractPositionResponse(FILE *out, STRING prefix, STRING inputPositionString,
+		char *positionStringBuffer, char *positionStringBuffer2, char *moveStringBuffer) {
+	POSITION position;
+	POSITION childPosition;
+	POSITION *childPositions;
+	VALUE *childValues;
+	REMOTENESS *childRemotenesses;
+	int numChildren, childIndex;
+	MOVELIST *currentMove = NULL;
+	MOVELIST *movesHead = NULL;
+	REMOTENESS rem = 0;
+	VALUE val = lose;
+	BOOLEAN positionStringMatchesAutoGUIPositionString = (gPositionStringDoMoveFunPtr == NULL) ? (gPositionToStringFunPtr == NULL) : (gPositionStringToAutoGUIPositionStringFunPtr == NULL);
+
+	if (kUsesQuartoGamesman) {
+		fprintf(out, "%s", prefix);
+		quartoDetailedPositionResponse(out, inputPositionString, positionStringBuffer);
+		return TRUE;
+	}
+	char oppTurnChar = (inputPositionString[0] == '1') ? '2' : '1';
+	position = StringToPosition(inputPositionString);
+	if (position == NULL_POSITION) {
+		return FALSE;
+	}
+	if (kSupportsShardGamesman) {
+		fprintf(out, "%s", prefix);
+		shardGamesmanDetailedPositionResponse(
+			out, inputPositionString, position, positionStringBuffer, moveStringBuffer);
+		return TRUE;
+	}
+	POSITIONLIST *childPositionsSentinel = StorePositionInList(NULL_POSITION, NULL);
+	POSITIONLIST *childPositionsTail = childPositionsSentinel;
+	fprintf(out, "%s{\"position\":\"%s\"", prefix, inputPositionString);
+	if (positionStringMatchesAutoGUIPositionString) {
+		fprintf(out, ",\"autoguiPosition\":\"%s\"", inputPositionString);
+	} else {
+		if (gPositionStringDoMoveFunPtr != NULL && gPositionStringToAutoGUIPositionStringFunPtr != NULL) {
+			gPositionStringToAutoGUIPositionStringFunPtr(inputPositionString, positionStringBuffer);
+		} else {
+			PositionToAutoGUIString(position, positionStringBuffer);
+		}
+		positionStringBuffer[0] = inputPositionString[0]; // Handle impartial games
+		fprintf(out, ",\"autoguiPosition\":\"%s\"", positionStringBuffer);
+	}
+
+	val = GetValueOfPosition(position);
+	rem = Remoteness(position);
+	if (val == tie && rem == 255) {
+		val = drawdraw;
+	}
+	InteractPrintJSONPositionValue(out, val); // e.g. will print ,"value":"win"
+	if (val != drawwin && val != drawlose && val != drawdraw) {
+		fprintf(out, ",\"remoteness\":%d", rem);
+	}
+
+	InteractPrintJSONMEXValue(out, position);
+	if (gPutWinBy) fprintf(out, ",\"winby\":%d", WinByLoad(position));
+	if (kUsePureDraw && (val == drawwin || val == drawlose)) {
+		// If using Pure Draw Analysis, the absence of drawlevel and drawremoteness 
+		// means that this position is not part of a pure draw cluster
+		fprintf(out, ",\"drawLevel\":%d,\"drawRemoteness\":%d", DrawLevelLoad(position), Remoteness(position));
+	}
+
+	fprintf(out, ",\"moves\":[");
+	if (Primitive(position) == undecided) {
+		movesHead = GenerateMoves(position);
+		/* Find all the children first so that their values come
+		   from the DB in one bulk request. */
+		for (numChildren = 0, currentMove = movesHead; currentMove; currentMove = currentMove->next)
+			numChildren++;
+		childPositions = (POSITION *) SafeMalloc((numChildren + 1) * sizeof(POSITION));
+		childValues = (VALUE *) SafeMalloc((numChildren + 1) * sizeof(VALUE));
+		childRemotenesses = (REMOTENESS *) SafeMalloc((numChildren + 1) * sizeof(REMOTENESS));
+		for (childIndex = 0, currentMove = movesHead; currentMove; currentMove = currentMove->next, childIndex++) {
+			childPositions[childIndex] = DoMove(position, currentMove->move);
+			childPositionsTail = AppendToTailOfPositionList(childPositions[childIndex], childPositionsTail);
+		}
+		GetValueAndRemotenessOfPositionBulk(childPositions, childValues, childRemotenesses, numChildren);
+
+		currentMove = movesHead;
+		childIndex = 0;
+		while (currentMove) {
+			childPosition = childPositions[childIndex];
+
+			if (gPositionStringDoMoveFunPtr == NULL) {
+				PositionToAutoGUIString(childPosition, positionStringBuffer);
+				if (positionStringBuffer[0] == '0' && !kPartizan) positionStringBuffer[0] = oppTurnChar; // Handle impartial games
+			} else {
+			 	if (gPositionStringToAutoGUIPositionStringFunPtr != NULL) {
+					gPositionStringDoMoveFunPtr(inputPositionString, currentMove->move, positionStringBuffer2);
+					gPositionStringToAutoGUIPositionStringFunPtr(positionStringBuffer2, positionStringBuffer);
+				} else {
+					gPositionStringDoMoveFunPtr(inputPositionString, currentMove->move, positionStringBuffer);
+				}
+			}
+
+			fprintf(out, "{\"autoguiPosition\":\"%s\"", positionStringBuffer);
+
+			if (!positionStringMatchesAutoGUIPositionString) {
+				if (gPositionStringDoMoveFunPtr == NULL) {
+					gPositionToStringFunPtr(childPosition, positionStringBuffer);
+					if (positionStringBuffer[0] == '0' && !kPartizan) positionStringBuffer[0] = oppTurnChar; // Handle impartial games
+				} else {
+					gPositionStringDoMoveFunPtr(inputPositionString, currentMove->move, positionStringBuffer);
+				}
+			}
+			fprintf(out, ",\"position\":\"%s\"", positionStringBuffer);
+
+			val = childValues[childIndex];
+			rem = childRemotenesses[childIndex];
+			if (val == tie && rem == 255) {
+				val = drawdraw;
+			}
+			InteractPrintJSONPositionValue(out, val);
+			if (val != drawwin && val != drawlose && val != drawdraw) {
+				fprintf(out, ",\"remoteness\":%d", rem);
+			}
+
+			InteractPrintJSONMEXValue(out, childPosition);
+			if (gPutWinBy) fprintf(out, ",\"winby\":%d", WinByLoad(childPosition));
+			if (kUsePureDraw && (val == drawwin || val == drawlose)) {
+				// If using Pure Draw Analysis, the absence of drawlevel and drawremoteness 
+				// means that this position is not part of a pure draw cluster
+				fprintf(out, ",\"drawLevel\":%d,\"drawRemoteness\":%d", DrawLevelLoad(childPosition), Remoteness(childPosition));
+			}
+
+			MoveToString(currentMove->move, moveStringBuffer);
+			fprintf(out, ",\"move\":\"%s\"", moveStringBuffer);
+
+			MoveToAutoGUIString(position, currentMove->move, moveStringBuffer);
+			if (moveStringBuffer[0] != '\0') {
+				// Print this field only if autoguiMove is not an empty string
+				fprintf(out, ",\"autoguiMove\":\"%s\"", moveStringBuffer);
+			}
+
+			currentMove = currentMove->next;
+			childIndex++;
+			fprintf(out, "}");
+			if (currentMove) {
+				fprintf(out, ",");
+			}
+		}
+		SafeFree(childPositions);
+		SafeFree(childValues);
+		SafeFree(childRemotenesses);
+
+		if (gGenerateMultipartMoveEdgesFunPtr != NULL) {
+			MULTIPARTEDGELIST *currEdge = NULL;
+			if (childPositionsSentinel->next != NULL) {
+				currEdge = gGenerateMultipartMoveEdgesFunPtr(position, movesHead, childPositionsSentinel->next);
+			}
+			if (currEdge != NULL) {
+				MULTIPARTEDGELIST *allEdges = currEdge;
+				fprintf(out, "],\"partMoves\":[");
+				while (currEdge != NULL) {
+					MoveToAutoGUIString(position, currEdge->partMove, moveStringBuffer);
+					fprintf(out, "{\"autoguiMove\":\"%s\"", moveStringBuffer);
+
+					MoveToString(currEdge->partMove, moveStringBuffer);
+					fprintf(out, ",\"move\":\"%s\"", moveStringBuffer);
+
+					if (currEdge->from != NULL_POSITION) {
+						PositionToAutoGUIString(currEdge->from, positionStringBuffer);
+						fprintf(out, ",\"from\":\"%s\"", positionStringBuffer);
+					}
+
+					if (currEdge->to != NULL_POSITION) {
+						fprintf(out, ",\"to\":\"%s\"", positionStringBuffer);
+					} else {
+						MoveToString(currEdge->fullMove, moveStringBuffer);
+						fprintf(out, ",\"full\":\"%s\"", moveStringBuffer);
+					}
+					fprintf(out, "}");
+
+					currEdge = currEdge->next;
+					if (currEdge) {
+						fprintf(out, ",");
+					}
+				}
+				FreeMultipartEdgeList(allEdges);
+			}
+		}
+		FreePositionList(childPositionsSentinel);
+		FreeMoveList(movesHead);
+	}
+	fprintf(out, "]}");
+
+	return TRUE;
+}
+
+/* Writes the JSON start_response for the initial position to out. */
+void InteractStartResponse(FILE *out, char *positionStringBuffer) {
+	BOOLEAN positionStringMatchesAutoGUIPositionString = (gPositionStringDoMoveFunPtr == NULL) ? (gPositionToStringFunPtr == NULL) : (gPositionStringToAutoGUIPositionStringFunPtr == NULL);
+
+	if (kExclusivelyTierGamesman) {
+		gInitializeHashWindow(gInitialTier, FALSE);
+	}
+	if (gRandomInitialPositionFunPtr != NULL) {
+		PositionToAutoGUIString(gRandomInitialPositionFunPtr(), positionStringBuffer);
+	} else {
+		PositionToAutoGUIString(gInitialPosition, positionStringBuffer);
+	}
+	if (positionStringBuffer[0] == '0' && !kPartizan) positionStringBuffer[0] = '1'; // Handle Impartial Games
+	fprintf(out, "{\"autoguiPosition\":\"%s\"", positionStringBuffer);
+	if (!positionStringMatchesAutoGUIPositionString) {
+		gPositionToStringFunPtr(gInitialPosition, positionStringBuffer);
+		if (positionStringBuffer[0] == '0' && !kPartizan) positionStringBuffer[0] = '1'; // Handle Impartial Games
+	}
+	fprintf(out, ",\"position\":\"%s\"}", positionStringBuffer);
 }
 
 void ServerInteractLoop(void) {
@@ -124,8 +339,8 @@ void ServerInteractLoop(void) {
 	#define RESULT "result =>> "
 	POSITION position;
 	POSITION childPosition;
-	MOVELIST *currentMove = NULL;
-	MOVELIST *movesHead = NULL;
+	MOVEBUFFER moves;
+	int i;
 	MOVE move;
 	REMOTENESS rem = 0;
 	STRING invalidBoardString = 
@@ -136,8 +351,8 @@ void ServerInteractLoop(void) {
 		sharddb_cache_init();
 	}
 
-	BOOLEAN positionStringMatchesAutoGUIPositionString = (gPositionStringDoMoveFunPtr == NULL) ? (gPositionToStringFunPtr == NULL) : (gPositionStringToAutoGUIPositionStringFunPtr == NULL);
 	char *positionStringBuffer2 = (char *) SafeMalloc(MAX_POSITION_STRING_LENGTH);
+	InitMoveBuffer(&moves);
 	/* Set stdout to do by line buffering so that sever interaction works right.
 	 * Otherwise the "ready =>>" message will sit in the buffer forever while
 	 * the server waits for it.
@@ -169,179 +384,15 @@ void ServerInteractLoop(void) {
 		/* Clear the '\n' so that string comparison is clearer. */
 		*strchr(input, '\n') = '\0';
 		if (FirstWordMatches(input, "position_response") || FirstWordMatches(input, "p")) {
-			if (!InteractReadBoardString(input, &inputPositionString)) {
-				printf("%s", invalidBoardString);
-				continue;
-			}
-			if (kUsesQuartoGamesman) {
-				quartoDetailedPositionResponse(inputPositionString, positionStringBuffer);
-				continue;
-			}
-			char oppTurnChar = (inputPositionString[0] == '1') ? '2' : '1';
-			position = StringToPosition(inputPositionString);
-			if (position == NULL_POSITION) {
+			if (!InteractReadBoardString(input, &inputPositionString) ||
+			    !InteractPositionResponse(stdout, RESULT, inputPositionString,
+			        positionStringBuffer, positionStringBuffer2, moveStringBuffer)) {
 				printf("%s", invalidBoardString);
 				continue;
 			}
-			if (kSupportsShardGamesman) {
-				shardGamesmanDetailedPositionResponse(
-					inputPositionString, position, positionStringBuffer, moveStringBuffer);
-				continue;
-			}
-			POSITIONLIST *childPositionsSentinel = StorePositionInList(NULL_POSITION, NULL);
-			POSITIONLIST *childPositionsTail = childPositionsSentinel;
-			printf(RESULT "{\"position\":\"%s\"", inputPositionString);
-			if (positionStringMatchesAutoGUIPositionString) {
-				printf(",\"autoguiPosition\":\"%s\"", inputPositionString);
-			} else {
-				if (gPositionStringDoMoveFunPtr != NULL && gPositionStringToAutoGUIPositionStringFunPtr != NULL) {
-					gPositionStringToAutoGUIPositionStringFunPtr(inputPositionString, positionStringBuffer);
-				} else {
-					PositionToAutoGUIString(position, positionStringBuffer);
-				}
-				positionStringBuffer[0] = inputPositionString[0]; // Handle impartial games
-				printf(",\"autoguiPosition\":\"%s\"", positionStringBuffer);
-			}
-
-			val = GetValueOfPosition(position);
-			rem = Remoteness(position);
-			if (val == tie && rem == 255) {
-				val = drawdraw;
-			}
-			InteractPrintJSONPositionValue(val); // e.g. will print ,"value":"win"
-			if (val != drawwin && val != drawlose && val != drawdraw) {
-				printf(",\"remoteness\":%d", rem);
-			}
-
-			InteractPrintJSONMEXValue(position);
-			if (gPutWinBy) printf(",\"winby\":%d", WinByLoad(position));
-			if (kUsePureDraw && (val == drawwin || val == drawlose)) {
-				// If using Pure Draw Analysis, the absence of drawlevel and drawremoteness 
-				// means that this position is not part of a pure draw cluster
-				printf(",\"drawLevel\":%d,\"drawRemoteness\":%d", DrawLevelLoad(position), Remoteness(position));
-			}
-
-			printf(",\"moves\":[");
-			if (Primitive(position) == undecided) {
-				currentMove = movesHead = GenerateMoves(position);
-				while (currentMove) {
-					childPosition = DoMove(position, currentMove->move);
-					childPositionsTail = AppendToTailOfPositionList(childPosition, childPositionsTail);
-
-					if (gPositionStringDoMoveFunPtr == NULL) {
-						PositionToAutoGUIString(childPosition, positionStringBuffer);
-						if (positionStringBuffer[0] == '0' && !kPartizan) positionStringBuffer[0] = oppTurnChar; // Handle impartial games
-					} else {
-					 	if (gPositionStringToAutoGUIPositionStringFunPtr != NULL) {
-							gPositionStringDoMoveFunPtr(inputPositionString, currentMove->move, positionStringBuffer2);
-							gPositionStringToAutoGUIPositionStringFunPtr(positionStringBuffer2, positionStringBuffer);
-						} else {
-							gPositionStringDoMoveFunPtr(inputPositionString, currentMove->move, positionStringBuffer);
-						}
-					}
-
-					printf("{\"autoguiPosition\":\"%s\"", positionStringBuffer);
-
-					if (!positionStringMatchesAutoGUIPositionString) {
-						if (gPositionStringDoMoveFunPtr == NULL) {
-							gPositionToStringFunPtr(childPosition, positionStringBuffer);
-							if (positionStringBuffer[0] == '0' && !kPartizan) positionStringBuffer[0] = oppTurnChar; // Handle impartial games
-						} else {
-							gPositionStringDoMoveFunPtr(inputPositionString, currentMove->move, positionStringBuffer);
-						}
-					}
-					printf(",\"position\":\"%s\"", positionStringBuffer);
-
-					val = GetValueOfPosition(childPosition);
-					rem = Remoteness(childPosition);
-					if (val == tie && rem == 255) {
-						val = drawdraw;
-					}
-					InteractPrintJSONPositionValue(val);
-					if (val != drawwin && val != drawlose && val != drawdraw) {
-						printf(",\"remoteness\":%d", rem);
-					}
-
-					InteractPrintJSONMEXValue(childPosition);
-					if (gPutWinBy) printf(",\"winby\":%d", WinByLoad(childPosition));
-					if (kUsePureDraw && (val == drawwin || val == drawlose)) {
-						// If using Pure Draw Analysis, the absence of drawlevel and drawremoteness 
-						// means that this position is not part of a pure draw cluster
-						printf(",\"drawLevel\":%d,\"drawRemoteness\":%d", DrawLevelLoad(childPosition), Remoteness(childPosition));
-					}
-
-					MoveToString(currentMove->move, moveStringBuffer);
-					printf(",\"move\":\"%s\"", moveStringBuffer);
-
-					MoveToAutoGUIString(position, currentMove->move, moveStringBuffer);
-					if (moveStringBuffer[0] != '\0') {
-						// Print this field only if autoguiMove is not an empty string
-						printf(",\"autoguiMove\":\"%s\"", moveStringBuffer);
-					}
-
-					currentMove = currentMove->next;
-					printf("}");
-					if (currentMove) {
-						printf(",");
-					}
-				}
-
-				if (gGenerateMultipartMoveEdgesFunPtr != NULL) {
-					MULTIPARTEDGELIST *currEdge = NULL;
-					if (childPositionsSentinel->next != NULL) {
-						currEdge = gGenerateMultipartMoveEdgesFunPtr(position, movesHead, childPositionsSentinel->next);
-					}
-					if (currEdge != NULL) {
-						MULTIPARTEDGELIST *allEdges = currEdge;
-						printf("],\"partMoves\":[");
-						while (currEdge != NULL) {
-							MoveToAutoGUIString(position, currEdge->partMove, moveStringBuffer);
-							printf("{\"autoguiMove\":\"%s\"", moveStringBuffer);
-
-							MoveToString(currEdge->partMove, moveStringBuffer);
-							printf(",\"move\":\"%s\"", moveStringBuffer);
-
-							if (currEdge->from != NULL_POSITION) {
-								PositionToAutoGUIString(currEdge->from, positionStringBuffer);
-								printf(",\"from\":\"%s\"", positionStringBuffer);
-							}
-
-							if (currEdge->to != NULL_POSITION) {
-								printf(",\"to\":\"%s\"", positionStringBuffer);
-							} else {
-								MoveToString(currEdge->fullMove, moveStringBuffer);
-								printf(",\"full\":\"%s\"", moveStringBuffer);
-							}
-							printf("}");
-
-							currEdge = currEdge->next;
-							if (currEdge) {
-								printf(",");
-							}
-						}
-						FreeMultipartEdgeList(allEdges);
-					}
-				}
-				FreePositionList(childPositionsSentinel);
-				FreeMoveList(movesHead);
-			}
-			printf("]}");
 		} else if (FirstWordMatches(input, "start_response")) {
-			if (kExclusivelyTierGamesman) {
-				gInitializeHashWindow(gInitialTier, FALSE);
-			}
-			if (gRandomInitialPositionFunPtr != NULL) {
-				PositionToAutoGUIString(gRandomInitialPositionFunPtr(), positionStringBuffer);
-			} else {
-				PositionToAutoGUIString(gInitialPosition, positionStringBuffer);
-			}
-			if (positionStringBuffer[0] == '0' && !kPartizan) positionStringBuffer[0] = '1'; // Handle Impartial Games
-			printf(RESULT "{\"autoguiPosition\":\"%s\"", positionStringBuffer);
-			if (!positionStringMatchesAutoGUIPositionString) {
-				gPositionToStringFunPtr(gInitialPosition, positionStringBuffer);
-				if (positionStringBuffer[0] == '0' && !kPartizan) positionStringBuffer[0] = '1'; // Handle Impartial Games
-			}
-			printf(",\"position\":\"%s\"}", positionStringBuffer);
+			printf(RESULT);
+			InteractStartResponse(stdout, positionStringBuffer);
 		} else if (FirstWordMatches(input, "start")) {
 			InteractCheckErrantExtra(input, 1);
 			printf(RESULT POSITION_FORMAT, gInitialPosition);
@@ -369,67 +420,59 @@ void ServerInteractLoop(void) {
 			}
 			InteractCheckErrantExtra(input, 2);
 			printf(RESULT "[");
-			currentMove = movesHead = GenerateMoves(position);
-			while (currentMove) {
-				childPosition = DoMove(position, currentMove->move);
-				currentMove = currentMove->next;
+			GenerateMovesToBuffer(position, &moves);
+			for (i = 0; i < moves.count; i++) {
+				childPosition = DoMove(position, moves.moves[i]);
 				printf(POSITION_FORMAT, childPosition);
-				if (currentMove) {
+				if (i + 1 < moves.count) {
 					printf(", ");
 				}
 			}
 			printf("]");
-			FreeMoveList(movesHead);
 		} else if (FirstWordMatches(input, "moves")) {
 			if (!InteractReadPosition(input, &position)) {
 				continue;
 			}
 			InteractCheckErrantExtra(input, 2);
 			printf(RESULT "[");
-			currentMove = movesHead = GenerateMoves(position);
-			while (currentMove) {
-				printf("%d", currentMove->move);
-				currentMove = currentMove->next;
-				if (currentMove) {
+			GenerateMovesToBuffer(position, &moves);
+			for (i = 0; i < moves.count; i++) {
+				printf("%d", moves.moves[i]);
+				if (i + 1 < moves.count) {
 					printf(", ");
 				}
 			}
 			printf("]");
-			FreeMoveList(movesHead);
 		} else if (FirstWordMatches(input, "moves")) {
 			if (!InteractReadPosition(input, &position)) {
 				continue;
 			}
 			InteractCheckErrantExtra(input, 2);
 			printf(RESULT "[");
-			currentMove = movesHead = GenerateMoves(position);
-			while (currentMove) {
-				MoveToString(currentMove->move, moveStringBuffer);
+			GenerateMovesToBuffer(position, &moves);
+			for (i = 0; i < moves.count; i++) {
+				MoveToString(moves.moves[i], moveStringBuffer);
 				printf("%s", moveStringBuffer);
-				currentMove = currentMove->next;
-				if (currentMove) {
+				if (i + 1 < moves.count) {
 					printf(", ");
 				}
 			}
 			printf("]");
-			FreeMoveList(movesHead);
 		} else if (FirstWordMatches(input, "autogui_moves")) {
 			if (!InteractReadPosition(input, &position)) {
 				continue;
 			}
 			InteractCheckErrantExtra(input, 2);
 			printf(RESULT "[");
-			currentMove = movesHead = GenerateMoves(position);
-			while (currentMove) {
-				MoveToAutoGUIString(position, currentMove->move, moveStringBuffer);
+			GenerateMovesToBuffer(position, &moves);
+			for (i = 0; i < moves.count; i++) {
+				MoveToAutoGUIString(position, moves.moves[i], moveStringBuffer);
 				printf("%s", moveStringBuffer);
-				currentMove = currentMove->next;
-				if (currentMove) {
+				if (i + 1 < moves.count) {
 					printf(", ");
 				}
 			}
 			printf("]");
-			FreeMoveList(movesHead);
 		} else if (FirstWordMatches(input, "position_string")) {
 			if (InteractReadPosition(input, &position)) {
 				InteractCheckErrantExtra(input, 2);
@@ -509,6 +552,7 @@ void ServerInteractLoop(void) {
 	SafeFree(positionStringBuffer);
 	SafeFree(moveStringBuffer);
 	SafeFree(positionStringBuffer2);
+	FreeMoveBuffer(&moves);
 	#undef RESULT
 }
 
@@ -15,7 +15,11 @@ STRING InteractReadPosition(STRING input, POSITION * result);
 STRING InteractReadLong(STRING input, long * result);
 STRING InteractReadBoardString(STRING input, char ** result);
 STRING InteractValueCharToValueString(char value_char);
-void InteractPrintJSONPositionValue(VALUE value);
+void InteractPrintJSONPositionValue(FILE *out, VALUE value);
+void InteractPrintJSONMEXValue(FILE *out, POSITION position);
+BOOLEAN InteractPositionResponse(FILE *out, STRING prefix, STRING inputPositionString,
+		char *positionStringBuffer, char *positionStringBuffer2, char *moveStringBuffer);
+void InteractStartResponse(FILE *out, char *positionStringBuffer);
 void InteractCheckErrantExtra(STRING input, int max_words);
 void ServerInteractLoop(void);
 extern POSITION gInitialPosition;
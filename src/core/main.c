@@ -44,6 +44,7 @@
 #include "hash.h"
 #include "visualization.h"
 #include "openPositions.h"
+#include "httpserver.h"
 //#include "Parallel.h"
 extern POSITION StringToPosition(STRING str);
 
@@ -106,7 +107,10 @@ void SetSolver()
 		return;
 	else if (kLoopy) {
 		if (gGoAgain == DefaultGoAgain) {
-			if(gBitPerfectDBSolver) {
+			if (gCSRLoopySolver && !kUsePureDraw) {
+				gBitPerfectDBSolver = FALSE;
+				gSolver = &CSRDetermineLoopyValue;
+			} else if(gBitPerfectDBSolver) {
 				if (kUsePureDraw) {
 					gSolver = &lpds_DetermineValue;
 				} else {
@@ -185,7 +189,9 @@ VALUE DetermineValue(POSITION position)
 		//}
 
 	} else if (gLoadDatabase && LoadDatabase()) {
-		if (GetValueOfPosition(position) == undecided) {
+		/* The network DB cannot be solved into; an unreachable server just
+		   leaves positions undecided. */
+		if (!gNetworkDB && GetValueOfPosition(position) == undecided) {
 			if (gPrintDatabaseInfo)
 				printf("\nRe-evaluating the value of %s...", kGameName);
 			gSolver(position);
@@ -331,6 +337,8 @@ void HandleArguments (int argc, char *argv[])
 			gGlobalPositionSolver = TRUE;
 		} else if (!strcasecmp(argv[i], "--bottomup")) {
 			gBottomUp = TRUE;
+		} else if (!strcasecmp(argv[i], "--csrloopy")) {
+			gCSRLoopySolver = TRUE;
 		} else if (!strcasecmp(argv[i], "--alpha-beta")) {
 			gAlphaBeta = TRUE;
 		} else if (!strcasecmp(argv[i], "--lowmem")) {
@@ -374,6 +382,30 @@ void HandleArguments (int argc, char *argv[])
 				fprintf(stderr, "No tier given for solve only tier option\n\n");
 				gMessage = TRUE;
 			}
+		} else if (!strcasecmp(argv[i], "--threads")) {
+			if ((i + 1) < argc) {
+				gTierSolverThreads = atoi(argv[++i]);
+				if (gTierSolverThreads <= 0) {
+					fprintf(stderr, "Number of solver threads is not valid\n\n");
+					gMessage = TRUE;
+				}
+			} else {
+				fprintf(stderr, "No thread count given for threads option\n\n");
+				gMessage = TRUE;
+			}
+		} else if (!strcasecmp(argv[i], "--processes")) {
+			if ((i + 1) < argc) {
+				gTierSolverProcesses = atoi(argv[++i]);
+				if (gTierSolverProcesses <= 0) {
+					fprintf(stderr, "Number of solver processes is not valid\n\n");
+					gMessage = TRUE;
+				}
+			} else {
+				fprintf(stderr, "No process count given for processes option\n\n");
+				gMessage = TRUE;
+			}
+		} else if (!strcasecmp(argv[i], "--rescantierdbs")) {
+			gTierDBRescan = TRUE;
 		} else if (!strcasecmp(argv[i], "--notiermenu")) {
 			gTierSolverMenu = FALSE;
 		} else if (!strcasecmp(argv[i], "--notierprint")) {
@@ -467,12 +499,20 @@ void HandleArguments (int argc, char *argv[])
 			gNetworkDB = TRUE;
 			gBitPerfectDB = FALSE;
 			gBitPerfectDBSolver = FALSE;
-			if ((i + 1) < argc) {
-				ServerAddress = argv[i++];
+			if ((i + 1) < argc && argv[i + 1][0] != '-') {
+				ServerAddress = argv[++i];
 			}
 		} else if (!strcasecmp(argv[i],"--hashCounting")) {
 			hashCounting();
 			return;
+		} else if (!strcasecmp(argv[i], "--hashBench")) {
+			InitializeGame();
+			if (generic_hash_num_contexts() == 0)
+				fprintf(stderr, "\nThis game does not use the generic hash.\n\n");
+			else if (generic_hash_benchmark(((i + 1) < argc) ? atoi(argv[i + 1]) : 0) != 0)
+				exit(1); // for make check
+			i += argc;
+			gMessage = TRUE;
 		} else if (!strcasecmp(argv[i],"--hashtable_buckets")) {
 			if(argc < (i + 2)) {
 				fprintf(stderr, "\nUsage: %s --hashtable_buckets <n>\n\n",
@@ -585,6 +625,22 @@ void HandleArguments (int argc, char *argv[])
 			gamesman_main(argv[0]);
 			ServerInteractLoop();
 			gMessage = TRUE;
+		} else if (!strcasecmp(argv[i], "--serve")) {
+			char *end = NULL;
+			long port = ((i + 1) < argc) ? strtol(argv[i + 1], &end, 10) : 0;
+			if (end && end != argv[i + 1] && *end == '\0' && port >= 1 && port <= 65535) {
+				STRING host = NULL;
+				i++;
+				if ((i + 1) < argc && strncmp(argv[i + 1], "--", 2))
+					host = argv[++i];
+				gIsInteract = TRUE;
+				gJustSolving = TRUE;
+				gamesman_main(argv[0]);
+				ServeHTTP(argv[0], host, (int) port);
+			} else {
+				fprintf(stderr, "No valid port (1-65535) given for serve option\n\n");
+			}
+			gMessage = TRUE;
 		} else {
 			fprintf(stderr, "\nInvalid option or missing parameter: %s, use %s --help for help\n\n", argv[i], argv[0]);
 			gMessage = TRUE;
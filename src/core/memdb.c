@@ -68,6 +68,16 @@ MEX             memdb_get_mex                   (POSITION pos);
 MEX             memdb_get_mex_file              (POSITION pos);
 void            memdb_set_mex                   (POSITION pos, MEX mex);
 
+/* Bulk, straight on memdb_array */
+void            memdb_get_value_bulk            (POSITION* positions, VALUE* values, int length);
+void            memdb_set_value_bulk            (POSITION* positions, VALUE* values, int length);
+void            memdb_get_remoteness_bulk       (POSITION* positions, REMOTENESS* remotenesses, int length);
+void            memdb_set_remoteness_bulk       (POSITION* positions, REMOTENESS* remotenesses, int length);
+void            memdb_get_mex_bulk              (POSITION* positions, MEX* mexes, int length);
+void            memdb_set_mex_bulk              (POSITION* positions, MEX* mexes, int length);
+void            memdb_check_visited_bulk        (POSITION* positions, BOOLEAN* visited, int length);
+void            memdb_mark_visited_bulk         (POSITION* positions, int length);
+
 /* saving to/reading from a file */
 BOOLEAN         memdb_save_database             ();
 BOOLEAN         memdb_load_database             ();
@@ -119,6 +129,10 @@ void memdb_init(DB_Table *new_db)
 		new_db->mark_visited = NULL;
 		new_db->unmark_visited = NULL;
 		new_db->put_mex = NULL;
+		new_db->put_value_bulk = NULL;
+		new_db->put_remoteness_bulk = NULL;
+		new_db->put_mex_bulk = NULL;
+		new_db->mark_visited_bulk = NULL;
 		new_db->free_db = memdb_close_file;
 
 		dirty = TRUE;
@@ -138,6 +152,16 @@ void memdb_init(DB_Table *new_db)
 		new_db->put_mex = memdb_set_mex;
 		new_db->put_winby = NULL;
 		new_db->free_db = memdb_free;
+
+		/* the file reader keeps the default bulk loops */
+		new_db->get_value_bulk = memdb_get_value_bulk;
+		new_db->put_value_bulk = memdb_set_value_bulk;
+		new_db->get_remoteness_bulk = memdb_get_remoteness_bulk;
+		new_db->put_remoteness_bulk = memdb_set_remoteness_bulk;
+		new_db->get_mex_bulk = memdb_get_mex_bulk;
+		new_db->put_mex_bulk = memdb_set_mex_bulk;
+		new_db->check_visited_bulk = memdb_check_visited_bulk;
+		new_db->mark_visited_bulk = memdb_mark_visited_bulk;
 	}
 
 	new_db->get_value = memdb_get_value;
@@ -282,6 +306,68 @@ MEX memdb_get_mex(POSITION pos)
 	return (MEX)(((int)*ptr & MEX_MASK) >> MEX_SHIFT);
 }
 
+void memdb_get_value_bulk(POSITION* positions, VALUE* values, int length)
+{
+	int i;
+	for (i = 0; i < length; i++)
+		values[i] = (VALUE)((int)memdb_array[positions[i]] & VALUE_MASK);
+}
+
+void memdb_set_value_bulk(POSITION* positions, VALUE* values, int length)
+{
+	int i;
+	cellValue *ptr;
+	for (i = 0; i < length; i++) {
+		ptr = &memdb_array[positions[i]];
+		*ptr = (((int)*ptr & ~VALUE_MASK) | (values[i] & VALUE_MASK));
+	}
+}
+
+void memdb_get_remoteness_bulk(POSITION* positions, REMOTENESS* remotenesses, int length)
+{
+	int i;
+	for (i = 0; i < length; i++)
+		remotenesses[i] = (REMOTENESS)(((int)memdb_array[positions[i]] & REMOTENESS_MASK) >> REMOTENESS_SHIFT);
+}
+
+void memdb_set_remoteness_bulk(POSITION* positions, REMOTENESS* remotenesses, int length)
+{
+	int i;
+	for (i = 0; i < length; i++)
+		memdb_set_remoteness(positions[i], remotenesses[i]);
+}
+
+void memdb_get_mex_bulk(POSITION* positions, MEX* mexes, int length)
+{
+	int i;
+	for (i = 0; i < length; i++)
+		mexes[i] = (MEX)(((int)memdb_array[positions[i]] & MEX_MASK) >> MEX_SHIFT);
+}
+
+void memdb_set_mex_bulk(POSITION* positions, MEX* mexes, int length)
+{
+	int i;
+	cellValue *ptr;
+	for (i = 0; i < length; i++) {
+		ptr = &memdb_array[positions[i]];
+		*ptr = (((int)*ptr & ~MEX_MASK) | ((mexes[i] & (MEX_MASK >> MEX_SHIFT)) << MEX_SHIFT));
+	}
+}
+
+void memdb_check_visited_bulk(POSITION* positions, BOOLEAN* visited, int length)
+{
+	int i;
+	for (i = 0; i < length; i++)
+		visited[i] = (BOOLEAN)(((int)memdb_array[positions[i]] & VISITED_MASK) == VISITED_MASK);
+}
+
+void memdb_mark_visited_bulk(POSITION* positions, int length)
+{
+	int i;
+	for (i = 0; i < length; i++)
+		memdb_array[positions[i]] |= VISITED_MASK;
+}
+
 
 /***********
  ************
@@ -362,6 +362,63 @@ MOVELIST *CreateMovelistNode(MOVE theMove, MOVELIST* theNextMove)
 	return(theHead);
 }
 
+void InitMoveBuffer(MOVEBUFFER* buffer)
+{
+	buffer->moves = NULL;
+	buffer->count = 0;
+	buffer->capacity = 0;
+}
+
+void FreeMoveBuffer(MOVEBUFFER* buffer)
+{
+	if (buffer->moves != NULL)
+		SafeFree(buffer->moves);
+	InitMoveBuffer(buffer);
+}
+
+static void GrowMoveBuffer(MOVEBUFFER* buffer, int capacity)
+{
+	if (capacity < MAXFANOUT)
+		capacity = MAXFANOUT;
+	if (capacity < 2 * buffer->capacity)
+		capacity = 2 * buffer->capacity;
+	if (buffer->moves == NULL)
+		buffer->moves = (MOVE *) SafeMalloc(sizeof(MOVE) * capacity);
+	else buffer->moves = (MOVE *) SafeRealloc(buffer->moves, sizeof(MOVE) * capacity);
+	buffer->capacity = capacity;
+}
+
+/* Fills buffer with the moves of pos, in the order GenerateMoves() lists
+   them, and returns how many there are. Games with gGenerateMovesArrayFunPtr
+   write straight into the buffer, so once it has grown to the game's
+   fan-out nothing is allocated; for the rest, the MOVELIST is copied and
+   freed. */
+int GenerateMovesToBuffer(POSITION pos, MOVEBUFFER* buffer)
+{
+	MOVELIST *head, *ptr;
+	int count;
+
+	if (gGenerateMovesArrayFunPtr != NULL) {
+		if (buffer->capacity == 0)
+			GrowMoveBuffer(buffer, MAXFANOUT);
+		count = gGenerateMovesArrayFunPtr(pos, buffer->moves, buffer->capacity);
+		if (count > buffer->capacity) {
+			GrowMoveBuffer(buffer, count);
+			count = gGenerateMovesArrayFunPtr(pos, buffer->moves, buffer->capacity);
+		}
+	} else {
+		head = GenerateMoves(pos);
+		for (count = 0, ptr = head; ptr != NULL; ptr = ptr->next, count++) {
+			if (count == buffer->capacity)
+				GrowMoveBuffer(buffer, count + 1);
+			buffer->moves[count] = ptr->move;
+		}
+		FreeMoveList(head);
+	}
+	buffer->count = count;
+	return count;
+}
+
 MULTIPARTEDGELIST *CreateMultipartEdgeListNode(POSITION from, POSITION to, MOVE partMove, MOVE fullMove, MULTIPARTEDGELIST* next)
 {
 	MULTIPARTEDGELIST* theHead = (MULTIPARTEDGELIST*) SafeMalloc (sizeof(MULTIPARTEDGELIST));
@@ -553,6 +610,52 @@ BOOLEAN RemoveTierFromList (TIER theTier, TIERLIST** theTierlist) {
 	return TRUE;
 }
 
+/* Arena counterparts of the list helpers above. The nodes are carved out
+   of arena, so building a list costs no malloc and the solver can drop
+   every list in the arena with one slab_reset(). */
+POSITIONLIST *StorePositionInListArena(POSITION pos, POSITIONLIST* head, slab_arena* arena)
+{
+	POSITIONLIST *tmp;
+
+	tmp = (POSITIONLIST *) slab_alloc(arena, sizeof(POSITIONLIST));
+	tmp->position = pos;
+	tmp->next     = head;
+
+	return(tmp);
+}
+
+void FreePositionListArena(POSITIONLIST* ptr, slab_arena* arena)
+{
+	POSITIONLIST *last;
+	while (ptr != NULL) {
+		last = ptr;
+		ptr = ptr->next;
+		slab_free(arena, last, sizeof(POSITIONLIST));
+	}
+}
+
+void AddPositionToQueueArena(POSITION pos, POSITIONQUEUE** tail, slab_arena* arena)
+{
+	POSITIONQUEUE* new_node = (POSITIONQUEUE *) slab_alloc(arena, sizeof(POSITIONQUEUE));
+
+	new_node->position = pos;
+	new_node->next = NULL;
+	if (*tail)
+		(*tail)->next = new_node;
+	(*tail) = new_node;
+}
+
+POSITION RemovePositionFromQueueArena(POSITIONQUEUE** head, slab_arena* arena)
+{
+	POSITION result = (*head)->position;
+	POSITIONQUEUE *nextnode = (*head)->next;
+
+	slab_free(arena, *head, sizeof(POSITIONQUEUE));
+	(*head) = nextnode;
+
+	return result;
+}
+
 // list constructor function for UndoMoveLists:
 UNDOMOVELIST *CreateUndoMovelistNode(UNDOMOVE theUndoMove, UNDOMOVELIST* theNextUndoMove)
 {
@@ -3,6 +3,7 @@
 #define GMCORE_MISC_H
 
 #include <stddef.h>
+#include "slab.h"
 
 size_t          MoveListLength                  (MOVELIST *ptr);
 void            FreeMoveList                    (MOVELIST* ptr);
@@ -40,6 +41,10 @@ void            BadElse                         (STRING function);
 MOVELIST*       CreateMovelistNode              (MOVE move, MOVELIST* tail);
 MOVELIST*       CopyMovelist                    (MOVELIST* list);
 
+void            InitMoveBuffer                  (MOVEBUFFER* buffer);
+void            FreeMoveBuffer                  (MOVEBUFFER* buffer);
+int             GenerateMovesToBuffer           (POSITION pos, MOVEBUFFER* buffer);
+
 POSITIONLIST*   StorePositionInList             (POSITION pos, POSITIONLIST* head);
 POSITIONLIST*   AppendToTailOfPositionList      (POSITION pos, POSITIONLIST* tail);
 POSITIONLIST*   CopyPositionList                (POSITIONLIST* list);
@@ -60,6 +65,14 @@ TIERLIST*       MoveToFrontOfTierlist   (TIER theTier, TIERLIST* theTierlist);
 BOOLEAN         TierInList                              (TIER theTier, TIERLIST* theTierlist);
 BOOLEAN         RemoveTierFromList              (TIER theTier, TIERLIST** theTierlist);
 
+/* The same, with the nodes in a slab arena. Lists built this way must be
+   given back with the Arena free functions (or all at once by resetting
+   the arena), never with FreePositionList() and friends. */
+POSITIONLIST*   StorePositionInListArena        (POSITION pos, POSITIONLIST* head, slab_arena* arena);
+void            FreePositionListArena           (POSITIONLIST* ptr, slab_arena* arena);
+void            AddPositionToQueueArena         (POSITION pos, POSITIONQUEUE** tail, slab_arena* arena);
+POSITION        RemovePositionFromQueueArena    (POSITIONQUEUE** head, slab_arena* arena);
+
 UNDOMOVELIST*   CreateUndoMovelistNode          (UNDOMOVE theUndoMove, UNDOMOVELIST* theNextUndoMove);
 MULTIPARTEDGELIST* CreateMultipartEdgeListNode(POSITION from, POSITION to, MOVE partMove, MOVE fullMove, MULTIPARTEDGELIST* next);
 
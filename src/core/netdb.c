@@ -30,7 +30,7 @@
 
 
 **
-**  ERROR: is crash out with printf: We will do this for now until we think of something better
+**  ERROR: reported on stderr; positions the server could not answer read as undecided
 **
 
 
@@ -49,8 +49,7 @@
 
 typedef short cellValue;
 
-void            netdb_close                     (){
-};                                                    //nothing
+void            netdb_close                     ();
 /* Value */
 VALUE           netdb_get_value                 (POSITION pos);
 
@@ -67,32 +66,53 @@ void netdb_get_bulk (POSITION* positions, VALUE* ValueArray, REMOTENESS* remoten
 /* saving to/reading from a file */
 BOOLEAN         netdb_load_database             ();
 
-/*LUI replacement algorithm using nth-chance clock*/
-/*This would probably be faster as a hash, but for small cache_Size < 100
- * naive looping may be better*/
-/*for smart db*/
-#define CACHE_SIZE 100
-#define CLOCK_LOOPS 5 //number of clock interations
-POSITION p_cache[CACHE_SIZE];
-cellValue v_cache[CACHE_SIZE];
-uint8_t cache_sweep[CACHE_SIZE]; //0 = fresh; CLOCK_LOOPS = replace
-short valid_num = 0; //index of first invalid entry
-short c_clock =0;         //the clock hand
-
-//cache prototypes:
-
-//FIXME: exact LRU should be used!
-//linked list?
-
+/* Lookups that miss the cache are sent in batches of at most
+ * NETDB_BATCH_MAX positions over one keep-alive connection, with up to
+ * NETDB_PIPELINE_DEPTH batches written before their responses are read.
+ * netdb_prefetch sends batches without waiting for them, so their answers
+ * arrive while the player is thinking and the next lookup is coalesced
+ * with them instead of costing its own round trip.
+ */
+#define NETDB_BATCH_MAX 1024
+#define NETDB_PIPELINE_DEPTH 4
+#define NETDB_RETRIES 1
+
+/* Direct-mapped cache of server answers. */
+#define NETDB_CACHE_BITS 16
+#define NETDB_CACHE_SIZE (1 << NETDB_CACHE_BITS)
+
+typedef struct {
+	POSITION pos;
+	cellValue cell;
+	BOOLEAN valid;
+} netdb_cache_entry;
+
+static netdb_cache_entry netdb_cache[NETDB_CACHE_SIZE];
+
+/* One request on the wire. Results for a blocking lookup are also
+ * written to dest[destIndex[i]]; prefetches have dest == NULL. */
+typedef struct {
+	POSITION positions[NETDB_BATCH_MAX];
+	int destIndex[NETDB_BATCH_MAX];
+	cellValue *dest;
+	int length;
+	int retries;
+	BOOLEAN dropped;
+} netdb_batch;
+
+static httpconn *netdb_conn = NULL;
+static netdb_batch netdb_inflight[NETDB_PIPELINE_DEPTH];
+static int netdb_inflight_head = 0;
+static int netdb_inflight_count = 0;
 
 //get cached position
 BOOLEAN get_position (POSITION pos, cellValue * outcell);
 
-
 //set cached position:
 void set_position (POSITION pos, cellValue cv);
 
-void checkResponseForErrors(httpres *res);
+BOOLEAN checkResponseForErrors(httpres *res);
+BOOLEAN netdb_init_db();
 
 /*
 ** Code
@@ -117,158 +137,262 @@ void netdb_init(DB_Table *new_db)
 }
 
 
-void error(char * reason, int code) /*fixme: handle better*/
+void error(char * reason, int code)
 {
-	(void) code;
-	fprintf(stderr, "\nCRITICAL NETDB ERROR:\n");
-	fprintf(stderr, "%s\n",reason);
-	exit(1);
+	fprintf(stderr, "\nNETDB ERROR (%d): %s\n", code, reason ? reason : "unknown error");
 }
 
 void badResponseCode(char * reason, int code)
 {
 	(void) reason;
-	fprintf(stderr, "\nCRITICAL NETDB ERROR:\n");
-	fprintf(stderr, "Server responded with HTTP status code: %d\n", code);
-	exit(1);
+	fprintf(stderr, "\nNETDB ERROR: Server responded with HTTP status code: %d\n", code);
 }
 
-//warning: syncronous net sending
-//will need to rewrite to be asynch
-
-void netdb_get_raw(POSITION * positions, cellValue * cells, int length){ //dispatch to get cells
-	httpreq *req;
-	httpres *res;
-	char* errMsg;
-
-	//byte found[] = malloc(sizeof(int)*length); //array to note found items
-	//fixme: reduce server request based on a bitmap!
-
-	//before we do anything, access the cache:
-	BOOLEAN allcached = TRUE;
-	int i;
-	for (i = 0; i< length; i++) {
-		if (!get_position(positions[i], cells + i))
-			allcached = FALSE;
+/* Opens (resolves) the connection to ServerAddress on first use. */
+static BOOLEAN netdb_connect()
+{
+	char *url, *errMsg = NULL;
+
+	if (netdb_conn != NULL)
+		return TRUE;
+	url = (char *) SafeMalloc(strlen(ServerAddress) + 1);
+	strcpy(url, ServerAddress);
+	if (newconnection(url, &netdb_conn, &errMsg) != 0) {
+		error(errMsg, 1);
+		free(errMsg);
+		netdb_conn = NULL;
 	}
-	if (allcached) //done
-		return;
-
-
-
-	char * url = malloc(strlen(ServerAddress)+1);
-	memcpy(url,ServerAddress,strlen(ServerAddress)+1);
+	SafeFree(url);
+	return netdb_conn != NULL;
+}
 
+/* Writes the request for batch to the connection. */
+static BOOLEAN netdb_send(netdb_batch *batch)
+{
+	httpreq *req;
+	char *errMsg = NULL;
 	char option[32]; //option encoding
 	char length_str[32]; //length encoding
+	POSITION body[NETDB_BATCH_MAX];
+	int i;
 
-	//connect to the server
-	if (newrequest(url, &req, &errMsg) != 0)
-	{
-		fprintf(stderr, "Problem creating request: %s\n", errMsg);
-		exit(1);
-	}
+	if (!netdb_connect() || newconnrequest(netdb_conn, &req) != 0)
+		return FALSE;
 
 	settype(req, HD_GET_VALUE_OF_POSITIONS);
-
-	addheader(req, HD_GAME_NAME,  kDBName);
-
-	net_itoa(getOption(),option);
+	addheader(req, HD_GAME_NAME, kDBName);
+	net_itoa(getOption(), option);
 	addheader(req, HD_GAME_VARIANT, option);
+	net_itoa(batch->length, length_str);
+	addheader(req, HD_LENGTH, length_str);
 
-	net_itoa(length,length_str);
-	addheader(req,HD_LENGTH,length_str);
-
-	//now generate the body:
-	POSITION * positions_copy = malloc(sizeof(POSITION)*length);
-	//position is 64 bit.. must convert
+	//position is 64 bit.. must convert to net order
+	for (i = 0; i < batch->length; i++)
+		body[i] = htonll(batch->positions[i]);
 
-	for (i=0; i<length; i++) {
-		positions_copy[i] = htonll(positions[i]); //convert to net order
+	if (sendrequest(netdb_conn, req, (char *) body, batch->length * sizeof(POSITION), &errMsg) != 0) {
+		error(errMsg, 2);
+		free(errMsg);
+		return FALSE;
 	}
+	return TRUE;
+}
 
-	//now post
-	if ((post(req,(char*)positions_copy,length*sizeof(POSITION), &res, &errMsg)) != 0)
-	{
-		fprintf(stderr, "Problem posting to the server: %s\n", errMsg);
-		exit(1);
+/* Reads the answer to batch, which must be the oldest request on the
+ * connection, into the cache and batch->dest. Returns 1 on success, 0 if
+ * the connection was lost and -1 if the server rejected the request.
+ */
+static int netdb_receive(netdb_batch *batch)
+{
+	httpres *res;
+	char *errMsg = NULL, *len_str;
+	cellValue *resvals, cell;
+	int i, ok;
+
+	if (receiveresponse(netdb_conn, &res, &errMsg) != 0) {
+		error(errMsg, 3);
+		free(errMsg);
+		freeresponse(res);
+		return 0;
 	}
-
-	free (positions_copy);
-	//now check errors:
-
-	//debug:
-	//printf("%s: %s\n", "Date", getheader(res, "date"));
-	//	printf("%s: %s\n", "Content-Length", getheader(res, "Content-Length"));
-	//	printf("%s: %s\n", "ReturnCode", getheader(res, HD_RETURN_CODE));
-	//	printf("%s: %s\n", "ReturnMessage", getheader(res, HD_RETURN_MESSAGE));
-
-	//normal:
-	//FIXME: check status
-	char* tmpVal;
-	getheader(res,"date",&tmpVal);
-	if (tmpVal == NULL) { //all real responses have this
-		error("Server did not respond to http request",10);
+	if (!checkResponseForErrors(res)) {
+		freeresponse(res);
+		return -1;
 	}
 
-	char * ecode_str;
-	getheader(res,HD_RETURN_CODE,&ecode_str);
-	if (ecode_str == NULL) {
-		error("Server sent back invalid response",11);
-	}
-	int ecode = atoi(ecode_str);
-	// printf("return code - %d\n",ecode);
-	if (ecode != 0) { //error
-		getheader(res,HD_RETURN_MESSAGE,&tmpVal);
-		error(tmpVal,ecode);
-		//can quit
+	//verify server not broken
+	getheader(res, HD_LENGTH, &len_str);
+	ok = len_str != NULL && atoi(len_str) == batch->length &&
+	     res->bodyLength >= (int) (batch->length * sizeof(cellValue));
+	free(len_str);
+	if (!ok) {
+		error("Server sent back invalid response", 10);
+		freeresponse(res);
+		return -1;
 	}
 
-	//verify server not broken
-	char * len_str;
-	getheader(res,HD_LENGTH,&len_str);
-	if (len_str == NULL || length!=atoi(len_str)) {
-		error("Server sent back invalid response",10);
+	//must do byte conversion (16 bit)
+	resvals = (cellValue *) (res->body);
+	for (i = 0; i < batch->length; i++) {
+		cell = ntohs(resvals[i]);
+		set_position(batch->positions[i], cell);
+		if (batch->dest != NULL)
+			batch->dest[batch->destIndex[i]] = cell;
 	}
+	freeresponse(res);
+	return 1;
+}
 
+/* Reconnects and sends every outstanding batch again, in order, so the
+ * responses on the new connection line up with the queue. A batch that
+ * has run out of retries is dropped and its lookups stay undecided.
+ */
+static void netdb_recover()
+{
+	netdb_batch *batch;
+	BOOLEAN sent;
+	int i;
 
+	do {
+		sent = TRUE;
+		if (netdb_conn != NULL)
+			closeconnection(netdb_conn);
+		for (i = 0; i < netdb_inflight_count && sent; i++) {
+			batch = &netdb_inflight[(netdb_inflight_head + i) % NETDB_PIPELINE_DEPTH];
+			if (batch->dropped)
+				continue;
+			if (batch->retries++ >= NETDB_RETRIES) {
+				batch->dropped = TRUE;
+				continue;
+			}
+			sent = netdb_send(batch);
+		}
+	} while (!sent);
+}
 
-	//now safe - just read out the body (length should be the same or we errored)
-	cellValue * resvals = (cellValue*)(res->body);
+/* Waits for the oldest outstanding batch. */
+static void netdb_complete_oldest()
+{
+	netdb_batch *batch = &netdb_inflight[netdb_inflight_head];
 
-	//must do byte conversion (16 bit)
-	for (i=0; i<length; i++) {
-		cells[i] = ntohs(resvals[i]);
-	}
+	while (!batch->dropped && netdb_receive(batch) == 0)
+		netdb_recover();
+	netdb_inflight_head = (netdb_inflight_head + 1) % NETDB_PIPELINE_DEPTH;
+	netdb_inflight_count--;
+}
 
+static void netdb_drain()
+{
+	while (netdb_inflight_count > 0)
+		netdb_complete_oldest();
+}
 
-	for (i = 0; i< length; i++) //cache what we got back
-		set_position(positions[i], cells[i]);
+/* Returns an empty batch at the tail of the pipeline, waiting for the
+ * oldest one if the pipeline is full. */
+static netdb_batch *netdb_new_batch(cellValue *dest)
+{
+	netdb_batch *batch;
+
+	if (netdb_inflight_count == NETDB_PIPELINE_DEPTH)
+		netdb_complete_oldest();
+	batch = &netdb_inflight[(netdb_inflight_head + netdb_inflight_count) % NETDB_PIPELINE_DEPTH];
+	batch->dest = dest;
+	batch->length = 0;
+	return batch;
+}
 
+/* Puts the batch returned by netdb_new_batch on the wire. */
+static void netdb_push(netdb_batch *batch)
+{
+	batch->retries = 0;
+	batch->dropped = FALSE;
+	netdb_inflight_count++;
+	/* Earlier batches were lost with a closed connection: resend them all. */
+	if ((netdb_inflight_count > 1 && (netdb_conn == NULL || netdb_conn->sockFd < 0)) ||
+	    !netdb_send(batch))
+		netdb_recover();
+}
 
+void netdb_get_raw(POSITION * positions, cellValue * cells, int length){ //dispatch to get cells
+	netdb_batch *batch = NULL;
+	BOOLEAN allcached = TRUE;
+	int i;
 
-	//done - free response
-	freeresponse(res);
-	free(url);
+	//before we do anything, access the cache:
+	for (i = 0; i < length; i++) {
+		if (!get_position(positions[i], cells + i)) {
+			cells[i] = 0; //undecided unless the server answers
+			allcached = FALSE;
+		}
+	}
+	if (allcached) //done
+		return;
 
+	//answers to earlier prefetches may be waiting already
+	if (netdb_inflight_count > 0) {
+		netdb_drain();
+		allcached = TRUE;
+		for (i = 0; i < length; i++)
+			if (!get_position(positions[i], cells + i))
+				allcached = FALSE;
+		if (allcached)
+			return;
+	}
+
+	for (i = 0; i < length; i++) {
+		cellValue cell;
+		if (get_position(positions[i], &cell))
+			continue;
+		if (batch == NULL)
+			batch = netdb_new_batch(cells);
+		batch->positions[batch->length] = positions[i];
+		batch->destIndex[batch->length++] = i;
+		if (batch->length == NETDB_BATCH_MAX) {
+			netdb_push(batch);
+			batch = NULL;
+		}
+	}
+	if (batch != NULL)
+		netdb_push(batch);
+	netdb_drain();
 }
 
-void netdb_init_db()
+/* Asks the server for positions without waiting for the answers, which
+ * land in the cache for a later netdb_get_raw. */
+void netdb_prefetch(POSITION * positions, int length)
+{
+	netdb_batch *batch = NULL;
+	cellValue cell;
+	int i;
+
+	if (!gNetworkDB)
+		return;
+	for (i = 0; i < length; i++) {
+		if (get_position(positions[i], &cell))
+			continue;
+		if (batch == NULL)
+			batch = netdb_new_batch(NULL);
+		batch->positions[batch->length++] = positions[i];
+		if (batch->length == NETDB_BATCH_MAX) {
+			netdb_push(batch);
+			batch = NULL;
+		}
+	}
+	if (batch != NULL)
+		netdb_push(batch);
+}
+
+BOOLEAN netdb_init_db()
 {
 	httpreq *req;
 	httpres *res;
-	char* errMsg;
-	char *url;
+	char* errMsg = NULL;
 	char option[32];
+	BOOLEAN ok;
 
 	// Create a new request
-	url = malloc(strlen(ServerAddress)+1);
-	memcpy(url, ServerAddress, strlen(ServerAddress)+1);
-	if (newrequest(url, &req, &errMsg) != 0)
-	{
-		fprintf(stderr, "Problem creating request: %s\n", errMsg);
-		exit(1);
-	}
+	if (!netdb_connect() || newconnrequest(netdb_conn, &req) != 0)
+		return FALSE;
 	settype(req, HD_INIT_DATABASE);
 
 	// Set the gamename header
@@ -279,22 +403,24 @@ void netdb_init_db()
 	addheader(req, HD_GAME_VARIANT, option);
 
 	// Now post
-	if ((post(req, NULL, 0, &res, &errMsg)) != 0)
+	if (sendrequest(netdb_conn, req, NULL, 0, &errMsg) != 0 ||
+	    receiveresponse(netdb_conn, &res, &errMsg) != 0)
 	{
-		fprintf(stderr, "Problem posting to the server: %s\n", errMsg);
-		exit(1);
+		error(errMsg, 1);
+		free(errMsg);
+		return FALSE;
 	}
 
 	// Check for errors:
-	checkResponseForErrors(res);
+	ok = checkResponseForErrors(res);
 
 	// Done - free memory
 	freeresponse(res);
-	free(url);
+	return ok;
 }
 
 
-void checkResponseForErrors(httpres *res)
+BOOLEAN checkResponseForErrors(httpres *res)
 {
 	char *ecode_str;
 	int ecode;
@@ -304,61 +430,50 @@ void checkResponseForErrors(httpres *res)
 	{
 		// Bad server response
 		badResponseCode(res->status, res->statusCode);
+		return FALSE;
 	}
 
 	// Check GamesmanServlet return code/message
 	getheader(res, HD_RETURN_CODE, &ecode_str);
-	if (ecode_str == NULL)
+	if (ecode_str == NULL) {
 		error("GamesmanServlet sent back invalid response. Missing return code.", 11);
+		return FALSE;
+	}
 	ecode = atoi(ecode_str);
+	free(ecode_str);
 	if (ecode != 0)
 	{
 		getheader(res, HD_RETURN_MESSAGE, &ecode_str);
 		error(ecode_str, ecode);
+		free(ecode_str);
+		return FALSE;
 	}
+	return TRUE;
 }
 
 
 //cache support:
 //return False if not found
 //If true, set the cached value appropriately
+static netdb_cache_entry *cache_slot (POSITION pos){
+	return &netdb_cache[(pos * 0x9E3779B97F4A7C15ULL) >> (64 - NETDB_CACHE_BITS)];
+}
+
 BOOLEAN get_position (POSITION pos, cellValue * outcell){
-	int i;
-	for (i=0; i<valid_num; i++) {
-		if (p_cache[i] == pos) {
-			*outcell = v_cache[i];
-			cache_sweep[i] = 0; //reset
-			return TRUE;
-		}
+	netdb_cache_entry *entry = cache_slot(pos);
+	if (entry->valid && entry->pos == pos) {
+		*outcell = entry->cell;
+		return TRUE;
 	}
 	return FALSE;
 }
 
-//this will push entries to the cache
+//this will push entries to the cache, replacing whatever shares the slot
 void set_position (POSITION pos, cellValue cv){
-	//check if already cached
-	if (get_position(pos,&cv))
-		return;
-
-	if (valid_num < CACHE_SIZE) {
-		p_cache[valid_num] = pos;
-		v_cache[valid_num] = cv;
-		cache_sweep[valid_num] = 0;
-		valid_num++;
-	}
-	//replacement (nth-chance clock)
-	while (TRUE) {
-		if (cache_sweep[c_clock] == CLOCK_LOOPS) { //replace
-			cache_sweep[c_clock] = 0; //reset
-			p_cache[c_clock] = pos;
-			v_cache[c_clock] = cv;
-			c_clock=(c_clock+1)%CACHE_SIZE;
-			return;
-		}
-		//otherwise increment clock and sweep counter
-		cache_sweep[c_clock]++;
-		c_clock=(c_clock+1)%CACHE_SIZE;
-	}
+	netdb_cache_entry *entry = cache_slot(pos);
+	entry->pos = pos;
+	entry->cell = cv;
+	entry->valid = TRUE;
 }
 
 //FIXME: add a cache clear function
@@ -431,7 +546,16 @@ BOOLEAN netdb_load_database()
 {
 	printf("\nInitializing net-db for %s...", kGameName);
 	fflush(stdout);
-	netdb_init_db();
-	printf("done.\n");
+	if (netdb_init_db())
+		printf("done.\n");
+	else
+		printf("failed; unanswered positions will read as undecided.\n");
 	return TRUE;
 }
+
+void netdb_close()
+{
+	netdb_drain();
+	freeconnection(netdb_conn);
+	netdb_conn = NULL;
+}
@@ -3,5 +3,6 @@
 
 /* General */
 void            netdb_init              (DB_Table *new_db);
+void            netdb_prefetch          (POSITION *positions, int length);
 
 #endif /* GMCORE_NETDB_H */
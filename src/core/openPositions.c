@@ -1296,11 +1296,11 @@ void DrawNumberChildrenInitialize()
 	gDrawNumberChildren = (char *) SafeMalloc (gNumberOfPositions * sizeof(signed char));
 	gDrawNumberChildrenOriginal = (char *) SafeMalloc (gNumberOfPositions * sizeof(signed char));
 	if (gInterestingness) {
-		gAnalysis.Interestingness = (float *) SafeMalloc (gNumberOfPositions * sizeof(float)); /* Interestingness */
+		gAnalysis.Interestingness = (unsigned short *) SafeMalloc (gNumberOfPositions * sizeof(unsigned short)); /* Interestingness */
 		for(i = 0; i < gNumberOfPositions; i++) {
 			gDrawNumberChildren[i] = 0;
 			gDrawNumberChildrenOriginal[i] = 0;
-			gAnalysis.Interestingness[i] = 0.0;
+			gAnalysis.Interestingness[i] = 0;
 		}
 	} else {
 		for(i = 0; i < gNumberOfPositions; i++) {
@@ -0,0 +1,207 @@
+/************************************************************************
+**
+** NAME:	posht.c
+**
+** DESCRIPTION:	Open addressing position to cell hash-table
+**
+** AUTHOR:	GamesCrafters Research Group, UC Berkeley
+**		Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+**
+** DATE:	2026-10-18
+**
+** LICENSE:	This file is part of GAMESMAN,
+**		The Finite, Two-person Perfect-Information Game Generator
+**		Released under the GPL:
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program, in COPYING; if not, write to the Free Software
+** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+**************************************************************************/
+
+/*
+   Slots come in groups of POSHT_GROUP_SIZE. Each slot has a tag byte, the
+   key and a 2-byte cell, kept in three arrays so a group's tags share a
+   cache line. A key's hash picks its home group and a 7-bit tag; a probe
+   compares all 16 tags of a group at once (with SSE2 where available) and
+   only looks at keys whose tag matches. Probing walks groups in order and
+   stops at the first group with an empty slot. Entries are never removed,
+   so no tombstones are needed. The table doubles once it is 7/8 full.
+
+   An entry costs 11 bytes against 40 or more for a malloced chain node.
+ */
+
+#include "gamesman.h"
+#include "posht.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define POSHT_EMPTY 0x80
+
+#define POSHT_MIN_GROUP_BITS 4
+
+static unsigned long long posht_hash(POSITION position) {
+
+	position ^= position >> 33;
+	position *= 0xff51afd7ed558ccdULL;
+	position ^= position >> 33;
+	position *= 0xc4ceb9fe1a85ec53ULL;
+	position ^= position >> 33;
+	return position;
+
+}
+
+/* Bit i is set for each slot i of the group whose tag equals tag */
+static unsigned int posht_match(const unsigned char *group, unsigned char tag) {
+
+#ifdef __SSE2__
+	__m128i tags = _mm_load_si128((const __m128i *) group);
+	return (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(tags, _mm_set1_epi8((char) tag)));
+#else
+	unsigned int mask = 0;
+	int i;
+
+	for (i = 0; i < POSHT_GROUP_SIZE; i++)
+		if (group[i] == tag)
+			mask |= 1u << i;
+	return mask;
+#endif
+
+}
+
+static void posht_alloc(posht *ht, int group_bits) {
+
+	POSITION slots;
+
+	ht->group_bits = group_bits;
+	ht->groups = 1ULL << group_bits;
+	ht->entries = 0;
+	slots = ht->groups * POSHT_GROUP_SIZE;
+
+	/* 16-byte aligned, so a group's tags load in one instruction */
+	if (posix_memalign((void **) &ht->tags, 64, slots) != 0) {
+		printf("Error: posht could not allocate %llu slots\n", slots);
+		ExitStageRight();
+		exit(0);
+	}
+	memset(ht->tags, POSHT_EMPTY, slots);
+	ht->keys = (POSITION *) SafeMalloc(slots * sizeof(POSITION));
+	ht->cells = (POSHT_CELL *) SafeMalloc(slots * sizeof(POSHT_CELL));
+
+}
+
+/* Returns the slot holding position, or the empty slot where it would go */
+static POSITION posht_probe(posht *ht, POSITION position, unsigned char *found) {
+
+	unsigned long long hash = posht_hash(position);
+	unsigned char tag = (unsigned char) (hash & 0x7f);
+	POSITION group = hash >> (64 - ht->group_bits);
+	unsigned char *tags;
+	unsigned int mask, empty;
+	int i;
+
+	while (TRUE) {
+		tags = ht->tags + group * POSHT_GROUP_SIZE;
+		for (mask = posht_match(tags, tag); mask != 0; mask &= mask - 1) {
+			i = __builtin_ctz(mask);
+			if (ht->keys[group * POSHT_GROUP_SIZE + i] == position) {
+				*found = TRUE;
+				return group * POSHT_GROUP_SIZE + i;
+			}
+		}
+		empty = posht_match(tags, POSHT_EMPTY);
+		if (empty != 0) {
+			*found = FALSE;
+			return group * POSHT_GROUP_SIZE + __builtin_ctz(empty);
+		}
+		group = (group + 1) & (ht->groups - 1);
+	}
+
+}
+
+static void posht_grow(posht *ht) {
+
+	unsigned char *old_tags = ht->tags;
+	POSITION *old_keys = ht->keys;
+	POSHT_CELL *old_cells = ht->cells;
+	POSITION old_slots = ht->groups * POSHT_GROUP_SIZE, i, slot;
+	unsigned char found;
+
+	posht_alloc(ht, ht->group_bits + 1);
+	for (i = 0; i < old_slots; i++) {
+		if (old_tags[i] != POSHT_EMPTY) {
+			slot = posht_probe(ht, old_keys[i], &found);
+			ht->tags[slot] = old_tags[i];
+			ht->keys[slot] = old_keys[i];
+			ht->cells[slot] = old_cells[i];
+			ht->entries++;
+		}
+	}
+	free(old_tags);
+	SafeFree(old_keys);
+	SafeFree(old_cells);
+
+}
+
+posht *posht_create(POSITION expected) {
+
+	posht *ht = (posht *) SafeMalloc(sizeof(posht));
+	int group_bits = POSHT_MIN_GROUP_BITS;
+
+	/* Room for expected entries without going over 7/8 full */
+	while (group_bits < 48 && (1ULL << group_bits) * POSHT_GROUP_SIZE * 7 / 8 < expected)
+		group_bits++;
+	posht_alloc(ht, group_bits);
+	return ht;
+
+}
+
+void posht_destroy(posht *ht) {
+
+	free(ht->tags);
+	SafeFree(ht->keys);
+	SafeFree(ht->cells);
+	SafeFree(ht);
+
+}
+
+POSHT_CELL *posht_lookup(posht *ht, POSITION position) {
+
+	unsigned char found;
+	POSITION slot = posht_probe(ht, position, &found);
+
+	return found ? ht->cells + slot : NULL;
+
+}
+
+POSHT_CELL *posht_insert(posht *ht, POSITION position) {
+
+	unsigned char found;
+	POSITION slot = posht_probe(ht, position, &found);
+
+	if (found)
+		return ht->cells + slot;
+
+	if ((ht->entries + 1) * 8 > ht->groups * POSHT_GROUP_SIZE * 7) {
+		posht_grow(ht);
+		slot = posht_probe(ht, position, &found);
+	}
+	ht->tags[slot] = (unsigned char) (posht_hash(position) & 0x7f);
+	ht->keys[slot] = position;
+	ht->cells[slot] = 0;
+	ht->entries++;
+	return ht->cells + slot;
+
+}
@@ -0,0 +1,48 @@
+#ifndef GMCORE_POSHT_H
+#define GMCORE_POSHT_H
+
+#include "gamesman.h"
+
+/*
+   Compact hash map from POSITION to one packed database cell, for
+   databases that only hold the positions a solve reaches.
+ */
+
+/* Value, visited, mex and remoteness bits as laid out in db.h */
+typedef unsigned short POSHT_CELL;
+
+/* Slots per group. The tags of a group are compared in one step. */
+#define POSHT_GROUP_SIZE 16
+
+typedef struct {
+
+	/* One tag byte per slot: POSHT_EMPTY, or 7 bits of the key's hash */
+	unsigned char *tags;
+
+	/* Keys and cells, indexed like tags */
+	POSITION *keys;
+	POSHT_CELL *cells;
+
+	/* Number of groups, a power of two */
+	POSITION groups;
+	int group_bits;
+
+	/* Number of entries in the table */
+	POSITION entries;
+
+} posht;
+
+/* Hash-table creation, sized for about expected entries */
+posht *posht_create(POSITION expected);
+
+/* Hash-table destruction */
+void posht_destroy(posht *ht);
+
+/* Cell for position, or NULL if it is not in the table */
+POSHT_CELL *posht_lookup(posht *ht, POSITION position);
+
+/* Cell for position, added as 0 (undecided, unvisited) if it is not in
+   the table. May move every cell, so don't hold on to older results. */
+POSHT_CELL *posht_insert(posht *ht, POSITION position);
+
+#endif
@@ -14,17 +14,25 @@
 #include "gamesman.h"
 #include "interact.h"
 #include "quartodb.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #define MAX16BIT 65536
 #define MAX20BIT 1048576
 #define FULL_OCCUPIED_SLOTS_MASK 0xFFFFFFFFFFFFFFFF
 #define PRIMITIVE_FULL 255
+#define QUARTO_FIRST_LIVE_LEVEL 13 // levels from here on are not on disk and are solved live
+#define QUARTO_TT_BITS 20 // 2^20 two-word entries in the live-solve transposition table
 
 static const int8_t QUARTO_UNDECIDED = -2, QUARTO_LOSE0 = 0, QUARTO_TIE0_16 = 1;
 
 /*internal declarations and definitions*/
 
 void            quartodb_free                     ();
+static void     quartoMapFreeAll                  ();
 
 /* saving to/reading from a file */
 BOOLEAN         quartodb_save_database            ();
@@ -102,6 +110,7 @@ void buildTier(QUARTOTIER *tier, uint8_t pieceToPlace, uint16_t piecesPlaced, ui
 }
 
 uint8_t *unsetBitLists = NULL;
+uint64_t *quartoTT = NULL;
 void initializeSolving() {
     // Initialize unsetBitLists Table
     unsetBitLists = (uint8_t *) malloc(sizeof(uint8_t) * MAX20BIT);
@@ -120,6 +129,8 @@ void initializeSolving() {
             }
         }
     }
+
+    quartoTT = (uint64_t *) SafeCalloc(UINT64_C(2) << QUARTO_TT_BITS, sizeof(uint64_t));
 }
 
 typedef struct {
@@ -276,27 +287,187 @@ void quartodb_init(DB_Table *new_db) {
 }
 
 void quartodb_free() {
+    quartoMapFreeAll();
     SafeFree(whichSetBit);
     SafeFree(unsetBitLists);
+    SafeFree(quartoTT);
 }
 
 int numBitsPerValue[17] = {5, 5, 4, 4, 4, 4, 4, 4, 4, 4, 3, 3, 3, 3, 2, 2, 1};
-int8_t quartodb_get_valueremoteness_from_file(QUARTOTIER *tier, TIERPOSITION tierPosition) {
-	int bitsPerValue = numBitsPerValue[tier->level];
+
+/*
+    Tier files are mapped on first use and kept in a small hash table keyed by
+    (level, piecesPlaced, occupiedSlots), so a lookup is a couple of memory reads
+    instead of an fopen/fseek/fread/fclose. When the mapped bytes exceed
+    QUARTO_MAP_BUDGET, or there are more than QUARTO_MAP_MAX_ENTRIES files,
+    the least recently used files are unmapped. Missing files are remembered
+    as empty entries so they are not probed again.
+*/
+#define QUARTO_MAP_BUCKETS 1024
+#define QUARTO_MAP_MAX_ENTRIES 4096
+#define QUARTO_MAP_BUDGET (UINT64_C(1) << 30)
+
+typedef struct quartomap {
+    uint64_t key;
+    uint8_t *data; // NULL if the tier file does not exist
+    size_t size;
+    struct quartomap *bucketNext;
+    struct quartomap *lruPrev, *lruNext; // lruPrev is more recently used
+} QUARTOMAP;
+
+static QUARTOMAP *quartoMapBuckets[QUARTO_MAP_BUCKETS];
+static QUARTOMAP *quartoMapMostRecent = NULL, *quartoMapLeastRecent = NULL;
+static uint64_t quartoMappedBytes = 0;
+static int quartoMapCount = 0;
+
+static uint64_t quartoMapKey(const QUARTOTIER *tier) {
+    return (((uint64_t) tier->level) << 32) | (((uint64_t) tier->piecesPlaced) << 16) | tier->occupiedSlots;
+}
+
+static QUARTOMAP **quartoMapBucket(uint64_t key) {
+    return &quartoMapBuckets[(key * UINT64_C(0x9E3779B97F4A7C15)) >> 54];
+}
+
+static void quartoMapUnlink(QUARTOMAP *map) {
+    if (map->lruPrev) map->lruPrev->lruNext = map->lruNext;
+    else quartoMapMostRecent = map->lruNext;
+    if (map->lruNext) map->lruNext->lruPrev = map->lruPrev;
+    else quartoMapLeastRecent = map->lruPrev;
+}
+
+static void quartoMapPushFront(QUARTOMAP *map) {
+    map->lruPrev = NULL;
+    map->lruNext = quartoMapMostRecent;
+    if (quartoMapMostRecent) quartoMapMostRecent->lruPrev = map;
+    else quartoMapLeastRecent = map;
+    quartoMapMostRecent = map;
+}
+
+static void quartoMapEvict(QUARTOMAP *map) {
+    QUARTOMAP **link = quartoMapBucket(map->key);
+    while (*link != map) {
+        link = &(*link)->bucketNext;
+    }
+    *link = map->bucketNext;
+    quartoMapUnlink(map);
+    if (map->data) {
+        munmap(map->data, map->size);
+        quartoMappedBytes -= map->size;
+    }
+    quartoMapCount--;
+    SafeFree(map);
+}
+
+static void quartoMapFreeAll() {
+    while (quartoMapLeastRecent) {
+        quartoMapEvict(quartoMapLeastRecent);
+    }
+}
+
+static QUARTOMAP *quartoMapGet(QUARTOTIER *tier) {
+    uint64_t key = quartoMapKey(tier);
+    QUARTOMAP **bucket = quartoMapBucket(key);
+    QUARTOMAP *map;
+    for (map = *bucket; map; map = map->bucketNext) {
+        if (map->key == key) {
+            if (map != quartoMapMostRecent) {
+                quartoMapUnlink(map);
+                quartoMapPushFront(map);
+            }
+            return map;
+        }
+    }
+
+    map = (QUARTOMAP *) SafeMalloc(sizeof(QUARTOMAP));
+    map->key = key;
+    map->data = NULL;
+    map->size = 0;
+
     char filename[100];
+    struct stat statbuf;
     snprintf(filename, 100, "./data/quarto/database/%02d/%04X%04X", tier->level, tier->piecesPlaced, tier->occupiedSlots);
-    FILE *fptr = fopen(filename, "r");
-    if (fptr == NULL) {
-        return 0;
+    int fd = open(filename, O_RDONLY);
+    if (fd >= 0) {
+        if (fstat(fd, &statbuf) == 0 && statbuf.st_size > 0) {
+            void *data = mmap(NULL, statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                map->data = (uint8_t *) data;
+                map->size = statbuf.st_size;
+            }
+        }
+        close(fd); // the mapping stays valid
+    }
+
+    map->bucketNext = *bucket;
+    *bucket = map;
+    quartoMapPushFront(map);
+    quartoMappedBytes += map->size;
+    quartoMapCount++;
+    while ((quartoMappedBytes > QUARTO_MAP_BUDGET || quartoMapCount > QUARTO_MAP_MAX_ENTRIES)
+            && quartoMapLeastRecent != map) {
+        quartoMapEvict(quartoMapLeastRecent);
     }
-    uint16_t twoValues;
+    return map;
+}
+
+static int8_t quartoMapRead(QUARTOMAP *map, int bitsPerValue, TIERPOSITION tierPosition) {
     uint64_t m = tierPosition * bitsPerValue;
-    fseek(fptr, m >> 3, SEEK_SET);
-    fread(&twoValues, sizeof(int16_t), 1, fptr);
-    fclose(fptr);
+    uint64_t byte = m >> 3;
+    if (byte >= map->size) {
+        return 0;
+    }
+    uint16_t twoValues = map->data[byte];
+    if (byte + 1 < map->size) {
+        twoValues |= ((uint16_t) map->data[byte + 1]) << 8;
+    }
     return (twoValues >> (m & 0b111)) & ((1 << bitsPerValue) - 1);
 }
 
+int8_t quartodb_get_valueremoteness_from_file(QUARTOTIER *tier, TIERPOSITION tierPosition) {
+    return quartoMapRead(quartoMapGet(tier), numBitsPerValue[tier->level], tierPosition);
+}
+
+typedef struct quartolookup {
+    QUARTOTIER tier; // canonical tier
+    TIERPOSITION tierPosition;
+    int8_t vr; // filled in by quartodb_get_valueremoteness_batch
+} QUARTOLOOKUP;
+
+static int compareQuartoLookups(const void *a, const void *b) {
+    const QUARTOLOOKUP *x = *(QUARTOLOOKUP * const *) a, *y = *(QUARTOLOOKUP * const *) b;
+    uint64_t kx = quartoMapKey(&x->tier), ky = quartoMapKey(&y->tier);
+    if (kx != ky) return (kx < ky) ? -1 : 1;
+    if (x->tierPosition != y->tierPosition) return (x->tierPosition < y->tierPosition) ? -1 : 1;
+    return 0;
+}
+
+/*
+    Resolves many lookups at once. Lookups are grouped by tier so that each
+    tier file is found in the cache once, and read in increasing offset order.
+*/
+void quartodb_get_valueremoteness_batch(QUARTOLOOKUP *lookups, int count) {
+    QUARTOLOOKUP *sorted[256];
+    QUARTOLOOKUP **order = (count <= 256) ? sorted : (QUARTOLOOKUP **) SafeMalloc(count * sizeof(QUARTOLOOKUP *));
+    QUARTOMAP *map = NULL;
+    uint64_t key = 0;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        order[i] = &lookups[i];
+    }
+    qsort(order, count, sizeof(QUARTOLOOKUP *), compareQuartoLookups);
+    for (i = 0; i < count; i++) {
+        if (map == NULL || quartoMapKey(&order[i]->tier) != key) {
+            map = quartoMapGet(&order[i]->tier);
+            key = map->key;
+        }
+        order[i]->vr = quartoMapRead(map, numBitsPerValue[order[i]->tier.level], order[i]->tierPosition);
+    }
+    if (order != sorted) {
+        SafeFree(order);
+    }
+}
+
 /*
     Return LOSE IN 0 if there exists a win quartet, regardless of whether the position is reachable. 
     Otherwise, return TIE IN 0 if the board is full, else QUARTO_UNDECIDED.
@@ -477,6 +648,46 @@ uint64_t quartoHash(QUARTOTIER *tier, uint64_t bitBoard) {
     return tierPosition;
 }
 
+uint64_t canonicalize(QUARTOTIER *tier, QUARTOTIER *symmetricTier, uint64_t bitBoard);
+
+/*
+    Transposition table for solvePositionLive, keyed by the canonical form of
+    a position so that symmetric positions share an entry. Each entry is two
+    words, {board ^ info, info}, where info holds the canonical piecesPlaced,
+    occupiedSlots and the value. Entries are read and written without locks;
+    a torn entry fails the xor check and is treated as a miss. Positions at
+    level QUARTO_TT_MAX_LEVEL and above have too small a subtree to be worth
+    canonicalizing.
+*/
+#define QUARTO_TT_MAX_LEVEL 14
+
+typedef struct quartottkey {
+    uint64_t board;
+    uint64_t info; // value bits are zero
+    uint64_t *entry;
+} QUARTOTTKEY;
+
+static BOOLEAN quartoTTProbe(QUARTOTIER *tier, uint64_t bitBoard, QUARTOTTKEY *key, int8_t *value) {
+    QUARTOTIER canonicalTier;
+    key->board = canonicalize(tier, &canonicalTier, bitBoard);
+    key->info = (((uint64_t) canonicalTier.piecesPlaced) << 32) | (((uint64_t) canonicalTier.occupiedSlots) << 16);
+    key->entry = quartoTT + (((key->board ^ (key->info * UINT64_C(0xC2B2AE3D27D4EB4F))) * UINT64_C(0x9E3779B97F4A7C15)) >> (64 - QUARTO_TT_BITS)) * 2;
+
+    uint64_t info = __atomic_load_n(&key->entry[1], __ATOMIC_RELAXED);
+    uint64_t board = __atomic_load_n(&key->entry[0], __ATOMIC_RELAXED) ^ info;
+    if ((info & ~UINT64_C(0xFF)) == key->info && board == key->board) {
+        *value = (int8_t) (info & 0xFF);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static void quartoTTStore(QUARTOTTKEY *key, int8_t value) {
+    uint64_t info = key->info | (uint8_t) value;
+    __atomic_store_n(&key->entry[0], key->board ^ info, __ATOMIC_RELAXED);
+    __atomic_store_n(&key->entry[1], info, __ATOMIC_RELAXED);
+}
+
 int8_t solvePositionLive(QUARTOTIER *tier, uint64_t bitBoard, uint8_t slot) {
     // First, check if current position is primitive.
     int8_t value;
@@ -490,6 +701,12 @@ int8_t solvePositionLive(QUARTOTIER *tier, uint64_t bitBoard, uint8_t slot) {
         return value;
     }
 
+    QUARTOTTKEY key;
+    BOOLEAN useTT = tier->level < QUARTO_TT_MAX_LEVEL;
+    if (useTT && quartoTTProbe(tier, bitBoard, &key, &value)) {
+        return value;
+    }
+
     // If not, then check child positons.
     int8_t i, j, nextSlot, childValue, minChildValue = 24;
     uint64_t childBitBoard;
@@ -509,7 +726,9 @@ int8_t solvePositionLive(QUARTOTIER *tier, uint64_t bitBoard, uint8_t slot) {
                 childTier.pieceToPlace = remainingPieces[j];
                 childValue = solvePositionLive(&childTier, childBitBoard, nextSlot);
                 if (childValue == QUARTO_LOSE0) {
-                    return 17 - tier->level; // Max value for a level
+                    value = 17 - tier->level; // Max value for a level
+                    if (useTT) quartoTTStore(&key, value);
+                    return value;
                 } else if (childValue < minChildValue) {
                     minChildValue = childValue;
                 }
@@ -523,7 +742,105 @@ int8_t solvePositionLive(QUARTOTIER *tier, uint64_t bitBoard, uint8_t slot) {
         for generateMoves and level 16 is primitive, so no need to initialize them */
         minChildValue = solvePositionLive(&childTier, childBitBoard, nextSlot);
     }
-    return 17 - tier->level - minChildValue;
+    value = 17 - tier->level - minChildValue;
+    if (useTT) quartoTTStore(&key, value);
+    return value;
+}
+
+/*
+    solvePositionLive with the root's children split across gTierSolverThreads
+    threads. Each thread claims the next unsolved child; once any child is a
+    LOSE IN 0 the position is decided and the threads stop claiming.
+*/
+typedef struct quartoliveroot {
+    QUARTOTIER *tier;
+    uint64_t bitBoard;
+    int numChildren;
+    int next; // next child to claim
+    int decided;
+    int8_t childValues[256]; // -1 if not solved
+} QUARTOLIVEROOT;
+
+static void *solveLiveRootWorker(void *ptr) {
+    QUARTOLIVEROOT *root = (QUARTOLIVEROOT *) ptr;
+    QUARTOTIER *tier = root->tier;
+    QUARTOTIER childTier;
+    uint8_t *emptySlots = unsetBitLists + (tier->occupiedSlots << 4);
+    int numPieces = 15 - tier->level;
+    int child;
+    int8_t nextSlot;
+
+    childTier.level = tier->level + 1;
+    childTier.piecesPlaced = tier->piecesPlaced | (1 << tier->pieceToPlace);
+    uint8_t *remainingPieces = unsetBitLists + ((childTier.piecesPlaced) << 4);
+    while (!__atomic_load_n(&root->decided, __ATOMIC_RELAXED)) {
+        child = __atomic_fetch_add(&root->next, 1, __ATOMIC_RELAXED);
+        if (child >= root->numChildren) {
+            break;
+        }
+        nextSlot = emptySlots[child / numPieces];
+        childTier.occupiedSlots = tier->occupiedSlots | (1 << nextSlot);
+        childTier.occupiedSlotsMask = tier->occupiedSlotsMask | (UINT64_C(0xF) << (nextSlot << 2));
+        childTier.pieceToPlace = remainingPieces[child % numPieces];
+        root->childValues[child] = solvePositionLive(&childTier,
+                root->bitBoard | (((uint64_t) tier->pieceToPlace) << (nextSlot << 2)), nextSlot);
+        if (root->childValues[child] == QUARTO_LOSE0) {
+            __atomic_store_n(&root->decided, 1, __ATOMIC_RELAXED);
+        }
+    }
+    return NULL;
+}
+
+int8_t solvePositionLiveParallel(QUARTOTIER *tier, uint64_t bitBoard) {
+    int i, n = gTierSolverThreads;
+    if (n <= 1 || tier->level >= 15) {
+        return solvePositionLive(tier, bitBoard, PRIMITIVE_FULL);
+    }
+
+    int8_t value = primitiveFull(bitBoard, tier->occupiedSlotsMask);
+    if (value != QUARTO_UNDECIDED) {
+        return value;
+    }
+    QUARTOTTKEY key;
+    if (tier->level < QUARTO_TT_MAX_LEVEL && quartoTTProbe(tier, bitBoard, &key, &value)) {
+        return value;
+    }
+
+    QUARTOLIVEROOT root;
+    root.tier = tier;
+    root.bitBoard = bitBoard;
+    root.numChildren = (16 - tier->level) * (15 - tier->level);
+    root.next = 0;
+    root.decided = 0;
+    memset(root.childValues, -1, sizeof(root.childValues));
+
+    pthread_t *threads = (pthread_t *) SafeMalloc(n * sizeof(pthread_t));
+    for (i = 1; i < n; i++) {
+        if (pthread_create(&threads[i], NULL, solveLiveRootWorker, &root) != 0) {
+            n = i; // carry on with the threads we have
+            break;
+        }
+    }
+    solveLiveRootWorker(&root);
+    for (i = 1; i < n; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    SafeFree(threads);
+
+    int8_t minChildValue = 24;
+    for (i = 0; i < root.numChildren; i++) {
+        if (root.childValues[i] == QUARTO_LOSE0) {
+            minChildValue = 0;
+            break;
+        } else if (root.childValues[i] >= 0 && root.childValues[i] < minChildValue) {
+            minChildValue = root.childValues[i];
+        }
+    }
+    value = 17 - tier->level - minChildValue;
+    if (tier->level < QUARTO_TT_MAX_LEVEL) {
+        quartoTTStore(&key, value);
+    }
+    return value;
 }
 
 BOOLEAN quartodb_save_database () {
@@ -567,7 +884,7 @@ void getValueRemoteness(int level, QUARTOTIER *tier, uint64_t bitBoard, char *va
     if (level <= 2) {
         *valueChar = 'T';
         *remoteness = 16 - level;
-    } else if (level < 13) {
+    } else if (level < QUARTO_FIRST_LIVE_LEVEL) {
         QUARTOTIER canonicalTier;
         uint64_t symmetricBitBoard = canonicalize(tier, &canonicalTier, bitBoard);
         uint64_t tierPosition = quartoHash(&canonicalTier, symmetricBitBoard);
@@ -575,20 +892,73 @@ void getValueRemoteness(int level, QUARTOTIER *tier, uint64_t bitBoard, char *va
         *valueChar = values[level][vr];
         *remoteness = remotenesses[level][vr];
     } else {
-        int8_t vr = solvePositionLive(tier, bitBoard, PRIMITIVE_FULL);
+        int8_t vr = solvePositionLiveParallel(tier, bitBoard);
         *valueChar = values[level][vr];
         *remoteness = remotenesses[level][vr];
     }
 }
 
-void quartoDetailedPositionResponse(STRING positionString, char *positionStringBuffer) {
-	printf("result =>> {");
+/*
+    Fills in the value and remoteness of every child of a position at a level
+    below 15, indexed by [empty slot index][remaining piece index]. Children
+    that are stored in the database are looked up in one batch. For children
+    solved live, a primitive first child means the slot's other children are
+    the same primitive, so they are skipped just as the caller skips them.
+*/
+void getChildrenValueRemoteness(int level, QUARTOTIER *tier, uint64_t bitBoard, char valueChars[16][16], int childRemotenesses[16][16]) {
+    int i, j, n = 0;
+    int8_t nextSlot;
+    uint64_t childBitBoard;
+    QUARTOTIER childTier;
+    QUARTOLOOKUP lookups[256];
+    BOOLEAN fromFile = level + 1 > 2 && level + 1 < QUARTO_FIRST_LIVE_LEVEL;
+    uint8_t *emptySlots = unsetBitLists + (tier->occupiedSlots << 4);
+
+    childTier.level = tier->level + 1;
+    childTier.piecesPlaced = tier->piecesPlaced | (1 << tier->pieceToPlace);
+    uint8_t *remainingPieces = unsetBitLists + ((childTier.piecesPlaced) << 4);
+    for (i = 0; i < 16 - level; i++) {
+        nextSlot = emptySlots[i];
+        childTier.occupiedSlots = tier->occupiedSlots | (1 << nextSlot);
+        childTier.occupiedSlotsMask = tier->occupiedSlotsMask | (UINT64_C(0xF) << (nextSlot << 2));
+        childBitBoard = bitBoard | (((uint64_t) tier->pieceToPlace) << (nextSlot << 2));
+        for (j = 0; j < 15 - level; j++) {
+            childTier.pieceToPlace = remainingPieces[j];
+            if (fromFile) {
+                QUARTOTIER canonicalTier;
+                uint64_t symmetricBitBoard = canonicalize(&childTier, &canonicalTier, childBitBoard);
+                lookups[n].tier = canonicalTier;
+                lookups[n].tierPosition = quartoHash(&canonicalTier, symmetricBitBoard);
+                n++;
+            } else {
+                getValueRemoteness(level + 1, &childTier, childBitBoard, &valueChars[i][j], &childRemotenesses[i][j]);
+                if (childRemotenesses[i][j] == 0) {
+                    break;
+                }
+            }
+        }
+    }
+
+    if (fromFile) {
+        quartodb_get_valueremoteness_batch(lookups, n);
+        n = 0;
+        for (i = 0; i < 16 - level; i++) {
+            for (j = 0; j < 15 - level; j++, n++) {
+                valueChars[i][j] = values[level + 1][lookups[n].vr];
+                childRemotenesses[i][j] = remotenesses[level + 1][lookups[n].vr];
+            }
+        }
+    }
+}
+
+void quartoDetailedPositionResponse(FILE *out, STRING positionString, char *positionStringBuffer) {
+	fprintf(out, "{");
 
     int turn;
     char *boardOrig;
 	if (!ParseStandardOnelinePositionString(positionString, &turn, &boardOrig)) {
 		// Failed to parse string
-		printf("}");
+		fprintf(out, "}");
         return;
 	}
 
@@ -605,7 +975,7 @@ void quartoDetailedPositionResponse(STRING positionString, char *positionStringB
 
     for (i = 0; i < 16; i++) {
         if (board[i] == '\0') {
-            printf("}"); // Invalid board string: board string not long enough
+            fprintf(out, "}"); // Invalid board string: board string not long enough
             return;
         } else if (board[i] == '-') {
             level--;
@@ -613,7 +983,7 @@ void quartoDetailedPositionResponse(STRING positionString, char *positionStringB
         } else {
             piece = board[i] - 'A';
             if (piece > 15) {
-                printf("}"); // Invalid board string: contains invalid characters
+                fprintf(out, "}"); // Invalid board string: contains invalid characters
                 return;
             }
             piecesPlaced |= UINT16_C(1) << piece;
@@ -626,7 +996,7 @@ void quartoDetailedPositionResponse(STRING positionString, char *positionStringB
         if (occupiedSlots & (1 << i)) occupiedSlotsCount++;
     }
     if (piecesPlacedCount != occupiedSlotsCount) {
-        printf("}"); // Invalid board string: number of pieces placed does not match number of occupied slots
+        fprintf(out, "}"); // Invalid board string: number of pieces placed does not match number of occupied slots
         return;
     }
 
@@ -648,10 +1018,10 @@ void quartoDetailedPositionResponse(STRING positionString, char *positionStringB
     buildTier(&tier, pieceToPlace, piecesPlaced, occupiedSlots);
     getValueRemoteness(level, &tier, bitBoard, &valueChar, &remoteness);
 
-	printf("\"position\":\"%s\",\"autoguiPosition\":\"%s\",", positionString, positionString);
-	printf("\"remoteness\":%d,", remoteness);
-    printf("\"positionValue\":\"%s\",", vctvs(valueChar));
-	printf("\"moves\":[");
+	fprintf(out, "\"position\":\"%s\",\"autoguiPosition\":\"%s\",", positionString, positionString);
+	fprintf(out, "\"remoteness\":%d,", remoteness);
+    fprintf(out, "\"positionValue\":\"%s\",", vctvs(valueChar));
+	fprintf(out, "\"moves\":[");
 
     if (!isPrimitive) {
         turn = (turn == 1) ? 2 : 1;
@@ -662,48 +1032,49 @@ void quartoDetailedPositionResponse(STRING positionString, char *positionStringB
         uint64_t childBitBoard;
         if (level == -1) {
             for (i = 0; i < 16; i++) {
-                printf("{\"position\":\"2_----------------%c\",\"autoguiPosition\":\"2_----------------%c\",\"remoteness\":16,\"positionValue\":\"tie\",", i + 'A', i + 'A');
-                printf("\"autoguiMove\":\"A_%c_%d\",", i + 'A', 272 + i); /// TODO
-                printf("\"move\":\"%d%d%d%d\"}", (i>>3)&1, (i>>2)&1, (i>>1)&1, i&1);
+                fprintf(out, "{\"position\":\"2_----------------%c\",\"autoguiPosition\":\"2_----------------%c\",\"remoteness\":16,\"positionValue\":\"tie\",", i + 'A', i + 'A');
+                fprintf(out, "\"autoguiMove\":\"A_%c_%d\",", i + 'A', 272 + i); /// TODO
+                fprintf(out, "\"move\":\"%d%d%d%d\"}", (i>>3)&1, (i>>2)&1, (i>>1)&1, i&1);
                 if (i < 15) {
-                    printf(",");
+                    fprintf(out, ",");
                 }
             }
         } else if (level < 15) {
+            char childValueChars[16][16];
+            int childRemotenesses[16][16];
+            getChildrenValueRemoteness(level, &tier, bitBoard, childValueChars, childRemotenesses);
             childTier.piecesPlaced = tier.piecesPlaced | (1 << tier.pieceToPlace);
             uint8_t *remainingPieces = unsetBitLists + ((childTier.piecesPlaced) << 4);
             for (i = 0; i < 16 - level; i++) { // Iterate through all possible empty slots
                 nextSlot = emptySlots[i];
-                childTier.occupiedSlots = tier.occupiedSlots | (1 << nextSlot);
-                childTier.occupiedSlotsMask = tier.occupiedSlotsMask | (UINT64_C(0xF) << (nextSlot << 2));
-                childBitBoard = bitBoard | (((uint64_t) tier.pieceToPlace) << (nextSlot << 2));
                 board[nextSlot] = pieceToPlace + 'A';
                 for (j = 0; j < 15 - level; j++) {  // Iterate through all possible remaining pieces
                     childTier.pieceToPlace = remainingPieces[j];
-                    getValueRemoteness(level + 1, &childTier, childBitBoard, &valueChar, &remoteness);
+                    valueChar = childValueChars[i][j];
+                    remoteness = childRemotenesses[i][j];
                     if (remoteness) { // non-primitive child
                         board[16] = childTier.pieceToPlace + 'A';
                         AutoGUIMakePositionString(turn, board, positionStringBuffer);
-                        printf("{\"position\":\"%s\",", positionStringBuffer);
-                        printf("\"autoguiPosition\":\"%s\",", positionStringBuffer);
-                        printf("\"remoteness\":%d,", remoteness);
-                        printf("\"positionValue\":\"%s\",", vctvs(valueChar));
-                        printf("\"autoguiMove\":\"A_%c_%d\",", childTier.pieceToPlace + 'A', 16 + nextSlot * 16 + childTier.pieceToPlace);
-                        printf("\"move\":\"%d-%d%d%d%d\"}", nextSlot+1, (childTier.pieceToPlace>>3)&1, (childTier.pieceToPlace>>2)&1, (childTier.pieceToPlace>>1)&1, childTier.pieceToPlace&1);  // slot is 1-indexed in moveName
+                        fprintf(out, "{\"position\":\"%s\",", positionStringBuffer);
+                        fprintf(out, "\"autoguiPosition\":\"%s\",", positionStringBuffer);
+                        fprintf(out, "\"remoteness\":%d,", remoteness);
+                        fprintf(out, "\"positionValue\":\"%s\",", vctvs(valueChar));
+                        fprintf(out, "\"autoguiMove\":\"A_%c_%d\",", childTier.pieceToPlace + 'A', 16 + nextSlot * 16 + childTier.pieceToPlace);
+                        fprintf(out, "\"move\":\"%d-%d%d%d%d\"}", nextSlot+1, (childTier.pieceToPlace>>3)&1, (childTier.pieceToPlace>>2)&1, (childTier.pieceToPlace>>1)&1, childTier.pieceToPlace&1);  // slot is 1-indexed in moveName
                         if (i < 15 - level || j < 14 - level) {
-                            printf(",");
+                            fprintf(out, ",");
                         }
                     } else {
                         board[16] = '-';
                         AutoGUIMakePositionString(turn, board, positionStringBuffer);
-                        printf("{\"position\":\"%s\",", positionStringBuffer);
-                        printf("\"autoguiPosition\":\"%s\",", positionStringBuffer);
-                        printf("\"remoteness\":%d,", remoteness);
-                        printf("\"positionValue\":\"%s\",", vctvs(valueChar));
-                        printf("\"autoguiMove\":\"A_-_%d\",", nextSlot); 
-                        printf("\"move\":\"%d\"}", nextSlot+1); // slot is 1-indexed in moveName
+                        fprintf(out, "{\"position\":\"%s\",", positionStringBuffer);
+                        fprintf(out, "\"autoguiPosition\":\"%s\",", positionStringBuffer);
+                        fprintf(out, "\"remoteness\":%d,", remoteness);
+                        fprintf(out, "\"positionValue\":\"%s\",", vctvs(valueChar));
+                        fprintf(out, "\"autoguiMove\":\"A_-_%d\",", nextSlot); 
+                        fprintf(out, "\"move\":\"%d\"}", nextSlot+1); // slot is 1-indexed in moveName
                         if (i < 15 - level) {
-                            printf(",");
+                            fprintf(out, ",");
                         }
                         break;
                     }
@@ -720,14 +1091,14 @@ void quartoDetailedPositionResponse(STRING positionString, char *positionStringB
             board[16] = '-';
 
             AutoGUIMakePositionString(turn, board, positionStringBuffer);
-            printf("{\"position\":\"%s\",", positionStringBuffer);
-            printf("\"autoguiPosition\":\"%s\",", positionStringBuffer);
-            printf("\"remoteness\":%d,", remoteness);
-            printf("\"positionValue\":\"%s\",", vctvs(valueChar));
-            printf("\"autoguiMove\":\"A_-_%d\",", nextSlot); 
-            printf("\"move\":\"%d\"}", nextSlot+1); // slot is 1-indexed in moveName
+            fprintf(out, "{\"position\":\"%s\",", positionStringBuffer);
+            fprintf(out, "\"autoguiPosition\":\"%s\",", positionStringBuffer);
+            fprintf(out, "\"remoteness\":%d,", remoteness);
+            fprintf(out, "\"positionValue\":\"%s\",", vctvs(valueChar));
+            fprintf(out, "\"autoguiMove\":\"A_-_%d\",", nextSlot); 
+            fprintf(out, "\"move\":\"%d\"}", nextSlot+1); // slot is 1-indexed in moveName
             board[16] = pieceToPlace + 'A';
         }
     }
-	printf("]}");
+	fprintf(out, "]}");
 }
\ No newline at end of file
@@ -13,13 +13,14 @@
 **************************************************************************/
 
 #include <zlib.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <sys/stat.h>
 #include "gamesman.h"
 #include "autoguistrings.h"
 #include <dirent.h>
 #include "interact.h"
 #include "sharddb.h"
-#define RESULT "result =>> "
 #define MAX_C4_SHARD_SIZE 52428800 // All un-gzipped shards are less than 50 MiB.
 
 /*internal declarations and definitions*/
@@ -40,7 +41,7 @@ REMOTENESS      sharddb_get_remoteness           (POSITION pos);
 BOOLEAN         sharddb_save_database            ();
 BOOLEAN         sharddb_load_database            ();
 
-/* LUR Cache */
+/* LRU Cache */
 typedef struct elem {
 	POSITION p;
 	VALUE v;
@@ -56,11 +57,60 @@ typedef struct elem_disk {
 	REMOTENESS r;
 } elem_disk_t;
 
+/* The position cache is split into stripes, each an independent LRU with
+   its own lock, so that concurrent request handlers can share it. Every
+   element a stripe will ever hold comes from its POOL. */
+typedef struct cache_stripe {
+	pthread_mutex_t lock;
+	elem_t **hash_table;
+	elem_t *pool;
+	elem_t head;
+	elem_t tail;
+	unsigned long long size;
+} cache_stripe_t;
+
+/* lru.bin starts with this header. The SNAPSHOT records after it hold no
+   position twice; journal records appended after those may repeat. */
+typedef struct cache_file_header {
+	char magic[4];
+	uint32_t version;
+	uint64_t snapshot;
+} cache_file_header_t;
+
+/* A slot of the journal ring. SEQ says whether it is free to fill (equal
+   to the filling ticket) or filled and ready to drain (ticket + 1). */
+typedef struct journal_slot {
+	unsigned long long seq;
+	elem_disk_t e;
+} journal_slot_t;
+
+/* A decompressed shard file, with an index of where each node at depth
+   index_bits of its tree starts, so lookups don't walk the whole shard. */
+typedef struct shard_segment {
+	int shard_id;
+	char *data;
+	size_t length;
+	char root_size;
+	int index_bits;
+	uint32_t *index_offset;
+	char *index_size;
+	unsigned long long last_use;
+	int refs;
+	BOOLEAN evicted;
+} shard_segment_t;
+
 static BOOLEAN sharddb_cache_load_from_disk(void);
 static BOOLEAN sharddb_cache_dump_to_disk(void);
-static BOOLEAN sharddb_cache_table_remove(elem_t *e);
-static void sharddb_cache_put(POSITION p, VALUE v, REMOTENESS r);
+static BOOLEAN sharddb_cache_table_remove(cache_stripe_t *s, elem_t *e);
+static BOOLEAN sharddb_cache_put(POSITION p, VALUE v, REMOTENESS r);
+static void sharddb_journal_start(unsigned long long records);
+static void sharddb_journal_stop(void);
+static void sharddb_journal_append(POSITION p, VALUE v, REMOTENESS r);
 static void sharddb_cache_get(VALUE *v, REMOTENESS *r, POSITION p);
+static shard_segment_t *sharddb_segment_acquire(int shardId, int leading3digits);
+static void sharddb_segment_release(shard_segment_t *seg);
+static void sharddb_segment_evict(int i);
+static char sharddb_segment_lookup(shard_segment_t *seg, POSITION key);
 
 /*
 ** Code
@@ -168,17 +218,17 @@ int ICOLUMNCOUNT = 6;
 void PositionToAutoGUIString(POSITION position, char *autoguiPositionStringBuffer);
 void MoveToAutoGUIString(POSITION position, MOVE move, char *autoguiMoveStringBuffer);
 
-void shardGamesmanDetailedPositionResponse(STRING inputPositionString, POSITION pos, char *positionStringBuffer, char *moveStringBuffer) {
+void shardGamesmanDetailedPositionResponse(FILE *out, STRING inputPositionString, POSITION pos, char *positionStringBuffer, char *moveStringBuffer) {
 	
-	printf(RESULT "{\"position\":\"%s\",\"autoguiPosition\":\"%s\"", inputPositionString, inputPositionString);
+	fprintf(out, "{\"position\":\"%s\",\"autoguiPosition\":\"%s\"", inputPositionString, inputPositionString);
 
 	ICOLUMNCOUNT = (getOption() == 2) ? 7 : 6;
 	VALUE value;
 	REMOTENESS remoteness;
 	sharddb_cache_get(&value, &remoteness, pos);
-	InteractPrintJSONPositionValue(value); // e.g. will print ,"value":"win"
-	printf(",\"remoteness\":%d", remoteness);
-	printf(",\"moves\":[");
+	InteractPrintJSONPositionValue(out, value); // e.g. will print ,"value":"win"
+	fprintf(out, ",\"remoteness\":%d", remoteness);
+	fprintf(out, ",\"moves\":[");
 
 	if (remoteness > 0) {
 		POSITION childPosition;
@@ -187,40 +237,69 @@ void shardGamesmanDetailedPositionResponse(STRING inputPositionString, POSITION
 		while (currentMove) {
 			childPosition = DoMove(pos, currentMove->move);
 			PositionToAutoGUIString(childPosition, positionStringBuffer);
-			printf("{\"position\":\"%s\",\"autoguiPosition\":\"%s\"", positionStringBuffer, positionStringBuffer);
+			fprintf(out, "{\"position\":\"%s\",\"autoguiPosition\":\"%s\"", positionStringBuffer, positionStringBuffer);
 
 			sharddb_cache_get(&value, &remoteness, childPosition);
-			InteractPrintJSONPositionValue(value); // e.g. will print ,"value":"win"
-			printf(",\"remoteness\":%d", remoteness);
+			InteractPrintJSONPositionValue(out, value); // e.g. will print ,"value":"win"
+			fprintf(out, ",\"remoteness\":%d", remoteness);
 		
 			MoveToString(currentMove->move, moveStringBuffer);
-			printf(",\"move\":\"%s\"", moveStringBuffer);
+			fprintf(out, ",\"move\":\"%s\"", moveStringBuffer);
 
 			MoveToAutoGUIString(childPosition, currentMove->move, moveStringBuffer);
-			printf(",\"autoguiMove\":\"%s\"", moveStringBuffer);
+			fprintf(out, ",\"autoguiMove\":\"%s\"", moveStringBuffer);
 
 			currentMove = currentMove->next;
-			printf("}");
+			fprintf(out, "}");
 			if (currentMove) {
-				printf(",");
+				fprintf(out, ",");
 			}
 		}
 		FreeMoveList(movesHead);
 	}
-	printf("]}");
+	fprintf(out, "]}");
 }
 
 /* LRU Cache */
+#define CACHE_STRIPE_BITS 6
+#define CACHE_STRIPES (1 << CACHE_STRIPE_BITS)
+
 static char CACHE_FILENAME[100];
 static unsigned long long CACHE_SIZE; 	// In bytes.
 static const double ALPHA = 0.75;		// Hash table target load factor
-static unsigned long long NUM_BUCKETS;
-static unsigned long long MAX_ELEMENTS;
-
-static elem_t **hash_table = NULL;
-static elem_t *head = NULL;
-static elem_t *tail = NULL;
-static unsigned long long cache_size = 0;
+static unsigned long long NUM_BUCKETS;	// Per stripe
+static unsigned long long MAX_ELEMENTS;	// Per stripe
+
+static cache_stripe_t *stripes = NULL;
+
+/* Cache journal. Misses are queued on a lock-free ring and appended to
+   CACHE_FILENAME by a background thread every JOURNAL_FLUSH_MS. Once the
+   journal holds more than 1/JOURNAL_COMPACT_FRACTION of the cache, the
+   thread rewrites the file as a fresh snapshot of the cache. */
+#define JOURNAL_SLOTS (1 << 16)
+#define JOURNAL_FLUSH_MS 1000
+#define JOURNAL_COMPACT_FRACTION 4
+#define CACHE_FILE_VERSION 1
+static const char CACHE_FILE_MAGIC[4] = { 'S', 'L', 'R', 'U' };
+
+static journal_slot_t *journal = NULL;
+static unsigned long long journal_tail = 0;		// Next ticket to fill, shared.
+static unsigned long long journal_head = 0;		// Next ticket to drain, writer only.
+static unsigned long long journal_records = 0;	// Journal records in the file, writer only.
+static pthread_t journal_thread;
+static pthread_mutex_t journal_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t journal_wake = PTHREAD_COND_INITIALIZER;
+static BOOLEAN journal_stop = FALSE;
+
+/* Shard segment cache */
+#define SEGMENT_SLOTS 16
+#define SEGMENT_BYTES (256ULL << 20)	// Budget for all decoded segments.
+#define SEGMENT_INDEX_BITS 16
+
+static pthread_mutex_t segment_lock = PTHREAD_MUTEX_INITIALIZER;
+static shard_segment_t *segments[SEGMENT_SLOTS];
+static unsigned long long segment_bytes = 0;
+static unsigned long long segment_clock = 0;
 
 /* https://www.geeksforgeeks.org/program-to-find-the-next-prime-number/ */
 static BOOLEAN is_prime(unsigned long long n) {
@@ -245,71 +324,299 @@ static unsigned long long prev_prime(unsigned long long n) {
 	return n;
 }
 
+static cache_stripe_t *stripe_of(POSITION p) {
+	return &stripes[(p * 0x9E3779B97F4A7C15ULL) >> (64 - CACHE_STRIPE_BITS)];
+}
+
 void sharddb_cache_init(void) {
-	if (hash_table) return;
-	int opt = getOption();
+	if (stripes) return;
+	int opt = getOption(), i;
 	snprintf(CACHE_FILENAME, 100, "./data/mconnect4_%d_sharddb/lru.bin", opt);
 	CACHE_SIZE = (opt == 1) ? (1ULL << 25) : (1ULL << 27); // 32 MiB for 6x6, 128 MiB for 6x7.
-	NUM_BUCKETS = prev_prime(CACHE_SIZE/(sizeof(elem_t)*ALPHA + sizeof(elem_t*)));
+	NUM_BUCKETS = prev_prime(CACHE_SIZE/CACHE_STRIPES/(sizeof(elem_t)*ALPHA + sizeof(elem_t*)));
 	MAX_ELEMENTS = NUM_BUCKETS * ALPHA;
-	hash_table = SafeCalloc(NUM_BUCKETS, sizeof(elem_t*));
-	head = SafeCalloc(1, sizeof(elem_t));
-	tail = SafeCalloc(1, sizeof(elem_t));
-	head->d_prev = NULL;
-	head->d_next = tail;
-	tail->d_prev = head;
-	tail->d_next = NULL;
-	cache_size = 0;
+	stripes = SafeCalloc(CACHE_STRIPES, sizeof(cache_stripe_t));
+	for (i = 0; i < CACHE_STRIPES; i++) {
+		pthread_mutex_init(&stripes[i].lock, NULL);
+		stripes[i].hash_table = SafeCalloc(NUM_BUCKETS, sizeof(elem_t*));
+		stripes[i].pool = SafeCalloc(MAX_ELEMENTS, sizeof(elem_t));
+		stripes[i].head.d_prev = NULL;
+		stripes[i].head.d_next = &stripes[i].tail;
+		stripes[i].tail.d_prev = &stripes[i].head;
+		stripes[i].tail.d_next = NULL;
+		stripes[i].size = 0;
+	}
 	if (!sharddb_cache_load_from_disk()) {
 		printf("sharddb_cache_init: load cache from disk failed.");
 	}
 }
 
 void sharddb_cache_deallocate(void) {
-	if (!hash_table) return;
+	int i;
+	if (!stripes) return;
+	sharddb_journal_stop();
 	if (!sharddb_cache_dump_to_disk()) {
 		printf("sharddb_cache_deallocate: cache dump failed.");
 	}
 	/* Deallocate all variables on heap. */
-	SafeFree(hash_table);
-	hash_table = NULL;
-	elem_t *walker = head, *tmp;
-	while (walker) {
-		tmp = walker;
-		walker = walker->d_next;
-		SafeFree(tmp);
+	for (i = 0; i < CACHE_STRIPES; i++) {
+		SafeFree(stripes[i].pool);
+		SafeFree(stripes[i].hash_table);
+		pthread_mutex_destroy(&stripes[i].lock);
+	}
+	SafeFree(stripes);
+	stripes = NULL;
+
+	pthread_mutex_lock(&segment_lock);
+	for (i = 0; i < SEGMENT_SLOTS; i++) {
+		if (segments[i])
+			sharddb_segment_evict(i);
+	}
+	pthread_mutex_unlock(&segment_lock);
+}
+
+/* Requires S->lock. Puts P at the head of S without checking whether it
+   is already there, evicting the least recently used element if full. */
+static void sharddb_cache_insert(cache_stripe_t *s, POSITION p, VALUE v, REMOTENESS r) {
+	unsigned long long slot = p % NUM_BUCKETS;
+	elem_t *e;
+	if (s->size == MAX_ELEMENTS) {
+		/* Evict least recently used element from cache. */
+		e = s->tail.d_prev;
+		s->tail.d_prev = e->d_prev;
+		e->d_prev->d_next = &s->tail;
+		if (!sharddb_cache_table_remove(s, e)) {
+			/* This should never happen. */
+			printf("sharddb_cache_put: failed to find existing element in hash table.");
+			return;
+		}
+	} else {
+		/* Cache is not full, take a new element from the pool. */
+		e = &s->pool[s->size++];
 	}
-	head = tail = NULL;
+	/* Put new values inside. */
+	e->p = p;
+	e->v = v;
+	e->r = r;
+	/* Insert as new head of linked list. */
+	e->d_prev = &s->head;
+	e->d_next = s->head.d_next;
+	s->head.d_next = e;
+	e->d_next->d_prev = e;
+	/* Insert into hash table at SLOT. */
+	e->s_next = s->hash_table[slot];
+	s->hash_table[slot] = e;
 }
 
+/* Rebuilds the cache from CACHE_FILENAME, then starts the journal. The
+   snapshot part holds each position once, so it goes straight into the
+   stripes. Only journal records appended after it are checked for
+   duplicates. A file without the header is all journal, and a torn last
+   record from a crash is ignored. */
 static BOOLEAN sharddb_cache_load_from_disk(void) {
+	cache_file_header_t header;
+	elem_disk_t *batch;
+	unsigned long long snapshot = 0, journaled = 0, n, i;
+	BOOLEAN ok = TRUE, headed = FALSE;
+	size_t got;
 	FILE *f = fopen(CACHE_FILENAME, "rb");
-	if (!f) return FALSE;
-	elem_disk_t e;
-	while (fread(&e, sizeof(elem_disk_t), 1, f)) {
-		sharddb_cache_put(e.p, e.v, e.r);
+	if (!f) {
+		sharddb_journal_start(0);
+		return FALSE;
+	}
+	if (fread(&header, sizeof(header), 1, f) == 1 &&
+	        !memcmp(header.magic, CACHE_FILE_MAGIC, sizeof(header.magic)) &&
+	        header.version == CACHE_FILE_VERSION) {
+		snapshot = header.snapshot;
+		headed = TRUE;
+	} else {
+		rewind(f);
+	}
+	batch = SafeMalloc(JOURNAL_SLOTS * sizeof(elem_disk_t));
+	while (snapshot > 0 && (got = fread(batch, sizeof(elem_disk_t), (snapshot < JOURNAL_SLOTS) ? snapshot : JOURNAL_SLOTS, f)) > 0) {
+		/* Stripe locks are not needed before the journal thread runs. */
+		for (i = 0; i < got; i++) {
+			sharddb_cache_insert(stripe_of(batch[i].p), batch[i].p, batch[i].v, batch[i].r);
+		}
+		snapshot -= got;
+	}
+	if (snapshot > 0) ok = FALSE;
+	while ((n = fread(batch, sizeof(elem_disk_t), JOURNAL_SLOTS, f)) > 0) {
+		for (i = 0; i < n; i++) {
+			sharddb_cache_put(batch[i].p, batch[i].v, batch[i].r);
+		}
+		journaled += n;
 	}
+	SafeFree(batch);
 	fclose(f);
-	return TRUE;
+	/* A file with no header or a short snapshot is rewritten right away. */
+	sharddb_journal_start((headed && ok) ? journaled : (~0ULL >> 1));
+	return ok;
 }
 
+/* Writes every stripe to a new CACHE_FILENAME as a snapshot, replacing
+   the old file and its journal in one rename. */
 static BOOLEAN sharddb_cache_dump_to_disk(void) {
-	FILE *f = fopen(CACHE_FILENAME, "wb");
+	char tmpname[110];
+	cache_file_header_t header;
+	elem_disk_t *batch;
+	int i, n = 0;
+	snprintf(tmpname, sizeof(tmpname), "%s.tmp", CACHE_FILENAME);
+	FILE *f = fopen(tmpname, "wb");
 	if (!f) return FALSE;
-	/* Write in reverse chronological order so that old elements are loaded first. */
-	elem_t *walker = tail->d_prev;
-	while (walker != head) {
-		fwrite(walker, sizeof(elem_disk_t), 1, f);
-		walker = walker->d_prev;
+	memcpy(header.magic, CACHE_FILE_MAGIC, sizeof(header.magic));
+	header.version = CACHE_FILE_VERSION;
+	header.snapshot = 0;
+	fwrite(&header, sizeof(header), 1, f);
+	batch = SafeMalloc(JOURNAL_SLOTS * sizeof(elem_disk_t));
+	/* Write each stripe in reverse chronological order so that old elements
+	   are loaded first. Every position maps to the same stripe on reload. */
+	for (i = 0; i < CACHE_STRIPES; i++) {
+		pthread_mutex_lock(&stripes[i].lock);
+		elem_t *walker = stripes[i].tail.d_prev;
+		while (walker != &stripes[i].head) {
+			batch[n].p = walker->p;
+			batch[n].v = walker->v;
+			batch[n].r = walker->r;
+			if (++n == JOURNAL_SLOTS) {
+				fwrite(batch, sizeof(elem_disk_t), n, f);
+				header.snapshot += n;
+				n = 0;
+			}
+			walker = walker->d_prev;
+		}
+		pthread_mutex_unlock(&stripes[i].lock);
+	}
+	fwrite(batch, sizeof(elem_disk_t), n, f);
+	header.snapshot += n;
+	SafeFree(batch);
+	rewind(f);
+	fwrite(&header, sizeof(header), 1, f);
+	if (fclose(f) != 0 || rename(tmpname, CACHE_FILENAME) != 0) {
+		remove(tmpname);
+		return FALSE;
 	}
-	fclose(f);
 	return TRUE;
 }
 
-static BOOLEAN sharddb_cache_table_remove(elem_t *e) {
+/* Queues a miss for the journal. Lock-free for any number of threads; if
+   the ring is full the record is dropped, and the next snapshot has it. */
+static void sharddb_journal_append(POSITION p, VALUE v, REMOTENESS r) {
+	unsigned long long ticket = __atomic_load_n(&journal_tail, __ATOMIC_RELAXED), seq;
+	journal_slot_t *slot;
+	if (!journal) return;
+	for (;;) {
+		slot = &journal[ticket & (JOURNAL_SLOTS - 1)];
+		seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		if (seq == ticket) {
+			if (__atomic_compare_exchange_n(&journal_tail, &ticket, ticket + 1, FALSE,
+			                                __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		} else if ((long long) (seq - ticket) < 0) {
+			return;
+		} else {
+			ticket = __atomic_load_n(&journal_tail, __ATOMIC_RELAXED);
+		}
+	}
+	slot->e.p = p;
+	slot->e.v = v;
+	slot->e.r = r;
+	__atomic_store_n(&slot->seq, ticket + 1, __ATOMIC_RELEASE);
+	/* Every half ring, wake the writer early rather than drop records. */
+	if ((ticket & (JOURNAL_SLOTS / 2 - 1)) == JOURNAL_SLOTS / 2 - 1)
+		pthread_cond_signal(&journal_wake);
+}
+
+/* Writes every filled journal slot to the end of CACHE_FILENAME. */
+static void sharddb_journal_flush(elem_disk_t *batch) {
+	journal_slot_t *slot;
+	FILE *f;
+	int n = 0;
+	while (n < JOURNAL_SLOTS) {
+		slot = &journal[journal_head & (JOURNAL_SLOTS - 1)];
+		if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != journal_head + 1) break;
+		batch[n++] = slot->e;
+		__atomic_store_n(&slot->seq, journal_head + JOURNAL_SLOTS, __ATOMIC_RELEASE);
+		journal_head++;
+	}
+	if (n == 0) return;
+	if (!(f = fopen(CACHE_FILENAME, "ab"))) return;
+	if (ftell(f) == 0) {
+		/* No file yet: start one with an empty snapshot. */
+		cache_file_header_t header;
+		memcpy(header.magic, CACHE_FILE_MAGIC, sizeof(header.magic));
+		header.version = CACHE_FILE_VERSION;
+		header.snapshot = 0;
+		fwrite(&header, sizeof(header), 1, f);
+	}
+	fwrite(batch, sizeof(elem_disk_t), n, f);
+	fclose(f);
+	journal_records += n;
+}
+
+static void *sharddb_journal_main(void *arg) {
+	elem_disk_t *batch = SafeMalloc(JOURNAL_SLOTS * sizeof(elem_disk_t));
+	struct timespec deadline;
+	BOOLEAN stop;
+	(void) arg;
+	for (;;) {
+		clock_gettime(CLOCK_REALTIME, &deadline);
+		deadline.tv_sec += JOURNAL_FLUSH_MS / 1000;
+		deadline.tv_nsec += (JOURNAL_FLUSH_MS % 1000) * 1000000L;
+		if (deadline.tv_nsec >= 1000000000L) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000L;
+		}
+		pthread_mutex_lock(&journal_lock);
+		if (!journal_stop)
+			pthread_cond_timedwait(&journal_wake, &journal_lock, &deadline);
+		stop = journal_stop;
+		pthread_mutex_unlock(&journal_lock);
+		sharddb_journal_flush(batch);
+		if (stop) break;
+		if (journal_records > MAX_ELEMENTS * CACHE_STRIPES / JOURNAL_COMPACT_FRACTION) {
+			if (sharddb_cache_dump_to_disk())
+				journal_records = 0;
+		}
+	}
+	SafeFree(batch);
+	return NULL;
+}
+
+/* RECORDS is the number of journal records already in the file. */
+static void sharddb_journal_start(unsigned long long records) {
+	unsigned long long i;
+	journal = SafeMalloc(JOURNAL_SLOTS * sizeof(journal_slot_t));
+	for (i = 0; i < JOURNAL_SLOTS; i++)
+		journal[i].seq = i;
+	journal_head = journal_tail = 0;
+	journal_records = records;
+	journal_stop = FALSE;
+	if (pthread_create(&journal_thread, NULL, sharddb_journal_main, NULL) != 0) {
+		printf("sharddb_journal_start: could not start the journal thread.");
+		SafeFree(journal);
+		journal = NULL;
+	}
+}
+
+/* Writes out what is queued and stops the journal thread. */
+static void sharddb_journal_stop(void) {
+	journal_slot_t *ring = journal;
+	if (!ring) return;
+	pthread_mutex_lock(&journal_lock);
+	journal_stop = TRUE;
+	pthread_cond_signal(&journal_wake);
+	pthread_mutex_unlock(&journal_lock);
+	pthread_join(journal_thread, NULL);
+	journal = NULL;
+	SafeFree(ring);
+}
+
+/* Requires S->lock. */
+static BOOLEAN sharddb_cache_table_remove(cache_stripe_t *s, elem_t *e) {
 	/* Look for existing element in table. */
 	unsigned long long slot = e->p % NUM_BUCKETS;
-	elem_t **walker = &hash_table[slot];
+	elem_t **walker = &s->hash_table[slot];
 	while (*walker) {
 		if ((*walker)->p == e->p) {
 			/* Found, remove it from table. */
@@ -321,52 +628,32 @@ static BOOLEAN sharddb_cache_table_remove(elem_t *e) {
 	return FALSE;
 }
 
-static void sharddb_cache_put(POSITION p, VALUE v, REMOTENESS r) {
+/* Returns FALSE if P was already cached. */
+static BOOLEAN sharddb_cache_put(POSITION p, VALUE v, REMOTENESS r) {
+	cache_stripe_t *s = stripe_of(p);
 	/* Look for existing element in table. */
 	unsigned long long slot = p % NUM_BUCKETS;
-	elem_t *walker = hash_table[slot];
+	pthread_mutex_lock(&s->lock);
+	elem_t *walker = s->hash_table[slot];
 	while (walker) {
 		if (walker->p == p) {
-			/* This should never happen. */
-			printf("sharddb_cache_put: inserting existing element.");
-			return;
+			/* Another thread missed on P at the same time and beat us to it. */
+			pthread_mutex_unlock(&s->lock);
+			return FALSE;
 		}
 		walker = walker->s_next;
 	}
-	elem_t *e;
-	if (cache_size == MAX_ELEMENTS) {
-		/* Evict least recently used element from cache. */
-		e = tail->d_prev;
-		tail->d_prev = e->d_prev;
-		e->d_prev->d_next = tail;
-		if (!sharddb_cache_table_remove(e)) {
-			/* This should never happen. */
-			printf("sharddb_cache_put: failed to find existing element in hash table.");
-			return;
-		}
-	} else {
-		/* Cache is not full, create a new element and add it. */
-		e = SafeCalloc(1, sizeof(elem_t));
-		++cache_size;
-	}
-	/* Put new values inside. */
-	e->p = p;
-	e->v = v;
-	e->r = r;
-	/* Insert as new head of linked list. */
-	e->d_prev = head;
-	e->d_next = head->d_next;
-	head->d_next = e;
-	e->d_next->d_prev = e;
-	/* Insert into hash table at SLOT. */
-	e->s_next = hash_table[slot];
-	hash_table[slot] = e;
+	sharddb_cache_insert(s, p, v, r);
+	pthread_mutex_unlock(&s->lock);
+	return TRUE;
 }
 
 static void sharddb_cache_get(VALUE *v, REMOTENESS *r, POSITION p) {
 	/* Look inside cache first. */
+	cache_stripe_t *s = stripe_of(p);
 	unsigned long long slot = p % NUM_BUCKETS;
-	elem_t *walker = hash_table[slot];
+	pthread_mutex_lock(&s->lock);
+	elem_t *walker = s->hash_table[slot];
 	while (walker) {
 		if (walker->p == p) {
 			/* Cache hit, read from cache and bring element to head. */
@@ -374,34 +661,208 @@ static void sharddb_cache_get(VALUE *v, REMOTENESS *r, POSITION p) {
 			*r = walker->r;
 			walker->d_next->d_prev = walker->d_prev;
 			walker->d_prev->d_next = walker->d_next;
-			walker->d_prev = head;
-			walker->d_next = head->d_next;
-			head->d_next = walker;
+			walker->d_prev = &s->head;
+			walker->d_next = s->head.d_next;
+			s->head.d_next = walker;
 			walker->d_next->d_prev = walker;
+			pthread_mutex_unlock(&s->lock);
 			return;
 		}
 		walker = walker->s_next;
 	}
-	/* Cache miss, read from disk and put in cache. */
+	pthread_mutex_unlock(&s->lock);
+	/* Cache miss, read from the shard's segment and put in cache. */
 	unsigned long long key = p & 0xFFFFFFFFFFFFF;
-	gzFile file = NULL;
 	int shardId, leading3digits;
 	getShardIDAndLeading3Digits(&shardId, &leading3digits, key);
 	key &= ((1ULL << 28) - 1);
+	shard_segment_t *seg = sharddb_segment_acquire(shardId, leading3digits);
+	if (!seg) {
+		*v = undecided;
+		*r = 0;
+		return;
+	}
+	char res = sharddb_segment_lookup(seg, key);
+	sharddb_segment_release(seg);
+	getValueRemotenessFromByte(v, r, res);
+	if (sharddb_cache_put(p, *v, *r))
+		sharddb_journal_append(p, *v, *r);
+}
+
+/* Shard segments */
+
+/* Returns the offset just past the encoding of the subtree at OFFSET. */
+static size_t sharddb_segment_skip(shard_segment_t *seg, size_t offset, int size) {
+	char ptr = seg->data[offset++];
+	if (ptr == 0) return offset + 1;
+	/* 1 means both halves share one encoding */
+	offset = sharddb_segment_skip(seg, offset, size - 1);
+	if (ptr == 1) return offset;
+	return sharddb_segment_skip(seg, offset, size - 1);
+}
+
+/* Fills the index slots below the node at OFFSET, which is DEPTH levels
+   down, and returns the offset just past its encoding. */
+static size_t sharddb_segment_build_index(shard_segment_t *seg, size_t offset, int size, int depth, unsigned long slot) {
+	unsigned long i, span = 1UL << (seg->index_bits - depth);
+	char ptr = seg->data[offset];
+	size_t end;
+	if (depth == seg->index_bits || ptr == 0) {
+		for (i = 0; i < span; i++) {
+			seg->index_offset[slot + i] = (uint32_t) offset;
+			seg->index_size[slot + i] = (char) size;
+		}
+		return sharddb_segment_skip(seg, offset, size);
+	}
+	end = sharddb_segment_build_index(seg, offset + 1, size - 1, depth + 1, slot);
+	if (ptr == 1)
+		sharddb_segment_build_index(seg, offset + 1, size - 1, depth + 1, slot + span/2);
+	else
+		end = sharddb_segment_build_index(seg, end, size - 1, depth + 1, slot + span/2);
+	return end;
+}
+
+/* Same answer as initializesegment(0, data + 1, root_size, key, &0), but
+   starts at the indexed node for KEY and only walks the subtrees it
+   has to skip over. */
+static char sharddb_segment_lookup(shard_segment_t *seg, POSITION key) {
+	size_t offset;
+	int size;
+	char ptr;
+	if (seg->root_size < 64 && (key >> seg->root_size) != 0)
+		return 0;
+	if (seg->index_bits > 0) {
+		unsigned long slot = key >> (seg->root_size - seg->index_bits);
+		offset = seg->index_offset[slot];
+		size = seg->index_size[slot];
+	} else {
+		offset = 1;
+		size = seg->root_size;
+	}
+	while ((ptr = seg->data[offset++]) != 0) {
+		size--;
+		if (ptr != 1 && ((key >> size) & 1))
+			offset = sharddb_segment_skip(seg, offset, size);
+	}
+	return seg->data[offset];
+}
+
+static shard_segment_t *sharddb_segment_load(int shardId, int leading3digits) {
 	char filename[100];
+	gzFile file;
+	int length;
 	snprintf(filename, 100, "./data/mconnect4_%d_sharddb/%d/solved-%d.gz", getOption(), leading3digits, shardId);
 	file = gzopen(filename, "rb");
-    if (!file) {
-        return;
-    }
-	char *gzbuffer = (char *) calloc(MAX_C4_SHARD_SIZE, 1);
-	gzread(file, gzbuffer, MAX_C4_SHARD_SIZE);
+	if (!file) {
+		return NULL;
+	}
+	shard_segment_t *seg = SafeCalloc(1, sizeof(shard_segment_t));
+	seg->shard_id = shardId;
+	seg->data = SafeMalloc(MAX_C4_SHARD_SIZE);
+	length = gzread(file, seg->data, MAX_C4_SHARD_SIZE);
 	gzclose(file);
-	char size = 28;
-	POSITION i = 0;
-	size = gzbuffer[i++];
-    char res = initializesegment(0, gzbuffer, size, key, &i);
-	SafeFree(gzbuffer);
-	getValueRemotenessFromByte(v, r, res);
-	sharddb_cache_put(p, *v, *r);
+	if (length < 2) {
+		SafeFree(seg->data);
+		SafeFree(seg);
+		return NULL;
+	}
+	/* Give back the part of the read buffer the shard didn't need. */
+	seg->length = length;
+	seg->data = SafeRealloc(seg->data, seg->length);
+	seg->root_size = seg->data[0];
+	seg->index_bits = (seg->root_size < SEGMENT_INDEX_BITS) ? seg->root_size : SEGMENT_INDEX_BITS;
+	if (seg->index_bits > 0) {
+		seg->index_offset = SafeMalloc(sizeof(uint32_t) << seg->index_bits);
+		seg->index_size = SafeMalloc(sizeof(char) << seg->index_bits);
+		sharddb_segment_build_index(seg, 1, seg->root_size, 0, 0);
+	}
+	return seg;
+}
+
+static void sharddb_segment_free(shard_segment_t *seg) {
+	SafeFree(seg->data);
+	if (seg->index_offset) SafeFree(seg->index_offset);
+	if (seg->index_size) SafeFree(seg->index_size);
+	SafeFree(seg);
+}
+
+/* Requires segment_lock. Drops the slot from the cache; the segment itself
+   goes once nobody is reading it. */
+static void sharddb_segment_evict(int i) {
+	shard_segment_t *seg = segments[i];
+	segments[i] = NULL;
+	segment_bytes -= seg->length;
+	if (seg->refs == 0)
+		sharddb_segment_free(seg);
+	else
+		seg->evicted = TRUE;
+}
+
+/* Returns the decoded segment of SHARDID with a reference held, loading it
+   if needed, or NULL if the shard file can't be read. */
+static shard_segment_t *sharddb_segment_acquire(int shardId, int leading3digits) {
+	shard_segment_t *seg, *loaded;
+	int i, victim;
+
+	pthread_mutex_lock(&segment_lock);
+	for (i = 0; i < SEGMENT_SLOTS; i++) {
+		if (segments[i] && segments[i]->shard_id == shardId) {
+			seg = segments[i];
+			seg->refs++;
+			seg->last_use = ++segment_clock;
+			pthread_mutex_unlock(&segment_lock);
+			return seg;
+		}
+	}
+	pthread_mutex_unlock(&segment_lock);
+
+	/* Decompress without holding the lock. */
+	loaded = sharddb_segment_load(shardId, leading3digits);
+	if (!loaded) return NULL;
+
+	pthread_mutex_lock(&segment_lock);
+	for (i = 0; i < SEGMENT_SLOTS; i++) {
+		if (segments[i] && segments[i]->shard_id == shardId) {
+			/* Someone else loaded it meanwhile. */
+			seg = segments[i];
+			seg->refs++;
+			seg->last_use = ++segment_clock;
+			pthread_mutex_unlock(&segment_lock);
+			sharddb_segment_free(loaded);
+			return seg;
+		}
+	}
+	/* Evict least recently used segments until there's room. */
+	while (TRUE) {
+		victim = -1;
+		for (i = 0; i < SEGMENT_SLOTS; i++) {
+			if (!segments[i]) {
+				if (segment_bytes + loaded->length <= SEGMENT_BYTES)
+					break;
+			} else if (victim < 0 || segments[i]->last_use < segments[victim]->last_use) {
+				victim = i;
+			}
+		}
+		if (i < SEGMENT_SLOTS || victim < 0)
+			break;
+		sharddb_segment_evict(victim);
+	}
+	loaded->refs = 1;
+	loaded->last_use = ++segment_clock;
+	if (i < SEGMENT_SLOTS) {
+		segments[i] = loaded;
+		segment_bytes += loaded->length;
+	} else {
+		/* Bigger than the whole budget, so use it once and drop it. */
+		loaded->evicted = TRUE;
+	}
+	pthread_mutex_unlock(&segment_lock);
+	return loaded;
+}
+
+static void sharddb_segment_release(shard_segment_t *seg) {
+	pthread_mutex_lock(&segment_lock);
+	if (--seg->refs == 0 && seg->evicted)
+		sharddb_segment_free(seg);
+	pthread_mutex_unlock(&segment_lock);
 }
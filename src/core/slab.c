@@ -0,0 +1,206 @@
+/************************************************************************
+**
+** NAME:	slab.c
+**
+** DESCRIPTION:	Size-class slab arenas for solver list nodes
+**
+** AUTHOR:	GamesCrafters Research Group, UC Berkeley
+**		Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+**
+** DATE:	2026-10-18
+**
+** LICENSE:	This file is part of GAMESMAN,
+**		The Finite, Two-person Perfect-Information Game Generator
+**		Released under the GPL:
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program, in COPYING; if not, write to the Free Software
+** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+**************************************************************************/
+
+/*
+   Blocks are cut off the front of the newest chunk with a pointer bump.
+   Chunks start at SLAB_FIRST_CHUNK bytes and double up to SLAB_MAX_CHUNK,
+   so a short solve doesn't hold megabytes and a long one mallocs rarely.
+   A freed block is pushed on its class's free list and handed out again
+   before any new space is cut. Nothing is given back to malloc until
+   slab_reset() or slab_destroy().
+
+   A 16-byte list node costs 16 bytes here, against 32 for a malloced one
+   once the malloc header and rounding are counted.
+ */
+
+#include "gamesman.h"
+#include "slab.h"
+
+#define SLAB_FIRST_CHUNK (64 << 10)
+#define SLAB_MAX_CHUNK   (4 << 20)
+
+/* Bytes of a chunk taken by its header, rounded to keep blocks aligned */
+#define SLAB_HEADER \
+	((sizeof(slab_chunk) + SLAB_ALIGN - 1) / SLAB_ALIGN * SLAB_ALIGN)
+
+/* Class of a block of size bytes, or -1 for a huge block; *block is set
+   to the bytes the block really takes */
+static int slab_class(size_t size, size_t *block) {
+
+	size_t bytes;
+	int class;
+
+	if (size <= SLAB_SMALL_MAX) {
+		class = size == 0 ? 0 : (int) ((size - 1) / SLAB_ALIGN);
+		*block = (size_t) (class + 1) * SLAB_ALIGN;
+		return class;
+	}
+	if (size > SLAB_LARGE_MAX) {
+		*block = (size + SLAB_ALIGN - 1) / SLAB_ALIGN * SLAB_ALIGN;
+		return -1;
+	}
+	class = SLAB_SMALL_MAX / SLAB_ALIGN;
+	for (bytes = 2 * SLAB_SMALL_MAX; bytes < size; bytes <<= 1)
+		class++;
+	*block = bytes;
+	return class;
+
+}
+
+static slab_chunk *slab_new_chunk(slab_arena *arena, size_t size) {
+
+	slab_chunk *chunk = (slab_chunk *) SafeMalloc(size);
+
+	chunk->size = size;
+	arena->reserved += size;
+	return chunk;
+
+}
+
+/* Starts a new newest chunk with room for at least block bytes */
+static void slab_grow(slab_arena *arena, size_t block) {
+
+	size_t size = arena->chunk_size;
+	slab_chunk *chunk;
+
+	if (size < block + SLAB_HEADER)
+		size = block + SLAB_HEADER;
+	chunk = slab_new_chunk(arena, size);
+	chunk->next = arena->chunks;
+	arena->chunks = chunk;
+	arena->next = (char *) chunk + SLAB_HEADER;
+	arena->end = (char *) chunk + size;
+	if (arena->chunk_size < SLAB_MAX_CHUNK)
+		arena->chunk_size <<= 1;
+
+}
+
+slab_arena *slab_create(const char *name) {
+
+	slab_arena *arena = (slab_arena *) SafeCalloc(1, sizeof(slab_arena));
+
+	arena->name = name;
+	arena->chunk_size = SLAB_FIRST_CHUNK;
+	return arena;
+
+}
+
+static void slab_free_chunks(slab_chunk *chunk) {
+
+	slab_chunk *next;
+
+	for (; chunk != NULL; chunk = next) {
+		next = chunk->next;
+		SafeFree(chunk);
+	}
+
+}
+
+void slab_destroy(slab_arena *arena) {
+
+	if (arena == NULL)
+		return;
+	slab_free_chunks(arena->chunks);
+	slab_free_chunks(arena->huge);
+	SafeFree(arena);
+
+}
+
+void *slab_alloc(slab_arena *arena, size_t size) {
+
+	size_t block;
+	int class = slab_class(size, &block);
+	slab_chunk *chunk;
+	void *result;
+
+	if (class < 0) {
+		chunk = slab_new_chunk(arena, block + SLAB_HEADER);
+		chunk->next = arena->huge;
+		arena->huge = chunk;
+		result = (char *) chunk + SLAB_HEADER;
+	} else if (arena->free_lists[class] != NULL) {
+		result = arena->free_lists[class];
+		arena->free_lists[class] = *(void **) result;
+	} else {
+		if ((size_t) (arena->end - arena->next) < block)
+			slab_grow(arena, block);
+		result = arena->next;
+		arena->next += block;
+	}
+	arena->live += block;
+	if (arena->live > arena->peak)
+		arena->peak = arena->live;
+	return result;
+
+}
+
+void slab_free(slab_arena *arena, void *block, size_t size) {
+
+	size_t bytes;
+	int class = slab_class(size, &bytes);
+
+	if (block == NULL)
+		return;
+	/* Huge blocks stay in their chunk until the reset */
+	if (class >= 0) {
+		*(void **) block = arena->free_lists[class];
+		arena->free_lists[class] = block;
+	}
+	arena->live -= bytes;
+
+}
+
+void slab_reset(slab_arena *arena) {
+
+	slab_chunk *newest = arena->chunks;
+
+	if (newest != NULL) {
+		slab_free_chunks(newest->next);
+		newest->next = NULL;
+		arena->reserved = newest->size;
+		arena->next = (char *) newest + SLAB_HEADER;
+	} else {
+		arena->reserved = 0;
+	}
+	slab_free_chunks(arena->huge);
+	arena->huge = NULL;
+	memset(arena->free_lists, 0, sizeof(arena->free_lists));
+	arena->live = 0;
+
+}
+
+void slab_print_stats(slab_arena *arena, FILE *out) {
+
+	fprintf(out, "%s: %llu bytes reserved, %llu live, %llu peak\n",
+	        arena->name, (unsigned long long) arena->reserved,
+	        (unsigned long long) arena->live, (unsigned long long) arena->peak);
+
+}
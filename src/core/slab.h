@@ -0,0 +1,69 @@
+#ifndef GMCORE_SLAB_H
+#define GMCORE_SLAB_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+   Size-class slab arenas for the small list nodes the solvers make by the
+   million (POSITIONLIST, FRnode, TIERLIST, IPOSITIONLIST). Blocks are cut
+   from large chunks, freed blocks go on a free list for their size class,
+   and a whole arena is given back at once with slab_reset() or
+   slab_destroy(). An arena is not thread-safe; threads use their own.
+ */
+
+/* Blocks are multiples of SLAB_ALIGN bytes. Sizes up to SLAB_SMALL_MAX get
+   a class per SLAB_ALIGN step, bigger ones a class per power of two up to
+   SLAB_LARGE_MAX; anything bigger gets a chunk of its own. */
+#define SLAB_ALIGN      16
+#define SLAB_SMALL_MAX  256
+#define SLAB_LARGE_MAX  16384
+#define SLAB_CLASSES    (SLAB_SMALL_MAX / SLAB_ALIGN + 6)
+
+typedef struct slab_chunk {
+	struct slab_chunk *next;
+	size_t size;            // bytes in the chunk, this header included
+} slab_chunk;
+
+typedef struct {
+
+	/* Shown by slab_print_stats() */
+	const char *name;
+
+	/* Chunks, newest first; blocks are cut from [next, end) of the newest */
+	slab_chunk *chunks;
+	char *next, *end;
+	size_t chunk_size;      // size of the next chunk to allocate
+
+	/* Blocks over SLAB_LARGE_MAX, one chunk each, kept until the reset */
+	slab_chunk *huge;
+
+	/* Freed blocks of each class, linked through their first word */
+	void *free_lists[SLAB_CLASSES];
+
+	/* Accounting, in bytes */
+	size_t reserved;        // held in chunks
+	size_t live;            // handed out and not freed since the last reset
+	size_t peak;            // highest live since the arena was created
+
+} slab_arena;
+
+/* Arena creation; name is not copied */
+slab_arena *slab_create(const char *name);
+
+/* Arena destruction, giving back every block and chunk */
+void slab_destroy(slab_arena *arena);
+
+/* Block of at least size bytes, SLAB_ALIGN aligned */
+void *slab_alloc(slab_arena *arena, size_t size);
+
+/* Gives block, which slab_alloc(arena, size) returned, back for reuse */
+void slab_free(slab_arena *arena, void *block, size_t size);
+
+/* Gives back every block at once. The newest chunk is kept for reuse. */
+void slab_reset(slab_arena *arena);
+
+/* One line of reserved, live and peak bytes */
+void slab_print_stats(slab_arena *arena, FILE *out);
+
+#endif
@@ -48,6 +48,12 @@ POSITIONLIST**  gParents = NULL;        /* The Parent of each node in a list */
 char*           gNumberChildren = NULL; /* The Number of children (used for Loopy games) */
 char*       gNumberChildrenOriginal = NULL;
 
+/* The nodes of gParents and of the BFS levels of SetParents live in
+   gParentArena and go back all at once in ParentFree. The frontier
+   queues live in gFRArena, which InitializeFR resets. */
+static slab_arena*      gParentArena = NULL;
+static slab_arena*      gFRArena = NULL;
+
 
 /*
 ** Local function prototypes
@@ -57,6 +63,7 @@ static void             ParentInitialize                (void);
 static VALUE    DetermineLoopyValue1            (POSITION pos);
 static void             ParentFree                      (void);
 static void             SetParents                      (POSITION bad, POSITION root);
+static VALUE    LoopyFinish                     (POSITION position, POSITION F0EdgeCount);
 
 
 /*
@@ -116,10 +123,7 @@ VALUE DetermineLoopyValue1(POSITION position)
 	POSITIONLIST *ptr;
 	VALUE childValue;
 	REMOTENESS remotenessChild;
-	POSITION i;
 	POSITION F0EdgeCount = 0;
-	POSITION F0NodeCount = 0;
-	POSITION F0DrawEdgeCount = 0;
 
 	/* Do DFS to set up Parent pointers and initialize KnownList w/Primitives */
 
@@ -216,8 +220,7 @@ VALUE DetermineLoopyValue1(POSITION position)
 
 		/* We are done with this position and no longer need to keep around its list of parents
 		** The tie frontier will not need this, either, because this child's value has already
-		** been determined.  It cannot be a tie. */
-		FreePositionList(gParents[child]);
+		** been determined.  It cannot be a tie. The nodes go back with gParentArena. */
 		gParents[child] = NULL;
 
 	} /* while still positions in FR */
@@ -254,7 +257,6 @@ VALUE DetermineLoopyValue1(POSITION position)
 			}
 			ptr = ptr->next;
 		}
-		FreePositionList(gParents[child]);
 		gParents[child] = NULL;
 	}
 
@@ -269,6 +271,20 @@ VALUE DetermineLoopyValue1(POSITION position)
 		printf("TIE cleanup\n");
 	}
 
+	return LoopyFinish(position, F0EdgeCount);
+}
+
+/*
+** Sets all visited positions that are still undecided to draws, and fills in
+** the analysis counts. Shared by both loopy engines.
+*/
+
+static VALUE LoopyFinish(POSITION position, POSITION F0EdgeCount)
+{
+	POSITION i;
+	POSITION F0NodeCount = 0;
+	POSITION F0DrawEdgeCount = 0;
+
 	for (i = 0; i < gNumberOfPositions; i++) {
 		if(Visited(i)) {
 			if(kDebugDetermineValue)
@@ -323,13 +339,13 @@ void DFS_SetParents (POSITION parent, POSITION position)
 	if(Visited(position)) { /* We've been down this path before, don't DFS */
 		if(kDebugDetermineValue) printf("Seen\n");
 		/* PARENT me */
-		gParents[position] = StorePositionInList(parent, gParents[position]);
+		gParents[position] = StorePositionInListArena(parent, gParents[position], gParentArena);
 	} else if((value = Primitive(position)) != undecided) { /* Primitive */
 		if(kDebugDetermineValue) printf("PRIM value = %s\n", gValueString[value]);
 		SetRemoteness(position,0); /* Primitives are leaves, remoteness = 0 */
 		MarkAsVisited(position);
 		/* PARENT me */
-		gParents[position] = StorePositionInList(parent, gParents[position]);
+		gParents[position] = StorePositionInListArena(parent, gParents[position], gParentArena);
 		/* Add me to FR. (I know i'm not already in the frontier because
 		 * this is the first time i've been visited) */
 		if(value == lose)
@@ -344,7 +360,7 @@ void DFS_SetParents (POSITION parent, POSITION position)
 		StoreValueOfPosition(position,value);
 	} else { /* first time, need to recursively determine value */
 		/* PARENT me */
-		gParents[position] = StorePositionInList(parent, gParents[position]);
+		gParents[position] = StorePositionInListArena(parent, gParents[position], gParentArena);
 		if(kDebugDetermineValue) printf("normal, continue searching\n");
 		MarkAsVisited(position);
 		movehead = GenerateMoves(position);
@@ -386,8 +402,9 @@ void DFS_SetParents (POSITION parent, POSITION position)
 
 void SetParents (POSITION parent, POSITION root)
 {
-	MOVELIST*       moveptr = NULL;
-	MOVELIST*       movehead = NULL;
+	MOVEBUFFER      moves;
+	MOVE            move;
+	int             i;
 	POSITIONLIST*   posptr = NULL;
 	POSITIONLIST*   thisLevel = NULL;
 	POSITIONLIST*   nextLevel = NULL;
@@ -397,7 +414,7 @@ void SetParents (POSITION parent, POSITION root)
 
 	// Check if the top is primitive.
 	MarkAsVisited(root);
-	gParents[root] = StorePositionInList(parent, gParents[root]);
+	gParents[root] = StorePositionInListArena(parent, gParents[root], gParentArena);
 	if ((value = Primitive(root)) != undecided) {
 		SetRemoteness(root, 0);
 		switch (value) {
@@ -411,7 +428,8 @@ void SetParents (POSITION parent, POSITION root)
 		return;
 	}
 
-	thisLevel = StorePositionInList(root, thisLevel);
+	thisLevel = StorePositionInListArena(root, thisLevel, gParentArena);
+	InitMoveBuffer(&moves);
 
 	while (thisLevel != NULL) {
 		POSITIONLIST* next;
@@ -420,11 +438,12 @@ void SetParents (POSITION parent, POSITION root)
 			next = posptr->next;
 			pos = posptr->position;
 
-			movehead = GenerateMoves(pos);
+			GenerateMovesToBuffer(pos, &moves);
 
-			for (moveptr = movehead; moveptr != NULL; moveptr = moveptr->next) {
-				printf("\n\nLOOPY SOLVER MOVE: %d\n\n", moveptr->move);
-				child = DoMove(pos, moveptr->move);
+			for (i = 0; i < moves.count; i++) {
+				move = moves.moves[i];
+				printf("\n\nLOOPY SOLVER MOVE: %d\n\n", move);
+				child = DoMove(pos, move);
 				// Robert Shi: can we speed this up by removing
 				// branching and use a default gCanonicalPosition
 				// function that returns the position itself when
@@ -433,11 +452,11 @@ void SetParents (POSITION parent, POSITION root)
 					child = gCanonicalPosition(child);
 
 				if (child >= gNumberOfPositions)
-					FoundBadPosition(child, pos, moveptr->move);
+					FoundBadPosition(child, pos, move);
 				// Robert Shi: are these (int) conversions really necessary?
 				++gNumberChildren[(int)pos];
 				++gNumberChildrenOriginal[(int)pos];
-				gParents[(int)child] = StorePositionInList(pos, gParents[(int)child]);
+				gParents[(int)child] = StorePositionInListArena(pos, gParents[(int)child], gParentArena);
 
 				if (Visited(child)) continue;
 				MarkAsVisited(child);
@@ -452,20 +471,19 @@ void SetParents (POSITION parent, POSITION root)
 					}
 					StoreValueOfPosition(child, value);
 				} else {
-					nextLevel = StorePositionInList(child, nextLevel);
+					nextLevel = StorePositionInListArena(child, nextLevel, gParentArena);
 				}
 				gTotalMoves++;
 			}
 
-			FreeMoveList(movehead);
-
-			/* Free as we go */
-			free(posptr);
+			/* Free as we go, for the parents to reuse */
+			slab_free(gParentArena, posptr, sizeof(POSITIONLIST));
 		}
 
 		thisLevel = nextLevel;
 		nextLevel = NULL;
 	}
+	FreeMoveBuffer(&moves);
 }
 
 
@@ -489,15 +507,15 @@ void ParentInitialize()
 	gParents = (POSITIONLIST **) SafeMalloc (gNumberOfPositions * sizeof(POSITIONLIST *));
 	for(i = 0; i < gNumberOfPositions; i++)
 		gParents[i] = NULL;
+	gParentArena = slab_create("Loopy parents");
 }
 
 void ParentFree()
 {
-	POSITION i;
-
-	for (i = 0; i < gNumberOfPositions; i++) {
-		FreePositionList(gParents[i]);
-	}
+	if (kDebugDetermineValue)
+		slab_print_stats(gParentArena, stdout);
+	slab_destroy(gParentArena);
+	gParentArena = NULL;
 
 	SafeFree(gParents);
 }
@@ -509,13 +527,13 @@ void NumberChildrenInitialize()
 	gNumberChildren = (char *) SafeMalloc (gNumberOfPositions * sizeof(signed char));
 	gNumberChildrenOriginal = (char *) SafeMalloc (gNumberOfPositions * sizeof(signed char));
 	if (gInterestingness) {
-		gAnalysis.Interestingness = (float *) SafeMalloc (gNumberOfPositions * sizeof(float)); /* Interestingness */
+		gAnalysis.Interestingness = (unsigned short *) SafeMalloc (gNumberOfPositions * sizeof(unsigned short)); /* Interestingness */
 	}
 	if (gInterestingness) {
 		for(i = 0; i < gNumberOfPositions; i++) {
 			gNumberChildren[i] = 0;
 			gNumberChildrenOriginal[i] = 0;
-			gAnalysis.Interestingness[i] = 0.0;
+			gAnalysis.Interestingness[i] = 0;
 		}
 	} else {
 		for(i = 0; i < gNumberOfPositions; i++) {
@@ -533,6 +551,9 @@ void NumberChildrenFree()
 
 void InitializeFR()
 {
+	if (gFRArena == NULL)
+		gFRArena = slab_create("Loopy frontier");
+	else slab_reset(gFRArena);
 	gHeadWinFR = NULL;
 	gTailWinFR = NULL;
 	gHeadLoseFR = NULL;
@@ -552,7 +573,7 @@ static POSITION DeQueueFR(FRnode **gHeadFR, FRnode **gTailFR)
 		position = (*gHeadFR)->position;
 		tmp = *gHeadFR;
 		(*gHeadFR) = (*gHeadFR)->next;
-		SafeFree(tmp);
+		slab_free(gFRArena, tmp, sizeof(FRnode));
 
 		if (*gHeadFR == NULL)
 			*gTailFR = NULL;
@@ -578,7 +599,7 @@ POSITION DeQueueTieFR()
 static void InsertFR(POSITION position, FRnode **firstnode,
                      FRnode **lastnode)
 {
-	FRnode *tmp = (FRnode *) SafeMalloc(sizeof(FRnode));
+	FRnode *tmp = (FRnode *) slab_alloc(gFRArena, sizeof(FRnode));
 	tmp->position = position;
 	tmp->next = NULL;
 
@@ -610,4 +631,255 @@ void InsertTieFR(POSITION position)
 	InsertFR(position, &gHeadTieFR, &gTailTieFR);
 }
 
+/*
+** The CSR loopy engine (--csrloopy).
+**
+** Does the same retrograde analysis as DetermineLoopyValue, but keeps the
+** parents of every position in one compressed sparse row index instead of
+** a POSITIONLIST per position: csrParents[csrOffsets[c] .. csrOffsets[c+1])
+** are the parents of c, one entry per edge. The index is built in two
+** passes. The first is the BFS of SetParents, which counts each position's
+** parents and records the edges it generates; the second turns the counts
+** into offsets and replays the edges into the rows. The frontiers and the
+** edge record are FIFO queues of fixed size chunks, so nothing here mallocs
+** per edge, and the chunks of the edge record are freed as it is replayed.
+*/
+
+#define L_CHUNK_SIZE 4096
+
+typedef struct lchunk {
+	POSITION positions[L_CHUNK_SIZE];
+	struct lchunk *next;
+} LCHUNK;
+
+typedef struct {
+	LCHUNK *head, *tail;
+	int headIndex, tailIndex;
+} LFRONTIER;
+
+static POSITION*        csrOffsets = NULL;
+static POSITION*        csrParents = NULL;
+
+static void lfrontierInit(LFRONTIER *fr)
+{
+	fr->head = fr->tail = (LCHUNK *) SafeMalloc(sizeof(LCHUNK));
+	fr->head->next = NULL;
+	fr->headIndex = fr->tailIndex = 0;
+}
+
+static void lfrontierPush(LFRONTIER *fr, POSITION position)
+{
+	if (fr->tailIndex == L_CHUNK_SIZE) {
+		fr->tail->next = (LCHUNK *) SafeMalloc(sizeof(LCHUNK));
+		fr->tail = fr->tail->next;
+		fr->tail->next = NULL;
+		fr->tailIndex = 0;
+	}
+	fr->tail->positions[fr->tailIndex++] = position;
+}
+
+static POSITION lfrontierPop(LFRONTIER *fr)
+{
+	LCHUNK *drained;
+
+	if (fr->headIndex == L_CHUNK_SIZE && fr->head != fr->tail) {
+		drained = fr->head;
+		fr->head = fr->head->next;
+		fr->headIndex = 0;
+		SafeFree(drained);
+	}
+	if (fr->head == fr->tail && fr->headIndex == fr->tailIndex)
+		return kBadPosition;
+	return fr->head->positions[fr->headIndex++];
+}
+
+static void lfrontierFree(LFRONTIER *fr)
+{
+	LCHUNK *chunk, *next;
+
+	for (chunk = fr->head; chunk != NULL; chunk = next) {
+		next = chunk->next;
+		SafeFree(chunk);
+	}
+	fr->head = fr->tail = NULL;
+}
+
+static void CSRPushPrimitive(POSITION position, VALUE value, LFRONTIER *winFR,
+                             LFRONTIER *loseFR, LFRONTIER *tieFR)
+{
+	SetRemoteness(position, 0);
+	switch (value) {
+	case lose: lfrontierPush(loseFR, position); break;
+	case win:  lfrontierPush(winFR, position); break;
+	case tie:  lfrontierPush(tieFR, position); break;
+	default:   BadElse("CSRDetermineLoopyValue found primitive with value other than win/lose/tie");
+	}
+	StoreValueOfPosition(position, value);
+}
+
+/*
+** Pass one: BFS from the root, marking positions visited, counting each
+** position's children and parents (the parent counts go in csrOffsets[c+1])
+** and putting primitives on the frontiers. Each expanded position is
+** recorded in edges as the position, its number of children, and then the
+** children themselves.
+*/
+
+static void CSRCountEdges(POSITION root, LFRONTIER *edges, LFRONTIER *winFR,
+                          LFRONTIER *loseFR, LFRONTIER *tieFR)
+{
+	LFRONTIER interior;
+	MOVEBUFFER moves;
+	POSITION pos, child;
+	VALUE value;
+	int i;
+
+	MarkAsVisited(root);
+	if ((value = Primitive(root)) != undecided) {
+		CSRPushPrimitive(root, value, winFR, loseFR, tieFR);
+		return;
+	}
+	lfrontierInit(&interior);
+	lfrontierPush(&interior, root);
+	InitMoveBuffer(&moves);
+
+	while ((pos = lfrontierPop(&interior)) != kBadPosition) {
+		GenerateMovesToBuffer(pos, &moves);
+		lfrontierPush(edges, pos);
+		lfrontierPush(edges, moves.count);
+
+		for (i = 0; i < moves.count; i++) {
+			child = DoMove(pos, moves.moves[i]);
+			if (gSymmetries)
+				child = gCanonicalPosition(child);
+			if (child >= gNumberOfPositions)
+				FoundBadPosition(child, pos, moves.moves[i]);
+			++gNumberChildren[pos];
+			++gNumberChildrenOriginal[pos];
+			++csrOffsets[child + 1];
+			lfrontierPush(edges, child);
+
+			if (Visited(child)) continue;
+			MarkAsVisited(child);
+
+			if ((value = Primitive(child)) != undecided)
+				CSRPushPrimitive(child, value, winFR, loseFR, tieFR);
+			else
+				lfrontierPush(&interior, child);
+			gTotalMoves++;
+		}
+	}
+	FreeMoveBuffer(&moves);
+	lfrontierFree(&interior);
+}
+
+/*
+** Pass two: turn the counts into offsets, then replay the recorded edges,
+** writing each parent into its children's rows.
+*/
+
+static void CSRFillEdges(LFRONTIER *edges)
+{
+	POSITION pos, child, numChildren, i;
+
+	for (i = 0; i < gNumberOfPositions; i++)
+		csrOffsets[i + 1] += csrOffsets[i];
+	csrParents = (POSITION *) SafeMalloc((csrOffsets[gNumberOfPositions] + 1) * sizeof(POSITION));
+
+	/* Use csrOffsets[c] as c's write cursor; afterwards it points at the
+	   start of c+1's row, so shift everything back by one. */
+	while ((pos = lfrontierPop(edges)) != kBadPosition) {
+		for (numChildren = lfrontierPop(edges); numChildren > 0; numChildren--) {
+			child = lfrontierPop(edges);
+			csrParents[csrOffsets[child]++] = pos;
+		}
+	}
+	for (i = gNumberOfPositions; i > 0; i--)
+		csrOffsets[i] = csrOffsets[i - 1];
+	csrOffsets[0] = 0;
+}
+
+VALUE CSRDetermineLoopyValue(POSITION position)
+{
+	LFRONTIER edges, winFR, loseFR, tieFR;
+	POSITION child, parent, edge, F0EdgeCount = 0;
+	VALUE childValue, value;
+	REMOTENESS remotenessChild;
+
+	/* Open positions walk gParents, which this engine doesn't build */
+	if (gUseOpen)
+		return DetermineLoopyValue(position);
+
+	NumberChildrenInitialize();
+	csrOffsets = (POSITION *) SafeCalloc(gNumberOfPositions + 1, sizeof(POSITION));
+	lfrontierInit(&edges);
+	lfrontierInit(&winFR);
+	lfrontierInit(&loseFR);
+	lfrontierInit(&tieFR);
+
+	CSRCountEdges(gInitialPosition, &edges, &winFR, &loseFR, &tieFR);
+	CSRFillEdges(&edges);
+	lfrontierFree(&edges);
+	if (kDebugDetermineValue)
+		printf("CSR parent index: " POSITION_FORMAT " edges\n", csrOffsets[gNumberOfPositions]);
+
+	/* Losing children first, as in DetermineLoopyValue1 */
+	while ((child = lfrontierPop(&loseFR)) != kBadPosition ||
+	       (child = lfrontierPop(&winFR)) != kBadPosition) {
+		childValue = GetValueOfPosition(child);
+		remotenessChild = Remoteness(child);
+
+		if (childValue == lose) {
+			for (edge = csrOffsets[child]; edge < csrOffsets[child + 1]; edge++) {
+				parent = csrParents[edge];
+				if ((value = GetValueOfPosition(parent)) == undecided) {
+					lfrontierPush(&winFR, parent);
+					SetRemoteness(parent, remotenessChild + 1);
+					StoreValueOfPosition(parent, win);
+				} else if (value != win) {
+					printf(POSITION_FORMAT " should be win.  Instead it is %d.", parent, value);
+					BadElse("CSRDetermineLoopyValue");
+				}
+			}
+		} else if (childValue == win) {
+			for (edge = csrOffsets[child]; edge < csrOffsets[child + 1]; edge++) {
+				parent = csrParents[edge];
+				if (--gNumberChildren[parent] == 0) {
+					F0EdgeCount -= (gNumberChildrenOriginal[parent] - 1);
+					lfrontierPush(&loseFR, parent);
+					SetRemoteness(parent, remotenessChild + 1);
+					StoreValueOfPosition(parent, lose);
+				}
+				F0EdgeCount++;
+			}
+		} else {
+			BadElse("CSRDetermineLoopyValue found FR member with other than win/lose value");
+		}
+	}
+
+	/* Ties, giving the lowest remoteness priority like DetermineLoopyValue1 */
+	while ((child = lfrontierPop(&tieFR)) != kBadPosition) {
+		remotenessChild = Remoteness(child);
+		for (edge = csrOffsets[child]; edge < csrOffsets[child + 1]; edge++) {
+			parent = csrParents[edge];
+			if (GetValueOfPosition(parent) == undecided) {
+				lfrontierPush(&tieFR, parent);
+				SetRemoteness(parent, remotenessChild + 1);
+				StoreValueOfPosition(parent, tie);
+			}
+		}
+	}
+
+	lfrontierFree(&winFR);
+	lfrontierFree(&loseFR);
+	lfrontierFree(&tieFR);
+	SafeFree(csrParents);
+	SafeFree(csrOffsets);
+	csrParents = csrOffsets = NULL;
+
+	value = LoopyFinish(gInitialPosition, F0EdgeCount);
+	NumberChildrenFree();
+	return value;
+}
+
 // End Loopy
@@ -3,6 +3,7 @@
 #define GMCORE_SOLVELOOPY_H
 
 VALUE           DetermineLoopyValue             (POSITION position);
+VALUE           CSRDetermineLoopyValue          (POSITION position);
 
 //void		InitializeVisitedArray		(void);
 //void		FreeVisitedArray		(void);
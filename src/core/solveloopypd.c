@@ -60,6 +60,10 @@ static FRnode *unanalyzedWinList = NULL;
 /* Linked lists of parents of each node. */
 static POSITIONLIST **parentsOf = NULL;
 
+/* Every list node of a solve: parents, BFS levels, frontiers and the
+   unanalyzed wins. Given back at once by FreeParents(). */
+static slab_arena *solveArena = NULL;
+
 /* Number of children left undecided. */   
 static char* numberChildren = NULL;  
 
@@ -239,7 +243,7 @@ static POSITION DeQueueFR(FRnode **gHeadFR, FRnode **gTailFR) {
 		position = (*gHeadFR)->position;
 		tmp = *gHeadFR;
 		(*gHeadFR) = (*gHeadFR)->next;
-		free(tmp);
+		slab_free(solveArena, tmp, sizeof(FRnode));
 
 		if (*gHeadFR == NULL) {
 			*gTailFR = NULL;
@@ -264,12 +268,12 @@ static POSITION DeQueueUnanalyzedWin(void) {
 	POSITIONLIST *oldHead = unanalyzedWinList;
 	POSITION pos = oldHead->position;
 	unanalyzedWinList = oldHead->next;
-	free(oldHead);
+	slab_free(solveArena, oldHead, sizeof(POSITIONLIST));
 	return pos;
 }
 
 static void InsertFR(POSITION position, FRnode **firstnode, FRnode **lastnode) {
-	FRnode *tmp = (FRnode *)SafeMalloc(sizeof(FRnode));
+	FRnode *tmp = (FRnode *)slab_alloc(solveArena, sizeof(FRnode));
 
 	tmp->position = position;
 	tmp->next = NULL;
@@ -297,13 +301,13 @@ static void InsertTieFR(POSITION position) {
 }
 
 static void InsertUnanalyzedWin(POSITION position) {
-	unanalyzedWinList = StorePositionInList(position, unanalyzedWinList);
+	unanalyzedWinList = StorePositionInListArena(position, unanalyzedWinList, solveArena);
 }
 
 static void FreeFRs(void) {
-	FreePositionList(winFRHead);
-	FreePositionList(loseFRHead);
-	FreePositionList(tieFRHead);
+	FreePositionListArena(winFRHead, solveArena);
+	FreePositionListArena(loseFRHead, solveArena);
+	FreePositionListArena(tieFRHead, solveArena);
 	winFRHead = winFRTail = NULL;
 	loseFRHead = loseFRTail = NULL;
 	tieFRHead = tieFRTail = NULL;
@@ -311,21 +315,22 @@ static void FreeFRs(void) {
 
 static void InitializeParents(void) {
 	parentsOf = (POSITIONLIST **)SafeCalloc(gNumberOfPositions, sizeof(POSITIONLIST *));
+	solveArena = slab_create("Pure draw solve lists");
 }
 
 static void FreeParents(void) {
-    POSITION i;
-
-	for (i = 0; i < gNumberOfPositions; ++i) {
-		FreePositionList(parentsOf[i]);
+	if (LPDS_DEBUG) {
+		slab_print_stats(solveArena, stdout);
 	}
+	slab_destroy(solveArena);
+	solveArena = NULL;
 	SafeFreeAndSetToNull((GENERIC_PTR *)&parentsOf);
 }
 
 static void InitializeNumberChildren(void) {
 	numberChildren = (char *)SafeCalloc(gNumberOfPositions, sizeof(signed char));
 	if (gInterestingness) {
-		gAnalysis.Interestingness = (float *)SafeCalloc(gNumberOfPositions, sizeof(float));
+		gAnalysis.Interestingness = (unsigned short *)SafeCalloc(gNumberOfPositions, sizeof(unsigned short));
 	}
 }
 
@@ -366,7 +371,7 @@ static VALUE SetPrimitiveOrEnqueue(POSITION pos, POSITIONLIST **nextLevel) {
 		SetValueInBPDB(pos, value);
 		SetSlotMax(pos, SL_DRAW_LEVEL_SLOT);
 	} else {
-		*nextLevel = StorePositionInList(pos, *nextLevel);
+		*nextLevel = StorePositionInListArena(pos, *nextLevel, solveArena);
 	}
 	return value;
 }
@@ -376,8 +381,8 @@ static VALUE SetPrimitiveOrEnqueue(POSITION pos, POSITIONLIST **nextLevel) {
    positions. Sends all primitive positions to their respective queues.
    Builds a backward graph that shows the parents of each position.  */
 static void SetParents(POSITION root) {
-	MOVELIST*       moveptr = NULL;
-	MOVELIST*       movehead = NULL;
+	MOVEBUFFER      moves;
+	int             i;
 	POSITIONLIST*   posptr = NULL;
 	POSITIONLIST*   thisLevel = NULL;
 	POSITIONLIST*   nextLevel = NULL;
@@ -389,13 +394,14 @@ static void SetParents(POSITION root) {
 	SetSlot(root, SL_VISITED_SLOT, TRUE);
 	/* Set the only parent of root position as bad. Thus, a bad parent
 	   indicates a root position. */
-	parentsOf[root] = StorePositionInList(kBadPosition, parentsOf[root]);
+	parentsOf[root] = StorePositionInListArena(kBadPosition, parentsOf[root], solveArena);
 	/* Edge case: if root is primitive, store it as the only entry
 	   in database and return. */
 	if (SetPrimitiveOrEnqueue(root, &nextLevel) != undecided) {
 		return;
 	}
 	/* The root is not a primitive position. Begin BFS. */
+	InitMoveBuffer(&moves);
 	while (nextLevel) {
 		thisLevel = nextLevel;
 		nextLevel = NULL;
@@ -403,28 +409,28 @@ static void SetParents(POSITION root) {
 			/* Extract the next position in list before we free it. */
 			next = posptr->next;
 			pos = posptr->position;
-			movehead = GenerateMoves(pos);
-			for (moveptr = movehead; moveptr; moveptr = moveptr->next) {
-				child = DoMove(pos, moveptr->move);
+			GenerateMovesToBuffer(pos, &moves);
+			for (i = 0; i < moves.count; i++) {
+				child = DoMove(pos, moves.moves[i]);
 				if (gSymmetries) {
 					child = gCanonicalPosition(child);
 				}
 				if (child >= gNumberOfPositions) {
-					FoundBadPosition(child, pos, moveptr->move);
+					FoundBadPosition(child, pos, moves.moves[i]);
 				}
 				++numberChildren[pos];
-				parentsOf[child] = StorePositionInList(pos, parentsOf[child]);
+				parentsOf[child] = StorePositionInListArena(pos, parentsOf[child], solveArena);
 				if (!GetSlot(child, SL_VISITED_SLOT)) {
 					SetSlot(child, SL_VISITED_SLOT, TRUE);
 					SetPrimitiveOrEnqueue(child, &nextLevel);
 					++gTotalMoves;
 				}
 			}
-			/* Free as we go */
-			free(posptr);
-			FreeMoveList(movehead);
+			/* Free as we go, for the parents to reuse */
+			slab_free(solveArena, posptr, sizeof(POSITIONLIST));
 		}
 	}
+	FreeMoveBuffer(&moves);
 }
 
 static void ProcessWinLose(VALUE valForWin, VALUE valForLose, int level) {
@@ -39,8 +39,10 @@
 #include "dirent.h"
 #include "levelfile_generator.h"
 #include <stdio.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <unistd.h>
 #include <time.h>
 
 // TIER VARIABLES
@@ -67,6 +69,7 @@ POSITION l_min = 0;
 void checkExistingDB();
 void AutoSolveAllTiers();
 void AutoSolveAllTiersMultiProcess();
+POSITION tCriticalPath(TIER, TIERLIST**, POSITION*);
 BOOLEAN gotoNextTier();
 void solveFirst(TIER);
 void PrepareToSolveNextTier();
@@ -80,6 +83,10 @@ void SolveTier(POSITION, POSITION);
 void SolveWithNonLoopyAlgorithm(POSITION, POSITION);
 void SolveWithLoopyAlgorithm(POSITION, POSITION);
 void LoopyParentsHelper(IPOSITIONLIST*, VALUE, REMOTENESS);
+void NonLoopyValueOfPosition(POSITION, VALUE*, REMOTENESS*);
+// Parallel Solver
+void SolveWithNonLoopyAlgorithmParallel(POSITION, POSITION, BOOLEAN);
+void SolveWithLoopyAlgorithmParallel(POSITION, POSITION, BOOLEAN);
 // Solver ChildCounter and Hashtable functions
 void rInitFRStuff();
 void rFreeFRStuff();
@@ -129,9 +136,6 @@ void DoTierDependencies(TIER, FILE*, time_t times[][2], time_t, time_t);
 VALUE DetermineRetrogradeValue(POSITION position) {
 	if (position == -1ULL) return undecided;
 	gDontLoadTierDB = FALSE;
-	// for the experimental GenerateMoves (commented out for now)
-	//if (gGenerateMovesEfficientFunPtr != NULL)
-	//    gGenerateMovesArray = (MOVE*) SafeMalloc(MAXFANOUT * sizeof(MOVE));
 	// initialize global variables
 	variant = getOption();
 	tierNames = TRUE;
@@ -361,7 +365,9 @@ VALUE DetermineRetrogradeValue(POSITION position) {
 			else
 			{
 				//Auto solve all of 'em
-				AutoSolveAllTiers();
+				if (gTierSolverProcesses > 1)
+					AutoSolveAllTiersMultiProcess();
+				else AutoSolveAllTiers();
 			}
 		}
 	}
@@ -389,84 +395,149 @@ void AutoSolveAllTiers() {
 
 // Set on by the command line (or the GUI) when no menu must appear
 
-//Currently spawns processes in batches. I want to make it so that as soon as a process
-//finishes, it will trigger the processes dependent on it to start. However, as of right
-//now I am using a naive way of detecting which tiers can be solved, which loops through
-//all of the tiers and uses an already written function, RemoteCanISolveTier(), to check.
-//Because of this, I have to spawn processes in batches because I cannot check for new tiers
-//to solve if there is a tier already being solved, because this results in spawning a thread
-//to solve a tier which is already in the process of being solved.
-//TODO: fix way by adding reverse-dependency graph
+// Solves every tier left, each in its own forked process. The tier tree is
+// turned into a reverse-dependency graph up front: every tier counts the
+// children it's still waiting on, and the moment its last child finishes it
+// goes on the ready list. At most gTierSolverProcesses are running at once,
+// and when a worker frees up the ready tier with the longest critical path
+// goes first: its own size plus the largest critical path among the tiers
+// that are waiting on it.
+// Each process solves its tier with the --threads sweep, so processes times
+// threads are busy at once. With gTierSolverProcesses at 0 the CPUs are
+// divided between them: CPUs / threads processes.
 void AutoSolveAllTiersMultiProcess() {
     ifprintf(gTierSolvePrint, "Fully Solving the game...\n\n");
 
-	pid_t wpid = 1;
-	BOOLEAN loop = TRUE;
+	TIERLIST *list, *ptr, *childs, *childPtr, *ready = NULL, **prev;
+	TIER max = 0, tier;
+	int i, workers = gTierSolverProcesses, running = 0, failed = 0, status;
+	int cpus = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	int threads = kSupportsThreads ? gTierSolverThreads : 1;
+	pid_t wpid;
+	time_t rawtime, mintime;
+	time_t (*rawtimes)[2];
+	int* pending; // children not yet solved, or -1 once dispatched
+
+	if (workers <= 0)
+		workers = cpus / threads;
+	else if (cpus > 0 && workers * threads > cpus)
+		printf("NOTE: %d processes of %d threads each is more than the %d CPUs.\n", workers, threads, cpus);
+	if (workers <= 0)
+		workers = 1;
 
-	TIERLIST *list;
 	list = RemoteGetTierSolveOrder();
-	TIERLIST *ptr;
-	int max = 0;
-
-	time_t rawtime;
+	for (ptr = list; ptr != NULL; ptr = ptr->next)
+		if (ptr->tier > max)
+			max = ptr->tier;
+
+	rawtimes = (time_t (*)[2]) SafeMalloc((max+1) * sizeof(*rawtimes));
+	pending = (int*) SafeMalloc((max+1) * sizeof(int));
+	TIERLIST** dependents = (TIERLIST**) SafeMalloc((max+1) * sizeof(TIERLIST*));
+	POSITION* critical = (POSITION*) SafeMalloc((max+1) * sizeof(POSITION));
+	pid_t* pids = (pid_t*) SafeMalloc(workers * sizeof(pid_t));
+	TIER* pidTiers = (TIER*) SafeMalloc(workers * sizeof(TIER));
+
+	for (tier = 0; tier <= max; tier++) {
+		pending[tier] = -1;
+		dependents[tier] = NULL;
+		critical[tier] = 0;
+		rawtimes[tier][0] = rawtimes[tier][1] = 0;
+	}
+	// build the graph, leaving out tiers whose DBs are already there
+	for (ptr = list; ptr != NULL; ptr = ptr->next)
+		if (CheckTierDB(ptr->tier, variant) != 1)
+			pending[ptr->tier] = 0;
 	for (ptr = list; ptr != NULL; ptr = ptr->next) {
-		if ((int) ptr->tier > max) {
-			max = (int) ptr->tier;
+		if (pending[ptr->tier] == -1) continue;
+		childs = gTierChildrenFunPtr(ptr->tier);
+		for (childPtr = childs; childPtr != NULL; childPtr = childPtr->next) {
+			if (childPtr->tier == ptr->tier || childPtr->tier > max
+			    || pending[childPtr->tier] == -1
+			    || TierInList(ptr->tier, dependents[childPtr->tier]))
+				continue;
+			pending[ptr->tier]++;
+			dependents[childPtr->tier] = CreateTierlistNode(ptr->tier, dependents[childPtr->tier]);
 		}
+		FreeTierList(childs);
+	}
+	for (ptr = list; ptr != NULL; ptr = ptr->next) {
+		if (pending[ptr->tier] == -1) continue;
+		tCriticalPath(ptr->tier, dependents, critical);
+		if (pending[ptr->tier] == 0)
+			ready = CreateTierlistNode(ptr->tier, ready);
 	}
-
-	time_t mintime;
-	time_t rawtimes[max+1][2];
-	int finished[max + 1];
 
 	time(&mintime);
 
-    while (loop) {
-        TIERLIST *list;
-        list = RemoteGetTierSolveOrder();
-
-        loop = FALSE;
-
-        TIERLIST *ptr;
-        for (ptr = list; ptr != NULL; ptr = ptr->next) {
-            if (RemoteCanISolveTier(ptr->tier)) {
-                printf("  Forking. Child Process will solve tier %llu \n", ptr->tier);
-
-				time(&rawtime);
-				rawtimes[ptr->tier][0] = rawtime - mintime;
-
-				finished[ptr->tier] = -1;
-
-                loop = TRUE;
-
-                pid_t child_pid;
-
-                if ((child_pid = fork()) == 0) {
-                    //child code
-                    RemoteSolveTier(ptr->tier, 0, RemoteGetTierSize(ptr->tier));
-
-                    printf("  Child process finished solving tier %llu \n", ptr->tier);
-
-                    FreeTierList(list);
-
-                    exit(0);
-                }
-            } else {
-				if (finished[ptr->tier] == -1) {
-					finished[ptr->tier] = 0;
-					time(&rawtime);
-  					rawtimes[ptr->tier][1] = rawtime - mintime;
-				}
+	while (ready != NULL || running > 0) {
+		while (ready != NULL && running < workers) {
+			// take the ready tier on the longest critical path
+			TIERLIST **best = &ready, *node;
+			for (prev = &ready; *prev != NULL; prev = &(*prev)->next)
+				if (critical[(*prev)->tier] > critical[(*best)->tier])
+					best = prev;
+			node = *best;
+			*best = node->next;
+			tier = node->tier;
+			SafeFree(node);
+
+			printf("  Forking. Child Process will solve tier %llu \n", tier);
+			fflush(stdout);
+			time(&rawtime);
+			rawtimes[tier][0] = rawtime - mintime;
+			pending[tier] = -1;
+
+			pid_t child_pid;
+
+			if ((child_pid = fork()) == 0) {
+				//child code
+				RemoteSolveTier(tier, 0, RemoteGetTierSize(tier));
+
+				printf("  Child process finished solving tier %llu \n", tier);
+
+				exit(0);
+			} else if (child_pid < 0) {
+				printf("ERROR: Couldn't fork a process to solve tier %llu!\n", tier);
+				failed++;
+				continue;
 			}
-        }
-        FreeTierList(list);
+			pids[running] = child_pid;
+			pidTiers[running] = tier;
+			running++;
+		}
+		if (running == 0)
+			break;
 
-        int status = 0;
-		while ((wpid = wait(&status)) > 0);
-    }
-    ifprintf(gTierSolvePrint, "\n%s is now fully solved!\n", kGameName);
+		if ((wpid = wait(&status)) <= 0)
+			break;
+		for (i = 0; i < running && pids[i] != wpid; i++) ;
+		if (i == running)
+			continue; // not one of ours
+		tier = pidTiers[i];
+		running--;
+		pids[i] = pids[running];
+		pidTiers[i] = pidTiers[running];
+
+		time(&rawtime);
+		rawtimes[tier][1] = rawtime - mintime;
+
+		tierdb_manifest_refresh(variant); // pick up the line the child appended
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || CheckTierDB(tier, variant) != 1) {
+			// leave everything that's waiting on it blocked
+			printf("ERROR: The process solving tier %llu failed!\n", tier);
+			failed++;
+			continue;
+		}
+		for (ptr = dependents[tier]; ptr != NULL; ptr = ptr->next)
+			if (--pending[ptr->tier] == 0)
+				ready = CreateTierlistNode(ptr->tier, ready);
+	}
+	FreeTierList(ready);
+
+	if (failed > 0)
+		printf("\n%d tier(s) couldn't be solved, so %s is NOT fully solved!\n", failed, kGameName);
+	else ifprintf(gTierSolvePrint, "\n%s is now fully solved!\n", kGameName);
 
-	list = RemoteGetTierSolveOrder();
 	for (ptr = list; ptr != NULL; ptr = ptr->next) {
 		time_t a = rawtimes[ptr->tier][0];
 		time_t b = rawtimes[ptr->tier][1];
@@ -477,6 +548,30 @@ void AutoSolveAllTiersMultiProcess() {
 	gVisTiers = TRUE;
 	GenerateTierTree(rawtimes);
 	gVisTiers = tempGVisTiers;
+
+	for (tier = 0; tier <= max; tier++)
+		FreeTierList(dependents[tier]);
+	FreeTierList(list);
+	SafeFree(rawtimes);
+	SafeFree(pending);
+	SafeFree(dependents);
+	SafeFree(critical);
+	SafeFree(pids);
+	SafeFree(pidTiers);
+}
+
+// The tier's size plus the longest chain of sizes among the tiers waiting
+// on it (memoized in critical, where 0 means not computed yet)
+POSITION tCriticalPath(TIER tier, TIERLIST** dependents, POSITION* critical) {
+	TIERLIST* ptr;
+	POSITION longest = 0, path;
+	if (critical[tier] != 0)
+		return critical[tier];
+	for (ptr = dependents[tier]; ptr != NULL; ptr = ptr->next)
+		if ((path = tCriticalPath(ptr->tier, dependents, critical)) > longest)
+			longest = path;
+	critical[tier] = RemoteGetTierSize(tier) + longest + 1; // +1 keeps it nonzero
+	return critical[tier];
 }
 
 // this function generates tier trees.
@@ -878,6 +973,13 @@ CHILDCOUNT* childCounts;
 
 //The Parent Pointers
 POSITIONLIST** rParents;
+// Their nodes, one arena per solver thread since each is unlocked
+slab_arena** rParentArenas = NULL;
+int rParentArenaCount = 0;
+
+// Threads for the tier being solved: gTierSolverThreads, or 1 for modules
+// without kSupportsThreads
+int rSolverThreads = 1;
 
 /* Rather than a Frontier Queue, this uses a sort of hashtable,
    with a POSITIONLIST for every REMOTENESS from 0 to REMOTENESS_MAX-1.
@@ -928,6 +1030,10 @@ void rInitFRStuff() {
 		rParents = (POSITIONLIST**) SafeMalloc (gNumberOfPositions * sizeof(POSITIONLIST*));
 		for (i = 0; i < gNumberOfPositions; i++)
 			rParents[i] = NULL;
+		rParentArenaCount = rSolverThreads;
+		rParentArenas = (slab_arena**) SafeMalloc (rParentArenaCount * sizeof(slab_arena*));
+		for (i = 0; i < (POSITION) rParentArenaCount; i++)
+			rParentArenas[i] = slab_create("Tier parents");
 	}
 	// 255 * 4 bytes = 1,020 bytes = ~1 KB
 	rWinFR = (IFRnode**) SafeMalloc (REMOTENESS_MAX * sizeof(IFRnode*));
@@ -941,10 +1047,16 @@ void rInitFRStuff() {
 void rFreeFRStuff() {
 	if (childCounts != NULL) SafeFree(childCounts);
 	if (!useUndo) {
-		// Free the Position Lists
-		POSITION i;
-		for (i = 0; i < gNumberOfPositions; i++)
-			FreePositionList(rParents[i]);
+		// Free the Position Lists, whose nodes all live in the arenas
+		int i;
+		for (i = 0; i < rParentArenaCount; i++) {
+			if (gTierSolvePrint)
+				slab_print_stats(rParentArenas[i], stdout);
+			slab_destroy(rParentArenas[i]);
+		}
+		if (rParentArenas != NULL) SafeFree(rParentArenas);
+		rParentArenas = NULL;
+		rParentArenaCount = 0;
 		if (rParents != NULL) SafeFree(rParents);
 	}
 	// Free the Position Lists
@@ -994,6 +1106,8 @@ POSITION numSolved, trueSizeOfTier;
 
 void SolveTier(POSITION start, POSITION end) {
 	numSolved = trueSizeOfTier = 0;
+	// only modules that say their callbacks are reentrant get the threads
+	rSolverThreads = kSupportsThreads ? gTierSolverThreads : 1;
 
 	BOOLEAN partialSolve = FALSE;
 	if (start != 0 || end != gCurrentTierSize) // we're only solving a partial tier!
@@ -1014,6 +1128,8 @@ void SolveTier(POSITION start, POSITION end) {
 	ifprintf(gTierSolvePrint, "\nSolver Type: %sLOOPY\n",((forceLoopy||gCurrentTierIsLoopy) ? "" : "NON-"));
 	ifprintf(gTierSolvePrint, "Using Symmetries: %s\n",(gSymmetries ? "YES" : "NO"));
 	ifprintf(gTierSolvePrint, "Checking Legality (using IsLegal): %s\n",(checkLegality ? "YES" : "NO"));
+	ifprintf(gTierSolvePrint, "Solver Threads: %d%s\n", rSolverThreads,
+	         (rSolverThreads < gTierSolverThreads) ? " (module doesn't set kSupportsThreads)" : "");
 	// now actually SOLVE depending on which solver to use
 	if (forceLoopy || gCurrentTierIsLoopy) { // LOOPY SOLVER
 		ifprintf(gTierSolvePrint, "Using UndoMove Functions: %s\n",(useUndo ? "YES" : "NO"));
@@ -1047,12 +1163,9 @@ void SolveTier(POSITION start, POSITION end) {
 // is a partial tier or not (that's what's nice about it)...
 void SolveWithNonLoopyAlgorithm(POSITION start, POSITION end) {
 	ifprintf(gTierSolvePrint, "\n-----PREPARING NON-LOOPY SOLVER-----\n");
-	POSITION pos, child;
-	MOVELIST *moves, *movesptr;
+	POSITION pos;
 	VALUE value;
 	REMOTENESS remoteness;
-	REMOTENESS maxWinRem, minLoseRem, minTieRem;
-	BOOLEAN seenLose, seenTie;
 
 	BOOLEAN usingLevelFiles = FALSE;
 	if (levelFiles && l_levelFileExists(gCurrentTier)) {
@@ -1068,64 +1181,17 @@ void SolveWithNonLoopyAlgorithm(POSITION start, POSITION end) {
 	}
 
 	ifprintf(gTierSolvePrint, "Doing a sweep of the tier, and solving it in one go...\n");
-	for (pos = start; pos < end; pos++) { // Solve only parents
+	if (rSolverThreads > 1) {
+		SolveWithNonLoopyAlgorithmParallel(start, end, usingLevelFiles);
+	} else for (pos = start; pos < end; pos++) { // Solve only parents
 		if (usingLevelFiles && !l_isInLevelFile(pos)) continue; //just skip
 		if (checkLegality && !gIsLegalFunPtr(pos)) continue; //skip
 		if (gSymmetries && pos != gCanonicalPosition(pos))
 			continue; // skip, since we'll do canon one later
 		trueSizeOfTier++;
-		value = Primitive(pos);
-		if (value != undecided) { // check for primitive-ness
-			SetRemoteness(pos,0);
-			StoreValueOfPosition(pos,value);
-		} else {
-			moves = movesptr = GenerateMoves(pos);
-			if (moves == NULL) { // no chillins
-				printf("ERROR: GenerateMoves on %llu returned NULL\n", pos);
-				ExitStageRight();
-			} else { // else, solve me
-				maxWinRem = -1;
-				minLoseRem = minTieRem = REMOTENESS_MAX;
-				seenLose = seenTie = FALSE;
-				for (; movesptr != NULL; movesptr = movesptr->next) {
-					child = DoMove(pos, movesptr->move);
-					if (gSymmetries)
-						child = gCanonicalPosition(child);
-					value = GetValueOfPosition(child);
-					if (value != undecided) {
-						remoteness = Remoteness(child);
-						if (value == tie) {
-							seenTie = TRUE;
-							if (remoteness < minTieRem)
-								minTieRem = remoteness;
-							continue;
-						} else if (value == lose) {
-							seenLose = TRUE;
-							if (remoteness < minLoseRem)
-								minLoseRem = remoteness;
-							continue;
-						} else if (remoteness > maxWinRem) //win
-							maxWinRem = remoteness;
-					} else {
-						printf("ERROR: GenerateMoves on %llu found undecided child, %llu!\n", pos, child);
-						ExitStageRight();
-					}
-				}
-				FreeMoveList(moves);
-				if (seenLose) {
-					SetRemoteness(pos,minLoseRem+1);
-					StoreValueOfPosition(pos, win);
-				} else if (seenTie) {
-					if (minTieRem == REMOTENESS_MAX)
-						SetRemoteness(pos,REMOTENESS_MAX); // a draw
-					else SetRemoteness(pos,minTieRem+1); // else a tie
-					StoreValueOfPosition(pos, tie);
-				} else {
-					SetRemoteness(pos,maxWinRem+1);
-					StoreValueOfPosition(pos, lose);
-				}
-			}
-		}
+		NonLoopyValueOfPosition(pos, &value, &remoteness);
+		SetRemoteness(pos,remoteness);
+		StoreValueOfPosition(pos,value);
 	}
 	if (checkLegality) {
 		ifprintf(gTierSolvePrint, "--True size of tier: %lld\n",trueSizeOfTier);
@@ -1134,13 +1200,104 @@ void SolveWithNonLoopyAlgorithm(POSITION start, POSITION end) {
 	if (usingLevelFiles) l_freeBitArray();
 }
 
-unsigned long long dedupHashSize = 0ULL; // Number of slots in dedup hash
-unsigned long long dedupHashElem = 0ULL; // Number of entries added to dedup hash
-unsigned long long dedupHashMask = 0LL;
-unsigned long long dedupHashBytes = 0LL;
+#define R_CHILDREN_ON_STACK 128
+
+// Moves of the position being solved. Per-thread like the dedup hash, and
+// kept between positions so that the sweeps don't allocate a move list each.
+__thread MOVEBUFFER rMoveBuffer = { NULL, 0, 0 };
+
+// Solves one position of a non-loopy tier, whose children are all in
+// already solved tiers. Shared by the serial and the parallel sweep.
+// The children are looked up in the DB with one bulk call.
+void NonLoopyValueOfPosition(POSITION pos, VALUE* valueOut, REMOTENESS* remotenessOut) {
+	POSITION childrenOnStack[R_CHILDREN_ON_STACK], *children;
+	VALUE valuesOnStack[R_CHILDREN_ON_STACK], *values;
+	REMOTENESS remotenessesOnStack[R_CHILDREN_ON_STACK], *remotenesses;
+	int numChildren, i;
+	VALUE value;
+	REMOTENESS remoteness;
+	REMOTENESS maxWinRem, minLoseRem, minTieRem;
+	BOOLEAN seenLose, seenTie;
+
+	value = Primitive(pos);
+	if (value != undecided) { // check for primitive-ness
+		*valueOut = value;
+		*remotenessOut = 0;
+		return;
+	}
+	numChildren = GenerateMovesToBuffer(pos, &rMoveBuffer);
+	if (numChildren == 0) { // no chillins
+		printf("ERROR: GenerateMoves on %llu returned NULL\n", pos);
+		ExitStageRight();
+	}
+	// else, solve me
+	if (numChildren <= R_CHILDREN_ON_STACK) {
+		children = childrenOnStack;
+		values = valuesOnStack;
+		remotenesses = remotenessesOnStack;
+	} else {
+		children = (POSITION*) SafeMalloc(numChildren * sizeof(POSITION));
+		values = (VALUE*) SafeMalloc(numChildren * sizeof(VALUE));
+		remotenesses = (REMOTENESS*) SafeMalloc(numChildren * sizeof(REMOTENESS));
+	}
+	for (i = 0; i < numChildren; i++) {
+		children[i] = DoMove(pos, rMoveBuffer.moves[i]);
+		if (gSymmetries)
+			children[i] = gCanonicalPosition(children[i]);
+	}
+	GetValueAndRemotenessOfCanonicalPositionBulk(children, values, remotenesses, numChildren);
+
+	maxWinRem = -1;
+	minLoseRem = minTieRem = REMOTENESS_MAX;
+	seenLose = seenTie = FALSE;
+	for (i = 0; i < numChildren; i++) {
+		value = values[i];
+		if (value != undecided) {
+			remoteness = remotenesses[i];
+			if (value == tie) {
+				seenTie = TRUE;
+				if (remoteness < minTieRem)
+					minTieRem = remoteness;
+				continue;
+			} else if (value == lose) {
+				seenLose = TRUE;
+				if (remoteness < minLoseRem)
+					minLoseRem = remoteness;
+				continue;
+			} else if (remoteness > maxWinRem) //win
+				maxWinRem = remoteness;
+		} else {
+			printf("ERROR: GenerateMoves on %llu found undecided child, %llu!\n", pos, children[i]);
+			ExitStageRight();
+		}
+	}
+	if (children != childrenOnStack) {
+		SafeFree(children);
+		SafeFree(values);
+		SafeFree(remotenesses);
+	}
+	if (seenLose) {
+		*remotenessOut = minLoseRem+1;
+		*valueOut = win;
+	} else if (seenTie) {
+		if (minTieRem == REMOTENESS_MAX)
+			*remotenessOut = REMOTENESS_MAX; // a draw
+		else *remotenessOut = minTieRem+1; // else a tie
+		*valueOut = tie;
+	} else {
+		*remotenessOut = maxWinRem+1;
+		*valueOut = lose;
+	}
+}
+
+// The dedup hash is per-thread so that parallel solver threads each get their own
+__thread unsigned long long dedupHashSize = 0ULL; // Number of slots in dedup hash
+__thread unsigned long long dedupHashElem = 0ULL; // Number of entries added to dedup hash
+__thread unsigned long long dedupHashMask = 0LL;
+__thread unsigned long long dedupHashBytes = 0LL;
 unsigned long long DEDUP_HASH_SIZE_INITIAL = 32LL; // Initial size of Dedup Hash
 int DEDUP_HASH_RATIO = 2; // Keep dedup hash size > (dedupHashElem << DEDUP_HASH_RATIO)
-POSITION *dedupHash = NULL; // Dedup hashtable
+__thread POSITION *dedupHash = NULL; // Dedup hashtable
 
 void dedupHashExpand() {
     if (dedupHash == NULL) {
@@ -1215,7 +1372,7 @@ void SolveWithLoopyAlgorithm(POSITION start, POSITION end) {
 	ifprintf(gTierSolvePrint, "\n-----PREPARING LOOPY SOLVER-----\n");
 	POSITION pos, posSaver, canonPos, child;
 	POSITIONLIST* tmp;
-	MOVELIST *moves, *movesptr;
+	int i;
 	VALUE value;
 	REMOTENESS remoteness;
 
@@ -1233,6 +1390,11 @@ void SolveWithLoopyAlgorithm(POSITION start, POSITION end) {
 	}
 
 	//int i,numMoves; // the generateMovesEfficient stuff is commented out for now
+	if (rSolverThreads > 1 && !partialSolve) {
+		SolveWithLoopyAlgorithmParallel(start, end, usingLevelFiles);
+		return;
+	}
+
 	ifprintf(gTierSolvePrint, "--Setting up Child Counters and Frontier Hashtables...\n");
 	rInitFRStuff();
 	ifprintf(gTierSolvePrint, "--Doing a sweep of the tier, and setting up the frontier...\n");
@@ -1252,20 +1414,18 @@ solve_start: // GASP!! A LABEL!!
 				numSolved++;
 				rInsertFR(value, pos, 0);
 			} else {
-				//if (gGenerateMovesEfficientFunPtr == NULL) { // do the normal stuff
-				moves = movesptr = GenerateMoves(pos);
+				GenerateMovesToBuffer(pos, &rMoveBuffer);
 				if (dedupHash != NULL) {
 					dedupHashElem = 0LL;
 					memset(dedupHash, 0, dedupHashBytes);
 				}
-				if (moves == NULL) { // no chillins
+				if (rMoveBuffer.count == 0) { // no chillins
 					printf("ERROR: GenerateMoves on %llu returned NULL\n", pos);
 					ExitStageRight();
 				} else {
 					//otherwise, make a Child Counter for it
-					movesptr = moves;
-                    for (; movesptr != NULL; movesptr = movesptr->next) {
-                    	child = gSymmetries ? gCanonicalPosition(DoMove(pos, movesptr->move)) : DoMove(pos, movesptr->move);
+                    for (i = 0; i < rMoveBuffer.count; i++) {
+                    	child = gSymmetries ? gCanonicalPosition(DoMove(pos, rMoveBuffer.moves[i])) : DoMove(pos, rMoveBuffer.moves[i]);
 						if (gSymmetries && useUndo && !dedupHashAdd(child)) continue;
 						childCounts[pos]++;
 
@@ -1278,10 +1438,9 @@ solve_start: // GASP!! A LABEL!!
                         	solveTheseTooList = StorePositionInList(child, solveTheseTooList);
                     	}
                     	if (!useUndo) { // if parent pointers, add to parent pointer list
-                        	rParents[child] = StorePositionInList(pos, rParents[child]);
+                        	rParents[child] = StorePositionInListArena(pos, rParents[child], rParentArenas[0]);
                     	}
                     }
-                    FreeMoveList(moves);
 				}
 			}
 		}
@@ -1447,6 +1606,431 @@ void LoopyParentsHelper(IPOSITIONLIST* list, VALUE valueParents, REMOTENESS remo
 	FreeIPositionList(list); // no longer need it!
 }
 
+/************************************************************************
+**
+** PARALLEL SOLVER
+**
+** Used instead of the sweeps above when --threads asks for more than one
+** thread. The range being swept is cut into one slice per thread; each
+** thread claims chunks of its own slice and, once that runs dry, steals
+** chunks from the other slices. Child counters are updated atomically,
+** and each thread inserts into its own frontier buckets, which are
+** gathered one remoteness level at a time. Within a level the order in
+** which children are processed doesn't change any value or remoteness,
+** so the tier DB comes out the same as the serial solver's.
+**
+** The module's Primitive, GenerateMoves and DoMove (plus IsLegal,
+** gCanonicalPosition and the UndoMove functions, when used) get called
+** from several threads at once, so they must not share scratch state.
+** Modules promise that by setting kSupportsThreads; the others are
+** solved with one thread whatever --threads says.
+**
+************************************************************************/
+
+#define R_CHUNK_SIZE 1024 // positions claimed at a time
+#define R_PARENT_LOCKS 4096 // lock stripes over rParents
+#define R_FRONTIER_INDEX(value) ((value) - win) // win, lose, tie -> 0, 1, 2
+
+typedef struct rthread_state {
+	POSITION solved, trueSize;
+	IFRnode* frontier[3][REMOTENESS_MAX]; // this thread's win/lose/tie buckets
+	slab_arena* parents; // where this thread's rParents nodes come from
+} RTHREADSTATE;
+
+typedef struct rwork_slice {
+	POSITION next; // claimed atomically, by the owner and by thieves
+	POSITION end;
+	char pad[48]; // keep slices on separate cache lines
+} RWORKSLICE;
+
+typedef void (*RWORKFUNC)(RTHREADSTATE*, POSITION, void*);
+
+typedef struct rparallel_job {
+	RWORKSLICE* slices;
+	RWORKFUNC work;
+	void* arg;
+} RPARALLELJOB;
+
+typedef struct rworker_arg {
+	RPARALLELJOB* job;
+	int id;
+} RWORKERARG;
+
+typedef struct rfrontier_job {
+	POSITION* children;
+	VALUE valueParents;
+	REMOTENESS remotenessChild;
+} RFRONTIERJOB;
+
+RTHREADSTATE* rThreadStates = NULL;
+pthread_mutex_t rParentLocks[R_PARENT_LOCKS];
+
+void rInitThreadStates() {
+	int i;
+	rThreadStates = (RTHREADSTATE*) SafeCalloc(rSolverThreads, sizeof(RTHREADSTATE));
+	if (!useUndo) {
+		// only the loopy sweep, after rInitFRStuff, has parent arenas
+		for (i = 0; i < rParentArenaCount; i++)
+			rThreadStates[i].parents = rParentArenas[i];
+		for (i = 0; i < R_PARENT_LOCKS; i++)
+			pthread_mutex_init(&rParentLocks[i], NULL);
+	}
+}
+
+// Sums the per-thread counters into numSolved/trueSizeOfTier
+void rCollectThreadCounts() {
+	int i;
+	numSolved = trueSizeOfTier = 0;
+	for (i = 0; i < rSolverThreads; i++) {
+		numSolved += rThreadStates[i].solved;
+		trueSizeOfTier += rThreadStates[i].trueSize;
+	}
+}
+
+void rFreeThreadStates() {
+	int i, v, r;
+	for (i = 0; i < rSolverThreads; i++)
+		for (v = 0; v < 3; v++)
+			for (r = 0; r < REMOTENESS_MAX; r++)
+				if (rThreadStates[i].frontier[v][r] != NULL)
+					FreeIPositionList(rThreadStates[i].frontier[v][r]);
+	if (!useUndo)
+		for (i = 0; i < R_PARENT_LOCKS; i++)
+			pthread_mutex_destroy(&rParentLocks[i]);
+	SafeFree(rThreadStates);
+	rThreadStates = NULL;
+}
+
+void rThreadInsertFR(RTHREADSTATE* state, VALUE value, POSITION position, REMOTENESS r) {
+	assert(r >= 0 && r < REMOTENESS_MAX);
+	if (value == win || value == lose || value == tie)
+		state->frontier[R_FRONTIER_INDEX(value)][r] =
+		        StorePositionInIList(position, state->frontier[R_FRONTIER_INDEX(value)][r]);
+}
+
+void* rParallelWorker(void* ptr) {
+	RWORKERARG* arg = (RWORKERARG*) ptr;
+	RPARALLELJOB* job = arg->job;
+	RTHREADSTATE* state = &rThreadStates[arg->id];
+	RWORKSLICE* slice;
+	POSITION from, to, i;
+	int victim;
+
+	generic_hash_thread_start();
+	// own slice first, then steal from the others
+	for (victim = 0; victim < rSolverThreads; victim++) {
+		slice = &job->slices[(arg->id + victim) % rSolverThreads];
+		while (TRUE) {
+			from = __atomic_fetch_add(&slice->next, R_CHUNK_SIZE, __ATOMIC_RELAXED);
+			if (from >= slice->end)
+				break;
+			to = (slice->end - from > R_CHUNK_SIZE) ? from + R_CHUNK_SIZE : slice->end;
+			for (i = from; i < to; i++)
+				job->work(state, i, job->arg);
+		}
+	}
+	if (arg->id != 0 && dedupHash != NULL) { // thread 0 is the main thread
+		free(dedupHash);
+		dedupHash = NULL;
+		dedupHashSize = dedupHashElem = dedupHashMask = dedupHashBytes = 0;
+	}
+	if (arg->id != 0)
+		FreeMoveBuffer(&rMoveBuffer);
+	return NULL;
+}
+
+// Calls work(state, i, arg) for every i in [start, end) across all threads,
+// returning once they are all done.
+void rParallelFor(POSITION start, POSITION end, RWORKFUNC work, void* arg) {
+	int i, n = rSolverThreads;
+	POSITION len = end - start;
+	RPARALLELJOB job;
+	pthread_t* threads = (pthread_t*) SafeMalloc(n * sizeof(pthread_t));
+	RWORKERARG* args = (RWORKERARG*) SafeMalloc(n * sizeof(RWORKERARG));
+
+	job.slices = (RWORKSLICE*) SafeMalloc(n * sizeof(RWORKSLICE));
+	job.work = work;
+	job.arg = arg;
+	for (i = 0; i < n; i++) {
+		job.slices[i].next = start + (len / n) * i + ((POSITION) i < len % n ? (POSITION) i : len % n);
+		job.slices[i].end = job.slices[i].next + len / n + ((POSITION) i < len % n ? 1 : 0);
+		args[i].job = &job;
+		args[i].id = i;
+	}
+	for (i = 1; i < n; i++) {
+		if (pthread_create(&threads[i], NULL, rParallelWorker, &args[i]) != 0) {
+			printf("ERROR: Couldn't create solver thread %d!\n", i);
+			ExitStageRight();
+		}
+	}
+	rParallelWorker(&args[0]);
+	for (i = 1; i < n; i++)
+		pthread_join(threads[i], NULL);
+	SafeFree(job.slices);
+	SafeFree(args);
+	SafeFree(threads);
+}
+
+// Runs the analysis hook that the raw stores skipped, on the main thread.
+void rAnalyzeSolvedPositions(POSITION start, POSITION end) {
+	POSITION pos;
+	VALUE value;
+	for (pos = start; pos < end; pos++) {
+		value = GetValueOfCanonicalPosition(pos);
+		if (value != undecided)
+			AnalyzePosition(pos, value);
+	}
+}
+
+void rNonLoopyWork(RTHREADSTATE* state, POSITION pos, void* arg) {
+	BOOLEAN usingLevelFiles = *(BOOLEAN*) arg;
+	VALUE value;
+	REMOTENESS remoteness;
+
+	if (usingLevelFiles && !l_isInLevelFile(pos)) return; //just skip
+	if (checkLegality && !gIsLegalFunPtr(pos)) return; //skip
+	if (gSymmetries && pos != gCanonicalPosition(pos))
+		return; // skip, since we'll do canon one later
+	state->trueSize++;
+	NonLoopyValueOfPosition(pos, &value, &remoteness);
+	StoreValueAndRemotenessOfCanonicalPosition(pos, value, remoteness);
+}
+
+void SolveWithNonLoopyAlgorithmParallel(POSITION start, POSITION end, BOOLEAN usingLevelFiles) {
+	rInitThreadStates();
+	rParallelFor(start, end, rNonLoopyWork, &usingLevelFiles);
+	rCollectThreadCounts();
+	rFreeThreadStates();
+	rAnalyzeSolvedPositions(start, end);
+}
+
+// Atomically takes this parent's child counter down, returning TRUE for the
+// one thread that gets to solve it.
+BOOLEAN rClaimParent(POSITION parent, VALUE valueParents) {
+	CHILDCOUNT count = __atomic_load_n(&childCounts[parent], __ATOMIC_RELAXED);
+	if (count == 0) // already dealt with OR illegal
+		return FALSE;
+	if (valueParents == win || valueParents == tie)
+		return __atomic_exchange_n(&childCounts[parent], 0, __ATOMIC_RELAXED) != 0;
+	while (count != 0) { // lose: the last winning child decides it
+		if (__atomic_compare_exchange_n(&childCounts[parent], &count, count - 1, FALSE,
+		                                __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			return (count == 1);
+	}
+	return FALSE;
+}
+
+void rLoopySweepWork(RTHREADSTATE* state, POSITION pos, void* arg) {
+	BOOLEAN usingLevelFiles = *(BOOLEAN*) arg;
+	int i;
+	POSITION child;
+	pthread_mutex_t* lock;
+	VALUE value;
+
+	if (usingLevelFiles && !l_isInLevelFile(pos)) return; //just skip
+	if (checkLegality && !gIsLegalFunPtr(pos)) return; //skip
+	if (gSymmetries && pos != gCanonicalPosition(pos))
+		return; // skip, since we'll do canon one later
+	state->trueSize++;
+	value = Primitive(pos);
+	if (value != undecided) { // check for primitive-ness
+		StoreValueAndRemotenessOfCanonicalPosition(pos, value, 0);
+		state->solved++;
+		rThreadInsertFR(state, value, pos, 0);
+		return;
+	}
+	GenerateMovesToBuffer(pos, &rMoveBuffer);
+	if (dedupHash != NULL) {
+		dedupHashElem = 0LL;
+		memset(dedupHash, 0, dedupHashBytes);
+	}
+	if (rMoveBuffer.count == 0) { // no chillins
+		printf("ERROR: GenerateMoves on %llu returned NULL\n", pos);
+		ExitStageRight();
+	}
+	for (i = 0; i < rMoveBuffer.count; i++) {
+		child = gSymmetries ? gCanonicalPosition(DoMove(pos, rMoveBuffer.moves[i])) : DoMove(pos, rMoveBuffer.moves[i]);
+		if (gSymmetries && useUndo && !dedupHashAdd(child)) continue;
+		childCounts[pos]++; // only this thread touches pos's counter here
+		if (!useUndo) {
+			lock = &rParentLocks[child % R_PARENT_LOCKS];
+			pthread_mutex_lock(lock);
+			rParents[child] = StorePositionInListArena(pos, rParents[child], state->parents);
+			pthread_mutex_unlock(lock);
+		}
+	}
+}
+
+void rLoopyFrontierWork(RTHREADSTATE* state, POSITION pos, void* arg) {
+	BOOLEAN usingLevelFiles = *(BOOLEAN*) arg;
+	POSITION canonPos;
+	VALUE value;
+	REMOTENESS remoteness;
+
+	if (usingLevelFiles && !l_isInLevelFile(pos)) return; //just skip
+	if (!useUndo && rParents[pos] == NULL) // if we didn't even see this child, don't put it on frontier!
+		return;
+	if (gSymmetries) {// use the canonical position's values
+		canonPos = gCanonicalPosition(pos);
+		if (useUndo && pos != canonPos)
+			return;
+	} else {
+		canonPos = pos; // else ignore
+	}
+	value = GetValueOfPosition(canonPos);
+	remoteness = Remoteness(canonPos);
+	if (!((value == tie && remoteness == REMOTENESS_MAX)
+	      || value == undecided))
+		rThreadInsertFR(state, value, pos, remoteness);
+}
+
+// The parallel counterpart of LoopyParentsHelper, for a single child.
+void rLoopyParentsOfChild(RTHREADSTATE* state, POSITION child, VALUE valueParents, REMOTENESS remotenessChild) {
+	POSITION parent;
+	POSITIONLIST *miniLoseFR = NULL, *parentList, *ptr;
+	UNDOMOVELIST *parents, *parentsPtr = NULL;
+
+	if (useUndo) {
+		parents = parentsPtr = gGenerateUndoMovesToTierFunPtr(child, gCurrentTier);
+		if (dedupHash != NULL) {
+			dedupHashElem = 0LL;
+			memset(dedupHash, 0, dedupHashBytes);
+		}
+		parentList = NULL;
+	} else {
+		parents = NULL;
+		parentList = rParents[child];
+	}
+	while (useUndo ? parentsPtr != NULL : parentList != NULL) {
+		if (useUndo) {
+			parent = gSymmetries ? gCanonicalPosition(gUnDoMoveFunPtr(child, parentsPtr->undomove)) : gUnDoMoveFunPtr(child, parentsPtr->undomove);
+			parentsPtr = parentsPtr->next;
+			if (gSymmetries && !dedupHashAdd(parent)) continue;
+			if (parent >= gCurrentTierSize) {
+				TIERPOSITION tp; TIER t;
+
+				gUnhashToTierPosition(parent, &tp, &t);
+				printf("ERROR: %llu generated undo-parent %llu (Tier: %llu, TierPosition: %llu),\n"
+				       "which is not in the current tier being solved!\n", child, parent, t, tp);
+				ExitStageRight();
+			}
+		} else {
+			parent = parentList->position;
+			parentList = parentList->next;
+		}
+		if (!rClaimParent(parent, valueParents))
+			continue;
+		if (valueParents == lose)
+			miniLoseFR = StorePositionInList(parent, miniLoseFR);
+		else rThreadInsertFR(state, valueParents, parent, remotenessChild + 1);
+		StoreValueAndRemotenessOfCanonicalPosition(parent, valueParents, remotenessChild + 1);
+		state->solved++;
+	}
+	if (parents != NULL)
+		FreeUndoMoveList(parents);
+	// if we solved LOSEs, deal with them now
+	for (ptr = miniLoseFR; ptr != NULL; ptr = ptr->next)
+		rLoopyParentsOfChild(state, ptr->position, win, remotenessChild + 1);
+	FreePositionList(miniLoseFR);
+}
+
+void rLoopyParentsWork(RTHREADSTATE* state, POSITION i, void* arg) {
+	RFRONTIERJOB* job = (RFRONTIERJOB*) arg;
+	rLoopyParentsOfChild(state, job->children[i], job->valueParents, job->remotenessChild);
+}
+
+// Gathers every thread's bucket for (value, r) and processes it in parallel.
+void rProcessFrontierLevel(VALUE value, REMOTENESS r, VALUE valueParents) {
+	POSITION count = 0, idx;
+	IFRnode* list;
+	IPOSITIONSUBLIST* sub;
+	RFRONTIERJOB job;
+	int i;
+
+	for (i = 0; i < rSolverThreads; i++)
+		if ((list = rThreadStates[i].frontier[R_FRONTIER_INDEX(value)][r]) != NULL)
+			count += list->size;
+	if (count == 0)
+		return;
+	job.children = (POSITION*) SafeMalloc(count * sizeof(POSITION));
+	job.valueParents = valueParents;
+	job.remotenessChild = r;
+	count = 0;
+	for (i = 0; i < rSolverThreads; i++) {
+		list = rThreadStates[i].frontier[R_FRONTIER_INDEX(value)][r];
+		if (list == NULL)
+			continue;
+		for (idx = 0, sub = list->head; idx < list->size; idx++) {
+			job.children[count++] = sub->positions[idx & 1023];
+			if (((idx + 1) & 1023) == 0)
+				sub = sub->next;
+		}
+		FreeIPositionList(list);
+		rThreadStates[i].frontier[R_FRONTIER_INDEX(value)][r] = NULL;
+	}
+	rParallelFor(0, count, rLoopyParentsWork, &job);
+	SafeFree(job.children);
+}
+
+void rDrawWork(RTHREADSTATE* state, POSITION pos, void* arg) {
+	(void) arg;
+	if (childCounts[pos] > 0) { // no lose/tie children, no/some wins = draw
+		StoreValueAndRemotenessOfCanonicalPosition(pos, tie, REMOTENESS_MAX); // a draw
+		state->solved++;
+	}
+}
+
+void SolveWithLoopyAlgorithmParallel(POSITION start, POSITION end, BOOLEAN usingLevelFiles) {
+	REMOTENESS r;
+
+	ifprintf(gTierSolvePrint, "--Setting up Child Counters and Frontier Hashtables...\n");
+	rInitFRStuff();
+	rInitThreadStates();
+	ifprintf(gTierSolvePrint, "--Doing a sweep of the tier, and setting up the frontier...\n");
+	rParallelFor(start, end, rLoopySweepWork, &usingLevelFiles);
+	rCollectThreadCounts();
+	if (checkLegality) {
+		ifprintf(gTierSolvePrint, "True size of tier: %lld\n",trueSizeOfTier);
+		ifprintf(gTierSolvePrint, "Tier %llu's hash efficiency: %.1f%c\n",gCurrentTier, 100*(double)trueSizeOfTier/gCurrentTierSize, '%');
+	}
+	ifprintf(gTierSolvePrint, "Amount now solved (primitives): %lld (%.1f%c)\n",numSolved, 100*(double)numSolved/trueSizeOfTier, '%');
+	if (numSolved == trueSizeOfTier) {
+		ifprintf(gTierSolvePrint, "Tier is all primitives! No loopy algorithm needed!\n");
+		goto done;
+	}
+	// SET UP FRONTIER!
+	ifprintf(gTierSolvePrint, "--Doing a sweep of child tiers, and setting up the frontier...\n");
+	rParallelFor(gCurrentTierSize, gNumberOfPositions, rLoopyFrontierWork, &usingLevelFiles);
+	tierdb_free_childpositions();
+	if (usingLevelFiles) l_freeBitArray();
+	ifprintf(gTierSolvePrint, "\n--Beginning the loopy algorithm...\n");
+	ifprintf(gTierSolvePrint, "--Processing Lose/Win Frontiers!\n");
+	for (r = 0; r <= REMOTENESS_MAX; r++) {
+		if (r != REMOTENESS_MAX)
+			rProcessFrontierLevel(lose, r, win);
+		if (r != 0)
+			rProcessFrontierLevel(win, r-1, lose);
+	}
+	rCollectThreadCounts();
+	ifprintf(gTierSolvePrint, "Amount now solved: %lld (%.1f%c)\n",numSolved, 100*(double)numSolved/trueSizeOfTier, '%');
+	if (numSolved == trueSizeOfTier)
+		goto done; // Else, we must process ties!
+	ifprintf(gTierSolvePrint, "--Processing Tie Frontier!\n");
+	for (r = 0; r < REMOTENESS_MAX; r++)
+		rProcessFrontierLevel(tie, r, tie);
+	rCollectThreadCounts();
+	ifprintf(gTierSolvePrint, "Amount now solved: %lld (%.1f%c)\n",numSolved, 100*(double)numSolved/trueSizeOfTier, '%');
+	if (numSolved == trueSizeOfTier)
+		goto done; // Else, we have undecideds... must make them DRAWs
+	ifprintf(gTierSolvePrint, "--Setting undecided to DRAWs...\n");
+	rParallelFor(0, gCurrentTierSize, rDrawWork, NULL);
+	rCollectThreadCounts();
+	assert(numSolved == trueSizeOfTier);
+done:
+	rFreeThreadStates();
+	rAnalyzeSolvedPositions(start, end);
+}
+
 
 /************************************************************************
 **
@@ -2024,6 +2608,7 @@ TIERLIST* RemoteGetTierSolveOrder() {
 // this tells you, given the current files, if you can solve this tier.
 // for simplicity, if tier is ALREADY solved, returns false
 BOOLEAN RemoteCanISolveTier(TIER tier) {
+	tierdb_manifest_refresh(variant); // other processes may have saved tiers since
 	if (!TierInList(tier, tierSolveList) || CheckTierDB(tier, variant) == 1)
 		return FALSE;
 	TIERLIST* childs = gTierChildrenFunPtr(tier);
@@ -36,10 +36,15 @@
 ** Code
 */
 
+/* Moves of the positions on the DFS stack, one buffer per depth, kept
+   between solves so they only grow to the game's fan-out once */
+static MOVEBUFFER *moveBuffers = NULL;
+static int moveBufferLevels = 0, moveBufferDepth = 0;
+
 VALUE DetermineValueSTD(POSITION position)
 {
 	BOOLEAN foundTie = FALSE, foundLose = FALSE, foundWin = FALSE;
-	MOVELIST *ptr, *head;
+	int depth, i, numMoves;
 	VALUE value;
 	POSITION child;
 	REMOTENESS maxRemoteness = 0, minRemoteness = MAXINT2;
@@ -68,11 +73,21 @@ VALUE DetermineValueSTD(POSITION position)
 		MarkAsVisited(position);
 		if(!kPartizan && !gTwoBits)
 			theMexCalc = MexCalcInit();
-		head = ptr = GenerateMoves(position);
-		while (ptr != NULL) {
-			MOVE move = ptr->move;
+		depth = moveBufferDepth++;
+		if (depth == moveBufferLevels) {
+			moveBufferLevels = moveBufferLevels ? 2 * moveBufferLevels : 64;
+			moveBuffers = (MOVEBUFFER *) (moveBuffers == NULL ?
+			                              SafeMalloc(sizeof(MOVEBUFFER) * moveBufferLevels) :
+			                              SafeRealloc(moveBuffers, sizeof(MOVEBUFFER) * moveBufferLevels));
+			for (i = depth; i < moveBufferLevels; i++)
+				InitMoveBuffer(&moveBuffers[i]);
+		}
+		/* deeper calls may move moveBuffers, so it's indexed afresh each time */
+		numMoves = GenerateMovesToBuffer(position, &moveBuffers[depth]);
+		for (i = 0; i < numMoves; i++) {
+			MOVE move = moveBuffers[depth].moves[i];
 			gAnalysis.TotalMoves++;
-			child = DoMove(position,ptr->move); /* Create the child */
+			child = DoMove(position,move); /* Create the child */
 
 			if(gSymmetries)
 				child = gCanonicalPosition(child);
@@ -118,10 +133,8 @@ VALUE DetermineValueSTD(POSITION position)
 
 			if (gUseGPS)
 				gUndoMove(move);
-
-			ptr = ptr->next;
-		} //while
-		FreeMoveList(head);
+		} //for
+		moveBufferDepth--;
 		UnMarkAsVisited(position);
 		if(!kPartizan && !gTwoBits)
 			MexStore(position,MexCompute(theMexCalc));
@@ -50,6 +50,12 @@ POSITIONLIST**  gVSParents = NULL;      /* The Parent of each node in a list */
 char*           gVSNumberChildren = NULL;       /* The Number of children (used for Loopy games) */
 char*       gVSNumberChildrenOriginal = NULL; /* Open Positions: for finding level1 frontier */
 
+/* Slab arenas of the parent lists (and the BFS levels of VSSetParents),
+   freed by VSParentFree, and of the frontier queues, reset by
+   VSInitializeFR */
+static slab_arena*      gVSParentArena = NULL;
+static slab_arena*      gVSFRArena = NULL;
+
 // Data to be stored in each slice of the database
 UINT32 SL_VALUESLOT = 0;
 UINT32 SL_MEXSLOT = 0;
@@ -289,8 +295,7 @@ VALUE VSDetermineLoopyValue1(POSITION position)
 
 		/* We are done with this position and no longer need to keep around its list of parents
 		** The tie frontier will not need this, either, because this child's value has already
-		** been determined.  It cannot be a tie. */
-		FreePositionList(gVSParents[child]);
+		** been determined.  It cannot be a tie. The nodes go back with gVSParentArena. */
 		gVSParents[child] = NULL;
 
 	} /* while still positions in FR */
@@ -328,7 +333,6 @@ VALUE VSDetermineLoopyValue1(POSITION position)
 			}
 			ptr = ptr->next;
 		}
-		FreePositionList(gVSParents[child]);
 		gVSParents[child] = NULL;
 	}
 
@@ -386,8 +390,8 @@ VALUE VSDetermineLoopyValue1(POSITION position)
 
 void VSSetParents (POSITION parent, POSITION root)
 {
-	MOVELIST*       moveptr;
-	MOVELIST*       movehead;
+	MOVEBUFFER      moves;
+	int             i;
 	POSITIONLIST*   posptr;
 	POSITIONLIST*   thisLevel;
 	POSITIONLIST*   nextLevel;
@@ -396,12 +400,11 @@ void VSSetParents (POSITION parent, POSITION root)
 	VALUE value;
 
 	posptr = thisLevel = nextLevel = NULL;
-	moveptr = movehead = NULL;
 
 	// Check if the top is primitive.
 	MarkAsVisited(root);
 
-	gVSParents[root] = StorePositionInList(parent, gVSParents[root]);
+	gVSParents[root] = StorePositionInListArena(parent, gVSParents[root], gVSParentArena);
 
 	if ((value = Primitive(root)) != undecided) {
 		SetRemoteness(root, 0);
@@ -416,7 +419,8 @@ void VSSetParents (POSITION parent, POSITION root)
 		return;
 	}
 
-	thisLevel = StorePositionInList(root, thisLevel);
+	thisLevel = StorePositionInListArena(root, thisLevel, gVSParentArena);
+	InitMoveBuffer(&moves);
 
 	while (thisLevel != NULL) {
 		POSITIONLIST* next;
@@ -425,18 +429,18 @@ void VSSetParents (POSITION parent, POSITION root)
 			next = posptr->next;
 			pos = posptr->position;
 
-			movehead = GenerateMoves(pos);
+			GenerateMovesToBuffer(pos, &moves);
 
-			for (moveptr = movehead; moveptr != NULL; moveptr = moveptr->next) {
-				child = DoMove(pos, moveptr->move);
+			for (i = 0; i < moves.count; i++) {
+				child = DoMove(pos, moves.moves[i]);
 				if (gSymmetries)
 					child = gCanonicalPosition(child);
 
 				if (child >= gNumberOfPositions)
-					FoundBadPosition(child, pos, moveptr->move);
+					FoundBadPosition(child, pos, moves.moves[i]);
 				++gVSNumberChildren[(int)pos];
 				++gVSNumberChildrenOriginal[(int)pos];
-				gVSParents[(int)child] = StorePositionInList(pos, gVSParents[(int)child]);
+				gVSParents[(int)child] = StorePositionInListArena(pos, gVSParents[(int)child], gVSParentArena);
 
 				if (Visited(child)) continue;
 				MarkAsVisited(child);
@@ -451,20 +455,19 @@ void VSSetParents (POSITION parent, POSITION root)
 					}
 					StoreValueOfPosition(child, value);
 				} else {
-					nextLevel = StorePositionInList(child, nextLevel);
+					nextLevel = StorePositionInListArena(child, nextLevel, gVSParentArena);
 				}
 				gTotalMoves++;
 			}
 
-			FreeMoveList(movehead);
-
-			/* Free as we go */
-			free(posptr);
+			/* Free as we go, for the parents to reuse */
+			slab_free(gVSParentArena, posptr, sizeof(POSITIONLIST));
 		}
 
 		thisLevel = nextLevel;
 		nextLevel = NULL;
 	}
+	FreeMoveBuffer(&moves);
 }
 
 
@@ -488,15 +491,15 @@ void VSParentInitialize()
 	gVSParents = (POSITIONLIST **) SafeMalloc (gNumberOfPositions * sizeof(POSITIONLIST *));
 	for(i = 0; i < gNumberOfPositions; i++)
 		gVSParents[i] = NULL;
+	gVSParentArena = slab_create("VS loopy parents");
 }
 
 void VSParentFree()
 {
-	POSITION i;
-
-	for (i = 0; i < gNumberOfPositions; i++) {
-		FreePositionList(gVSParents[i]);
-	}
+	if (kDebugDetermineValue)
+		slab_print_stats(gVSParentArena, stdout);
+	slab_destroy(gVSParentArena);
+	gVSParentArena = NULL;
 
 	SafeFree(gVSParents);
 }
@@ -508,14 +511,14 @@ void VSNumberChildrenInitialize()
 	gVSNumberChildren = (char *) SafeMalloc (gNumberOfPositions * sizeof(signed char));
 	gVSNumberChildrenOriginal = (char *) SafeMalloc (gNumberOfPositions * sizeof(signed char));     /* Open Positions: for finding level1 frontier */
 	if (gInterestingness) {
-		gAnalysis.Interestingness = (float *) SafeMalloc (gNumberOfPositions * sizeof(float)); /* Interestingness */
+		gAnalysis.Interestingness = (unsigned short *) SafeMalloc (gNumberOfPositions * sizeof(unsigned short)); /* Interestingness */
 	}
 
 	if (gInterestingness) {
 		for(i = 0; i < gNumberOfPositions; i++) {
 			gVSNumberChildren[i] = 0;
 			gVSNumberChildrenOriginal[i] = 0;
-			gAnalysis.Interestingness[i] = 0.0;
+			gAnalysis.Interestingness[i] = 0;
 		}
 	} else {
 		for(i = 0; i < gNumberOfPositions; i++) {
@@ -534,6 +537,9 @@ void VSNumberChildrenFree()
 
 void VSInitializeFR()
 {
+	if (gVSFRArena == NULL)
+		gVSFRArena = slab_create("VS loopy frontier");
+	else slab_reset(gVSFRArena);
 	gVSHeadWinFR = NULL;
 	gVSTailWinFR = NULL;
 	gVSHeadLoseFR = NULL;
@@ -553,7 +559,7 @@ static POSITION VSDeQueueFR(FRnode **gHeadFR, FRnode **gTailFR)
 		position = (*gHeadFR)->position;
 		tmp = *gHeadFR;
 		(*gHeadFR) = (*gHeadFR)->next;
-		SafeFree(tmp);
+		slab_free(gVSFRArena, tmp, sizeof(FRnode));
 
 		if (*gHeadFR == NULL)
 			*gTailFR = NULL;
@@ -579,7 +585,7 @@ POSITION VSDeQueueTieFR()
 static void VSInsertFR(POSITION position, FRnode **firstnode,
                        FRnode **lastnode)
 {
-	FRnode *tmp = (FRnode *) SafeMalloc(sizeof(FRnode));
+	FRnode *tmp = (FRnode *) slab_alloc(gVSFRArena, sizeof(FRnode));
 	tmp->position = position;
 	tmp->next = NULL;
 
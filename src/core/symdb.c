@@ -51,6 +51,7 @@ BOOLEAN symdb_readFromDisk = FALSE;
 SCHEME symdb_readScheme = NULL;
 UINT32 symdb_readStart = 0;
 UINT8 symdb_readOffset = 0;
+CHECKPOINTINDEX symdb_readIndex = NULL;
 
 //
 // stores the format of a slice; in particular the
@@ -263,6 +264,10 @@ symdb_init(
 	new_db->unmark_visited = symdb_unmark_visited;
 	new_db->get_mex = symdb_get_mex;
 	new_db->put_mex = symdb_set_mex;
+	new_db->get_value_bulk = symdb_get_value_bulk;
+	new_db->get_remoteness_bulk = symdb_get_remoteness_bulk;
+	new_db->check_visited_bulk = symdb_check_visited_bulk;
+	new_db->get_mex_bulk = symdb_get_mex_bulk;
 	new_db->get_winby = symdb_get_winby;
 	new_db->put_winby = symdb_set_winby;
 	new_db->get_drawlevel = symdb_get_drawlevel;
@@ -475,6 +480,9 @@ symdb_free( )
 			BPDB_TRACE("symdb_load_database()", "call to bitlib to open file failed", status);
 			goto _bailout;
 		}
+
+		bitlib_checkpoint_free( symdb_readIndex );
+		symdb_readIndex = NULL;
 	}
 
 	// free write slice format
@@ -598,6 +606,77 @@ symdb_get_mex(
 	return (MEX) functionsMapping->get_slice_slot( (UINT64)pos, SYMDB_MEXSLOT );
 }
 
+/*
+   The bulk getters look up the slot reader and the slice maxima once
+   instead of once per position.
+ */
+
+void
+symdb_get_value_bulk(
+        POSITION *positions,
+        VALUE *values,
+        int length
+        )
+{
+	UINT64 (*get_slot)(UINT64, UINT8) = functionsMapping->get_slice_slot;
+	int i;
+
+	for(i = 0; i < length; i++) {
+		values[i] = (VALUE) get_slot( (UINT64)positions[i], SYMDB_VALUESLOT );
+		if (values[i] == tie && symdb_get_remoteness(positions[i]) == (int) symdb_write_slice->maxvalue[SYMDB_REMSLOT/2] ) {
+			values[i] = drawdraw;
+		}
+	}
+}
+
+void
+symdb_get_remoteness_bulk(
+        POSITION *positions,
+        REMOTENESS *remotenesses,
+        int length
+        )
+{
+	UINT64 (*get_slot)(UINT64, UINT8) = functionsMapping->get_slice_slot;
+	REMOTENESS draw = (REMOTENESS)(symdb_write_slice->maxvalue[SYMDB_REMSLOT/2]+1);
+	int i;
+
+	for(i = 0; i < length; i++) {
+		remotenesses[i] = (REMOTENESS) get_slot( (UINT64)positions[i], SYMDB_REMSLOT );
+		if(remotenesses[i] == draw)
+			remotenesses[i] = REMOTENESS_MAX;
+	}
+}
+
+void
+symdb_check_visited_bulk(
+        POSITION *positions,
+        BOOLEAN *visited,
+        int length
+        )
+{
+	UINT64 (*get_slot)(UINT64, UINT8) = functionsMapping->get_slice_slot;
+	int i;
+
+	for(i = 0; i < length; i++) {
+		visited[i] = (BOOLEAN) get_slot( (UINT64)positions[i], SYMDB_VISITEDSLOT );
+	}
+}
+
+void
+symdb_get_mex_bulk(
+        POSITION *positions,
+        MEX *mexes,
+        int length
+        )
+{
+	UINT64 (*get_slot)(UINT64, UINT8) = functionsMapping->get_slice_slot;
+	int i;
+
+	for(i = 0; i < length; i++) {
+		mexes[i] = (MEX) get_slot( (UINT64)positions[i], SYMDB_MEXSLOT );
+	}
+}
+
 void
 symdb_set_winby(
         POSITION pos,
@@ -1297,6 +1376,84 @@ symdb_get_slice_slot(
 	return bitlib_read_bits( symdb_array + byteOffset, bitOffset, symdb_slice->size[index] );
 }
 
+/*++
+
+   Routine Description:
+
+    symdb_scan_slice_slot decodes a skip-encoded stream,
+    starting at the beginning of the record for slice
+    currentSlice, until it reaches the requested slice
+    and returns the value of the requested slot.
+
+   Arguments:
+
+    inFile - file to refill the buffer from; may be NULL if
+            the buffer already holds every byte to be read
+    inputBuffer - buffer holding the start of the stream
+    bufferLength - length of buffer
+    offset - bit offset of the first record in the first
+            byte of the buffer
+    currentSlice - slice the first record begins at
+    position - slice being looked up
+    index - slot to return
+
+   Return value:
+
+    Value of the requested slot, or 0 if the slice is
+    part of a run of skips
+
+   --*/
+
+static UINT64
+symdb_scan_slice_slot(
+        dbFILE inFile,
+        BYTE *inputBuffer,
+        UINT32 bufferLength,
+        UINT8 offset,
+        UINT64 currentSlice,
+        UINT64 position,
+        UINT8 index
+        )
+{
+	BYTE *curBuffer = inputBuffer;
+	UINT8 currentSlot = 0;
+	UINT64 value = 0;
+
+	while(currentSlice < position) {
+		if(bitlib_read_from_buffer( inFile, &curBuffer, inputBuffer, bufferLength, &offset, 1 ) == 0) {
+
+			for(currentSlot = 0; currentSlot < (symdb_write_slice->slots); currentSlot++) {
+				bitlib_read_from_buffer( inFile, &curBuffer, inputBuffer, bufferLength, &offset, symdb_write_slice->size[currentSlot]);
+			}
+			currentSlice++;
+		} else {
+			currentSlice += symdb_generic_read_varnum( inFile, symdb_readScheme, &curBuffer, inputBuffer, bufferLength, &offset, TRUE );
+		}
+	}
+
+	// if skips passed the sought position,
+	// return 0
+	if(currentSlice != position) {
+		return 0;
+	}
+
+	// if slice is part of a range of skips, return 0
+	if(bitlib_read_from_buffer( inFile, &curBuffer, inputBuffer, bufferLength, &offset, 1 ) != 0) {
+		return 0;
+	}
+
+	for(currentSlot = 0; currentSlot < (symdb_write_slice->slots); currentSlot++) {
+		value = bitlib_read_from_buffer( inFile, &curBuffer, inputBuffer, bufferLength, &offset, symdb_write_slice->size[currentSlot]);
+
+		if(currentSlot == index) {
+			return value;
+		}
+	}
+
+	return 0;
+}
+
+
 UINT64
 symdb_get_slice_slot_disk(
         UINT64 position,
@@ -1305,16 +1462,14 @@ symdb_get_slice_slot_disk(
 {
 	BYTE *inputBuffer = NULL;
 	BYTE *curBuffer = NULL;
+	UINT32 blockLength = 0;
+	UINT64 block = 0;
 
 	index /= 2;
 
 	// assign offset of first bit
 	UINT8 offset = symdb_readOffset;
 
-	// counters
-	UINT64 currentSlice = 0;
-	UINT8 currentSlot = 0;
-
 	// Eventually REMOVE these NULL checks, once the
 	// code is mature and these NULL errors do not occur.
 	if(NULL == symdb_readFile) {
@@ -1327,6 +1482,21 @@ symdb_get_slice_slot_disk(
 		goto _bailout;
 	}
 
+	// with a checkpoint index, inflate and decode only the
+	// block holding the slice; otherwise scan from the start
+	if(NULL != symdb_readIndex) {
+		if(position >= symdb_readIndex->slices) {
+			return 0;
+		}
+
+		block = bitlib_checkpoint_find( symdb_readIndex, position );
+
+		if(GMSUCCESS(bitlib_checkpoint_read_block( symdb_readIndex, block, &inputBuffer, &blockLength ))) {
+			return symdb_scan_slice_slot( NULL, inputBuffer, blockLength, symdb_readIndex->bit[block],
+			                             symdb_readIndex->slice[block], position, index );
+		}
+	}
+
 	// seek to desired location
 	bitlib_file_seek(symdb_readFile, symdb_readStart, SEEK_SET);
 
@@ -1339,42 +1509,7 @@ symdb_get_slice_slot_disk(
 	bitlib_file_read_bytes( symdb_readFile, inputBuffer, symdb_buffer_length );
 
 	if(symdb_readScheme->indicator) {
-
-		while(currentSlice < position) {
-			if(bitlib_read_from_buffer( symdb_readFile, &curBuffer, inputBuffer, symdb_buffer_length, &offset, 1 ) == 0) {
-
-				for(currentSlot = 0; currentSlot < (symdb_write_slice->slots); currentSlot++) {
-					bitlib_read_from_buffer( symdb_readFile, &curBuffer, inputBuffer, symdb_buffer_length, &offset, symdb_write_slice->size[currentSlot]);
-				}
-				currentSlice++;
-			} else {
-				UINT64 skips = symdb_generic_read_varnum( symdb_readFile, symdb_readScheme, &curBuffer, inputBuffer, symdb_buffer_length, &offset, TRUE );
-				currentSlice += skips;
-			}
-		}
-
-		if(currentSlice == position)
-		{
-			// if slice is part of a range of skips, return 0
-			if(bitlib_read_from_buffer( symdb_readFile, &curBuffer, inputBuffer, symdb_buffer_length, &offset, 1 ) != 0) {
-				return 0;
-			}
-
-			for(currentSlot = 0; currentSlot < (symdb_write_slice->slots); currentSlot++) {
-				UINT64 value = bitlib_read_from_buffer( symdb_readFile, &curBuffer, inputBuffer, symdb_buffer_length, &offset, symdb_write_slice->size[currentSlot]);
-
-				if(currentSlot == index)
-				{
-					return value;
-				}
-			}
-		}
-		else
-		{
-			// if skips passed the sought position,
-			// return 0
-			return 0;
-		}
+		return symdb_scan_slice_slot( symdb_readFile, inputBuffer, symdb_buffer_length, offset, 0, position, index );
 	} else {
 		// computation for a scheme 0 encoded db
 		UINT64 byteOffset = 0;
@@ -1749,6 +1884,10 @@ symdb_save_database()
 	// final file name
 	char outfilename[256];
 
+	// checkpoint index file names
+	char indexname[256];
+	char finalindexname[256];
+
 	// track smallest file
 	int smallestscheme = 0;
 	int smallestsize = -1;
@@ -1851,6 +1990,8 @@ symdb_save_database()
 						printf("Removing %s\n", outfilenames[smallestscheme]);
 					}
 					remove(outfilenames[smallestscheme]);
+					bitlib_checkpoint_filename(outfilenames[smallestscheme], indexname);
+					remove(indexname);
 				}
 				smallestscheme = i;
 				smallestsize = fileinfo.st_size;
@@ -1859,6 +2000,8 @@ symdb_save_database()
 					printf("Removing %s\n", outfilenames[i]);
 				}
 				remove(outfilenames[i]);
+				bitlib_checkpoint_filename(outfilenames[i], indexname);
+				remove(indexname);
 			}
 		}
 		cur = cur->next;
@@ -1877,6 +2020,13 @@ symdb_save_database()
 	}
 	rename(outfilenames[smallestscheme], outfilename);
 
+	// carry the checkpoint index along, if the chosen scheme has one
+	bitlib_checkpoint_filename(outfilenames[smallestscheme], indexname);
+	bitlib_checkpoint_filename(outfilename, finalindexname);
+	if(rename(indexname, finalindexname) != 0) {
+		remove(finalindexname);
+	}
+
 _bailout:
 
 	for(i = 0; i<(int) slist_size(symdb_schemes); i++) {
@@ -1993,12 +2143,19 @@ symdb_generic_save_database(
 	BYTE *outputBuffer = NULL;
 	BYTE *curBuffer = NULL;
 
+	// restart points for random access to skip-encoded files
+	CHECKPOINTINDEX checkpoints = NULL;
+	char indexname[256];
+
 	outputBuffer = alloca( symdb_buffer_length * sizeof(BYTE));
 	memset(outputBuffer, 0, symdb_buffer_length);
 	curBuffer = outputBuffer;
 
 	mkdir("data", 0755);
 
+	bitlib_checkpoint_filename(outfilename, indexname);
+	remove(indexname);
+
 	status = bitlib_file_open(outfilename, "wb", &outFile);
 	if(!GMSUCCESS(status)) {
 		BPDB_TRACE("symdb_generic_save_database()", "call to bitlib to open file failed", status);
@@ -2024,6 +2181,12 @@ symdb_generic_save_database(
 	}
 
 	if(scheme->indicator) {
+		checkpoints = bitlib_checkpoint_new( symdb_slices );
+		if(NULL == checkpoints) {
+			status = STATUS_NOT_ENOUGH_MEMORY;
+			goto _bailout;
+		}
+
 		for(slice = 0; slice<symdb_slices; slice++) {
 
 			// Check if the slice has a mapping
@@ -2031,11 +2194,24 @@ symdb_generic_save_database(
 
 				// If so, then check to see if skips must be outputted
 				if(consecutiveSkips != 0) {
+					status = bitlib_checkpoint_mark( outFile, &curBuffer, outputBuffer, offset, checkpoints, slice - consecutiveSkips );
+					if(!GMSUCCESS(status)) {
+						BPDB_TRACE("symdb_generic_save_database()", "call to bitlib to mark checkpoint failed", status);
+						goto _bailout;
+					}
+
 					// Put skips into output buffer
 					symdb_generic_write_varnum( outFile, scheme, &curBuffer, outputBuffer, symdb_buffer_length, &offset, consecutiveSkips);
 					// Reset skip counter
 					consecutiveSkips = 0;
 				}
+
+				status = bitlib_checkpoint_mark( outFile, &curBuffer, outputBuffer, offset, checkpoints, slice );
+				if(!GMSUCCESS(status)) {
+					BPDB_TRACE("symdb_generic_save_database()", "call to bitlib to mark checkpoint failed", status);
+					goto _bailout;
+				}
+
 				bitlib_value_to_buffer( outFile, &curBuffer, outputBuffer, symdb_buffer_length, &offset, 0, 1 );
 				for(slot=0; slot < (symdb_write_slice->slots); slot++) {
 					bitlib_value_to_buffer( outFile, &curBuffer, outputBuffer, symdb_buffer_length, &offset, symdb_get_slice_slot(slice, 2*slot), symdb_write_slice->size[slot] );
@@ -2067,13 +2243,23 @@ symdb_generic_save_database(
 		bitlib_file_write_bytes(outFile, outputBuffer, curBuffer-outputBuffer+1);
 	}
 
+	if(NULL != checkpoints) {
+		bitlib_checkpoint_finish( outFile, checkpoints );
+	}
+
 	status = bitlib_file_close(outFile);
 	if(!GMSUCCESS(status)) {
 		BPDB_TRACE("symdb_generic_save_database()", "call to bitlib to close file failed", status);
 		goto _bailout;
 	}
 
+	// an index that cannot be saved only costs lookup speed
+	if(NULL != checkpoints && checkpoints->count > 0) {
+		bitlib_checkpoint_save( checkpoints, outfilename );
+	}
+
 _bailout:
+	bitlib_checkpoint_free( checkpoints );
 	return status;
 }
 
@@ -2170,6 +2356,12 @@ symdb_load_database( )
 	// otherwise, close the file
 	if(symdb_readFromDisk) {
 		symdb_readFile = inFile;
+
+		if(symdb_readScheme->indicator &&
+		   GMSUCCESS(bitlib_checkpoint_load( outfilename, &symdb_readIndex )) &&
+		   gBitPerfectDBVerbose) {
+			printf("Using checkpoint index: %llu blocks\n", symdb_readIndex->count);
+		}
 	} else {
 		status = bitlib_file_close(inFile);
 		if(!GMSUCCESS(status)) {
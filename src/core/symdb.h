@@ -107,6 +107,35 @@ symdb_set_mex(
         POSITION pos,
         MEX mex);
 
+// bulk getters, reading one slot for many positions
+void
+symdb_get_value_bulk(
+        POSITION *positions,
+        VALUE *values,
+        int length
+        );
+
+void
+symdb_get_remoteness_bulk(
+        POSITION *positions,
+        REMOTENESS *remotenesses,
+        int length
+        );
+
+void
+symdb_check_visited_bulk(
+        POSITION *positions,
+        BOOLEAN *visited,
+        int length
+        );
+
+void
+symdb_get_mex_bulk(
+        POSITION *positions,
+        MEX *mexes,
+        int length
+        );
+
 // get/set winby
 WINBY
 symdb_get_winby(
@@ -40,14 +40,33 @@
 #include <zlib.h>
 #include <netinet/in.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
 #include "gamesman.h"
 #include <dirent.h>
 #include "tierdb.h"
 
 /*internal declarations and definitions*/
 
-#define tierdb_FILEVER 1
+/*
+   File versions:
+   1 - one gzip stream of cells, with a lookup .idx file giving the
+       compressed size of every FILESIZE bytes so the play path can seek.
+       Still readable, but no longer written.
+   2 - a header, a table of block offsets, then the cells in blocks of
+       TIERDB_BLOCK_CELLS, each deflated on its own. Any block can be found
+       and inflated without touching the rest, and the whole file can be
+       inflated with one uncompress() per block. The ".gz" file name is kept
+       so every tool that looks for tier DBs still finds them.
+ */
+#define tierdb_FILEVER 2
+#define tierdb_GZIP_FILEVER 1
 #define FILESIZE 1048576L
+#define TIERDB_BLOCK_CELLS 65536 // 128 KB of cells per block
+#define TIERDB_OPEN_FILES_MAX 16 // tier files kept mapped for the play path
 
 POSITION offsets[50000];
 unsigned long numOffsets = 0;
@@ -56,6 +75,71 @@ BOOLEAN alreadyReinitialized = FALSE;
 
 typedef short tierdb_cellValue;
 
+/* A version 2 file, mapped for the play path. Blocks are inflated (into host
+   byte order) the first time a cell in them is asked for. */
+typedef struct tierdb_blockfile {
+	TIER tier;
+	BOOLEAN used;
+	BOOLEAN gzipped;                // a version 1 file: use the .idx lookup
+	unsigned char *map;
+	size_t mapSize;
+	POSITION firstPos, numCells;
+	unsigned long blockCells, numBlocks;
+	POSITION *offsets;              // numBlocks+1 of them, in host byte order
+	tierdb_cellValue **blocks;
+	unsigned char *inArray;         // a child tier's: which blocks are in tierdb_array
+} TIERDB_BLOCKFILE;
+
+TIERDB_BLOCKFILE tierdb_openFiles[TIERDB_OPEN_FILES_MAX];
+int tierdb_nextOpenFile = 0;
+// The play path may be called from several threads (--serve, --export);
+// the open files, their blocks and the version 1 offsets are shared.
+pthread_mutex_t tierdb_openFilesLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* tierdb_load_database() only maps the version 2 files of the child tiers
+   in the hash window. Their blocks are inflated into tierdb_array the first
+   time a cell in them is asked for. Getters look the cell's page, one of
+   TIERDB_BLOCK_CELLS cells counting from tierdb_lazyStart, up in
+   tierdb_lazyPages, which needs no search through the files; a page is full
+   once all the blocks overlapping it are. Solver threads can ask at the
+   same time, so a block is claimed with a compare-and-swap, and whoever
+   else wants it waits for it to be marked full. */
+#define TIERDB_LAZY_EMPTY 0
+#define TIERDB_LAZY_FILLING 1
+#define TIERDB_LAZY_FULL 2
+
+TIERDB_BLOCKFILE *tierdb_lazyFiles = NULL;      // one per tier in the window
+POSITION *tierdb_lazyFileStart = NULL;          // where each goes in tierdb_array
+int tierdb_numLazyFiles = 0;
+POSITION tierdb_lazyStart = (POSITION) -1;      // the first child cell, or -1 if none is lazy
+POSITION tierdb_lazyEnd = 0;
+unsigned char *tierdb_lazyPages = NULL;
+
+/* The solve manifest, ./data/m<kDBName>_<variant>_tierdb/manifest, lists the
+   tiers whose whole DB has been saved, one line each:
+	<tier> <cells> <file bytes> <crc32 of the cells, in hex>
+   and a tier saved again gets a new line; later lines win. Saves append
+   their line with a single write() to the file opened O_APPEND, so tiers
+   saved by processes running side by side never mix their lines up. A
+   rescan rebuilds the file from the DBs themselves and swaps it in with one
+   rename(). CheckTierDB() answers from the copy in memory, which is read
+   once and then only catches up on lines appended since. */
+#define TIERDB_MANIFEST_BUCKETS 4096
+#define TIERDB_MANIFEST_LINE_MAX 128
+
+typedef struct tierdb_manifest_entry {
+	TIER tier;
+	POSITION cells;
+	unsigned long long bytes;
+	unsigned long checksum;
+	struct tierdb_manifest_entry *next;
+} TIERDB_MANIFEST_ENTRY;
+
+TIERDB_MANIFEST_ENTRY *tierdb_manifest[TIERDB_MANIFEST_BUCKETS];
+int tierdb_manifestVariant = -1;        // variant whose manifest is in memory
+ino_t tierdb_manifestInode = 0;         // the file it was read from
+off_t tierdb_manifestRead = 0;          // bytes of that file read so far
+
 BOOLEAN tierdb_dirty;
 POSITION tierdb_CurrentPosition;
 tierdb_cellValue tierdb_CurrentValue;
@@ -84,6 +168,20 @@ MEX             tierdb_get_mex                  (POSITION pos);
 MEX             tierdb_get_mex_from_lookup_table             (POSITION pos);
 void            tierdb_set_mex                  (POSITION pos, MEX mex);
 
+/* Bulk */
+void            tierdb_get_value_bulk           (POSITION* positions, VALUE* values, int length);
+void            tierdb_get_value_bulk_from_lookup_table      (POSITION* positions, VALUE* values, int length);
+void            tierdb_set_value_bulk           (POSITION* positions, VALUE* values, int length);
+void            tierdb_get_remoteness_bulk      (POSITION* positions, REMOTENESS* remotenesses, int length);
+void            tierdb_get_remoteness_bulk_from_lookup_table (POSITION* positions, REMOTENESS* remotenesses, int length);
+void            tierdb_set_remoteness_bulk      (POSITION* positions, REMOTENESS* remotenesses, int length);
+void            tierdb_get_mex_bulk             (POSITION* positions, MEX* mexes, int length);
+void            tierdb_get_mex_bulk_from_lookup_table        (POSITION* positions, MEX* mexes, int length);
+void            tierdb_set_mex_bulk             (POSITION* positions, MEX* mexes, int length);
+void            tierdb_check_visited_bulk       (POSITION* positions, BOOLEAN* visited, int length);
+void            tierdb_check_visited_bulk_from_lookup_table  (POSITION* positions, BOOLEAN* visited, int length);
+void            tierdb_mark_visited_bulk        (POSITION* positions, int length);
+
 /* saving to/reading from a file */
 BOOLEAN         tierdb_save_database            ();
 BOOLEAN         tierdb_load_database            ();
@@ -91,7 +189,32 @@ BOOLEAN         tierdb_load_database            ();
 tierdb_cellValue*       (*tierdb_get_raw)(POSITION pos);
 tierdb_cellValue*       tierdb_get_raw_ptr      (POSITION pos);
 tierdb_cellValue        tierdb_get_raw_from_lookup_table (POSITION pos);
+void                    tierdb_lazy_release     ();
+void                    tierdb_lazy_fill_page   (unsigned long page);
 void                    load_offsets (TIER tier);
+tierdb_cellValue        tierdb_get_raw_from_gzip_lookup_table (TIER tier, TIERPOSITION tierposition);
+
+/* version 2 files */
+POSITION                tierdb_swap_position    (POSITION pos);
+BOOLEAN                 tierdb_write_blockfile  (char *filename, POSITION numPos, POSITION start, POSITION finish, unsigned long *checksum);
+BOOLEAN                 tierdb_map_blockfile    (char *filename, TIERDB_BLOCKFILE *file);
+void                    tierdb_unmap_blockfile  (TIERDB_BLOCKFILE *file);
+BOOLEAN                 tierdb_inflate_block    (TIERDB_BLOCKFILE *file, unsigned long block, tierdb_cellValue *dest);
+BOOLEAN                 tierdb_read_blockfile   (char *filename, POSITION numPos, tierdb_cellValue *dest, POSITION start, POSITION finish);
+TIERDB_BLOCKFILE*       tierdb_open_tier_file   (TIER tier);
+int                     tierdb_file_version     (char *filename);
+BOOLEAN                 tierdb_file_checksum    (char *filename, POSITION numCells, unsigned long *checksum);
+
+/* the solve manifest */
+int                     tierdb_probe_tier       (TIER tier, int variant);
+void                    tierdb_manifest_name    (char *dest, int variant);
+void                    tierdb_manifest_sync    (int variant);
+BOOLEAN                 tierdb_manifest_read    (int variant);
+void                    tierdb_manifest_clear   ();
+void                    tierdb_manifest_set     (TIER tier, POSITION cells, unsigned long long bytes, unsigned long checksum);
+TIERDB_MANIFEST_ENTRY*  tierdb_manifest_find    (TIER tier);
+void                    tierdb_manifest_append  (int variant, TIER tier, POSITION cells,
+                                                 unsigned long long bytes, unsigned long checksum);
 
 tierdb_cellValue*       tierdb_array;
 
@@ -138,6 +261,15 @@ void tierdb_init(DB_Table *new_db)
 	new_db->get_mex = tierdb_get_mex;
 	new_db->save_database = tierdb_save_database;
 	new_db->load_database = tierdb_load_database;
+
+	new_db->get_value_bulk = tierdb_get_value_bulk;
+	new_db->put_value_bulk = tierdb_set_value_bulk;
+	new_db->get_remoteness_bulk = tierdb_get_remoteness_bulk;
+	new_db->put_remoteness_bulk = tierdb_set_remoteness_bulk;
+	new_db->get_mex_bulk = tierdb_get_mex_bulk;
+	new_db->put_mex_bulk = tierdb_set_mex_bulk;
+	new_db->check_visited_bulk = tierdb_check_visited_bulk;
+	new_db->mark_visited_bulk = tierdb_mark_visited_bulk;
 }
 
 /*
@@ -159,6 +291,10 @@ BOOLEAN tierdb_reinit(DB_Table *new_db)
 		new_db->get_remoteness = tierdb_get_remoteness_from_lookup_table;
 		new_db->check_visited = tierdb_check_visited_from_lookup_table;
 		new_db->get_mex = tierdb_get_mex_from_lookup_table;
+		new_db->get_value_bulk = tierdb_get_value_bulk_from_lookup_table;
+		new_db->get_remoteness_bulk = tierdb_get_remoteness_bulk_from_lookup_table;
+		new_db->check_visited_bulk = tierdb_check_visited_bulk_from_lookup_table;
+		new_db->get_mex_bulk = tierdb_get_mex_bulk_from_lookup_table;
 		alreadyReinitialized = TRUE;
 		return TRUE;
 	} else {
@@ -168,12 +304,14 @@ BOOLEAN tierdb_reinit(DB_Table *new_db)
 
 void tierdb_free_childpositions()
 {
+	tierdb_lazy_release();
 	if (tierdb_array)
 		tierdb_array = (tierdb_cellValue *) SafeRealloc(tierdb_array, gCurrentTierSize * sizeof(tierdb_cellValue));
 }
 
 void tierdb_free()
 {
+	tierdb_lazy_release();
 	if(tierdb_array)
 		SafeFree(tierdb_array);
 }
@@ -183,21 +321,89 @@ void tierdb_close_file()
 	tierdb_goodClose = gzclose(tierdb_filep);
 }
 
+// Makes sure pos's page of a lazily loaded child tier has been inflated.
+#define tierdb_touch(pos) do { \
+	if ((pos) >= tierdb_lazyStart && __atomic_load_n(&tierdb_lazyPages[((pos) - tierdb_lazyStart) / TIERDB_BLOCK_CELLS], \
+	                                                 __ATOMIC_ACQUIRE) != TIERDB_LAZY_FULL) \
+		tierdb_lazy_fill_page(((pos) - tierdb_lazyStart) / TIERDB_BLOCK_CELLS); \
+} while (0)
+
 tierdb_cellValue* tierdb_get_raw_ptr(POSITION pos)
 {
+	tierdb_touch(pos);
 	return (&tierdb_array[pos]);
 }
 
+// Unmaps the child tiers' files. Pages not yet inflated are left as they are.
+void tierdb_lazy_release()
+{
+	int i;
+	for (i = 0; i < tierdb_numLazyFiles; i++)
+		if (tierdb_lazyFiles[i].map != NULL)
+			tierdb_unmap_blockfile(&tierdb_lazyFiles[i]);
+	if (tierdb_lazyFiles != NULL)
+		SafeFree(tierdb_lazyFiles);
+	if (tierdb_lazyFileStart != NULL)
+		SafeFree(tierdb_lazyFileStart);
+	if (tierdb_lazyPages != NULL)
+		SafeFree(tierdb_lazyPages);
+	tierdb_lazyFiles = NULL;
+	tierdb_lazyFileStart = NULL;
+	tierdb_lazyPages = NULL;
+	tierdb_numLazyFiles = 0;
+	tierdb_lazyStart = (POSITION) -1;
+	tierdb_lazyEnd = 0;
+}
+
+// Inflates the blocks that overlap a page straight into tierdb_array, each
+// only once: the first thread to want a block claims it, and any other
+// waits for it. The page is full once all of them are.
+void tierdb_lazy_fill_page(unsigned long page)
+{
+	POSITION first = tierdb_lazyStart + (POSITION) page * TIERDB_BLOCK_CELLS, last, from, to;
+	unsigned char state;
+	TIERDB_BLOCKFILE *file;
+	unsigned long b;
+	int i;
+
+	last = (first + TIERDB_BLOCK_CELLS < tierdb_lazyEnd) ? first + TIERDB_BLOCK_CELLS : tierdb_lazyEnd;
+	for (i = 0; i < tierdb_numLazyFiles; i++) {
+		file = &tierdb_lazyFiles[i];
+		if (file->map == NULL || tierdb_lazyFileStart[i] >= last ||
+		    tierdb_lazyFileStart[i] + file->numCells <= first)
+			continue;
+		// the page's cells [from, to) of this file
+		from = (first > tierdb_lazyFileStart[i]) ? first - tierdb_lazyFileStart[i] : 0;
+		to = (last < tierdb_lazyFileStart[i] + file->numCells) ? last - tierdb_lazyFileStart[i] : file->numCells;
+		for (b = from / file->blockCells; (POSITION) b * file->blockCells < to; b++) {
+			state = TIERDB_LAZY_EMPTY;
+			if (__atomic_compare_exchange_n(&file->inArray[b], &state, TIERDB_LAZY_FILLING, FALSE,
+			                                __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+				if (!tierdb_inflate_block(file, b, tierdb_array + tierdb_lazyFileStart[i] + (POSITION) b * file->blockCells)) {
+					printf("Unable to inflate block %lu of tier %llu's DB\n", b, file->tier);
+					exit(1);
+				}
+				__atomic_store_n(&file->inArray[b], TIERDB_LAZY_FULL, __ATOMIC_RELEASE);
+			} else {
+				while (__atomic_load_n(&file->inArray[b], __ATOMIC_ACQUIRE) != TIERDB_LAZY_FULL)
+					sched_yield();
+			}
+		}
+	}
+	__atomic_store_n(&tierdb_lazyPages[page], TIERDB_LAZY_FULL, __ATOMIC_RELEASE);
+}
+
 void load_offsets(TIER tier) {
 	if (tierForWhichOffsetsLoaded == tier) {
 		return;
 	}
     FILE *fp;
-	sprintf(tierdb_outfilename, "./data/m%s_%d_tierdb/lookup/m%s_%d_%llu_tierdb.dat.gz.idx",
+	char filename[TIERDB_OUTFILENAME_LENGTH_MAX];
+	snprintf(filename, sizeof(filename), "./data/m%s_%d_tierdb/lookup/m%s_%d_%llu_tierdb.dat.gz.idx",
 		        kDBName, getOption(), kDBName, getOption(), tier);
-    fp = fopen(tierdb_outfilename, "r");
+    fp = fopen(filename, "r");
     if (fp == NULL) {
-        printf("Can't open %s\n", tierdb_outfilename);
+        printf("Can't open %s\n", filename);
     	exit(1);
     }
 
@@ -219,19 +425,53 @@ tierdb_cellValue tierdb_get_raw_from_lookup_table(POSITION pos)
 {
 	TIER tier;
 	TIERPOSITION tierposition;
+	TIERDB_BLOCKFILE *file;
+	tierdb_cellValue cell;
+	unsigned long block;
 	gUnhashToTierPosition(pos, &tierposition, &tier);
+
+	pthread_mutex_lock(&tierdb_openFilesLock);
+	file = tierdb_open_tier_file(tier);
+	if (file->gzipped) {
+		cell = tierdb_get_raw_from_gzip_lookup_table(tier, tierposition);
+		pthread_mutex_unlock(&tierdb_openFilesLock);
+		return cell;
+	}
+	if (tierposition < file->firstPos || tierposition - file->firstPos >= file->numCells) {
+		printf("Tier position %llu isn't in the DB for tier %llu\n", tierposition, tier);
+		exit(1);
+	}
+	tierposition -= file->firstPos;
+	block = tierposition / file->blockCells;
+	if (file->blocks[block] == NULL) { // first touch
+		file->blocks[block] = (tierdb_cellValue *) SafeMalloc(file->blockCells * sizeof(tierdb_cellValue));
+		if (!tierdb_inflate_block(file, block, file->blocks[block])) {
+			printf("Unable to inflate block %lu of tier %llu's DB\n", block, tier);
+			exit(1);
+		}
+	}
+	cell = file->blocks[block][tierposition % file->blockCells];
+	pthread_mutex_unlock(&tierdb_openFilesLock);
+	return cell;
+}
+
+// The version 1 play path: seek to the gzip member holding this cell.
+// Called with tierdb_openFilesLock held, which also covers offsets[].
+tierdb_cellValue tierdb_get_raw_from_gzip_lookup_table(TIER tier, TIERPOSITION tierposition)
+{
+	char filename[TIERDB_OUTFILENAME_LENGTH_MAX];
 	load_offsets(tier);
 
-	sprintf(tierdb_outfilename, "./data/m%s_%d_tierdb/m%s_%d_%llu_tierdb.dat.gz",
+	snprintf(filename, sizeof(filename), "./data/m%s_%d_tierdb/m%s_%d_%llu_tierdb.dat.gz",
 		        kDBName, getOption(), kDBName, getOption(), tier);
 
 	unsigned long long chunk = (tierposition * 2 + sizeof(short) + sizeof(POSITION)) / FILESIZE;
     unsigned long seekTo = (tierposition * 2 + sizeof(short) + sizeof(POSITION)) % FILESIZE;
 
     // Open file using open
-    int fd = open(tierdb_outfilename, O_RDONLY);
+    int fd = open(filename, O_RDONLY);
     if (fd < 0) {
-        printf("Unable to open %s\n", tierdb_outfilename);
+        printf("Unable to open %s\n", filename);
         exit(1);
     }
 
@@ -241,7 +481,7 @@ tierdb_cellValue tierdb_get_raw_from_lookup_table(POSITION pos)
     // open using gzdopen
 	gzFile gzf = gzdopen(fd, "rb");
     if (gzf == Z_NULL) {
-        printf("Unable to gzdopen %s\n", tierdb_outfilename);
+        printf("Unable to gzdopen %s\n", filename);
         exit(1);
     }
 
@@ -350,7 +590,7 @@ void tierdb_set_mex(POSITION pos, MEX mex)
 
 	ptr = tierdb_get_raw(pos);
 
-	*ptr = (VALUE)(((int)*ptr & ~MEX_MASK) | (mex << MEX_SHIFT));
+	*ptr = (VALUE)(((int)*ptr & ~MEX_MASK) | ((mex & (MEX_MASK >> MEX_SHIFT)) << MEX_SHIFT));
 }
 
 MEX tierdb_get_mex(POSITION pos)
@@ -367,6 +607,110 @@ MEX tierdb_get_mex_from_lookup_table(POSITION pos)
 	return (MEX) ((tierdb_get_raw_from_lookup_table(pos) & MEX_MASK) >> MEX_SHIFT);
 }
 
+/*
+** Bulk versions. These work on tierdb_array directly, since tierdb_get_raw
+** always points there while a tier is being solved. Only the getters can
+** land in a lazily loaded child tier.
+*/
+
+void tierdb_get_value_bulk(POSITION* positions, VALUE* values, int length)
+{
+	int i;
+	for (i = 0; i < length; i++) {
+		tierdb_touch(positions[i]);
+		values[i] = (VALUE)((int)tierdb_array[positions[i]] & VALUE_MASK);
+	}
+}
+
+void tierdb_get_value_bulk_from_lookup_table(POSITION* positions, VALUE* values, int length)
+{
+	int i;
+	for (i = 0; i < length; i++)
+		values[i] = (VALUE)(tierdb_get_raw_from_lookup_table(positions[i]) & VALUE_MASK);
+}
+
+void tierdb_set_value_bulk(POSITION* positions, VALUE* values, int length)
+{
+	int i;
+	tierdb_cellValue *ptr;
+	for (i = 0; i < length; i++) {
+		ptr = &tierdb_array[positions[i]];
+		*ptr = (((int)*ptr & ~VALUE_MASK) | (values[i] & VALUE_MASK));
+	}
+}
+
+void tierdb_get_remoteness_bulk(POSITION* positions, REMOTENESS* remotenesses, int length)
+{
+	int i;
+	for (i = 0; i < length; i++) {
+		tierdb_touch(positions[i]);
+		remotenesses[i] = (REMOTENESS)(((int)tierdb_array[positions[i]] & REMOTENESS_MASK) >> REMOTENESS_SHIFT);
+	}
+}
+
+void tierdb_get_remoteness_bulk_from_lookup_table(POSITION* positions, REMOTENESS* remotenesses, int length)
+{
+	int i;
+	for (i = 0; i < length; i++)
+		remotenesses[i] = (REMOTENESS)((tierdb_get_raw_from_lookup_table(positions[i]) & REMOTENESS_MASK) >> REMOTENESS_SHIFT);
+}
+
+void tierdb_set_remoteness_bulk(POSITION* positions, REMOTENESS* remotenesses, int length)
+{
+	int i;
+	for (i = 0; i < length; i++)
+		tierdb_set_remoteness(positions[i], remotenesses[i]);
+}
+
+void tierdb_get_mex_bulk(POSITION* positions, MEX* mexes, int length)
+{
+	int i;
+	for (i = 0; i < length; i++) {
+		tierdb_touch(positions[i]);
+		mexes[i] = (MEX)(((int)tierdb_array[positions[i]] & MEX_MASK) >> MEX_SHIFT);
+	}
+}
+
+void tierdb_get_mex_bulk_from_lookup_table(POSITION* positions, MEX* mexes, int length)
+{
+	int i;
+	for (i = 0; i < length; i++)
+		mexes[i] = (MEX)((tierdb_get_raw_from_lookup_table(positions[i]) & MEX_MASK) >> MEX_SHIFT);
+}
+
+void tierdb_set_mex_bulk(POSITION* positions, MEX* mexes, int length)
+{
+	int i;
+	tierdb_cellValue *ptr;
+	for (i = 0; i < length; i++) {
+		ptr = &tierdb_array[positions[i]];
+		*ptr = (((int)*ptr & ~MEX_MASK) | ((mexes[i] & (MEX_MASK >> MEX_SHIFT)) << MEX_SHIFT));
+	}
+}
+
+void tierdb_check_visited_bulk(POSITION* positions, BOOLEAN* visited, int length)
+{
+	int i;
+	for (i = 0; i < length; i++) {
+		tierdb_touch(positions[i]);
+		visited[i] = (BOOLEAN)(((int)tierdb_array[positions[i]] & VISITED_MASK) == VISITED_MASK);
+	}
+}
+
+void tierdb_check_visited_bulk_from_lookup_table(POSITION* positions, BOOLEAN* visited, int length)
+{
+	int i;
+	for (i = 0; i < length; i++)
+		visited[i] = (BOOLEAN)((tierdb_get_raw_from_lookup_table(positions[i]) & VISITED_MASK) == VISITED_MASK);
+}
+
+void tierdb_mark_visited_bulk(POSITION* positions, int length)
+{
+	int i;
+	for (i = 0; i < length; i++)
+		tierdb_array[positions[i]] |= VISITED_MASK;
+}
+
 
 /***********
  ************
@@ -374,19 +718,14 @@ MEX tierdb_get_mex_from_lookup_table(POSITION pos)
  **
  **	Name: saveDatabase()
  **
- **	Description: writes tierdb to a compressed file in gzip format.
+ **	Description: writes tierdb to a file of separately compressed blocks
+ **		(file version 2, see the top of this file).
  **
  **	Inputs: none
  **
  **	Outputs: none
  **
- **	Calls:	(In libz libraries)
- **		gzopen
- **		gzclose
- **		gzwrite
- **		(In std libraries)
- **		htonl
- **		ntohl
+ **	Calls:	tierdb_write_blockfile
  **
  **	Requirements:	tierdb_array contains a valid database of positions
  **			gNumberOfPositions stores the correct number of positions in tierdb_array
@@ -400,16 +739,14 @@ MEX tierdb_get_mex_from_lookup_table(POSITION pos)
 BOOLEAN tierdb_save_database ()
 {
 	char tierdb_outfilename_partial[TIERDB_OUTFILENAME_PARTIAL_LENGTH_MAX];
+	BOOLEAN wholeTier = TRUE;
+	unsigned long checksum;
 	struct stat statbuf;
-	statbuf.st_size = 0;
 
 	if(!gHashWindowInitialized)
 		return FALSE;
 
-	unsigned long i;
 	tierdb_goodCompression = 1;
-	tierdb_goodClose = 0;
-	POSITION tot = 0,sTot = gCurrentTierSize;
 
 	POSITION start = 0, finish = gCurrentTierSize;
 
@@ -420,6 +757,7 @@ BOOLEAN tierdb_save_database ()
 	mkdir("data", 0755);
 	snprintf(tierdb_outfilename_partial, TIERDB_OUTFILENAME_PARTIAL_LENGTH_MAX, "./data/m%s_%d_tierdb",kDBName,getOption());
 	mkdir(tierdb_outfilename_partial, 0755);
+	// its existence tells tierdb_reinit to read straight from the files
 	sprintf(tierdb_lookupfilename,"./data/m%s_%d_tierdb/lookup", kDBName, getOption());
 	mkdir(tierdb_lookupfilename, 0755);
 
@@ -428,60 +766,28 @@ BOOLEAN tierdb_save_database ()
 		        tierdb_outfilename_partial, kDBName, getOption(), gCurrentTier, gDBTierStart, gDBTierEnd);
 		start = gDBTierStart;
 		finish = gDBTierEnd;
+		wholeTier = FALSE;
 		// reset the vars
 		gDBTierStart = gDBTierEnd = -1;
 	} else {
 		snprintf(tierdb_outfilename, TIERDB_OUTFILENAME_LENGTH_MAX, "%s/m%s_%d_%llu_tierdb.dat.gz",
 		        tierdb_outfilename_partial, kDBName, getOption(), gCurrentTier);
 	}
-	sprintf(tierdb_lookupfilename, "./data/m%s_%d_tierdb/lookup/m%s_%d_%llu_tierdb.dat.gz.idx",
-		        kDBName, getOption(), kDBName, getOption(), gCurrentTier);
-	FILE *indexFP = fopen(tierdb_lookupfilename, "wb");
-
-	if((tierdb_filep = gzopen(tierdb_outfilename, "wb")) == NULL) {
-		if(kDebugDetermineValue) {
-			printf("Unable to create compressed data file\n");
-		}
-		return FALSE;
-	}
-
-	tierdb_dbVer[0] = htons(tierdb_FILEVER);
-	tierdb_numPos[0] = htonl(gMaxPosOffset[1]) | (((POSITION) htonl(gMaxPosOffset[1] >> 32)) << 32);
-	tierdb_goodCompression = gzwrite(tierdb_filep, tierdb_dbVer, sizeof(short));
-	tierdb_goodCompression = gzwrite(tierdb_filep, tierdb_numPos, sizeof(POSITION));
-	for(i=start; i<finish && tierdb_goodCompression; i++) { //convert to network byteorder for platform independence.
-		tierdb_array[i] = htons(tierdb_array[i]);
-		tierdb_goodCompression = gzwrite(tierdb_filep, tierdb_array+i, sizeof(tierdb_cellValue));
-		tot += tierdb_goodCompression;
-		tierdb_array[i] = ntohs(tierdb_array[i]);
-		
-		if ((sizeof(short) + sizeof(POSITION) + (i + 1) * sizeof(tierdb_cellValue)) % FILESIZE == 0 || i + 1 == finish) {
-			gzclose(tierdb_filep);
-			off_t prevsize = statbuf.st_size;
-			stat(tierdb_outfilename, &statbuf);
-			fprintf(indexFP, "%ld\n",(long unsigned int)(statbuf.st_size - prevsize));
-			if((tierdb_filep = gzopen(tierdb_outfilename, "ab")) == NULL) {
-				if(kDebugDetermineValue) {
-					printf("Unable to create compressed data file\n");
-				}
-				return FALSE;
-			}
-		}
-	}
-	tierdb_goodClose = gzclose(tierdb_filep);
-	fclose(indexFP);
+	tierdb_goodCompression = tierdb_write_blockfile(tierdb_outfilename, gMaxPosOffset[1], start, finish, &checksum);
 
-	if(tierdb_goodCompression && (tierdb_goodClose == 0)) {
+	if(tierdb_goodCompression) {
+		// minitierdbs are left out; the merge that makes the whole tier saves again
+		if (wholeTier && stat(tierdb_outfilename, &statbuf) == 0)
+			tierdb_manifest_append(getOption(), gCurrentTier, finish - start, statbuf.st_size, checksum);
 		if(kDebugDetermineValue && !gJustSolving) {
 			printf("File Successfully compressed\n");
 		}
 		return TRUE;
 	} else {
 		if(kDebugDetermineValue) {
-			fprintf(stderr, "\nError in file compression.\n Error codes:\ngzwrite error: %d\ngzclose error:%d\nBytes To Be Written: " POSITION_FORMAT "\nBytes Written: " POSITION_FORMAT "\n",tierdb_goodCompression, tierdb_goodClose,sTot*4,tot);
+			fprintf(stderr, "\nError in file compression.\n Cells To Be Written: " POSITION_FORMAT "\n",finish-start);
 		}
-		remove (tierdb_outfilename);
-		return FALSE;
+		return FALSE; // any older DB of this tier is left as it was
 	}
 
 }
@@ -489,13 +795,18 @@ BOOLEAN tierdb_save_database ()
 /*
 **	Name: loadDatabase()
 **
-**	Description: loads the compressed file in gzip format into tierdb_array.
+**	Description: loads the compressed files of the tiers in the hash window
+**		into tierdb_array. The current tier's version 2 file is inflated a
+**		block at a time; the child tiers' are only mapped, and inflated
+**		page by page as they are read (tierdb_lazy_fill_page). Version 1
+**		files are still read cell by cell with gzread.
 **
 **	Inputs: none
 **
 **	Outputs: none
 **
-**	Calls:	(In libz libraries)
+**	Calls:	tierdb_read_blockfile
+**			(In libz libraries)
 **			gzopen
 **			gzclose
 **			gzread
@@ -525,7 +836,18 @@ BOOLEAN tierdb_load_database()
 	if(!tierdb_array && !gZeroMemPlayer)
 		return FALSE;
 
-	int index;
+	int index, fileVer;
+	tierdb_lazy_release();
+	if (tierdb_array && gNumTiersInHashWindow > 2) {
+		tierdb_numLazyFiles = gNumTiersInHashWindow;
+		tierdb_lazyFiles = (TIERDB_BLOCKFILE *) SafeCalloc(tierdb_numLazyFiles, sizeof(TIERDB_BLOCKFILE));
+		tierdb_lazyFileStart = (POSITION *) SafeMalloc(tierdb_numLazyFiles * sizeof(POSITION));
+		for (index = 0; index < tierdb_numLazyFiles; index++)
+			tierdb_lazyFileStart[index] = (index > 0) ? gMaxPosOffset[index-1] : 0;
+		tierdb_lazyEnd = gMaxPosOffset[gNumTiersInHashWindow-1];
+		tierdb_lazyPages = (unsigned char *) SafeCalloc((tierdb_lazyEnd - gMaxPosOffset[1]) / TIERDB_BLOCK_CELLS + 1,
+		                                                sizeof(unsigned char));
+	}
 	// always load current tier at BOTTOM, thus it being first
 	for (index = 1; index < gNumTiersInHashWindow; index++) {
 		if (index == 1 && !gDBLoadMainTier) {         // if solving, DON'T load from file
@@ -536,7 +858,8 @@ BOOLEAN tierdb_load_database()
 		}
 		sprintf(tierdb_outfilename, "./data/m%s_%d_tierdb/m%s_%d_%llu_tierdb.dat.gz",
 		        kDBName, getOption(), kDBName, getOption(), gTierInHashWindow[index]);
-		if((tierdb_filep = gzopen(tierdb_outfilename, "rb")) == NULL) {
+		fileVer = tierdb_file_version(tierdb_outfilename);
+		if(fileVer == 0 || (fileVer == tierdb_GZIP_FILEVER && (tierdb_filep = gzopen(tierdb_outfilename, "rb")) == NULL)) {
 			if (gOpponent == AgainstEvaluator) { // go ahead and ignore the loading of the DB
 				maxpos = gMaxPosOffset[index];
 				for(j = 0; j < maxpos; j++)
@@ -544,6 +867,37 @@ BOOLEAN tierdb_load_database()
 				continue;
 			} else return FALSE;
 		}
+		if (fileVer == tierdb_FILEVER && index > 1 && tierdb_lazyFiles != NULL) {
+			TIERDB_BLOCKFILE *file = &tierdb_lazyFiles[index];
+			POSITION storedNumPos;
+			if (!tierdb_map_blockfile(tierdb_outfilename, file)) {
+				if(kDebugDetermineValue)
+					printf("\n\nError in file decompression: %s is damaged\n\n", tierdb_outfilename);
+				return FALSE;
+			}
+			memcpy(&storedNumPos, file->map + sizeof(short), sizeof(POSITION));
+			if (tierdb_swap_position(storedNumPos) != gMaxPosOffset[index]-gMaxPosOffset[index-1]
+			    || file->firstPos != 0 || file->numCells != gMaxPosOffset[index]-gMaxPosOffset[index-1]) {
+				tierdb_unmap_blockfile(file);
+				if(kDebugDetermineValue)
+					printf("\n\nError in file decompression: %s is for another tier size\n\n", tierdb_outfilename);
+				return FALSE;
+			}
+			file->tier = gTierInHashWindow[index];
+			file->inArray = (unsigned char *) SafeCalloc(file->numBlocks ? file->numBlocks : 1, sizeof(unsigned char));
+			gTierDBExists[index] = TRUE; // lets static evaluator know that this tierdb actually exists!
+			continue;
+		}
+		if (fileVer == tierdb_FILEVER) {
+			if (!tierdb_read_blockfile(tierdb_outfilename, gMaxPosOffset[index]-gMaxPosOffset[index-1],
+			                           tierdb_array+gMaxPosOffset[index-1], 0, gMaxPosOffset[index]-gMaxPosOffset[index-1])) {
+				if(kDebugDetermineValue)
+					printf("\n\nError in file decompression: %s is damaged or for another tier size\n\n", tierdb_outfilename);
+				return FALSE;
+			}
+			gTierDBExists[index] = TRUE; // lets static evaluator know that this tierdb actually exists!
+			continue;
+		}
 		tierdb_goodDecompression = gzread(tierdb_filep,tierdb_dbVer,sizeof(short));
 		tierdb_goodDecompression = gzread(tierdb_filep,tierdb_numPos,sizeof(POSITION));
 		*tierdb_dbVer = ntohs(*tierdb_dbVer);
@@ -553,7 +907,7 @@ BOOLEAN tierdb_load_database()
 				printf("\n\nError in file decompression: Stored gNumberOfPositions differs from internal gNumberOfPositions\n\n");
 			return FALSE;
 		}
-		correctDBVer = (*tierdb_dbVer == tierdb_FILEVER);
+		correctDBVer = (*tierdb_dbVer == tierdb_GZIP_FILEVER);
 		if (correctDBVer) {
 			maxpos = gMaxPosOffset[index];
 			for(i = gMaxPosOffset[index-1]; i < maxpos && tierdb_goodDecompression; i++) {
@@ -569,16 +923,44 @@ BOOLEAN tierdb_load_database()
 		}
 		gTierDBExists[index] = TRUE; // lets static evaluator know that this tierdb actually exists!
 	}
+	// from here on the child tiers' cells come in on first touch
+	if (tierdb_lazyFiles != NULL)
+		tierdb_lazyStart = gMaxPosOffset[1];
 	if(kDebugDetermineValue)
 		printf("Files Successfully Decompressed\n");
 	return TRUE;
 }
 
 /* A helper to solveretrograde which simply checks for the existance of a DB.
- * Error Codes: 0 = Doesn't exist, -1 = Incorrect/corrupted, 1 = Exists. */
+ * Error Codes: 0 = Doesn't exist, -1 = Incorrect/corrupted, 1 = Exists.
+ * The answer comes from the solve manifest in memory; nothing is opened
+ * unless the manifest hasn't been read yet. */
 int CheckTierDB(TIER tier, int variant) {
+	TIERDB_MANIFEST_ENTRY *entry;
+	tierdb_manifest_sync(variant);
+	for (entry = tierdb_manifest[tier % TIERDB_MANIFEST_BUCKETS]; entry != NULL; entry = entry->next)
+		if (entry->tier == tier)
+			return (entry->cells == gNumberOfTierPositionsFunPtr(tier)) ? 1 : -1;
+	return 0;
+}
+
+/* CheckTierDB's answer, from the tier's file itself: opens it and reads
+ * its header. */
+int tierdb_probe_tier(TIER tier, int variant) {
+	TIERDB_BLOCKFILE file;
+	int fileVer;
 	sprintf(tierdb_outfilename, "./data/m%s_%d_tierdb/m%s_%d_%llu_tierdb.dat.gz",
 	        kDBName, variant, kDBName, variant, tier);
+	if ((fileVer = tierdb_file_version(tierdb_outfilename)) == 0)
+		return 0;
+	if (fileVer == tierdb_FILEVER) {
+		if (!tierdb_map_blockfile(tierdb_outfilename, &file))
+			return -1;
+		tierdb_unmap_blockfile(&file);
+		if (file.firstPos != 0 || file.numCells != gNumberOfTierPositionsFunPtr(tier))
+			return -1;
+		return 1;
+	}
 	if((tierdb_filep = gzopen(tierdb_outfilename, "rb")) == NULL) {
 		return 0;
 	}
@@ -588,12 +970,210 @@ int CheckTierDB(TIER tier, int variant) {
 	*tierdb_numPos = ntohl(*tierdb_numPos) | (((POSITION) ntohl(*tierdb_numPos >> 32)) << 32);
 	tierdb_goodClose = gzclose(tierdb_filep);
 	if(!tierdb_goodDecompression || (*tierdb_numPos != gNumberOfTierPositionsFunPtr(tier))
-	   || (*tierdb_dbVer != tierdb_FILEVER) || (tierdb_goodClose != 0)) {
+	   || (*tierdb_dbVer != tierdb_GZIP_FILEVER) || (tierdb_goodClose != 0)) {
 		return -1;
 	}
 	return 1;
 }
 
+/*
+** The solve manifest (see the top of this file)
+*/
+
+void tierdb_manifest_name(char *dest, int variant)
+{
+	snprintf(dest, TIERDB_OUTFILENAME_LENGTH_MAX, "./data/m%s_%d_tierdb/manifest", kDBName, variant);
+}
+
+void tierdb_manifest_clear()
+{
+	TIERDB_MANIFEST_ENTRY *entry, *next;
+	int i;
+	for (i = 0; i < TIERDB_MANIFEST_BUCKETS; i++) {
+		for (entry = tierdb_manifest[i]; entry != NULL; entry = next) {
+			next = entry->next;
+			SafeFree(entry);
+		}
+		tierdb_manifest[i] = NULL;
+	}
+	tierdb_manifestInode = 0;
+	tierdb_manifestRead = 0;
+}
+
+TIERDB_MANIFEST_ENTRY* tierdb_manifest_find(TIER tier)
+{
+	TIERDB_MANIFEST_ENTRY *entry = tierdb_manifest[tier % TIERDB_MANIFEST_BUCKETS];
+	while (entry != NULL && entry->tier != tier)
+		entry = entry->next;
+	return entry;
+}
+
+void tierdb_manifest_set(TIER tier, POSITION cells, unsigned long long bytes, unsigned long checksum)
+{
+	TIERDB_MANIFEST_ENTRY *entry = tierdb_manifest_find(tier);
+	if (entry == NULL) {
+		entry = (TIERDB_MANIFEST_ENTRY *) SafeMalloc(sizeof(TIERDB_MANIFEST_ENTRY));
+		entry->tier = tier;
+		entry->next = tierdb_manifest[tier % TIERDB_MANIFEST_BUCKETS];
+		tierdb_manifest[tier % TIERDB_MANIFEST_BUCKETS] = entry;
+	}
+	entry->cells = cells;
+	entry->bytes = bytes;
+	entry->checksum = checksum;
+}
+
+/* Reads the lines of variant's manifest that haven't been read yet, or all
+   of it if a rescan has replaced the file. FALSE if there's no manifest. */
+BOOLEAN tierdb_manifest_read(int variant)
+{
+	char filename[TIERDB_OUTFILENAME_LENGTH_MAX], line[TIERDB_MANIFEST_LINE_MAX];
+	unsigned long long bytes;
+	unsigned long checksum;
+	struct stat statbuf;
+	POSITION cells;
+	size_t length;
+	TIER tier;
+	FILE *fp;
+
+	tierdb_manifest_name(filename, variant);
+	if ((fp = fopen(filename, "r")) == NULL)
+		return FALSE;
+	if (fstat(fileno(fp), &statbuf) != 0) {
+		fclose(fp);
+		return FALSE;
+	}
+	if (statbuf.st_ino != tierdb_manifestInode || statbuf.st_size < tierdb_manifestRead) {
+		tierdb_manifest_clear();
+		tierdb_manifestInode = statbuf.st_ino;
+	}
+	if (fseeko(fp, tierdb_manifestRead, SEEK_SET) != 0) {
+		fclose(fp);
+		return FALSE;
+	}
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		length = strlen(line);
+		if (line[length - 1] != '\n')
+			break; // not all there yet; it's read again next time
+		tierdb_manifestRead += length;
+		if (sscanf(line, "%llu %llu %llu %lx", &tier, &cells, &bytes, &checksum) == 4)
+			tierdb_manifest_set(tier, cells, bytes, checksum);
+	}
+	fclose(fp);
+	return TRUE;
+}
+
+/* Makes the manifest in memory variant's. It is read from disk the first
+   time; if there is none yet (the DBs were solved before there were
+   manifests) or --rescantierdbs was given, it is rebuilt from the DBs. */
+void tierdb_manifest_sync(int variant)
+{
+	if (variant == tierdb_manifestVariant)
+		return;
+	tierdb_manifest_clear();
+	tierdb_manifestVariant = variant;
+	if (gTierDBRescan || !tierdb_manifest_read(variant))
+		tierdb_manifest_rescan(variant);
+}
+
+/* Catches up on the tiers other processes have saved since the manifest
+   was last read. */
+void tierdb_manifest_refresh(int variant)
+{
+	if (variant != tierdb_manifestVariant)
+		tierdb_manifest_sync(variant);
+	else tierdb_manifest_read(variant);
+}
+
+/* Records that tier's whole DB was saved, both on disk and, if it's
+   variant's, in memory. */
+void tierdb_manifest_append(int variant, TIER tier, POSITION cells,
+                            unsigned long long bytes, unsigned long checksum)
+{
+	char filename[TIERDB_OUTFILENAME_LENGTH_MAX], line[TIERDB_MANIFEST_LINE_MAX];
+	int fd, length;
+
+	length = snprintf(line, sizeof(line), "%llu %llu %llu %lx\n", tier, cells, bytes, checksum);
+	tierdb_manifest_name(filename, variant);
+	if ((fd = open(filename, O_WRONLY | O_APPEND | O_CREAT, 0644)) < 0
+	    || write(fd, line, length) != length) {
+		fprintf(stderr, "\nCouldn't note tier %llu in %s; rescan with --rescantierdbs.\n", tier, filename);
+	}
+	if (fd >= 0)
+		close(fd);
+	if (variant != tierdb_manifestVariant)
+		return;
+	tierdb_manifest_set(tier, cells, bytes, checksum);
+}
+
+/* Rebuilds variant's manifest from the whole-tier DBs on disk and puts it
+   in place of the old one. Every DB is inflated to checksum it; one whose
+   checksum differs from the one the old manifest has is left out, so it
+   gets solved again. Nothing should be saving tiers of this variant
+   meanwhile: lines appended to the old manifest are lost. Returns the
+   number of tiers found, or -1 if the manifest couldn't be written. */
+int tierdb_manifest_rescan(int variant)
+{
+	char directory[TIERDB_OUTFILENAME_PARTIAL_LENGTH_MAX], prefix[TIERDB_OUTFILENAME_PARTIAL_LENGTH_MAX];
+	char filename[TIERDB_OUTFILENAME_LENGTH_MAX], tmpname[TIERDB_OUTFILENAME_LENGTH_MAX + 16];
+	char dbname[TIERDB_OUTFILENAME_PARTIAL_LENGTH_MAX + NAME_MAX + 2]; // directory/d_name
+	TIERDB_MANIFEST_ENTRY *old;
+	unsigned long checksum;
+	struct stat statbuf;
+	struct dirent *dp;
+	POSITION cells;
+	size_t prefixLength;
+	int found = 0, end;
+	TIER tier;
+	DIR *dfd;
+	FILE *fp;
+
+	snprintf(directory, sizeof(directory), "./data/m%s_%d_tierdb", kDBName, variant);
+	snprintf(prefix, sizeof(prefix), "m%s_%d_", kDBName, variant);
+	prefixLength = strlen(prefix);
+	tierdb_manifest_clear();
+	tierdb_manifestVariant = variant;
+	if ((dfd = opendir(directory)) == NULL)
+		return 0; // nothing solved yet
+	tierdb_manifest_read(variant); // to check the checksums against
+	tierdb_manifest_name(filename, variant);
+	snprintf(tmpname, sizeof(tmpname), "%s.%d", filename, (int) getpid());
+	if ((fp = fopen(tmpname, "w")) == NULL) {
+		closedir(dfd);
+		return -1;
+	}
+	ifprintf(gTierSolvePrint, "--Rescanning the Tier DBs in %s...\n", directory);
+	while ((dp = readdir(dfd)) != NULL) {
+		// only whole tiers: m<kDBName>_<variant>_<tier>_tierdb.dat.gz
+		if (strncmp(dp->d_name, prefix, prefixLength) != 0
+		    || sscanf(dp->d_name + prefixLength, "%llu%n", &tier, &end) != 1
+		    || strcmp(dp->d_name + prefixLength + end, "_tierdb.dat.gz") != 0)
+			continue;
+		snprintf(dbname, sizeof(dbname), "%s/%s", directory, dp->d_name);
+		cells = gNumberOfTierPositionsFunPtr(tier);
+		if (tierdb_probe_tier(tier, variant) != 1 || stat(dbname, &statbuf) != 0
+		    || !tierdb_file_checksum(dbname, cells, &checksum)) {
+			ifprintf(gTierSolvePrint, "--%llu's Tier DB appears incorrect/corrupted. Leaving it out.\n", tier);
+			continue;
+		}
+		old = tierdb_manifest_find(tier);
+		if (old != NULL && old->cells == cells && old->checksum != checksum) {
+			ifprintf(gTierSolvePrint, "--%llu's Tier DB doesn't match its checksum. Leaving it out.\n", tier);
+			continue;
+		}
+		fprintf(fp, "%llu %llu %llu %lx\n", tier, cells, (unsigned long long) statbuf.st_size, checksum);
+		found++;
+	}
+	closedir(dfd);
+	if (fclose(fp) != 0 || rename(tmpname, filename) != 0) {
+		remove(tmpname);
+		return -1;
+	}
+	tierdb_manifest_clear();
+	tierdb_manifest_read(variant);
+	ifprintf(gTierSolvePrint, "  %d Tier DBs found.\n", found);
+	return found;
+}
+
 /* Yet another helper. Overrides the positions between gDBTierStart and
  * gDBTierEnd with the values from the minifile. */
 BOOLEAN tierdb_load_minifile(char* filename)
@@ -608,6 +1188,9 @@ BOOLEAN tierdb_load_minifile(char* filename)
 
 	sprintf(tierdb_outfilename, "./data/m%s_%d_tierdb/%s",
 	        kDBName, getOption(), filename);
+	if (tierdb_file_version(tierdb_outfilename) == tierdb_FILEVER)
+		return tierdb_read_blockfile(tierdb_outfilename, gCurrentTierSize,
+		                             tierdb_array+gDBTierStart, gDBTierStart, gDBTierEnd);
 	if((tierdb_filep = gzopen(tierdb_outfilename, "rb")) == NULL)
 		return FALSE;
 	tierdb_goodDecompression = gzread(tierdb_filep,tierdb_dbVer,sizeof(short));
@@ -616,7 +1199,7 @@ BOOLEAN tierdb_load_minifile(char* filename)
 	*tierdb_numPos = ntohl(*tierdb_numPos) | (((POSITION) ntohl(*tierdb_numPos >> 32)) << 32);
 	if(*tierdb_numPos != gCurrentTierSize)
 		return FALSE;
-	correctDBVer = (*tierdb_dbVer == tierdb_FILEVER);
+	correctDBVer = (*tierdb_dbVer == tierdb_GZIP_FILEVER);
 	if (correctDBVer) {
 		for(i = gDBTierStart; i < gDBTierEnd && tierdb_goodDecompression; i++) {
 			tierdb_goodDecompression = gzread(tierdb_filep, tierdb_array+i, sizeof(tierdb_cellValue));
@@ -628,3 +1211,309 @@ BOOLEAN tierdb_load_minifile(char* filename)
 		return FALSE;
 	return TRUE;
 }
+
+/*
+** Version 2 files
+**
+** All fields are in network byte order:
+**	short		file version (2)
+**	POSITION	number of positions in the tier
+**	POSITION	first position stored (nonzero only for minitierdbs)
+**	POSITION	number of cells stored
+**	uint32		cells per block
+**	uint32		number of blocks
+**	POSITION	offset of each block from the start of the file, and
+**			then the end of the last block
+**	...		the blocks, each compress2()ed on its own
+*/
+
+#define TIERDB_HEADER_SIZE (sizeof(short) + 3 * sizeof(POSITION) + 2 * sizeof(unsigned int))
+
+// the same byte order trick the version 1 header uses for gMaxPosOffset
+POSITION tierdb_swap_position(POSITION pos)
+{
+	return htonl(pos) | (((POSITION) htonl(pos >> 32)) << 32);
+}
+
+/* Returns 0 if the file can't be opened, tierdb_GZIP_FILEVER if it is a gzip
+   stream, and tierdb_FILEVER otherwise. */
+int tierdb_file_version(char *filename)
+{
+	unsigned char magic[2];
+	FILE *fp = fopen(filename, "rb");
+	if (fp == NULL)
+		return 0;
+	if (fread(magic, 1, 2, fp) != 2) {
+		fclose(fp);
+		return 0;
+	}
+	fclose(fp);
+	return (magic[0] == 0x1f && magic[1] == 0x8b) ? tierdb_GZIP_FILEVER : tierdb_FILEVER;
+}
+
+// Writes tierdb_array[start, finish) as a version 2 file. checksum gets the
+// crc32 of the cells, in network byte order. The file is written under a
+// temporary name and renamed over filename, so a reader (or a crash) never
+// sees it half written and an older DB survives a failed save.
+BOOLEAN tierdb_write_blockfile(char *filename, POSITION numPos, POSITION start, POSITION finish, unsigned long *checksum)
+{
+	char tmpname[TIERDB_OUTFILENAME_LENGTH_MAX + 16];
+	unsigned long numBlocks = (finish - start + TIERDB_BLOCK_CELLS - 1) / TIERDB_BLOCK_CELLS, b, i, cells;
+	uLong bound = compressBound(TIERDB_BLOCK_CELLS * sizeof(tierdb_cellValue));
+	uLongf compressedSize;
+	tierdb_cellValue *block;
+	Bytef *compressed;
+	POSITION *offsets, field;
+	unsigned int field32;
+	short ver;
+	BOOLEAN good = TRUE;
+	FILE *fp;
+
+	snprintf(tmpname, sizeof(tmpname), "%s.%d", filename, (int) getpid());
+	if ((fp = fopen(tmpname, "wb")) == NULL) {
+		if(kDebugDetermineValue) {
+			printf("Unable to create compressed data file\n");
+		}
+		return FALSE;
+	}
+	block = (tierdb_cellValue *) SafeMalloc(TIERDB_BLOCK_CELLS * sizeof(tierdb_cellValue));
+	compressed = (Bytef *) SafeMalloc(bound);
+	offsets = (POSITION *) SafeCalloc(numBlocks + 1, sizeof(POSITION));
+	*checksum = crc32(0L, Z_NULL, 0);
+
+	ver = htons(tierdb_FILEVER);
+	good = good && fwrite(&ver, sizeof(short), 1, fp) == 1;
+	field = tierdb_swap_position(numPos);
+	good = good && fwrite(&field, sizeof(POSITION), 1, fp) == 1;
+	field = tierdb_swap_position(start);
+	good = good && fwrite(&field, sizeof(POSITION), 1, fp) == 1;
+	field = tierdb_swap_position(finish - start);
+	good = good && fwrite(&field, sizeof(POSITION), 1, fp) == 1;
+	field32 = htonl(TIERDB_BLOCK_CELLS);
+	good = good && fwrite(&field32, sizeof(unsigned int), 1, fp) == 1;
+	field32 = htonl((unsigned int) numBlocks);
+	good = good && fwrite(&field32, sizeof(unsigned int), 1, fp) == 1;
+	// room for the offset table, filled in at the end
+	good = good && fwrite(offsets, sizeof(POSITION), numBlocks + 1, fp) == numBlocks + 1;
+
+	offsets[0] = TIERDB_HEADER_SIZE + (numBlocks + 1) * sizeof(POSITION);
+	for (b = 0; b < numBlocks && good; b++) {
+		cells = (finish - start - b * TIERDB_BLOCK_CELLS > TIERDB_BLOCK_CELLS) ?
+		        TIERDB_BLOCK_CELLS : finish - start - b * TIERDB_BLOCK_CELLS;
+		for (i = 0; i < cells; i++) //convert to network byteorder for platform independence.
+			block[i] = htons(tierdb_array[start + b * TIERDB_BLOCK_CELLS + i]);
+		*checksum = crc32(*checksum, (Bytef *) block, cells * sizeof(tierdb_cellValue));
+		compressedSize = bound;
+		good = compress2(compressed, &compressedSize, (Bytef *) block,
+		                 cells * sizeof(tierdb_cellValue), Z_DEFAULT_COMPRESSION) == Z_OK
+		       && fwrite(compressed, 1, compressedSize, fp) == compressedSize;
+		offsets[b + 1] = offsets[b] + compressedSize;
+	}
+	for (b = 0; b <= numBlocks; b++)
+		offsets[b] = tierdb_swap_position(offsets[b]);
+	good = good && fseek(fp, TIERDB_HEADER_SIZE, SEEK_SET) == 0
+	       && fwrite(offsets, sizeof(POSITION), numBlocks + 1, fp) == numBlocks + 1;
+	good = (fclose(fp) == 0) && good;
+	good = good && rename(tmpname, filename) == 0;
+	if (!good)
+		remove(tmpname);
+
+	SafeFree(block);
+	SafeFree(compressed);
+	SafeFree(offsets);
+	return good;
+}
+
+// Maps a version 2 file and checks its header and offset table.
+BOOLEAN tierdb_map_blockfile(char *filename, TIERDB_BLOCKFILE *file)
+{
+	struct stat statbuf;
+	unsigned char *ptr;
+	unsigned int field32;
+	unsigned long b;
+	short ver;
+	int fd;
+
+	memset(file, 0, sizeof(TIERDB_BLOCKFILE));
+	if ((fd = open(filename, O_RDONLY)) < 0)
+		return FALSE;
+	if (fstat(fd, &statbuf) != 0 || (size_t) statbuf.st_size < TIERDB_HEADER_SIZE) {
+		close(fd);
+		return FALSE;
+	}
+	file->mapSize = statbuf.st_size;
+	file->map = (unsigned char *) mmap(NULL, file->mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // the mapping stays valid
+	if (file->map == MAP_FAILED) {
+		file->map = NULL;
+		return FALSE;
+	}
+
+	ptr = file->map;
+	memcpy(&ver, ptr, sizeof(short)); ptr += sizeof(short);
+	ptr += sizeof(POSITION); // numPos, only needed by tierdb_read_blockfile
+	memcpy(&file->firstPos, ptr, sizeof(POSITION)); ptr += sizeof(POSITION);
+	memcpy(&file->numCells, ptr, sizeof(POSITION)); ptr += sizeof(POSITION);
+	memcpy(&field32, ptr, sizeof(unsigned int)); ptr += sizeof(unsigned int);
+	file->blockCells = ntohl(field32);
+	memcpy(&field32, ptr, sizeof(unsigned int)); ptr += sizeof(unsigned int);
+	file->numBlocks = ntohl(field32);
+	file->firstPos = tierdb_swap_position(file->firstPos);
+	file->numCells = tierdb_swap_position(file->numCells);
+
+	if (ntohs(ver) != tierdb_FILEVER || file->blockCells == 0
+	    || file->numBlocks != (file->numCells + file->blockCells - 1) / file->blockCells
+	    || TIERDB_HEADER_SIZE + (file->numBlocks + 1) * sizeof(POSITION) > file->mapSize) {
+		tierdb_unmap_blockfile(file);
+		return FALSE;
+	}
+	file->offsets = (POSITION *) SafeMalloc((file->numBlocks + 1) * sizeof(POSITION));
+	memcpy(file->offsets, ptr, (file->numBlocks + 1) * sizeof(POSITION));
+	for (b = 0; b <= file->numBlocks; b++) {
+		file->offsets[b] = tierdb_swap_position(file->offsets[b]);
+		if (file->offsets[b] > file->mapSize || (b > 0 && file->offsets[b] < file->offsets[b - 1])) {
+			tierdb_unmap_blockfile(file);
+			return FALSE;
+		}
+	}
+	file->blocks = (tierdb_cellValue **) SafeCalloc(file->numBlocks ? file->numBlocks : 1, sizeof(tierdb_cellValue *));
+	return TRUE;
+}
+
+void tierdb_unmap_blockfile(TIERDB_BLOCKFILE *file)
+{
+	unsigned long b;
+	if (file->blocks != NULL) {
+		for (b = 0; b < file->numBlocks; b++)
+			if (file->blocks[b] != NULL)
+				SafeFree(file->blocks[b]);
+		SafeFree(file->blocks);
+	}
+	if (file->offsets != NULL)
+		SafeFree(file->offsets);
+	if (file->inArray != NULL)
+		SafeFree(file->inArray);
+	if (file->map != NULL)
+		munmap(file->map, file->mapSize);
+	file->blocks = NULL;
+	file->offsets = NULL;
+	file->inArray = NULL;
+	file->map = NULL;
+}
+
+// Inflates one block into dest, in host byte order.
+BOOLEAN tierdb_inflate_block(TIERDB_BLOCKFILE *file, unsigned long block, tierdb_cellValue *dest)
+{
+	POSITION first = (POSITION) block * file->blockCells;
+	unsigned long i, cells = (file->numCells - first > file->blockCells) ? file->blockCells : file->numCells - first;
+	uLongf size = cells * sizeof(tierdb_cellValue);
+
+	if (uncompress((Bytef *) dest, &size, file->map + file->offsets[block],
+	               file->offsets[block + 1] - file->offsets[block]) != Z_OK
+	    || size != cells * sizeof(tierdb_cellValue))
+		return FALSE;
+	for (i = 0; i < cells; i++)
+		dest[i] = ntohs(dest[i]);
+	return TRUE;
+}
+
+// The crc32 of the numCells cells of a whole-tier file, in network byte
+// order, as tierdb_write_blockfile() works it out. Inflates all of it.
+BOOLEAN tierdb_file_checksum(char *filename, POSITION numCells, unsigned long *checksum)
+{
+	TIERDB_BLOCKFILE file;
+	tierdb_cellValue *block;
+	unsigned long b, i, cells;
+	BOOLEAN good = TRUE;
+	gzFile gzfile;
+
+	*checksum = crc32(0L, Z_NULL, 0);
+	if (tierdb_file_version(filename) == tierdb_GZIP_FILEVER) {
+		// the cells follow the version and the size, already in network byte order
+		if ((gzfile = gzopen(filename, "rb")) == NULL)
+			return FALSE;
+		block = (tierdb_cellValue *) SafeMalloc(TIERDB_BLOCK_CELLS * sizeof(tierdb_cellValue));
+		good = gzseek(gzfile, sizeof(short) + sizeof(POSITION), SEEK_SET) >= 0;
+		for (b = 0; (POSITION) b * TIERDB_BLOCK_CELLS < numCells && good; b++) {
+			cells = (numCells - (POSITION) b * TIERDB_BLOCK_CELLS > TIERDB_BLOCK_CELLS) ?
+			        TIERDB_BLOCK_CELLS : numCells - (POSITION) b * TIERDB_BLOCK_CELLS;
+			good = gzread(gzfile, block, cells * sizeof(tierdb_cellValue)) == (int) (cells * sizeof(tierdb_cellValue));
+			if (good)
+				*checksum = crc32(*checksum, (Bytef *) block, cells * sizeof(tierdb_cellValue));
+		}
+		good = (gzclose(gzfile) == Z_OK) && good;
+		SafeFree(block);
+		return good;
+	}
+	if (!tierdb_map_blockfile(filename, &file))
+		return FALSE;
+	if (file.firstPos != 0 || file.numCells != numCells) {
+		tierdb_unmap_blockfile(&file);
+		return FALSE;
+	}
+	block = (tierdb_cellValue *) SafeMalloc(file.blockCells * sizeof(tierdb_cellValue));
+	for (b = 0; b < file.numBlocks && good; b++) {
+		cells = (file.numCells - (POSITION) b * file.blockCells > file.blockCells) ?
+		        file.blockCells : file.numCells - (POSITION) b * file.blockCells;
+		if ((good = tierdb_inflate_block(&file, b, block))) {
+			for (i = 0; i < cells; i++)
+				block[i] = htons(block[i]);
+			*checksum = crc32(*checksum, (Bytef *) block, cells * sizeof(tierdb_cellValue));
+		}
+	}
+	SafeFree(block);
+	tierdb_unmap_blockfile(&file);
+	return good;
+}
+
+/* Inflates a whole version 2 file holding cells [start, finish) of a tier
+   with numPos positions into dest. */
+BOOLEAN tierdb_read_blockfile(char *filename, POSITION numPos, tierdb_cellValue *dest, POSITION start, POSITION finish)
+{
+	TIERDB_BLOCKFILE file;
+	POSITION storedNumPos;
+	unsigned long b;
+	BOOLEAN good;
+
+	if (!tierdb_map_blockfile(filename, &file))
+		return FALSE;
+	memcpy(&storedNumPos, file.map + sizeof(short), sizeof(POSITION));
+	good = tierdb_swap_position(storedNumPos) == numPos
+	       && file.firstPos == start && file.numCells == finish - start;
+	for (b = 0; b < file.numBlocks && good; b++)
+		good = tierdb_inflate_block(&file, b, dest + b * file.blockCells);
+	tierdb_unmap_blockfile(&file);
+	return good;
+}
+
+// The play path's cache of mapped tier files. Called with
+// tierdb_openFilesLock held.
+TIERDB_BLOCKFILE* tierdb_open_tier_file(TIER tier)
+{
+	char filename[TIERDB_OUTFILENAME_LENGTH_MAX];
+	TIERDB_BLOCKFILE *file;
+	int i;
+
+	for (i = 0; i < TIERDB_OPEN_FILES_MAX; i++)
+		if (tierdb_openFiles[i].used && tierdb_openFiles[i].tier == tier)
+			return &tierdb_openFiles[i];
+
+	file = &tierdb_openFiles[tierdb_nextOpenFile];
+	tierdb_nextOpenFile = (tierdb_nextOpenFile + 1) % TIERDB_OPEN_FILES_MAX;
+	if (file->used)
+		tierdb_unmap_blockfile(file);
+	file->used = FALSE;
+
+	snprintf(filename, sizeof(filename), "./data/m%s_%d_tierdb/m%s_%d_%llu_tierdb.dat.gz",
+	        kDBName, getOption(), kDBName, getOption(), tier);
+	if (tierdb_file_version(filename) == tierdb_GZIP_FILEVER) {
+		memset(file, 0, sizeof(TIERDB_BLOCKFILE));
+		file->gzipped = TRUE;
+	} else if (!tierdb_map_blockfile(filename, file)) {
+		printf("Unable to open %s\n", filename);
+		exit(1);
+	}
+	file->tier = tier;
+	file->used = TRUE;
+	return file;
+}
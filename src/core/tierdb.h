@@ -8,4 +8,8 @@ void tierdb_free_childpositions();
 int CheckTierDB     (TIER, int);
 BOOLEAN tierdb_load_minifile (char*);
 
+/* Solve manifest */
+void tierdb_manifest_refresh (int);
+int tierdb_manifest_rescan (int);
+
 #endif /* GMCORE_TIERDB_H */
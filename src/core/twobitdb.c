@@ -43,6 +43,12 @@ BOOLEAN         twobitdb_check_visited          (POSITION position);
 void            twobitdb_mark_visited           (POSITION position);
 void            twobitdb_unmark_visited         (POSITION position);
 
+/* Bulk */
+void            twobitdb_get_value_bulk         (POSITION* positions, VALUE* values, int length);
+void            twobitdb_set_value_bulk         (POSITION* positions, VALUE* values, int length);
+void            twobitdb_check_visited_bulk     (POSITION* positions, BOOLEAN* visited, int length);
+void            twobitdb_mark_visited_bulk      (POSITION* positions, int length);
+
 
 int* twobitdb_database; //a cell has 8 bits
 int* twobitdb_visited;  //a cell has 8 bits
@@ -69,6 +75,10 @@ void twobitdb_init(DB_Table *new_db) {
 	new_db->check_visited = twobitdb_check_visited;
 	new_db->mark_visited = twobitdb_mark_visited;
 	new_db->unmark_visited = twobitdb_unmark_visited;
+	new_db->get_value_bulk = twobitdb_get_value_bulk;
+	new_db->put_value_bulk = twobitdb_set_value_bulk;
+	new_db->check_visited_bulk = twobitdb_check_visited_bulk;
+	new_db->mark_visited_bulk = twobitdb_mark_visited_bulk;
 
 	new_db->free_db = twobitdb_free;
 
@@ -134,3 +144,35 @@ void twobitdb_unmark_visited (POSITION position)
 	twobitdb_visited[position >> 5] &= ~(1 << (position & 31));
 	return;
 }
+
+void twobitdb_get_value_bulk(POSITION* positions, VALUE* values, int length)
+{
+	int i;
+	for (i = 0; i < length; i++)
+		values[i] = (VALUE)(3 & (twobitdb_database[positions[i] >> 4] >> ((positions[i] & 15) << 1)));
+}
+
+void twobitdb_set_value_bulk(POSITION* positions, VALUE* values, int length)
+{
+	int i, shamt;
+	int* ptr;
+	for (i = 0; i < length; i++) {
+		ptr = &twobitdb_database[positions[i] >> 4];
+		shamt = (positions[i] & 15) << 1;
+		*ptr = ((*ptr & ~(3 << shamt)) | ((3 & values[i]) << shamt));
+	}
+}
+
+void twobitdb_check_visited_bulk(POSITION* positions, BOOLEAN* visited, int length)
+{
+	int i;
+	for (i = 0; i < length; i++)
+		visited[i] = ((twobitdb_visited[positions[i] >> 5] >> (positions[i] & 31)) & 1);
+}
+
+void twobitdb_mark_visited_bulk(POSITION* positions, int length)
+{
+	int i;
+	for (i = 0; i < length; i++)
+		twobitdb_visited[positions[i] >> 5] |= 1 << (positions[i] & 31);
+}
@@ -140,6 +140,15 @@ typedef struct movelist_item
 }
 MOVELIST;
 
+/* A caller-owned array of moves, filled by GenerateMovesToBuffer() */
+typedef struct movebuffer
+{
+	MOVE *moves;
+	int count;
+	int capacity;
+}
+MOVEBUFFER;
+
 typedef struct remotenesslist_item
 {
 	REMOTENESS remoteness;
@@ -33,39 +33,33 @@
 
 #include "gamesman.h"
 #include "univdb.h"
-#include "univht.h"
+#include "posht.h"
 #include "db.h"
 
-univht *ht;
-
-extern FILE *strdbg;
+posht *ht;
 
 #define MAX_INIT_SLOTS 200
 
-DB_Table *univdb_init() {
-
-	BOOLEAN univdb_equal_entries(void *left, void* right);
-	POSITION univdb_hashcode(void *object);
-	void univdb_destroy_entry(void *entry);
+void univdb_init(DB_Table *new_db) {
 
 	POSITION slots;
-	DB_Table *db;
-
-	strdbg = stderr;
-
-	db = (DB_Table *) SafeMalloc(sizeof(DB_Table));
-	db->get_value = univdb_get_value;
-	db->put_value = univdb_put_value;
-	db->get_remoteness = univdb_get_remoteness;
-	db->put_remoteness = univdb_put_remoteness;
-	db->check_visited = univdb_check_visited;
-	db->mark_visited = univdb_mark_visited;
-	db->unmark_visited = univdb_unmark_visited;
-	db->get_mex = univdb_get_mex;
-	db->put_mex = univdb_put_mex;
-	db->free_db = univdb_free;
-	db->save_database = univdb_save_database;
-	db->load_database = univdb_load_database;
+
+	new_db->get_value = univdb_get_value;
+	new_db->put_value = univdb_put_value;
+	new_db->get_remoteness = univdb_get_remoteness;
+	new_db->put_remoteness = univdb_put_remoteness;
+	new_db->check_visited = univdb_check_visited;
+	new_db->mark_visited = univdb_mark_visited;
+	new_db->unmark_visited = univdb_unmark_visited;
+	new_db->get_mex = univdb_get_mex;
+	new_db->put_mex = univdb_put_mex;
+	new_db->free_db = univdb_free;
+	new_db->save_database = univdb_save_database;
+	new_db->load_database = univdb_load_database;
+	new_db->get_value_bulk = univdb_get_value_bulk;
+	new_db->get_remoteness_bulk = univdb_get_remoteness_bulk;
+	new_db->check_visited_bulk = univdb_check_visited_bulk;
+	new_db->get_mex_bulk = univdb_get_mex_bulk;
 
 	/* Decide how many slots the database will have initially.
 	   It is the maximum of gNumberOfPosition or MAX_INIT_SLOTS
@@ -73,58 +67,13 @@ DB_Table *univdb_init() {
 	slots = (gNumberOfPositions > MAX_INIT_SLOTS) ? MAX_INIT_SLOTS : gNumberOfPositions;
 
 	/* Create hash table for database */
-	ht = univht_create((unsigned long int) slots, 0.75, univdb_equal_entries, univdb_hashcode, univdb_destroy_entry, sizeof(univdb_entry), offsetof(univdb_entry, chain));
-
-	/* Return newly created table of database callbacks */
-	return db;
-
-}
-
-BOOLEAN univdb_equal_entries(void *left, void* right) {
-
-	return (((univdb_entry *) left)->position == ((univdb_entry *) right)->position);
-
-}
-
-POSITION univdb_hashcode(void *object) {
-
-	return ((univdb_entry *) object)->position;
-
-}
-
-void univdb_destroy_entry(void *entry) {
-
-	SafeFree(entry);
-
-}
-
-univdb_entry *univdb_create_entry(POSITION position) {
-
-	univdb_entry *entry;
-
-	entry = (univdb_entry *) SafeMalloc(sizeof(univdb_entry));
-	entry->position = position;
-	entry->flags = undecided;
-
-	/* Insert newly created entry into hash table */
-	univht_insert(ht, (void *)entry);
-
-	/* Return newly created entry */
-	return entry;
-}
-
-univdb_entry *univdb_lookup_entry(POSITION position) {
-
-	univdb_entry entry;
-
-	entry.position = position;
-	return (univdb_entry *)univht_lookup(ht, &entry);
+	ht = posht_create(slots);
 
 }
 
 void univdb_free() {
 	/* Destroy hash table */
-	univht_destroy(ht);
+	posht_destroy(ht);
 	fprintf(stderr, "destroying hash\n");
 	ht = NULL;
 }
@@ -132,10 +81,10 @@ void univdb_free() {
 
 VALUE univdb_get_value (POSITION position) {
 
-	univdb_entry *entry;
+	POSHT_CELL *entry;
 
 	/* Obtain entry from hash-table */
-	entry = univdb_lookup_entry(position);
+	entry = posht_lookup(ht, position);
 
 	/* If no entry in hash-table, value is undecided */
 	if (entry == NULL) {
@@ -146,7 +95,7 @@ VALUE univdb_get_value (POSITION position) {
 	/* Else extract value from the flags bit-array */
 	else {
 
-		return (entry->flags & VALUE_MASK);
+		return (*entry & VALUE_MASK);
 
 	}
 
@@ -154,33 +103,25 @@ VALUE univdb_get_value (POSITION position) {
 
 VALUE univdb_put_value (POSITION position, VALUE value) {
 
-	univdb_entry *entry;
+	POSHT_CELL *entry;
 
-	/* Obtain entry from hash-table */
-	entry = univdb_lookup_entry(position);
-
-	/* If no entry in hash-table, create new one */
-	if (entry == NULL) {
-
-		/* Create new hash table entry for position */
-		entry = univdb_create_entry(position);
-
-	}
+	/* Obtain entry from hash-table, creating it if there is none */
+	entry = posht_insert(ht, position);
 
 	/* Set new flags to entry to include for updated value */
-	entry->flags = (entry->flags & ~VALUE_MASK) | (value & VALUE_MASK);
+	*entry = (*entry & ~VALUE_MASK) | (value & VALUE_MASK);
 
 	/* Return filtered value */
-	return (entry->flags & VALUE_MASK);
+	return (*entry & VALUE_MASK);
 
 }
 
 REMOTENESS univdb_get_remoteness (POSITION position) {
 
-	univdb_entry *entry;
+	POSHT_CELL *entry;
 
 	/* Obtain entry from hash-table */
-	entry = univdb_lookup_entry(position);
+	entry = posht_lookup(ht, position);
 
 	/* If no entry in hash-table, remoteness is 0 */
 	if (entry == NULL) {
@@ -192,7 +133,7 @@ REMOTENESS univdb_get_remoteness (POSITION position) {
 	/* Else extract remoteness from the flags bit-array */
 	else {
 
-		return (entry->flags & REMOTENESS_MASK) >> REMOTENESS_SHIFT;
+		return (*entry & REMOTENESS_MASK) >> REMOTENESS_SHIFT;
 
 	}
 
@@ -200,50 +141,34 @@ REMOTENESS univdb_get_remoteness (POSITION position) {
 
 void univdb_put_remoteness (POSITION position, REMOTENESS remoteness) {
 
-	univdb_entry *entry;
-
-	/* Obtain entry from hash-table */
-	entry = univdb_lookup_entry(position);
-
-	/* If no entry in hash-table, create new one */
-	if (entry == NULL) {
+	POSHT_CELL *entry;
 
-		/* Create new hash table entry for position */
-		entry = univdb_create_entry(position);
-
-	}
+	/* Obtain entry from hash-table, creating it if there is none */
+	entry = posht_insert(ht, position);
 
 	/* Set new flags to entry to include for updated remoteness */
-	entry->flags = (entry->flags & ~REMOTENESS_MASK) | (remoteness << REMOTENESS_SHIFT);
+	*entry = (*entry & ~REMOTENESS_MASK) | (remoteness << REMOTENESS_SHIFT);
 
 }
 
 void univdb_put_mex (POSITION position, MEX mex) {
 
-	univdb_entry *entry;
-
-	/* Obtain entry from hash-table */
-	entry = univdb_lookup_entry(position);
-
-	/* If no entry in hash-table, create new one */
-	if (entry == NULL) {
-
-		/* Create new hash table entry for position */
-		entry = univdb_create_entry(position);
+	POSHT_CELL *entry;
 
-	}
+	/* Obtain entry from hash-table, creating it if there is none */
+	entry = posht_insert(ht, position);
 
 	/* Set new flags to entry to include for updated remoteness */
-	entry->flags = (VALUE) ((entry->flags & ~MEX_MASK) | (mex << MEX_SHIFT));
+	*entry = (VALUE) ((*entry & ~MEX_MASK) | (mex << MEX_SHIFT));
 
 }
 
 MEX univdb_get_mex (POSITION position) {
 
-	univdb_entry *entry;
+	POSHT_CELL *entry;
 
 	/* Obtain entry from hash-table */
-	entry = univdb_lookup_entry(position);
+	entry = posht_lookup(ht, position);
 
 	/* If no entry in hash-table, mex value is 0 */
 	/* NOTE: Is that the correct thing to do? */
@@ -256,7 +181,7 @@ MEX univdb_get_mex (POSITION position) {
 	/* Else extract remoteness from the flags bit-array */
 	else {
 
-		return (MEX) ((entry->flags & MEX_MASK) >> MEX_SHIFT);
+		return (MEX) ((*entry & MEX_MASK) >> MEX_SHIFT);
 
 	}
 
@@ -264,10 +189,10 @@ MEX univdb_get_mex (POSITION position) {
 
 BOOLEAN univdb_check_visited (POSITION position) {
 
-	univdb_entry *entry;
+	POSHT_CELL *entry;
 
 	/* Obtain entry from hash-table */
-	entry = univdb_lookup_entry(position);
+	entry = posht_lookup(ht, position);
 
 	/* If no entry in hash-table, entry is not visited */
 	if (entry == NULL) {
@@ -278,7 +203,7 @@ BOOLEAN univdb_check_visited (POSITION position) {
 	/* Else extract visited mark from the flags bit-array */
 	else {
 
-		return (entry->flags & VISITED_MASK) == VISITED_MASK;
+		return (*entry & VISITED_MASK) == VISITED_MASK;
 
 	}
 
@@ -286,16 +211,16 @@ BOOLEAN univdb_check_visited (POSITION position) {
 
 void univdb_mark_visited (POSITION position) {
 
-	univdb_entry *entry;
+	POSHT_CELL *entry;
 
 	/* Obtain entry from hash-table */
-	entry = univdb_lookup_entry(position);
+	entry = posht_lookup(ht, position);
 
 	/* If entry in hash-table */
 	if (entry != NULL) {
 
 		/* Set visited flag */
-		entry->flags |= VISITED_MASK;
+		*entry |= VISITED_MASK;
 
 	}
 
@@ -303,17 +228,67 @@ void univdb_mark_visited (POSITION position) {
 
 void univdb_unmark_visited (POSITION position) {
 
-	univdb_entry *entry;
+	POSHT_CELL *entry;
 
 	/* Obtain entry from hash-table */
-	entry = univdb_lookup_entry(position);
+	entry = posht_lookup(ht, position);
 
 	/* If entry in hash-table */
 	if (entry != NULL) {
 
 		/* Unset visited flag */
-		entry->flags &= ~VISITED_MASK;
+		*entry &= ~VISITED_MASK;
+
+	}
+
+}
+
+/* Absent entries read as in the single position versions. */
+
+void univdb_get_value_bulk (POSITION *positions, VALUE *values, int length) {
+
+	POSHT_CELL *entry;
+	int i;
+
+	for (i = 0; i < length; i++) {
+		entry = posht_lookup(ht, positions[i]);
+		values[i] = (entry == NULL) ? undecided : (*entry & VALUE_MASK);
+	}
+
+}
+
+void univdb_get_remoteness_bulk (POSITION *positions, REMOTENESS *remotenesses, int length) {
+
+	POSHT_CELL *entry;
+	int i;
+
+	for (i = 0; i < length; i++) {
+		entry = posht_lookup(ht, positions[i]);
+		remotenesses[i] = (entry == NULL) ? 0 : (*entry & REMOTENESS_MASK) >> REMOTENESS_SHIFT;
+	}
+
+}
+
+void univdb_check_visited_bulk (POSITION *positions, BOOLEAN *visited, int length) {
+
+	POSHT_CELL *entry;
+	int i;
+
+	for (i = 0; i < length; i++) {
+		entry = posht_lookup(ht, positions[i]);
+		visited[i] = (entry != NULL) && ((*entry & VISITED_MASK) == VISITED_MASK);
+	}
+
+}
+
+void univdb_get_mex_bulk (POSITION *positions, MEX *mexes, int length) {
+
+	POSHT_CELL *entry;
+	int i;
 
+	for (i = 0; i < length; i++) {
+		entry = posht_lookup(ht, positions[i]);
+		mexes[i] = (entry == NULL) ? 0 : (MEX) ((*entry & MEX_MASK) >> MEX_SHIFT);
 	}
 
 }
@@ -4,15 +4,7 @@
 #include "db.h"
 #include "gamesman.h"
 
-typedef struct univdb_entry {
-
-	POSITION position;
-	VALUE flags;
-	struct univdb_entry *chain;
-
-} univdb_entry;
-
-DB_Table *univdb_init();
+void univdb_init(DB_Table *new_db);
 
 void univdb_free();
 
@@ -28,6 +20,11 @@ void univdb_unmark_visited (POSITION position);
 
 MEX univdb_get_mex (POSITION position);
 void univdb_put_mex (POSITION position, MEX mex);
+
+void univdb_get_value_bulk (POSITION *positions, VALUE *values, int length);
+void univdb_get_remoteness_bulk (POSITION *positions, REMOTENESS *remotenesses, int length);
+void univdb_check_visited_bulk (POSITION *positions, BOOLEAN *visited, int length);
+void univdb_get_mex_bulk (POSITION *positions, MEX *mexes, int length);
 BOOLEAN univdb_save_database();
 BOOLEAN univdb_load_database();
 
@@ -11,6 +11,7 @@
 **************************************************************************/
 
 #include "gamesman.h"
+#include <pthread.h>
 
 /*************************************************************************
 **
@@ -381,19 +382,40 @@ typedef struct {
 
 #define HASH_RECORDS 100000
 
-HASH_RECORD hashRecords[HASH_RECORDS];
+// One cache per thread, since the solver may unhash from several at once;
+// a thread's cache is freed when it exits
+pthread_key_t hashCacheKey;
+pthread_once_t hashCacheKeyOnce = PTHREAD_ONCE_INIT;
 
-int hashCacheInited = 0;
+void hashCacheKeyInit() {
+	pthread_key_create(&hashCacheKey, free);
+}
+
+HASH_RECORD *hashCacheRecords() {
+	HASH_RECORD *hashRecords;
 
+	pthread_once(&hashCacheKeyOnce, hashCacheKeyInit);
+	hashRecords = (HASH_RECORD *) pthread_getspecific(hashCacheKey);
+	if (hashRecords == NULL) {
+		hashRecords = (HASH_RECORD *) SafeMalloc(HASH_RECORDS * sizeof(HASH_RECORD));
+		for (long i=0; i<HASH_RECORDS; i++) {
+			hashRecords[i].position = -1LL;
+		}
+		pthread_setspecific(hashCacheKey, hashRecords);
+	}
+	return hashRecords;
+}
+
+// Empties the calling thread's cache (the others are gone by now)
 void hashCacheInit() {
+	HASH_RECORD *hashRecords = hashCacheRecords();
 	for (long i=0; i<HASH_RECORDS; i++) {
 		hashRecords[i].position = -1LL;
 	}
-	hashCacheInited = 1;
 }
 
 void hashCachePut(int tier, POSITION position, char *board) {
-	if (!hashCacheInited) hashCacheInit();
+	HASH_RECORD *hashRecords = hashCacheRecords();
 
 	long i = position % HASH_RECORDS;
 	if (hashRecords[i].tier != tier ||
@@ -406,7 +428,7 @@ void hashCachePut(int tier, POSITION position, char *board) {
 
 // Returns TRUE if cache miss, otherwise FALSE
 BOOLEAN hashCacheGet(int tier, POSITION position, char *board) {
-	if (!hashCacheInited) hashCacheInit();
+	HASH_RECORD *hashRecords = hashCacheRecords();
 
 	long i = position % HASH_RECORDS;
 	if (hashRecords[i].tier == tier &&
@@ -457,6 +479,7 @@ void InitializeGame() {
 	gGenerateUndoMovesToTierFunPtr = &GenerateUndoMovesToTier;
 	gCustomUnhash = &customUnhash;
 	gReturnTurn = &returnTurn;
+	kSupportsThreads = TRUE;
 	SetupTierStuff();
 
 	for(i = 0; i < BOARDSIZE; i++)
@@ -789,7 +812,10 @@ POSITION DoMove(POSITION position, MOVE move) {
 
 	TIER tier; TIERPOSITION tierposition;
 	gUnhashToTierPosition(position, &tierposition, &tier);
-	gCurrentTier = tier;
+	// the solver only moves from its current tier, so it never writes here
+	// and its threads don't race on it
+	if (gCurrentTier != tier)
+		gCurrentTier = tier;
 
 	POSITION toReturn = hash(board, turn, piecesLeft, numX, numO);
 	SafeFree(board);
@@ -195,6 +195,19 @@ POSITION hash(int);
 void unhash(POSITION, int*);
 void FreeHelper(struct row**);
 
+/* Where generateMovesInto puts its moves: consed onto list, or, when
+   array is set, appended to it (counting past capacity). */
+typedef struct movesink {
+	MOVELIST *list;
+	MOVE *array;
+	int count;
+	int capacity;
+} MOVESINK;
+
+static void sinkAddMove(MOVESINK *, MOVE);
+void generateMovesInto(POSITION, MOVESINK *);
+int GenerateMovesArray(POSITION, MOVE *, int);
+
 // Internal
 int destination (int, int);
 int move_hash (int, int, int, int);
@@ -231,6 +244,7 @@ void InitializeGame()
 	if (DEBUGGING) printf("start initialize game\n");
 
 	SetupGame();
+	gGenerateMovesArrayFunPtr = &GenerateMovesArray;
 
 	if (DEBUGGING) printf("end initializegame\n");
 }
@@ -966,9 +980,59 @@ void PrintPosition(POSITION position, STRING playerName, BOOLEAN usersTurn) {
 ************************************************************************/
 
 MOVELIST *GenerateMoves(POSITION position) {
+	MOVESINK moves = { NULL, NULL, 0, 0 };
+
+	generateMovesInto(position, &moves);
+	return(moves.list);
+}
+
+/************************************************************************
+**
+** NAME:        GenerateMovesArray
+**
+** DESCRIPTION: GenerateMoves without the linked list. Writes the moves
+**              into a caller-owned array, in the order GenerateMoves
+**              lists them.
+**
+** INPUTS:      POSITION position : The position to branch off of.
+**              MOVE *moves       : Where to write the moves.
+**              int capacity      : How many moves fit in moves.
+**
+** OUTPUTS:     (int), the number of moves, which may be more than
+**              capacity, in which case only capacity were written.
+**
+************************************************************************/
+
+int GenerateMovesArray(POSITION position, MOVE *moves, int capacity) {
+	MOVESINK sink = { NULL, moves, 0, capacity };
+	MOVE tmp;
+	int i, j;
+
+	generateMovesInto(position, &sink);
+	/* GenerateMoves conses, so its list is in reverse generation order */
+	if (sink.count <= capacity) {
+		for (i = 0, j = sink.count - 1; i < j; i++, j--) {
+			tmp = moves[i];
+			moves[i] = moves[j];
+			moves[j] = tmp;
+		}
+	}
+	return(sink.count);
+}
+
+static void sinkAddMove(MOVESINK *moves, MOVE move) {
+	if (moves->array == NULL) {
+		moves->list = CreateMovelistNode(move, moves->list);
+	} else {
+		if (moves->count < moves->capacity)
+			moves->array[moves->count] = move;
+		moves->count++;
+	}
+}
+
+void generateMovesInto(POSITION position, MOVESINK *moves) {
 	if (DEBUGGING)
 		printf("generate\n");
-	MOVELIST *head = NULL;
 	int slot, direction, ssdir;
 	int pusher2, pusher3, pushee1, pushee2, pushee3;
 	char whoseTurn, opponent;
@@ -1000,10 +1064,10 @@ MOVELIST *GenerateMoves(POSITION position) {
 					pushee2 = destination(slot, (0 - direction));
 
 					if (gBoard[pushee1] == '*') {
-						head = CreateMovelistNode(move_hash(slot,NULLSLOT, NULLSLOT, direction), head);
+						sinkAddMove(moves, move_hash(slot,NULLSLOT, NULLSLOT, direction));
 					}
 					if (gBoard[pushee2] == '*') {
-						head = CreateMovelistNode(move_hash(slot,NULLSLOT, NULLSLOT, (0 - direction)), head);
+						sinkAddMove(moves, move_hash(slot,NULLSLOT, NULLSLOT, (0 - direction)));
 					}
 
 					/*Multiple Piece Moves in positive directions*/
@@ -1017,7 +1081,7 @@ MOVELIST *GenerateMoves(POSITION position) {
 						    ((gBoard[pushee1] == '*') ||
 						     ((gBoard[pushee1] == opponent) &&
 		  ((pushee2 == NULLSLOT) || (gBoard[pushee2] == '*'))))) {
-							head = CreateMovelistNode(move_hash(slot, pusher2, NULLSLOT, direction), head);
+							sinkAddMove(moves, move_hash(slot, pusher2, NULLSLOT, direction));
 						}
 
 						/*Triple Piece Push in positive direction*/
@@ -1035,7 +1099,7 @@ MOVELIST *GenerateMoves(POSITION position) {
 						                     ((pushee2 == NULLSLOT) || (gBoard[pushee2] == '*')) ||
 						                     /*two pieces pushed*/
 						                     (((pushee2 != NULLSLOT) && (gBoard[pushee2] == opponent)) && ((pushee3 == NULLSLOT) || (gBoard[pushee3] == '*'))))))) {
-							head = CreateMovelistNode(move_hash(slot, pusher2, pusher3, direction), head);
+							sinkAddMove(moves, move_hash(slot, pusher2, pusher3, direction));
 						}
 					}
 
@@ -1051,7 +1115,7 @@ MOVELIST *GenerateMoves(POSITION position) {
 						if ((pushee1 != NULLSLOT) &&
 						    ((gBoard[pushee1] == '*') ||
 						     ((gBoard[pushee1] == opponent) && ((pushee2 == NULLSLOT) || (gBoard[pushee2] == '*')))))
-							head = CreateMovelistNode(move_hash(slot, pusher2, NULLSLOT, direction), head);
+							sinkAddMove(moves, move_hash(slot, pusher2, NULLSLOT, direction));
 
 
 						/*Triple Piece Push in negative direction*/
@@ -1069,7 +1133,7 @@ MOVELIST *GenerateMoves(POSITION position) {
 						                     ((pushee2 == NULLSLOT) || (gBoard[pushee2] == '*')) ||
 						                     /*two pieces pushed*/
 						                     (((pushee2 != NULLSLOT) && (gBoard[pushee2] == opponent)) && ((pushee3 == NULLSLOT) || (gBoard[pushee3] == '*'))))))) {
-							head = CreateMovelistNode(move_hash(slot, pusher2, pusher3, direction), head);
+							sinkAddMove(moves, move_hash(slot, pusher2, pusher3, direction));
 						}
 					}
 
@@ -1091,12 +1155,12 @@ MOVELIST *GenerateMoves(POSITION position) {
 								    (gBoard[pusher2] == whoseTurn) && (gBoard[pushee1] == '*') && (gBoard[pushee2] == '*')) {
 
 									/*two piece sidestep*/
-									head = CreateMovelistNode(move_hash(slot,pusher2, NULLSLOT, ssdir), head);
+									sinkAddMove(moves, move_hash(slot,pusher2, NULLSLOT, ssdir));
 
 									/*three piece sidestep*/
 									if ((pusher3 != NULLSLOT) && (pushee3 != NULLSLOT) &&
 									    (gBoard[pusher3] == whoseTurn) && (gBoard[pushee3] == '*')) {
-										head = CreateMovelistNode(move_hash(slot,pusher2,pusher3,ssdir), head);
+										sinkAddMove(moves, move_hash(slot,pusher2,pusher3,ssdir));
 									}
 								}
 							}
@@ -1109,11 +1173,10 @@ MOVELIST *GenerateMoves(POSITION position) {
 		}
 		if (DEBUGGING)
 			printf("end gen\n");
-		return(head);
+		return;
 	}
 	if (DEBUGGING)
 		printf("end gen - NULL\n");
-	return(NULL);
 }
 
 
@@ -118,7 +118,7 @@ void SetupTierStuff();
 STRING TierToString(TIER tier);
 TIERLIST* TierChildren(TIER tier);
 TIERPOSITION NumberOfTierPositions(TIER tier);
-int GenerateMovesEfficient (POSITION);
+int GenerateMovesArray (POSITION, MOVE*, int);
 
 /************************************************************************
 **
@@ -136,7 +136,7 @@ void InitializeGame ()
 
 	//gPutWinBy = &computeWinBy;
 
-	gGenerateMovesEfficientFunPtr = &GenerateMovesEfficient;
+	gGenerateMovesArrayFunPtr = &GenerateMovesArray;
 }
 
 
@@ -866,11 +866,13 @@ STRING TierToString(TIER tier) {
 }
 
 
-// An experimental GenerateMoves that should be much faster
-int GenerateMovesEfficient (POSITION position)
+// GenerateMoves without the list: writes up to capacity moves into moves,
+// in the same order as GenerateMoves, and returns how many there are.
+int GenerateMovesArray (POSITION position, MOVE* moves, int capacity)
 {
 	int x, y, i, j, index = 0;
 	int turn;
+	MOVE tmp;
 	char* board = unhash(position, &turn);
 	for (y = 1; y <= length; y++) { // look through all the rows, bottom-up
 		for (x = 1; x <= width; x++) { // look through the columns, left-to-right
@@ -883,11 +885,19 @@ int GenerateMovesEfficient (POSITION position)
 			for (j = -2; j <= 2; j++) // rows, bottom-up
 				for (i = -2; i <= 2; i++) // columns, left-right
 					if (legalCoords(x+i,y+j) && board[toIndex(x+i,y+j)] == SPACE)
-						gGenerateMovesArray[index++] = (x*1000) + (y*100) + ((x+i)*10) + (y+j);
+						if (index++ < capacity)
+							moves[index-1] = (x*1000) + (y*100) + ((x+i)*10) + (y+j);
 		}
 	}
 	if (board != NULL)
 		SafeFree(board);
+	// GenerateMoves conses onto the front, so its list is in reverse
+	if (index <= capacity)
+		for (i = 0, j = index-1; i < j; i++, j--) {
+			tmp = moves[i];
+			moves[i] = moves[j];
+			moves[j] = tmp;
+		}
 	return index;
 }
 
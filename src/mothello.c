@@ -154,6 +154,7 @@ int oppositedirection(int);
 BOOLEAN IsPlayableBoard(char[]);
 
 BOOLEAN quickgeneratemoves(char[], int);
+int GenerateMovesArray(POSITION position, MOVE *moves, int capacity);
 void PositionToString(POSITION position, char *positionStringBuffer);
 char* getBoard(POSITION);
 char* getBlankBoard(void);
@@ -236,6 +237,8 @@ void InitializeGame(void) {
     gPutWinBy = &computeWinBy;
     gActualNumberOfPositionsOptFunPtr = &ActualNumberOfPositions;
     gPositionToStringFunPtr = &PositionToString;
+    gGenerateMovesArrayFunPtr = &GenerateMovesArray;
+    kSupportsThreads = TRUE;
 
     // Setup Tier Stuff
     // SetupTierStuff();
@@ -745,6 +748,56 @@ MOVELIST *GenerateMoves(POSITION position) {
 	return head;
 }
 
+/************************************************************************
+**
+** NAME:        GenerateMovesArray
+**
+** DESCRIPTION: GenerateMoves without the linked list. Writes the moves
+**              into a caller-owned array, in the order GenerateMoves
+**              lists them (highest square first, since it conses).
+**
+** INPUTS:      POSITION position : The position to branch off of.
+**              MOVE *moves       : Where to write the moves.
+**              int capacity      : How many moves fit in moves.
+**
+** OUTPUTS:     (int), the number of moves, which may be more than
+**              capacity, in which case only capacity were written.
+**
+************************************************************************/
+
+int GenerateMovesArray(POSITION position, MOVE *moves, int capacity) {
+    int i, j, count = 0;
+    char *board = getBoard(position);
+    char ownpiece, opponentpiece;
+
+    if (getTurn(position) == 1) {
+        ownpiece = 'B';
+        opponentpiece = 'W';
+    } else {
+        ownpiece = 'W';
+        opponentpiece = 'B';
+    }
+
+    for (i = (OthRows * OthCols) - 1; i >= 0; i--)
+        if (board[i] == BLANKPIECE) {
+            for (j = 1; j < 9; j++)
+                if (variant_NoGenMovesRestriction ||
+                    Check1Spot1Direc(i, board, ownpiece, opponentpiece, j))
+                    break;
+            if (j < 9) {
+                if (count < capacity) moves[count] = i;
+                count++;
+            }
+        }
+    free(board);
+    if (count == 0) {
+        if (capacity > 0) moves[0] = PASSMOVE;
+        count = 1;
+    }
+
+    return count;
+}
+
 /************************************************************************
 **
 ** NAME:        GetAndPrintPlayersMove
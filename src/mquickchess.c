@@ -149,13 +149,26 @@ void UndoMove(char *boardArray,int rowi, int rowf, int coli, int colf, int curre
 void testDoMove(char *boardArray, int rowi, int rowf, int coli, int colf, int currentPlayer);
 MOVE createMove(int rowi, int coli, int rowf, int colf);
 MOVE createPawnMove(int rowi, int coli, int rowf, int colf, char replacementPiece);
-void generateMovesDirection(char* boardArray,  MOVELIST **moves, int currentPlayer, int i, int j, int direction);
-void generatePawnMoves(char *boardArray,  MOVELIST **moves, int currentPlayer, int i, int j);
-void generateKnightMoves(char *boardArray,  MOVELIST **moves, int currentPlayer, int i, int j);
-void generateRookMoves(char *boardArray,  MOVELIST **moves, int currentPlayer, int i, int j);
-void generateBishopMoves(char *boardArray,  MOVELIST **moves, int currentPlayer, int i, int j);
-void generateQueenMoves(char *boardArray,  MOVELIST **moves, int currentPlayer, int i, int j);
-void generateKingMoves(char *boardArray,  MOVELIST **moves, int currentPlayer, int i, int j);
+
+/* Where the generate*Moves helpers put their moves: consed onto list, or,
+   when array is set, appended to it (counting past capacity). */
+typedef struct movesink {
+	MOVELIST *list;
+	MOVE *array;
+	int count;
+	int capacity;
+} MOVESINK;
+
+static void sinkAddMove(MOVESINK *moves, MOVE newMove);
+void generateAllMoves(POSITION position, MOVESINK *moves);
+int GenerateMovesArray(POSITION position, MOVE *moves, int capacity);
+void generateMovesDirection(char* boardArray,  MOVESINK *moves, int currentPlayer, int i, int j, int direction);
+void generatePawnMoves(char *boardArray,  MOVESINK *moves, int currentPlayer, int i, int j);
+void generateKnightMoves(char *boardArray,  MOVESINK *moves, int currentPlayer, int i, int j);
+void generateRookMoves(char *boardArray,  MOVESINK *moves, int currentPlayer, int i, int j);
+void generateBishopMoves(char *boardArray,  MOVESINK *moves, int currentPlayer, int i, int j);
+void generateQueenMoves(char *boardArray,  MOVESINK *moves, int currentPlayer, int i, int j);
+void generateKingMoves(char *boardArray,  MOVESINK *moves, int currentPlayer, int i, int j);
 void printArray (char* boardArray);
 void printMoveList(MOVELIST *moves);
 BOOLEAN replacement(char *boardArray, char replacementPiece);
@@ -272,7 +285,9 @@ void InitializeGame ()
 	gIsLegalFunPtr                                        = &IsLegal;
 	gNumberOfTierPositionsFunPtr  = &NumberOfTierPositions;
 	gTierToStringFunPtr                           = &TierToString;
+	gGenerateMovesArrayFunPtr                     = &GenerateMovesArray;
 	kSupportsTierGamesman = TRUE;
+	kSupportsThreads = TRUE;
 	/*
 	   3x4 Initial Game
 	   +---+---+---+
@@ -389,7 +404,63 @@ void InitializeGame ()
 
 MOVELIST *GenerateMoves (POSITION position)
 {
-	MOVELIST *moves = NULL;
+	MOVESINK moves = { NULL, NULL, 0, 0 };
+
+	/* Use CreateMovelistNode(move, next) to 'cons' together a linked list */
+	generateAllMoves(position, &moves);
+
+	return moves.list;
+}
+
+/************************************************************************
+**
+** NAME:        GenerateMovesArray
+**
+** DESCRIPTION: GenerateMoves without the linked list. Writes the moves
+**              into a caller-owned array, in the order GenerateMoves
+**              lists them.
+**
+** INPUTS:      POSITION position : Current position for move
+**                                  generation.
+**              MOVE *moves       : Where to write the moves.
+**              int capacity      : How many moves fit in moves.
+**
+** OUTPUTS:     (int)             : The number of moves, which may be
+**                                  more than capacity, in which case
+**                                  only capacity were written.
+**
+************************************************************************/
+
+int GenerateMovesArray (POSITION position, MOVE *moves, int capacity)
+{
+	MOVESINK sink = { NULL, moves, 0, capacity };
+	MOVE tmp;
+	int i, j;
+
+	generateAllMoves(position, &sink);
+	/* GenerateMoves conses, so its list is in reverse generation order */
+	if (sink.count <= capacity) {
+		for (i = 0, j = sink.count-1; i < j; i++, j--) {
+			tmp = moves[i];
+			moves[i] = moves[j];
+			moves[j] = tmp;
+		}
+	}
+	return sink.count;
+}
+
+static void sinkAddMove(MOVESINK *moves, MOVE newMove) {
+	if (moves->array == NULL) {
+		moves->list = CreateMovelistNode(newMove, moves->list);
+	} else {
+		if (moves->count < moves->capacity)
+			moves->array[moves->count] = newMove;
+		moves->count++;
+	}
+}
+
+void generateAllMoves(POSITION position, MOVESINK *moves)
+{
 	int currentPlayer, i,j;
 	char piece;
 	char boardArray[rows*cols];
@@ -403,22 +474,22 @@ MOVELIST *GenerateMoves (POSITION position)
 			if (isSameTeam(piece, currentPlayer)) {
 				switch (piece) {
 				case WHITE_QUEEN: case BLACK_QUEEN:
-					generateQueenMoves(boardArray, &moves, currentPlayer, i, j);
+					generateQueenMoves(boardArray, moves, currentPlayer, i, j);
 					break;
 				case WHITE_BISHOP: case BLACK_BISHOP:
-					generateBishopMoves(boardArray, &moves, currentPlayer, i, j);
+					generateBishopMoves(boardArray, moves, currentPlayer, i, j);
 					break;
 				case WHITE_ROOK: case BLACK_ROOK:
-					generateRookMoves(boardArray, &moves, currentPlayer, i, j);
+					generateRookMoves(boardArray, moves, currentPlayer, i, j);
 					break;
 				case WHITE_KNIGHT: case BLACK_KNIGHT:
-					generateKnightMoves(boardArray, &moves, currentPlayer, i, j);
+					generateKnightMoves(boardArray, moves, currentPlayer, i, j);
 					break;
 				case WHITE_PAWN: case BLACK_PAWN:
-					generatePawnMoves(boardArray, &moves, currentPlayer, i, j);
+					generatePawnMoves(boardArray, moves, currentPlayer, i, j);
 					break;
 				case WHITE_KING: case BLACK_KING:
-					generateKingMoves(boardArray, &moves, currentPlayer, i, j);
+					generateKingMoves(boardArray, moves, currentPlayer, i, j);
 					break;
 				default:
 					break;
@@ -426,10 +497,6 @@ MOVELIST *GenerateMoves (POSITION position)
 			}
 		}
 	}
-
-	/* Use CreateMovelistNode(move, next) to 'cons' together a linked list */
-
-	return moves;
 }
 
 
@@ -1252,62 +1319,62 @@ BOOLEAN kingCheck(char *Board, int row, int col, int currentPlayer, char current
 **
 ************************************************************************/
 
-void generateKingMoves(char *boardArray, MOVELIST **moves, int currentPlayer, int i, int j){
+void generateKingMoves(char *boardArray, MOVESINK *moves, int currentPlayer, int i, int j){
 	MOVE newMove;
 	//UP
 	if (i != 0 && !isSameTeam(boardArray[(i-1)*cols + j], currentPlayer)) {
 		newMove = createMove(i, j, i-1, j);
 		if (testMove(boardArray, i,i-1,j,j, currentPlayer)) {
-			*moves = CreateMovelistNode(newMove, *moves);
+			sinkAddMove(moves, newMove);
 		}
 	}
 	//Down
 	if (i != rows-1 && !isSameTeam(boardArray[(i+1)*cols + j], currentPlayer)) {
 		newMove = createMove(i, j, i+1, j);
 		if (testMove(boardArray, i,i+1,j,j, currentPlayer)) {
-			*moves = CreateMovelistNode(newMove, *moves);
+			sinkAddMove(moves, newMove);
 		}
 	}
 	//Left
 	if (j != 0 && !isSameTeam(boardArray[i*cols + j-1], currentPlayer)) {
 		newMove = createMove(i, j, i, j-1 );
 		if (testMove(boardArray, i,i,j,j-1, currentPlayer)) {
-			*moves = CreateMovelistNode(newMove, *moves);
+			sinkAddMove(moves, newMove);
 		}
 	}
 	//Right
 	if (j != cols-1 && !isSameTeam(boardArray[i*cols + j+1], currentPlayer)) {
 		newMove = createMove(i, j, i, j+1 );
 		if (testMove(boardArray, i,i,j,j+1, currentPlayer)) {
-			*moves = CreateMovelistNode(newMove, *moves);
+			sinkAddMove(moves, newMove);
 		}
 	}
 	//Up-left
 	if (i != 0 && j != 0 && !isSameTeam(boardArray[(i-1)*cols + j-1], currentPlayer)) {
 		newMove = createMove(i, j, i-1, j-1 );
 		if (testMove(boardArray, i,i-1,j,j-1, currentPlayer)) {
-			*moves = CreateMovelistNode(newMove, *moves);
+			sinkAddMove(moves, newMove);
 		}
 	}
 	//Up-right
 	if (i != 0 && j != cols-1 && !isSameTeam(boardArray[(i-1)*cols + j+1], currentPlayer)) {
 		newMove = createMove(i, j, i-1, j+1 );
 		if (testMove(boardArray, i,i-1,j,j+1, currentPlayer)) {
-			*moves = CreateMovelistNode(newMove, *moves);
+			sinkAddMove(moves, newMove);
 		}
 	}
 	//Down-left
 	if (i != rows-1 && j != 0 && !isSameTeam(boardArray[(i+1)*cols + j-1], currentPlayer)) {
 		newMove = createMove(i, j, i+1, j-1 );
 		if (testMove(boardArray, i,i+1,j,j-1, currentPlayer)) {
-			*moves = CreateMovelistNode(newMove, *moves);
+			sinkAddMove(moves, newMove);
 		}
 	}
 	//Down-right
 	if (i != rows-1 && j != cols-1 && !isSameTeam(boardArray[(i+1)*cols + j+1], currentPlayer)) {
 		newMove = createMove(i, j, i+1, j+1 );
 		if (testMove(boardArray, i,i+1,j,j+1, currentPlayer)) {
-			*moves = CreateMovelistNode(newMove, *moves);
+			sinkAddMove(moves, newMove);
 		}
 	}
 }
@@ -1317,7 +1384,7 @@ void generateKingMoves(char *boardArray, MOVELIST **moves, int currentPlayer, in
 ** checks of the piece taken, if any, is of the same team.  Then checks if the move puts
 ** the player in check.  Generates moves in all directions until it hits a piece.
 */
-void generateQueenMoves(char *boardArray,  MOVELIST **moves, int currentPlayer, int i, int j){
+void generateQueenMoves(char *boardArray,  MOVESINK *moves, int currentPlayer, int i, int j){
 	generateMovesDirection(boardArray, moves, currentPlayer, i, j, UP);
 	generateMovesDirection(boardArray, moves, currentPlayer, i, j, DOWN);
 	generateMovesDirection(boardArray, moves, currentPlayer, i, j, LEFT);
@@ -1333,7 +1400,7 @@ void generateQueenMoves(char *boardArray,  MOVELIST **moves, int currentPlayer,
 ** checks of the piece taken, if any, is of the same team.  Then checks if the move puts
 ** the player in check.  Generates moves in the four diagonal directions until it hits a piece.
 */
-void generateBishopMoves(char *boardArray,  MOVELIST **moves, int currentPlayer, int i, int j){
+void generateBishopMoves(char *boardArray,  MOVESINK *moves, int currentPlayer, int i, int j){
 	generateMovesDirection(boardArray, moves, currentPlayer, i, j, UL);
 	generateMovesDirection(boardArray, moves, currentPlayer, i, j, UR);
 	generateMovesDirection(boardArray, moves, currentPlayer, i, j, DL);
@@ -1345,7 +1412,7 @@ void generateBishopMoves(char *boardArray,  MOVELIST **moves, int currentPlayer,
 ** checks of the piece taken, if any, is of the same team.  Then checks if the move puts
 ** the player in check.  Generates moves in 4 compass directions until it hits a piece.
 */
-void generateRookMoves(char *boardArray,  MOVELIST **moves, int currentPlayer, int i, int j){
+void generateRookMoves(char *boardArray,  MOVESINK *moves, int currentPlayer, int i, int j){
 	generateMovesDirection(boardArray, moves, currentPlayer, i, j, UP);
 	generateMovesDirection(boardArray, moves, currentPlayer, i, j, DOWN);
 	generateMovesDirection(boardArray, moves, currentPlayer, i, j, LEFT);
@@ -1358,62 +1425,62 @@ void generateRookMoves(char *boardArray,  MOVELIST **moves, int currentPlayer, i
 ** the player in check.  There are 8 possible moves for a knight.  The first direction indicates
 ** 2 blocks of move, the second direction is one block.
 */
-void generateKnightMoves(char *boardArray,  MOVELIST **moves, int currentPlayer, int i, int j){
+void generateKnightMoves(char *boardArray,  MOVESINK *moves, int currentPlayer, int i, int j){
 	MOVE newMove;
 	//Left 2, Down 1
 	if (i < rows-1 && j > 1 && !isSameTeam(boardArray[(i+1)*cols + j-2], currentPlayer)) {
 		newMove = createMove(i, j, i+1, j-2 );
 		if (testMove(boardArray, i,i+1,j,j-2, currentPlayer)) {
-			*moves = CreateMovelistNode(newMove, *moves);
+			sinkAddMove(moves, newMove);
 		}
 	}
 	//Right 2, Down 1
 	if (i < rows-1 && j < cols-2 && !isSameTeam(boardArray[(i+1)*cols + j+2], currentPlayer)) {
 		newMove = createMove(i, j, i+1, j+2 );
 		if (testMove(boardArray, i,i+1,j,j+2, currentPlayer)) {
-			*moves = CreateMovelistNode(newMove, *moves);
+			sinkAddMove(moves, newMove);
 		}
 	}
 	//Down 2, Left 1
 	if (i < rows-2 && j > 0 && !isSameTeam(boardArray[(i+2)*cols + j-1], currentPlayer)) {
 		newMove = createMove(i, j, i+2, j-1);
 		if (testMove(boardArray, i,i+2,j,j-1, currentPlayer)) {
-			*moves = CreateMovelistNode(newMove, *moves);
+			sinkAddMove(moves, newMove);
 		}
 	}
 	//Down 2, Right 1
 	if (i < rows-2 && j < cols-1 && !isSameTeam(boardArray[(i+2)*cols + j+1], currentPlayer)) {
 		newMove = createMove(i, j, i+2, j+1);
 		if (testMove(boardArray, i,i+2,j,j+1, currentPlayer)) {
-			*moves = CreateMovelistNode(newMove, *moves);
+			sinkAddMove(moves, newMove);
 		}
 	}
 	//Left 2, Up 1
 	if (i > 0 && j > 1 && !isSameTeam(boardArray[(i-1)*cols + j-2], currentPlayer)) {
 		newMove = createMove(i, j, i-1, j-2 );
 		if (testMove(boardArray, i,i-1,j,j-2, currentPlayer)) {
-			*moves = CreateMovelistNode(newMove, *moves);
+			sinkAddMove(moves, newMove);
 		}
 	}
 	//Right 2, Up 1
 	if (i > 0 && j < cols-2 && !isSameTeam(boardArray[(i-1)*cols + j+2], currentPlayer)) {
 		newMove = createMove(i, j, i-1, j+2 );
 		if (testMove(boardArray, i,i-1,j,j+2, currentPlayer)) {
-			*moves = CreateMovelistNode(newMove, *moves);
+			sinkAddMove(moves, newMove);
 		}
 	}
 	//Up 2, Left 1
 	if (i > 1 && j > 0 && !isSameTeam(boardArray[(i-2)*cols + j-1], currentPlayer)) {
 		newMove = createMove(i, j, i-2, j-1 );
 		if (testMove(boardArray, i,i-2,j,j-1, currentPlayer)) {
-			*moves = CreateMovelistNode(newMove, *moves);
+			sinkAddMove(moves, newMove);
 		}
 	}
 	//Up 2, Right 1
 	if (i > 1 && j < cols-1 && !isSameTeam(boardArray[(i-2)*cols + j+1], currentPlayer)) {
 		newMove = createMove(i, j, i-2, j+1 );
 		if (testMove(boardArray, i, i-2, j,j+1, currentPlayer)) {
-			*moves = CreateMovelistNode(newMove, *moves);
+			sinkAddMove(moves, newMove);
 		}
 	}
 }
@@ -1424,31 +1491,31 @@ void generateKnightMoves(char *boardArray,  MOVELIST **moves, int currentPlayer,
 ** the player in check.  Calculates moves forward one piece if there is no piece there
 ** or moves diagonal forward if there is an opposing player piece there.
 */
-void generatePawnMoves(char *boardArray,  MOVELIST **moves, int currentPlayer, int i, int j){
+void generatePawnMoves(char *boardArray,  MOVESINK *moves, int currentPlayer, int i, int j){
 
 	if (currentPlayer == BLACK_TURN) {
 		//down 1.  Only a legal move if there is no piece there
 		if (i != rows-1 && boardArray[(i+1)*cols + j] == ' ') {
 			MOVE newMove = createMove(i, j, i+1, j);
 			if (testMove(boardArray, i,i+1,j,j, currentPlayer)) {
-				*moves = CreateMovelistNode(newMove, *moves);
+				sinkAddMove(moves, newMove);
 				// check if pawn is at the end
 				if(i + 1 == rows-1) {
 					if(replacement(boardArray, BLACK_QUEEN)) {
 						newMove = createPawnMove(i, j, i+1, j, BLACK_QUEEN);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 					if(replacement(boardArray, BLACK_ROOK)) {
 						newMove = createPawnMove(i, j, i+1, j, BLACK_ROOK);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 					if(replacement(boardArray, BLACK_BISHOP)) {
 						newMove = createPawnMove(i, j, i+1, j, BLACK_BISHOP);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 					if(replacement(boardArray, BLACK_KNIGHT)) {
 						newMove = createPawnMove(i, j, i+1, j, BLACK_KNIGHT);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 
 
@@ -1460,24 +1527,24 @@ void generatePawnMoves(char *boardArray,  MOVELIST **moves, int currentPlayer, i
 		    !isSameTeam(boardArray[(i+1)*cols + j-1], currentPlayer)) {
 			MOVE newMove = createMove(i, j, i+1, j-1);
 			if (testMove(boardArray, i,i+1,j,j-1, currentPlayer)) {
-				*moves = CreateMovelistNode(newMove, *moves);
+				sinkAddMove(moves, newMove);
 				// check if pawn is at the end
 				if(i + 1 == rows-1) {
 					if(replacement(boardArray, BLACK_QUEEN)) {
 						newMove = createPawnMove(i, j, i+1, j, BLACK_QUEEN);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 					if(replacement(boardArray, BLACK_ROOK)) {
 						newMove = createPawnMove(i, j, i+1, j, BLACK_ROOK);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 					if(replacement(boardArray, BLACK_BISHOP)) {
 						newMove = createPawnMove(i, j, i+1, j, BLACK_BISHOP);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 					if(replacement(boardArray, BLACK_KNIGHT)) {
 						newMove = createPawnMove(i, j, i+1, j, BLACK_KNIGHT);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 				}
 			}
@@ -1487,24 +1554,24 @@ void generatePawnMoves(char *boardArray,  MOVELIST **moves, int currentPlayer, i
 		    !isSameTeam(boardArray[(i+1)*cols + j+1], currentPlayer)) {
 			MOVE newMove = createMove(i, j, i+1, j+1);
 			if (testMove(boardArray, i, i+1, j, j+1, currentPlayer)) {
-				*moves = CreateMovelistNode(newMove, *moves);
+				sinkAddMove(moves, newMove);
 				// check if pawn is at the end
 				if(i + 1 == rows-1) {
 					if(replacement(boardArray, BLACK_QUEEN)) {
 						newMove = createPawnMove(i, j, i+1, j, BLACK_QUEEN);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 					if(replacement(boardArray, BLACK_ROOK)) {
 						newMove = createPawnMove(i, j, i+1, j, BLACK_ROOK);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 					if(replacement(boardArray, BLACK_BISHOP)) {
 						newMove = createPawnMove(i, j, i+1, j, BLACK_BISHOP);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 					if(replacement(boardArray, BLACK_KNIGHT)) {
 						newMove = createPawnMove(i, j, i+1, j, BLACK_KNIGHT);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 				}
 			}
@@ -1514,24 +1581,24 @@ void generatePawnMoves(char *boardArray,  MOVELIST **moves, int currentPlayer, i
 		if (i != 0 && boardArray[(i-1)*cols + j] == ' ') {
 			MOVE newMove = createMove(i, j, i-1, j);
 			if (testMove(boardArray, i, i-1, j, j, currentPlayer)) {
-				*moves = CreateMovelistNode(newMove, *moves);
+				sinkAddMove(moves, newMove);
 				// check if pawn is at the end
 				if(i-1 == 0) {
 					if(replacement(boardArray, WHITE_QUEEN)) {
 						newMove = createPawnMove(i, j, i+1, j, WHITE_QUEEN);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 					if(replacement(boardArray, WHITE_ROOK)) {
 						newMove = createPawnMove(i, j, i+1, j, WHITE_ROOK);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 					if(replacement(boardArray, WHITE_BISHOP)) {
 						newMove = createPawnMove(i, j, i+1, j, WHITE_BISHOP);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 					if(replacement(boardArray, WHITE_KNIGHT)) {
 						newMove = createPawnMove(i, j, i+1, j, WHITE_KNIGHT);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 				}
 			}
@@ -1541,24 +1608,24 @@ void generatePawnMoves(char *boardArray,  MOVELIST **moves, int currentPlayer, i
 		    !isSameTeam(boardArray[(i-1)*cols + j-1], currentPlayer)) {
 			MOVE newMove = createMove(i, j, i-1, j-1);
 			if (testMove(boardArray, i, i-1,j,j-1, currentPlayer)) {
-				*moves = CreateMovelistNode(newMove, *moves);
+				sinkAddMove(moves, newMove);
 				// check if pawn is at the end
 				if(i-1 == 0) {
 					if(replacement(boardArray, WHITE_QUEEN)) {
 						newMove = createPawnMove(i, j, i+1, j, WHITE_QUEEN);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 					if(replacement(boardArray, WHITE_ROOK)) {
 						newMove = createPawnMove(i, j, i+1, j, WHITE_ROOK);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 					if(replacement(boardArray, WHITE_BISHOP)) {
 						newMove = createPawnMove(i, j, i+1, j, WHITE_BISHOP);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 					if(replacement(boardArray, WHITE_KNIGHT)) {
 						newMove = createPawnMove(i, j, i+1, j, WHITE_KNIGHT);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 				}
 			}
@@ -1568,24 +1635,24 @@ void generatePawnMoves(char *boardArray,  MOVELIST **moves, int currentPlayer, i
 		    !isSameTeam(boardArray[(i-1)*cols + j+1], currentPlayer)) {
 			MOVE newMove = createMove(i, j, i-1, j+1);
 			if (testMove(boardArray, i, i-1, j, j+1, currentPlayer)) {
-				*moves = CreateMovelistNode(newMove, *moves);
+				sinkAddMove(moves, newMove);
 				// check if pawn is at the end
 				if(i-1 == 0) {
 					if(replacement(boardArray, WHITE_QUEEN)) {
 						newMove = createPawnMove(i, j, i+1, j, WHITE_QUEEN);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 					if(replacement(boardArray, WHITE_ROOK)) {
 						newMove = createPawnMove(i, j, i+1, j, WHITE_ROOK);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 					if(replacement(boardArray, WHITE_BISHOP)) {
 						newMove = createPawnMove(i, j, i+1, j, WHITE_BISHOP);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 					if(replacement(boardArray, WHITE_KNIGHT)) {
 						newMove = createPawnMove(i, j, i+1, j, WHITE_KNIGHT);
-						*moves = CreateMovelistNode(newMove, *moves);
+						sinkAddMove(moves, newMove);
 					}
 				}
 			}
@@ -1603,7 +1670,7 @@ void generatePawnMoves(char *boardArray,  MOVELIST **moves, int currentPlayer, i
    they hit another piece.  They can only take that piece if it is of the other team.
    POSTCONDITION: moves is updated with all of the legal moves.
  */
-void generateMovesDirection(char* boardArray,  MOVELIST **moves, int currentPlayer, int i, int j, int direction) {
+void generateMovesDirection(char* boardArray,  MOVESINK *moves, int currentPlayer, int i, int j, int direction) {
 	int i_inc=0, j_inc=0,  new_i=i, new_j=j;
 	char piece;
 	switch (direction) {
@@ -1644,7 +1711,7 @@ void generateMovesDirection(char* boardArray,  MOVELIST **moves, int currentPlay
 		if (!isSameTeam(piece, currentPlayer)) {
 			newMove = createMove(i, j, new_i, new_j);
 			if (testMove(boardArray, i, new_i, j, new_j, currentPlayer)) {
-				*moves = CreateMovelistNode(newMove, *moves);
+				sinkAddMove(moves, newMove);
 			}
 		}
 		if (piece != ' ') {
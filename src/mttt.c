@@ -565,6 +565,9 @@ POSITION DoSymmetry(POSITION position, int symmetry) {
 ** DESCRIPTION: Go through all of the positions that are symmetrically
 **              equivalent and return the SMALLEST, which will be used
 **              as the canonical element for the equivalence set.
+**              A position's top cell is its most significant digit,
+**              so the images are compared cell by cell from the top
+**              on one unhashed board, and only the winner is hashed.
 **
 ** INPUTS:      POSITION position : The position return the canonical elt. of.
 **
@@ -573,19 +576,28 @@ POSITION DoSymmetry(POSITION position, int symmetry) {
 ************************************************************************/
 
 POSITION GetCanonicalPosition(POSITION position) {
-	POSITION newPosition, theCanonicalPosition;
-	int i;
-
-	theCanonicalPosition = position;
+	BlankOX theBlankOx[BOARDSIZE], symmBlankOx[BOARDSIZE];
+	int i, symmetry, best = -1; /* -1 is the position itself */
+	BlankOX mine, theirs;
 
-	for(i = 0; i < NUMSYMMETRIES; i++) {
+	PositionToBlankOX(position,theBlankOx);
 
-		newPosition = DoSymmetry(position, i); /* get new */
-		if(newPosition < theCanonicalPosition) /* THIS is the one */
-			theCanonicalPosition = newPosition; /* set it to the ans */
+	for(symmetry = 0; symmetry < NUMSYMMETRIES; symmetry++) {
+		for(i = BOARDSIZE - 1; i >= 0; i--) {
+			mine = theBlankOx[gSymmetryMatrix[symmetry][i]];
+			theirs = (best < 0) ? theBlankOx[i] : theBlankOx[gSymmetryMatrix[best][i]];
+			if(mine != theirs)
+				break;
+		}
+		if(i >= 0 && mine < theirs) /* THIS is the one */
+			best = symmetry;
 	}
 
-	return(theCanonicalPosition);
+	if(best < 0)
+		return(position);
+	for(i = 0; i < BOARDSIZE; i++)
+		symmBlankOx[i] = theBlankOx[gSymmetryMatrix[best][i]];
+	return(BlankOXToPosition(symmBlankOx));
 }
 
 /**************************************************/
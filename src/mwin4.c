@@ -197,6 +197,7 @@ int             MostSigBit(uint num);
 POSITION        ModPosToPosition(POSITION p);
 POSITION        PositionToModPos(POSITION p, TIER t);
 XOBlank WhoseTurn(POSITION pos);
+int             GenerateMovesArray(POSITION position, MOVE *moves, int capacity);
 
 void InitializeGame()
 {
@@ -230,6 +231,8 @@ void InitializeGame()
 	gPosition.piecesPlaced = 0;
 	gUndoMove = UndoMove;
 	gCanonicalPosition = GetCanonicalPosition;
+	gGenerateMovesArrayFunPtr = &GenerateMovesArray;
+	kSupportsThreads = TRUE;
 }
 
 
@@ -488,13 +491,14 @@ VALUE Primitive(POSITION position)
 		int ll[WIN4_WIDTH][WIN4_HEIGHT]; //lower left
 		int u[WIN4_WIDTH][WIN4_HEIGHT]; //up
 		XOBlank board[WIN4_WIDTH][WIN4_HEIGHT+1];
+		XOBlank scratch[MAXW][MAXH]; // not gPosition.board, so tiers can be solved in parallel
 		int col,row;
-		PositionToBoard(position, gPosition.board); // Temporary storage.
+		PositionToBoard(position, scratch); // Temporary storage.
 		for (col=0; col<WIN4_WIDTH; col++)
 			board[col][WIN4_HEIGHT]=2;
 		for (col=0; col<WIN4_WIDTH; col++)
 			for (row=0; row<WIN4_HEIGHT; row++)
-				board[col][row] = gPosition.board[col][row];
+				board[col][row] = scratch[col][row];
 		// Check for four in a row
 		// First do column 0:
 		col=0;
@@ -713,13 +717,17 @@ void PrintPosition(POSITION position,STRING playerName,BOOLEAN usersTurn)
 MOVELIST *GenerateMoves(POSITION position)
 {
 	MOVELIST *head = NULL;
+	XOBlank scratch[MAXW][MAXH];
+	XOBlank (*board)[MAXH] = gPosition.board;
 	int i;
 
-	if (!gUseGPS)
-		PositionToBoard(position, gPosition.board); // Temporary storage.
+	if (!gUseGPS) {
+		PositionToBoard(position, scratch); // Temporary storage.
+		board = scratch;
+	}
 
 	for(i = 0; i < WIN4_WIDTH; i++) {
-		if(gPosition.board[i][WIN4_HEIGHT-1] == Blank)
+		if(board[i][WIN4_HEIGHT-1] == Blank)
 			head = CreateMovelistNode(i,head);
 	}
 
@@ -727,6 +735,45 @@ MOVELIST *GenerateMoves(POSITION position)
 
 }
 
+/************************************************************************
+**
+** NAME:        GenerateMovesArray
+**
+** DESCRIPTION: GenerateMoves without the linked list. Writes the moves
+**              into a caller-owned array, in the order GenerateMoves
+**              lists them.
+**
+** INPUTS:      POSITION position : The position to branch off of.
+**              MOVE *moves       : Where to write the moves.
+**              int capacity      : How many moves fit in moves.
+**
+** OUTPUTS:     (int), the number of moves, which may be more than
+**              capacity, in which case only capacity were written.
+**
+************************************************************************/
+
+int GenerateMovesArray(POSITION position, MOVE *moves, int capacity)
+{
+	XOBlank scratch[MAXW][MAXH];
+	XOBlank (*board)[MAXH] = gPosition.board;
+	int i, count = 0;
+
+	if (!gUseGPS) {
+		PositionToBoard(position, scratch); // Temporary storage.
+		board = scratch;
+	}
+
+	for(i = WIN4_WIDTH - 1; i >= 0; i--) {
+		if(board[i][WIN4_HEIGHT-1] == Blank) {
+			if (count < capacity)
+				moves[count] = i;
+			count++;
+		}
+	}
+
+	return(count);
+}
+
 /************************************************************************
 **
 ** NAME:        GetAndPrintPlayersMove
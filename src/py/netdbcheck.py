@@ -0,0 +1,122 @@
+"""Checks a game's --netDb client against the stand-in in netdbstub.py.
+
+    python3 netdbcheck.py <game binary>...
+
+Each game is run with --interact against a fresh stand-in. The check asks
+for the initial position and two generations of its children, and fails
+(exit status 1) unless
+  - every value and remoteness printed is the one the stand-in served,
+  - the children of a position are fetched in a single batched request, and
+  - every request, from InitDatabase on, came in over one connection.
+"""
+from __future__ import annotations
+import json
+import subprocess
+import sys
+import typing
+
+from netdbstub import NetDbServer, remoteness_of, value_of
+
+value_strings: dict[str, str] = {'W': 'win', 'L': 'lose', 'T': 'tie'}
+
+reply_timeout: int = 20
+
+
+class CheckFailed(Exception):
+    pass
+
+
+class Interact:
+    """A game binary running --interact against the stand-in."""
+
+    def __init__(self, binary: str, port: int) -> None:
+        self.process = subprocess.Popen(
+            [binary, '--netDb', '127.0.0.1:%d/GamesmanServlet' % port, '--interact'],
+            stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+            text=True)
+
+    def ask(self, command: str, marker: str = 'result =>> ') -> str:
+        assert self.process.stdin is not None and self.process.stdout is not None
+        try:
+            self.process.stdin.write(command + '\n')
+            self.process.stdin.flush()
+        except BrokenPipeError:
+            raise CheckFailed('exited before %r' % command)
+        for line in self.process.stdout:
+            if marker in line:
+                return line.split(marker, 1)[1].strip()
+        raise CheckFailed('no answer to %r' % command)
+
+    def close(self) -> None:
+        try:
+            assert self.process.stdin is not None
+            self.process.stdin.write('exit\n')
+            self.process.stdin.close()
+            self.process.wait(timeout=reply_timeout)
+        except (BrokenPipeError, subprocess.TimeoutExpired):
+            self.process.kill()
+            self.process.wait()
+
+
+def expect(condition: bool, message: str) -> None:
+    if not condition:
+        raise CheckFailed(message)
+
+
+def check_position_response(game: Interact, board: str) -> list[str]:
+    """Checks the answers for board and its children; returns the children."""
+    response: dict[str, typing.Any] = json.loads(game.ask('position_response "%s"' % board))
+    expect('error' not in response, 'position_response "%s": %s' % (board, response))
+    entries = [response] + response['moves']
+    for entry in entries:
+        position = int(game.ask('position "%s"' % entry['position'], 'position hash: '))
+        expect(entry['positionValue'] == value_strings[value_of(position)]
+               and entry['remoteness'] == remoteness_of(position),
+               '%s (%d) is %s in %d, the stand-in served %s in %d'
+               % (entry['position'], position, entry['positionValue'], entry['remoteness'],
+                  value_strings[value_of(position)], remoteness_of(position)))
+    return [move['position'] for move in response['moves']]
+
+
+def check_game(binary: str) -> None:
+    server = NetDbServer()
+    server.start()
+    game = Interact(binary, server.port)
+    try:
+        start: str = json.loads(game.ask('start_response'))['position']
+        children = check_position_response(game, start)
+        expect(len(children) > 1, 'the initial position needs several children')
+        batches = [r.length for r in server.requests if r.type == 'GetValueOfPositions']
+        expect(len(children) in batches,
+               'the %d children were not fetched in one request: %s' % (len(children), batches))
+        check_position_response(game, children[0])
+        # a position nobody has asked about yet: a lookup of its own
+        child = int(game.ask('position "%s"' % children[1], 'position hash: '))
+        position = json.loads(game.ask('child_positions %d' % child))[0]
+        asked = len(server.requests)
+        expect(int(game.ask('remoteness %d' % position)) == remoteness_of(position)
+               and len(server.requests) == asked + 1,
+               'remoteness %d does not match or was not asked for' % position)
+    finally:
+        game.close()
+        server.shutdown()
+        server.server_close()
+    requests = server.requests
+    expect(len(requests) > 2 and requests[0].type == 'InitDatabase',
+           'expected InitDatabase and then lookups, got %s' % requests)
+    expect(server.connections == 1 and all(r.connection == 1 for r in requests),
+           '%d requests came in over %d connections' % (len(requests), server.connections))
+    print('%s: %d requests over 1 connection, batches of %s'
+          % (binary, len(requests), [r.length for r in requests[1:]]))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) < 2:
+        print('usage: %s <game binary>...' % sys.argv[0])
+        sys.exit(2)
+    try:
+        for binary in sys.argv[1:]:
+            check_game(binary)
+    except CheckFailed as failure:
+        print('%s: %s' % (binary, failure))
+        sys.exit(1)
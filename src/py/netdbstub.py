@@ -0,0 +1,124 @@
+"""A stand-in for the GamesmanServlet that --netDb talks to.
+
+It answers InitDatabase with ReturnCode 0 and GetValueOfPositions with
+cell_for(position) for every position in the batch, so a client's answers
+can be checked without a solved database. Each request is recorded with the
+connection it came in on and the number of positions it asked for.
+
+Run it on its own with
+    python3 netdbstub.py [port]
+and point a game at it with --netDb 127.0.0.1:<port>/GamesmanServlet.
+"""
+from __future__ import annotations
+import http.server
+import socketserver
+import struct
+import sys
+import threading
+import typing
+
+# VALUE is undecided, win, lose, tie, ...; cells are laid out as in db.h.
+value_names: str = 'UWLT'
+value_mask: int = 3
+remoteness_shift: int = 8
+remoteness_max: int = 50
+
+
+def cell_for(position: int) -> int:
+    """The synthetic cell served for position: a decided value and a
+    remoteness, both derived from the position alone."""
+    value: int = 1 + position % 3
+    remoteness: int = (position // 3) % remoteness_max
+    return value | (remoteness << remoteness_shift)
+
+
+def value_of(position: int) -> str:
+    return value_names[cell_for(position) & value_mask]
+
+
+def remoteness_of(position: int) -> int:
+    return cell_for(position) >> remoteness_shift
+
+
+class Request(typing.NamedTuple):
+    connection: int
+    type: str
+    length: int
+
+
+class NetDbHandler(http.server.BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'  # keep the connection open between requests
+
+    def setup(self) -> None:
+        super().setup()
+        with self.server.lock:
+            self.server.connections += 1
+            self.connection_id = self.server.connections
+
+    def do_POST(self) -> None:
+        body: bytes = self.rfile.read(int(self.headers.get('Content-Length', 0)))
+        req_type: str = self.headers.get('TYPE', '')
+        if req_type == 'InitDatabase':
+            self.record(req_type, 0)
+            self.reply(b'', {})
+        elif req_type == 'GetValueOfPositions':
+            length: int = int(self.headers.get('Length', -1))
+            if length < 0 or len(body) != 8 * length:
+                self.record(req_type, length)
+                self.reply(b'', {'ReturnCode': '1',
+                                 'ReturnMessage': 'Length does not match the body'})
+                return
+            positions = struct.unpack('>%dQ' % length, body)
+            self.record(req_type, length)
+            cells: bytes = struct.pack('>%dH' % length,
+                                       *(cell_for(p) for p in positions))
+            self.reply(cells, {'Length': str(length)})
+        else:
+            self.record(req_type, 0)
+            self.reply(b'', {'ReturnCode': '2',
+                             'ReturnMessage': 'Unknown TYPE ' + req_type})
+
+    def record(self, req_type: str, length: int) -> None:
+        with self.server.lock:
+            self.server.requests.append(Request(self.connection_id, req_type, length))
+
+    def reply(self, body: bytes, headers: dict[str, str]) -> None:
+        self.send_response(200)
+        self.send_header('ReturnCode', headers.pop('ReturnCode', '0'))
+        for name, value in headers.items():
+            self.send_header(name, value)
+        self.send_header('Content-Type', 'application/octet-stream')
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def log_message(self, format: str, *args: typing.Any) -> None:
+        if self.server.verbose:
+            super().log_message(format, *args)
+
+
+class NetDbServer(socketserver.ThreadingMixIn, http.server.HTTPServer):
+    daemon_threads = True
+
+    def __init__(self, port: int = 0, verbose: bool = False) -> None:
+        super().__init__(('127.0.0.1', port), NetDbHandler)
+        self.lock = threading.Lock()
+        self.connections: int = 0
+        self.requests: list[Request] = []
+        self.verbose = verbose
+
+    @property
+    def port(self) -> int:
+        return self.server_address[1]
+
+    def start(self) -> None:
+        threading.Thread(target=self.serve_forever, daemon=True).start()
+
+
+if __name__ == '__main__':
+    server = NetDbServer(int(sys.argv[1]) if len(sys.argv) > 1 else 0, verbose=True)
+    print('netdb stand-in listening on 127.0.0.1:%d' % server.port, flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass